@@ -0,0 +1,38 @@
+#include "ottsr.h"
+
+static ottsr_app_t g_app = {0};
+
+int main(int argc, char *argv[]) {
+    GtkApplication *app;
+    int status;
+    
+    // Command-line queries answer from disk without bringing up GTK
+    if (argc > 1 && strcmp(argv[1], "--tui") == 0) {
+        return ottsr_tui_main(argc - 1, argv + 1);
+    }
+    if (argc > 1 && strcmp(argv[1], "stats") == 0) {
+        return ottsr_stats_main(argc - 1, argv + 1);
+    }
+    if (argc > 1 && strcmp(argv[1], "search") == 0) {
+        return ottsr_search_main(argc - 1, argv + 1);
+    }
+    if (argc > 1 && strcmp(argv[1], "plan") == 0) {
+        return ottsr_plan_main(argc - 1, argv + 1);
+    }
+    if (argc > 1 && strcmp(argv[1], "migrate") == 0) {
+        return ottsr_migrate_main(argc - 1, argv + 1);
+    }
+    if (argc > 1 && strcmp(argv[1], "aggregate") == 0) {
+        return ottsr_aggregate_main(argc - 1, argv + 1);
+    }
+    
+    app = gtk_application_new("com.github.g-flame.ottsr", G_APPLICATION_FLAGS_NONE);
+    g_signal_connect(app, "activate", G_CALLBACK(ottsr_activate), &g_app);
+    
+    status = g_application_run(G_APPLICATION(app), argc, argv);
+    
+    ottsr_cleanup_app(&g_app);
+    g_object_unref(app);
+    
+    return status;
+}
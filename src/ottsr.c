@@ -1,27 +1,92 @@
 #include "ottsr.h"
 #include <stddef.h>
 
-static ottsr_app_t g_app = {0};
-
 // Forward declarations
-static void ottsr_activate(GtkApplication *app, gpointer user_data);
+static void ottsr_on_phase_due(const ottsr_clock_event_t *event, gpointer user_data);
 
 // Application startup
-static void ottsr_activate(GtkApplication *app, gpointer user_data) {
+void ottsr_activate(GtkApplication *app, gpointer user_data) {
     ottsr_app_t *ottsr_app = (ottsr_app_t *)user_data;
-    ottsr_app->app = app;
     
+    // Initialising clears the whole struct, so the application is set after
     ottsr_init_app(ottsr_app);
+    ottsr_app->app = app;
+    ottsr_app->clock = ottsr_clock_new(ottsr_on_phase_due, ottsr_app);
+    ottsr_hooks_start(ottsr_app);
+    ottsr_checkpoint_open(ottsr_app);
     ottsr_create_main_window(ottsr_app);
     
     if (ottsr_app->main_window) {
         gtk_widget_show_all(ottsr_app->main_window);
+        ottsr_checkpoint_recover(ottsr_app);
+        ottsr_http_start(ottsr_app);
+        ottsr_group_start(ottsr_app);
+        ottsr_config_monitor_start(ottsr_app);
+        ottsr_catalog_load_async(ottsr_app);
+        ottsr_subjects_load_async(ottsr_app);
+        ottsr_estimates_load_async(ottsr_app);
+        ottsr_tray_start(ottsr_app);
+        ottsr_archive_schedule(ottsr_app);
     }
 }
 
+// Built-in settings and profiles used when nothing has been saved yet
+void ottsr_config_set_defaults(ottsr_config_t *config) {
+    config->theme = OTTSR_THEME_LIGHT;
+    config->sound_volume = 70;
+    config->max_fps = OTTSR_DEFAULT_MAX_FPS;
+    config->minimize_to_tray = TRUE;
+    config->autostart_sessions = FALSE;
+    config->window_width = OTTSR_WINDOW_WIDTH;
+    config->window_height = OTTSR_WINDOW_HEIGHT;
+    config->http_port = 0;
+    strcpy(config->http_address, OTTSR_HTTP_DEFAULT_ADDRESS);
+    config->group_role = OTTSR_GROUP_NONE;
+    strcpy(config->group_name, OTTSR_GROUP_DEFAULT_NAME);
+    
+    // Create default profiles
+    strcpy(config->profiles[0].name, "Pomodoro");
+    config->profiles[0].study_minutes = 25;
+    config->profiles[0].break_minutes = 5;
+    config->profiles[0].long_break_minutes = 15;
+    config->profiles[0].sessions_until_long_break = 4;
+    config->profiles[0].sound_enabled = TRUE;
+    config->profiles[0].notifications_enabled = TRUE;
+    config->profiles[0].total_study_time = 0;
+    config->profiles[0].total_sessions = 0;
+    config->profiles[0].completed_sessions = 0;
+    
+    strcpy(config->profiles[1].name, "Deep Work");
+    config->profiles[1].study_minutes = 90;
+    config->profiles[1].break_minutes = 20;
+    config->profiles[1].long_break_minutes = 30;
+    config->profiles[1].sessions_until_long_break = 2;
+    config->profiles[1].sound_enabled = TRUE;
+    config->profiles[1].notifications_enabled = TRUE;
+    config->profiles[1].total_study_time = 0;
+    config->profiles[1].total_sessions = 0;
+    config->profiles[1].completed_sessions = 0;
+    
+    strcpy(config->profiles[2].name, "Short Sprint");
+    config->profiles[2].study_minutes = 15;
+    config->profiles[2].break_minutes = 3;
+    config->profiles[2].long_break_minutes = 10;
+    config->profiles[2].sessions_until_long_break = 3;
+    config->profiles[2].sound_enabled = TRUE;
+    config->profiles[2].notifications_enabled = TRUE;
+    config->profiles[2].total_study_time = 0;
+    config->profiles[2].total_sessions = 0;
+    config->profiles[2].completed_sessions = 0;
+    
+    config->profile_count = 3;
+    config->active_profile = 0;
+    strcpy(config->last_subject, "");
+}
+
 // Initialize application state
 void ottsr_init_app(ottsr_app_t *app) {
     memset(app, 0, sizeof(ottsr_app_t));
+    ottsr_kiosk_init(app);
     
     // Initialize session
     app->session.state = OTTSR_STATE_IDLE;
@@ -29,51 +94,7 @@ void ottsr_init_app(ottsr_app_t *app) {
     app->session.pause_duration = 0;
     app->session.is_long_break = FALSE;
     
-    // Initialize config with defaults
-    app->config.theme = OTTSR_THEME_LIGHT;
-    app->config.sound_volume = 70;
-    app->config.minimize_to_tray = TRUE;
-    app->config.autostart_sessions = FALSE;
-    app->config.window_width = OTTSR_WINDOW_WIDTH;
-    app->config.window_height = OTTSR_WINDOW_HEIGHT;
-    
-    // Create default profiles
-    strcpy(app->config.profiles[0].name, "Pomodoro");
-    app->config.profiles[0].study_minutes = 25;
-    app->config.profiles[0].break_minutes = 5;
-    app->config.profiles[0].long_break_minutes = 15;
-    app->config.profiles[0].sessions_until_long_break = 4;
-    app->config.profiles[0].sound_enabled = TRUE;
-    app->config.profiles[0].notifications_enabled = TRUE;
-    app->config.profiles[0].total_study_time = 0;
-    app->config.profiles[0].total_sessions = 0;
-    app->config.profiles[0].completed_sessions = 0;
-    
-    strcpy(app->config.profiles[1].name, "Deep Work");
-    app->config.profiles[1].study_minutes = 90;
-    app->config.profiles[1].break_minutes = 20;
-    app->config.profiles[1].long_break_minutes = 30;
-    app->config.profiles[1].sessions_until_long_break = 2;
-    app->config.profiles[1].sound_enabled = TRUE;
-    app->config.profiles[1].notifications_enabled = TRUE;
-    app->config.profiles[1].total_study_time = 0;
-    app->config.profiles[1].total_sessions = 0;
-    app->config.profiles[1].completed_sessions = 0;
-    
-    strcpy(app->config.profiles[2].name, "Short Sprint");
-    app->config.profiles[2].study_minutes = 15;
-    app->config.profiles[2].break_minutes = 3;
-    app->config.profiles[2].long_break_minutes = 10;
-    app->config.profiles[2].sessions_until_long_break = 3;
-    app->config.profiles[2].sound_enabled = TRUE;
-    app->config.profiles[2].notifications_enabled = TRUE;
-    app->config.profiles[2].total_study_time = 0;
-    app->config.profiles[2].total_sessions = 0;
-    app->config.profiles[2].completed_sessions = 0;
-    
-    app->config.profile_count = 3;
-    app->config.active_profile = 0;
-    strcpy(app->config.last_subject, "");
+    ottsr_config_set_defaults(&app->config);
     
     // Load saved config
     if (!ottsr_load_config(app)) {
@@ -83,34 +104,29 @@ void ottsr_init_app(ottsr_app_t *app) {
 
 // Get configuration directory path
 char* ottsr_get_config_path(void) {
+    // On a kiosk every student gets a directory under the kiosk root
+    char *kiosk_dir = ottsr_kiosk_dir();
+    if (kiosk_dir) return kiosk_dir;
+    
     const char* home = g_get_home_dir();
     if (!home) return NULL;
     
     return g_build_filename(home, OTTSR_CONFIG_DIR, NULL);
 }
 
-// Load configuration from JSON file
-gboolean ottsr_load_config(ottsr_app_t *app) {
-    char *config_dir = ottsr_get_config_path();
-    if (!config_dir) return FALSE;
-    
-    char *config_file = g_build_filename(config_dir, OTTSR_CONFIG_FILE, NULL);
-    
+// Decode settings.json contents on top of the values already in config
+gboolean ottsr_config_parse_json(ottsr_config_t *config, const char *data, gssize length) {
     GError *error = NULL;
     JsonParser *parser = json_parser_new();
     
-    if (!json_parser_load_from_file(parser, config_file, &error)) {
-        g_free(config_dir);
-        g_free(config_file);
+    if (!json_parser_load_from_data(parser, data, length, &error)) {
         g_object_unref(parser);
         if (error) g_error_free(error);
         return FALSE;
     }
     
     JsonNode *root = json_parser_get_root(parser);
-    if (!JSON_NODE_HOLDS_OBJECT(root)) {
-        g_free(config_dir);
-        g_free(config_file);
+    if (!root || !JSON_NODE_HOLDS_OBJECT(root)) {
         g_object_unref(parser);
         return FALSE;
     }
@@ -119,22 +135,57 @@ gboolean ottsr_load_config(ottsr_app_t *app) {
     
     // Load basic settings
     if (json_object_has_member(root_obj, "active_profile")) {
-        app->config.active_profile = json_object_get_int_member(root_obj, "active_profile");
+        config->active_profile = json_object_get_int_member(root_obj, "active_profile");
     }
     
     if (json_object_has_member(root_obj, "theme")) {
-        app->config.theme = json_object_get_int_member(root_obj, "theme");
+        config->theme = json_object_get_int_member(root_obj, "theme");
     }
     
     if (json_object_has_member(root_obj, "sound_volume")) {
-        app->config.sound_volume = json_object_get_int_member(root_obj, "sound_volume");
+        config->sound_volume = json_object_get_int_member(root_obj, "sound_volume");
+    }
+    
+    if (json_object_has_member(root_obj, "max_fps")) {
+        config->max_fps = json_object_get_int_member(root_obj, "max_fps");
+    }
+    
+    if (json_object_has_member(root_obj, "http_port")) {
+        config->http_port = json_object_get_int_member(root_obj, "http_port");
+    }
+    
+    if (json_object_has_member(root_obj, "http_address")) {
+        const char* address = json_object_get_string_member(root_obj, "http_address");
+        if (address) {
+            strncpy(config->http_address, address, OTTSR_MAX_NAME_LEN - 1);
+            config->http_address[OTTSR_MAX_NAME_LEN - 1] = '\0';
+        }
+    }
+    
+    if (json_object_has_member(root_obj, "group_role")) {
+        const char* role = json_object_get_string_member(root_obj, "group_role");
+        if (g_strcmp0(role, "leader") == 0) {
+            config->group_role = OTTSR_GROUP_LEADER;
+        } else if (g_strcmp0(role, "follower") == 0) {
+            config->group_role = OTTSR_GROUP_FOLLOWER;
+        } else {
+            config->group_role = OTTSR_GROUP_NONE;
+        }
+    }
+    
+    if (json_object_has_member(root_obj, "group_name")) {
+        const char* name = json_object_get_string_member(root_obj, "group_name");
+        if (name && *name) {
+            strncpy(config->group_name, name, OTTSR_MAX_NAME_LEN - 1);
+            config->group_name[OTTSR_MAX_NAME_LEN - 1] = '\0';
+        }
     }
     
     if (json_object_has_member(root_obj, "last_subject")) {
         const char* subject = json_object_get_string_member(root_obj, "last_subject");
         if (subject) {
-            strncpy(app->config.last_subject, subject, OTTSR_MAX_NAME_LEN - 1);
-            app->config.last_subject[OTTSR_MAX_NAME_LEN - 1] = '\0';
+            strncpy(config->last_subject, subject, OTTSR_MAX_NAME_LEN - 1);
+            config->last_subject[OTTSR_MAX_NAME_LEN - 1] = '\0';
         }
     }
     
@@ -149,7 +200,7 @@ gboolean ottsr_load_config(ottsr_app_t *app) {
         
         for (guint i = 0; i < profile_count; i++) {
             JsonObject *profile_obj = json_array_get_object_element(profiles_array, i);
-            ottsr_profile_t *profile = &app->config.profiles[i];
+            ottsr_profile_t *profile = &config->profiles[i];
             
             const char *name = json_object_get_string_member(profile_obj, "name");
             if (name) {
@@ -168,47 +219,107 @@ gboolean ottsr_load_config(ottsr_app_t *app) {
             profile->completed_sessions = json_object_get_int_member(profile_obj, "completed_sessions");
         }
         
-        app->config.profile_count = profile_count;
+        config->profile_count = profile_count;
     }
     
-    g_free(config_dir);
-    g_free(config_file);
     g_object_unref(parser);
     return TRUE;
 }
 
-// Save configuration to JSON file
-gboolean ottsr_save_config(ottsr_app_t *app) {
-    char *config_dir = ottsr_get_config_path();
-    if (!config_dir) return FALSE;
+// Load one settings.json, preferring the binary snapshot when it is unchanged.
+// An unchanged mtime and size settle that without reading the file; after a
+// touch or a same-second write the contents are hashed before any parsing.
+gboolean ottsr_config_load_file(const char *config_file, ottsr_config_t *config) {
+    gint64 started = g_get_monotonic_time();
+    char *contents = NULL;
+    gsize length = 0;
+    GStatBuf st;
+    
+    if (g_stat(config_file, &st) != 0) return FALSE;
+    
+    if (ottsr_snapshot_load(config_file, &st, 0, config)) {
+        g_debug("Config loaded from snapshot in %.3f ms",
+                (g_get_monotonic_time() - started) / 1000.0);
+        return TRUE;
+    }
     
-    // Create config directory if it doesn't exist
-    g_mkdir_with_parents(config_dir, 0755);
+    if (!g_file_get_contents(config_file, &contents, &length, NULL)) return FALSE;
+    
+    // Never 0, which asks the snapshot for a stat match
+    guint64 source_hash = ottsr_hash_bytes(contents, length) | 1;
+    gboolean success = TRUE;
+    
+    if (ottsr_snapshot_load(config_file, &st, source_hash, config)) {
+        // Same contents under a new mtime; record it so the next start can skip the read
+        ottsr_snapshot_store(config_file, &st, source_hash, config);
+        g_debug("Config loaded from snapshot after a content check in %.3f ms",
+                (g_get_monotonic_time() - started) / 1000.0);
+    } else if (ottsr_config_parse_json(config, contents, length)) {
+        ottsr_snapshot_store(config_file, &st, source_hash, config);
+        g_debug("Config parsed from JSON in %.3f ms",
+                (g_get_monotonic_time() - started) / 1000.0);
+    } else {
+        success = FALSE;
+    }
     
-    char *config_file = g_build_filename(config_dir, OTTSR_CONFIG_FILE, NULL);
+    g_free(contents);
+    return success;
+}
+
+// Load configuration, importing a legacy ottsr.conf on first run
+gboolean ottsr_load_config(ottsr_app_t *app) {
+    char *config_file = ottsr_get_config_file();
+    if (!config_file) return FALSE;
     
+    if (!g_file_test(config_file, G_FILE_TEST_EXISTS)) {
+        ottsr_legacy_import(config_file);
+    }
+    
+    gboolean success = ottsr_config_load_file(config_file, &app->config);
+    g_free(config_file);
+    return success;
+}
+
+// Serialize configuration to settings.json contents
+char* ottsr_config_to_json(const ottsr_config_t *config, gsize *length) {
     JsonBuilder *builder = json_builder_new();
     json_builder_begin_object(builder);
     
     // Save basic settings
     json_builder_set_member_name(builder, "active_profile");
-    json_builder_add_int_value(builder, app->config.active_profile);
+    json_builder_add_int_value(builder, config->active_profile);
     
     json_builder_set_member_name(builder, "theme");
-    json_builder_add_int_value(builder, app->config.theme);
+    json_builder_add_int_value(builder, config->theme);
     
     json_builder_set_member_name(builder, "sound_volume");
-    json_builder_add_int_value(builder, app->config.sound_volume);
+    json_builder_add_int_value(builder, config->sound_volume);
+    
+    json_builder_set_member_name(builder, "max_fps");
+    json_builder_add_int_value(builder, config->max_fps);
+    
+    json_builder_set_member_name(builder, "http_port");
+    json_builder_add_int_value(builder, config->http_port);
+    
+    json_builder_set_member_name(builder, "http_address");
+    json_builder_add_string_value(builder, config->http_address);
+    
+    json_builder_set_member_name(builder, "group_role");
+    json_builder_add_string_value(builder, config->group_role == OTTSR_GROUP_LEADER ? "leader" :
+                                  config->group_role == OTTSR_GROUP_FOLLOWER ? "follower" : "none");
+    
+    json_builder_set_member_name(builder, "group_name");
+    json_builder_add_string_value(builder, config->group_name);
     
     json_builder_set_member_name(builder, "last_subject");
-    json_builder_add_string_value(builder, app->config.last_subject);
+    json_builder_add_string_value(builder, config->last_subject);
     
     // Save profiles
     json_builder_set_member_name(builder, "profiles");
     json_builder_begin_array(builder);
     
-    for (int i = 0; i < app->config.profile_count; i++) {
-        ottsr_profile_t *profile = &app->config.profiles[i];
+    for (int i = 0; i < config->profile_count; i++) {
+        const ottsr_profile_t *profile = &config->profiles[i];
         
         json_builder_begin_object(builder);
         
@@ -252,8 +363,45 @@ gboolean ottsr_save_config(ottsr_app_t *app) {
     JsonNode *root = json_builder_get_root(builder);
     json_generator_set_root(generator, root);
     
+    char *data = json_generator_to_data(generator, length);
+    
+    g_object_unref(builder);
+    g_object_unref(generator);
+    json_node_free(root);
+    
+    return data;
+}
+
+// Get settings.json path
+char* ottsr_get_config_file(void) {
+    char *config_dir = ottsr_get_config_path();
+    if (!config_dir) return NULL;
+    
+    char *config_file = g_build_filename(config_dir, OTTSR_CONFIG_FILE, NULL);
+    g_free(config_dir);
+    return config_file;
+}
+
+// Save configuration to JSON file
+gboolean ottsr_save_config(ottsr_app_t *app) {
+    if (app->kiosk) return ottsr_kiosk_save(app);
+    
+    char *config_dir = ottsr_get_config_path();
+    if (!config_dir) return FALSE;
+    
+    // Create config directory if it doesn't exist
+    g_mkdir_with_parents(config_dir, 0755);
+    
+    char *config_file = g_build_filename(config_dir, OTTSR_CONFIG_FILE, NULL);
+    
+    gsize length = 0;
+    char *data = ottsr_config_to_json(&app->config, &length);
+    
+    // Remember what we wrote so the file monitor can ignore our own saves
+    app->saved_config_hash = ottsr_hash_bytes(data, length);
+    
     GError *error = NULL;
-    gboolean success = json_generator_to_file(generator, config_file, &error);
+    gboolean success = g_file_set_contents(config_file, data, length, &error);
     
     if (!success && error) {
         g_warning("Failed to save config: %s", error->message);
@@ -262,15 +410,29 @@ gboolean ottsr_save_config(ottsr_app_t *app) {
     
     g_free(config_dir);
     g_free(config_file);
-    g_object_unref(builder);
-    g_object_unref(generator);
-    json_node_free(root);
+    g_free(data);
     
     return success;
 }
 
-// Format time display
-void ottsr_format_time(int seconds, char *buffer, size_t buffer_size) {
+
+// 64-bit FNV-1a, used to key caches on file contents
+guint64 ottsr_hash_bytes(const void *data, gsize length) {
+    const guchar *bytes = data;
+    guint64 hash = 14695981039346656037ull;
+    
+    for (gsize i = 0; i < length; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+// "MM:SS" / "H:MM:SS" for every second a phase can last, built once so the
+// per-second refresh formats nothing
+static char ottsr_time_table[OTTSR_TIME_TABLE_SECONDS + 1][8];
+
+static void ottsr_time_format(int seconds, char *buffer, size_t buffer_size) {
     int hours = seconds / 3600;
     int minutes = (seconds % 3600) / 60;
     int secs = seconds % 60;
@@ -282,138 +444,295 @@ void ottsr_format_time(int seconds, char *buffer, size_t buffer_size) {
     }
 }
 
-// Format statistics display
-void ottsr_format_stats(ottsr_app_t *app, char *buffer, size_t buffer_size) {
-    ottsr_profile_t *profile = &app->config.profiles[app->config.active_profile];
+// Shared, never freed; longer than the table allows only on the main thread
+const char *ottsr_time_text(int seconds) {
+    static gsize built = 0;
+    if (g_once_init_enter(&built)) {
+        for (int i = 0; i <= OTTSR_TIME_TABLE_SECONDS; i++) {
+            ottsr_time_format(i, ottsr_time_table[i], sizeof(ottsr_time_table[i]));
+        }
+        g_once_init_leave(&built, 1);
+    }
     
-    int hours = profile->total_study_time / 3600;
-    int minutes = (profile->total_study_time % 3600) / 60;
+    if (seconds < 0) seconds = 0;
+    if (seconds <= OTTSR_TIME_TABLE_SECONDS) return ottsr_time_table[seconds];
     
-    snprintf(buffer, buffer_size, 
-             "Sessions completed: %d | Total time: %dh %dm | Current session: %d",
-             profile->completed_sessions, hours, minutes, app->session.current_sessions);
+    static char beyond[32];
+    ottsr_time_format(seconds, beyond, sizeof(beyond));
+    return beyond;
 }
 
-// Update display elements
-void ottsr_update_display(ottsr_app_t *app) {
-    if (!app->timer_label || !app->status_label || !app->stats_label) return;
-    
+// Format time display
+void ottsr_format_time(int seconds, char *buffer, size_t buffer_size) {
+    if (seconds >= 0 && seconds <= OTTSR_TIME_TABLE_SECONDS) {
+        g_strlcpy(buffer, ottsr_time_text(seconds), buffer_size);
+    } else {
+        ottsr_time_format(seconds, buffer, buffer_size);
+    }
+}
+
+// Statistics line, rebuilt only when one of its numbers changes
+const char *ottsr_stats_text(ottsr_app_t *app) {
+    ottsr_profile_t *profile = &app->config.profiles[app->config.active_profile];
+    int minutes = (int)(profile->total_study_time / 60);
+    
+    if (app->stats_text[0] == '\0' ||
+        app->stats_completed != profile->completed_sessions ||
+        app->stats_minutes != minutes ||
+        app->stats_sessions != app->session.current_sessions) {
+        app->stats_completed = profile->completed_sessions;
+        app->stats_minutes = minutes;
+        app->stats_sessions = app->session.current_sessions;
+        snprintf(app->stats_text, sizeof(app->stats_text),
+                 "Sessions completed: %d | Total time: %dh %dm | Current session: %d",
+                 profile->completed_sessions, minutes / 60, minutes % 60,
+                 app->session.current_sessions);
+    }
+    return app->stats_text;
+}
+
+// GTK copies every string it is given, so only hand over what actually changed
+static void ottsr_label_update(GtkWidget *label, const char *text) {
+    if (strcmp(gtk_label_get_label(GTK_LABEL(label)), text) != 0) {
+        gtk_label_set_text(GTK_LABEL(label), text);
+    }
+}
+
+static void ottsr_progress_text_update(GtkWidget *bar, const char *text) {
+    if (g_strcmp0(gtk_progress_bar_get_text(GTK_PROGRESS_BAR(bar)), text) != 0) {
+        gtk_progress_bar_set_text(GTK_PROGRESS_BAR(bar), text);
+    }
+}
+
+// Status line for the session state, shared by every frontend
+const char *ottsr_status_text(ottsr_app_t *app) {
+    switch (app->session.state) {
+        case OTTSR_STATE_STUDYING:
+            return "Studying...";
+        case OTTSR_STATE_BREAKING:
+            return app->session.is_long_break ? "Long Break" : "Break";
+        case OTTSR_STATE_PAUSED:
+            return "Paused";
+        default:
+            return "Ready to start studying";
+    }
+}
+
+// Length in seconds of a study or break phase on profile, or the one a
+// study group's leader set for the session in progress
+int ottsr_phase_length(ottsr_app_t *app, const ottsr_profile_t *profile, gboolean breaking, gboolean is_long_break) {
+    const ottsr_session_t *session = &app->session;
+    
+    if (!breaking) {
+        return session->group_study_seconds > 0 ? session->group_study_seconds : profile->study_minutes * 60;
+    } else if (is_long_break) {
+        return session->group_long_break_seconds > 0 ? session->group_long_break_seconds :
+                                                       profile->long_break_minutes * 60;
+    }
+    return session->group_break_seconds > 0 ? session->group_break_seconds : profile->break_minutes * 60;
+}
+
+// Study phases between long breaks, likewise
+int ottsr_long_break_interval(ottsr_app_t *app, const ottsr_profile_t *profile) {
+    if (app->session.group_sessions_until_long_break > 0) return app->session.group_sessions_until_long_break;
+    return MAX(1, profile->sessions_until_long_break);
+}
+
+// Seconds left on the timer; when idle, the length of the next study phase
+int ottsr_remaining_time(ottsr_app_t *app) {
     ottsr_profile_t *profile = &app->config.profiles[app->config.active_profile];
-    
-    // Update timer display
-    char time_str[32];
-    int remaining_time = 0;
     
     if (app->session.state == OTTSR_STATE_STUDYING) {
-        remaining_time = profile->study_minutes * 60 - app->session.elapsed_study_seconds;
+        return ottsr_phase_length(app, profile, FALSE, FALSE) - app->session.elapsed_study_seconds;
     } else if (app->session.state == OTTSR_STATE_BREAKING) {
-        int break_duration = app->session.is_long_break ? 
-                           profile->long_break_minutes : profile->break_minutes;
-        remaining_time = break_duration * 60 - app->session.elapsed_break_seconds;
-    } else {
-        remaining_time = profile->study_minutes * 60;
+        return ottsr_phase_length(app, profile, TRUE, app->session.is_long_break) -
+               app->session.elapsed_break_seconds;
     }
+    return ottsr_phase_length(app, profile, FALSE, FALSE);
+}
+
+// Update display elements
+void ottsr_update_display(ottsr_app_t *app) {
+    ottsr_tui_update(app);
+    if (!app->timer_label || !app->status_label || !app->stats_label) return;
     
-    if (remaining_time < 0) remaining_time = 0;
-    ottsr_format_time(remaining_time, time_str, sizeof(time_str));
-    gtk_label_set_text(GTK_LABEL(app->timer_label), time_str);
+    // Update timer display
+    ottsr_label_update(app->timer_label, ottsr_time_text(ottsr_remaining_time(app)));
+    ottsr_label_update(app->status_label, ottsr_status_text(app));
     
-    // Update progress bars
+    // Update progress bars; the frame clock animates them between ticks
+    gint64 now = g_get_monotonic_time();
     if (app->session_progress) {
         double progress = 0.0;
         if (app->session.state == OTTSR_STATE_STUDYING) {
-            progress = (double)app->session.elapsed_study_seconds / (profile->study_minutes * 60);
+            progress = ottsr_phase_progress(app, now);
         }
         gtk_progress_bar_set_fraction(GTK_PROGRESS_BAR(app->session_progress), progress);
-        gtk_progress_bar_set_text(GTK_PROGRESS_BAR(app->session_progress), 
-                                 app->session.state == OTTSR_STATE_STUDYING ? "Studying..." : "");
+        ottsr_progress_text_update(app->session_progress,
+                                   app->session.state == OTTSR_STATE_STUDYING ? "Studying..." : "");
     }
     
     if (app->break_progress) {
         double progress = 0.0;
         if (app->session.state == OTTSR_STATE_BREAKING) {
-            int break_duration = app->session.is_long_break ? 
-                               profile->long_break_minutes : profile->break_minutes;
-            progress = (double)app->session.elapsed_break_seconds / (break_duration * 60);
+            progress = ottsr_phase_progress(app, now);
         }
         gtk_progress_bar_set_fraction(GTK_PROGRESS_BAR(app->break_progress), progress);
-        gtk_progress_bar_set_text(GTK_PROGRESS_BAR(app->break_progress), 
-                                 app->session.state == OTTSR_STATE_BREAKING ? "On break..." : "");
+        ottsr_progress_text_update(app->break_progress,
+                                   app->session.state == OTTSR_STATE_BREAKING ? "On break..." : "");
     }
     
     // Update stats
-    char stats_str[256];
-    ottsr_format_stats(app, stats_str, sizeof(stats_str));
-    gtk_label_set_text(GTK_LABEL(app->stats_label), stats_str);
+    ottsr_label_update(app->stats_label, ottsr_stats_text(app));
+}
+
+// Length in seconds of the phase the running session is in
+int ottsr_phase_duration(ottsr_app_t *app) {
+    ottsr_profile_t *profile = &app->config.profiles[app->session.profile_index];
     
-    // Update time spinners
-    if (app->study_time_spin && app->break_time_spin) {
-        gtk_spin_button_set_value(GTK_SPIN_BUTTON(app->study_time_spin), profile->study_minutes);
-        gtk_spin_button_set_value(GTK_SPIN_BUTTON(app->break_time_spin), profile->break_minutes);
+    return ottsr_phase_length(app, profile, app->session.state == OTTSR_STATE_BREAKING,
+                              app->session.is_long_break);
+}
+
+// Bring the elapsed seconds of the running phase up to date from its anchor
+void ottsr_session_sync(ottsr_app_t *app) {
+    int *elapsed;
+    if (app->session.state == OTTSR_STATE_STUDYING) {
+        elapsed = &app->session.elapsed_study_seconds;
+    } else if (app->session.state == OTTSR_STATE_BREAKING) {
+        elapsed = &app->session.elapsed_break_seconds;
+    } else {
+        return;
     }
+    
+    gint64 seconds = (g_get_monotonic_time() - app->phase_anchor) / G_USEC_PER_SEC;
+    *elapsed = (int)CLAMP(seconds, 0, ottsr_phase_duration(app));
 }
 
-// Timer callback for session management
-gboolean ottsr_timer_callback(gpointer user_data) {
-    ottsr_app_t *app = (ottsr_app_t *)user_data;
+// Time the current phase as if it began at anchor (monotonic)
+static void ottsr_phase_arm(ottsr_app_t *app, gint64 anchor) {
+    app->phase_anchor = anchor;
+    if (app->clock) {
+        ottsr_clock_arm(app->clock, anchor + (gint64)ottsr_phase_duration(app) * G_USEC_PER_SEC);
+    }
+}
+
+// Continue the current phase from the seconds already counted
+void ottsr_phase_resume(ottsr_app_t *app) {
+    int elapsed = app->session.state == OTTSR_STATE_STUDYING ?
+        app->session.elapsed_study_seconds : app->session.elapsed_break_seconds;
+    ottsr_phase_arm(app, g_get_monotonic_time() - (gint64)elapsed * G_USEC_PER_SEC);
+}
+
+// The phase length may have changed: keep its start, move its deadline
+void ottsr_phase_retime(ottsr_app_t *app) {
+    if (app->session.state == OTTSR_STATE_STUDYING || app->session.state == OTTSR_STATE_BREAKING) {
+        ottsr_phase_arm(app, app->phase_anchor);
+    }
+}
+
+// Tell everything that mirrors the session (tray, dashboard, study group)
+void ottsr_notify_state(ottsr_app_t *app) {
+    ottsr_tray_notify(app);
+    ottsr_http_update(app);
+    ottsr_group_announce(app);
+}
+
+// Put the running session into a phase that began at anchor without the
+// bookkeeping of finishing the current one; used to follow a group leader
+void ottsr_phase_enter(ottsr_app_t *app, ottsr_state_t state, gboolean is_long_break, gint64 anchor) {
+    gboolean changed = app->session.state != state || app->session.is_long_break != is_long_break;
+    
+    app->session.state = state;
+    app->session.is_long_break = is_long_break;
+    if (changed && state == OTTSR_STATE_BREAKING) {
+        app->session.break_start = time(NULL);
+    } else if (changed) {
+        app->session.session_start = time(NULL);
+        app->session.elapsed_study_seconds = 0;
+        app->session.recorded_study_seconds = 0;
+    }
+    ottsr_phase_arm(app, anchor);
+    ottsr_session_sync(app);
+    
+    if (changed) {
+        ottsr_checkpoint_write(app);
+        ottsr_notify_state(app);
+    }
+    ottsr_update_display(app);
+}
+
+// Finish the current phase at deadline and start the next one there, so
+// however late this runs the schedule does not move
+void ottsr_phase_advance(ottsr_app_t *app, gint64 deadline) {
     ottsr_profile_t *profile = &app->config.profiles[app->session.profile_index];
     
     if (app->session.state == OTTSR_STATE_STUDYING) {
-        app->session.elapsed_study_seconds++;
+        app->session.elapsed_study_seconds = ottsr_phase_length(app, profile, FALSE, FALSE);
+        ottsr_history_record_study(app, TRUE);
+        app->session.current_sessions++;
+        profile->completed_sessions++;
         
-        // Check if study session is complete
-        if (app->session.elapsed_study_seconds >= profile->study_minutes * 60) {
-            app->session.current_sessions++;
-            profile->completed_sessions++;
-            
-            // Determine if this should be a long break
-            app->session.is_long_break = 
-                (app->session.current_sessions % profile->sessions_until_long_break == 0);
-            
-            // Switch to break
-            app->session.state = OTTSR_STATE_BREAKING;
-            app->session.break_start = time(NULL);
-            app->session.elapsed_break_seconds = 0;
-            
-            const char *break_type = app->session.is_long_break ? "Long Break" : "Break";
-            gtk_label_set_text(GTK_LABEL(app->status_label), break_type);
-            
-            ottsr_show_notification(app, "Study Session Complete!", 
-                                  app->session.is_long_break ? "Time for a long break!" : "Time for a break!");
-            ottsr_play_notification_sound(app);
-        }
-    } else if (app->session.state == OTTSR_STATE_BREAKING) {
-        app->session.elapsed_break_seconds++;
+        // Determine if this should be a long break
+        app->session.is_long_break = 
+            (app->session.current_sessions % ottsr_long_break_interval(app, profile) == 0);
         
-        int break_duration = app->session.is_long_break ? 
-                           profile->long_break_minutes : profile->break_minutes;
+        // Switch to break
+        app->session.state = OTTSR_STATE_BREAKING;
+        app->session.break_start = time(NULL);
+        app->session.elapsed_break_seconds = 0;
+        ottsr_phase_arm(app, deadline);
         
-        // Check if break is complete
-        if (app->session.elapsed_break_seconds >= break_duration * 60) {
-            if (app->config.autostart_sessions) {
-                // Automatically start next session
-                app->session.state = OTTSR_STATE_STUDYING;
-                app->session.session_start = time(NULL);
-                app->session.elapsed_study_seconds = 0;
-                gtk_label_set_text(GTK_LABEL(app->status_label), "Studying...");
-                
-                ottsr_show_notification(app, "Break Complete!", "Back to studying!");
-                ottsr_play_notification_sound(app);
-            } else {
-                // Stop and wait for user to start next session
-                ottsr_stop_session(app);
-                ottsr_show_notification(app, "Break Complete!", "Ready for your next study session!");
-                ottsr_play_notification_sound(app);
-            }
+        ottsr_checkpoint_write(app);
+        ottsr_notify_state(app);
+        ottsr_hooks_fire(app, "study-end");
+        ottsr_hooks_fire(app, "break-start");
+        ottsr_show_notification(app, "Study Session Complete!", 
+                              app->session.is_long_break ? "Time for a long break!" : "Time for a break!");
+        ottsr_play_notification_sound(app);
+    } else if (app->session.state == OTTSR_STATE_BREAKING) {
+        ottsr_hooks_fire(app, "break-end");
+        
+        if (app->config.autostart_sessions) {
+            // Automatically start next session
+            app->session.state = OTTSR_STATE_STUDYING;
+            app->session.session_start = time(NULL);
+            app->session.elapsed_study_seconds = 0;
+            app->session.recorded_study_seconds = 0;
+            ottsr_phase_arm(app, deadline);
+            
+            ottsr_checkpoint_write(app);
+            ottsr_notify_state(app);
+            ottsr_hooks_fire(app, "study-start");
+            ottsr_show_notification(app, "Break Complete!", "Back to studying!");
+            ottsr_play_notification_sound(app);
+        } else {
+            // Stop and wait for user to start next session
+            ottsr_stop_session(app);
+            ottsr_show_notification(app, "Break Complete!", "Ready for your next study session!");
+            ottsr_play_notification_sound(app);
         }
     }
     
-    return G_SOURCE_CONTINUE;
+    ottsr_update_display(app);
 }
 
-// UI update callback
-gboolean ottsr_ui_update_callback(gpointer user_data) {
+// A phase deadline from the clock thread
+static void ottsr_on_phase_due(const ottsr_clock_event_t *event, gpointer user_data) {
+    ottsr_phase_advance((ottsr_app_t *)user_data, event->deadline);
+}
+
+// Once-a-second display refresh; transitions come from ottsr_on_phase_due
+gboolean ottsr_timer_callback(gpointer user_data) {
     ottsr_app_t *app = (ottsr_app_t *)user_data;
+    ottsr_session_sync(app);
+    
+    // Periodic checkpoint so a crash loses at most a few seconds
+    if (app->session.state != OTTSR_STATE_IDLE &&
+        time(NULL) - app->checkpoint.last_write >= OTTSR_CHECKPOINT_INTERVAL) {
+        ottsr_checkpoint_write(app);
+    }
+    
     ottsr_update_display(app);
     return G_SOURCE_CONTINUE;
 }
@@ -423,6 +742,12 @@ void ottsr_show_notification(ottsr_app_t *app, const char *title, const char *me
     ottsr_profile_t *profile = &app->config.profiles[app->session.profile_index];
     if (!profile->notifications_enabled) return;
     
+    // The terminal frontend has no application to notify through
+    if (!app->app) {
+        g_print("%s %s\n", title, message);
+        return;
+    }
+    
     GNotification *notification = g_notification_new(title);
     g_notification_set_body(notification, message);
     g_notification_set_priority(notification, G_NOTIFICATION_PRIORITY_NORMAL);
@@ -440,6 +765,32 @@ void ottsr_play_notification_sound(ottsr_app_t *app) {
     g_print("\a");
 }
 
+static void on_active_profile_notify(ottsr_property_t property, int profile, gpointer user_data) {
+    ottsr_app_t *app = user_data;
+
+    if (gtk_combo_box_get_active(GTK_COMBO_BOX(app->profile_combo)) != profile) {
+        g_signal_handlers_block_by_func(app->profile_combo, on_profile_changed, app);
+        gtk_combo_box_set_active(GTK_COMBO_BOX(app->profile_combo), profile);
+        g_signal_handlers_unblock_by_func(app->profile_combo, on_profile_changed, app);
+    }
+    ottsr_update_display(app);
+}
+
+static void on_profile_name_notify(ottsr_property_t property, int profile, gpointer user_data) {
+    ottsr_app_t *app = user_data;
+    GtkTreeModel *model = gtk_combo_box_get_model(GTK_COMBO_BOX(app->profile_combo));
+    GtkTreeIter iter;
+
+    if (gtk_tree_model_iter_nth_child(model, &iter, NULL, profile)) {
+        gtk_list_store_set(GTK_LIST_STORE(model), &iter, 0, app->config.profiles[profile].name, -1);
+    }
+}
+
+// The idle timer shows the study length; a running phase its own length
+static void on_phase_length_notify(ottsr_property_t property, int profile, gpointer user_data) {
+    ottsr_update_display(user_data);
+}
+
 // Create main window with modern design
 void ottsr_create_main_window(ottsr_app_t *app) {
     GError *error = NULL;
@@ -456,6 +807,9 @@ void ottsr_create_main_window(ottsr_app_t *app) {
                                app->config.window_width, 
                                app->config.window_height);
     gtk_window_set_resizable(GTK_WINDOW(app->main_window), FALSE);
+    ottsr_progress_attach(app);
+    g_signal_connect(app->main_window, "delete-event", G_CALLBACK(on_main_window_delete), app);
+    g_signal_connect(app->main_window, "window-state-event", G_CALLBACK(on_main_window_state), app);
     
     // Load CSS styling
     app->css_provider = gtk_css_provider_new();
@@ -487,6 +841,12 @@ void ottsr_create_main_window(ottsr_app_t *app) {
     gtk_style_context_add_class(gtk_widget_get_style_context(title_label), "timer-display");
     gtk_box_pack_start(GTK_BOX(header_box), title_label, FALSE, FALSE, 0);
     
+    // Student sign-in on shared kiosks
+    GtkWidget *kiosk_bar = ottsr_kiosk_create_bar(app);
+    if (kiosk_bar) {
+        gtk_box_pack_start(GTK_BOX(container), kiosk_bar, FALSE, FALSE, 0);
+    }
+    
     // Profile selection
     GtkWidget *profile_box = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 10);
     gtk_box_pack_start(GTK_BOX(container), profile_box, FALSE, FALSE, 0);
@@ -509,6 +869,9 @@ void ottsr_create_main_window(ottsr_app_t *app) {
     g_signal_connect(profiles_btn, "clicked", G_CALLBACK(on_profiles_clicked), app);
     gtk_box_pack_start(GTK_BOX(profile_box), profiles_btn, FALSE, FALSE, 0);
     
+    // Catalog search
+    gtk_box_pack_start(GTK_BOX(container), ottsr_catalog_create_entry(app), FALSE, FALSE, 0);
+    
     // Subject entry
     GtkWidget *subject_box = gtk_box_new(GTK_ORIENTATION_VERTICAL, 5);
     gtk_box_pack_start(GTK_BOX(container), subject_box, FALSE, FALSE, 0);
@@ -521,9 +884,16 @@ void ottsr_create_main_window(ottsr_app_t *app) {
     gtk_style_context_add_class(gtk_widget_get_style_context(app->subject_entry), "settings-entry");
     gtk_entry_set_placeholder_text(GTK_ENTRY(app->subject_entry), "Enter your subject here...");
     gtk_entry_set_text(GTK_ENTRY(app->subject_entry), app->config.last_subject);
+    ottsr_subjects_attach(app, app->subject_entry);
     g_signal_connect(app->subject_entry, "changed", G_CALLBACK(on_subject_changed), app);
     gtk_box_pack_start(GTK_BOX(subject_box), app->subject_entry, FALSE, FALSE, 0);
     
+    app->note_entry = gtk_entry_new();
+    gtk_style_context_add_class(gtk_widget_get_style_context(app->note_entry), "settings-entry");
+    gtk_entry_set_placeholder_text(GTK_ENTRY(app->note_entry), "Notes for this session (optional)");
+    gtk_entry_set_max_length(GTK_ENTRY(app->note_entry), OTTSR_NOTE_MAX_LEN);
+    gtk_box_pack_start(GTK_BOX(subject_box), app->note_entry, FALSE, FALSE, 0);
+    
     // Time settings
     GtkWidget *time_grid = gtk_grid_new();
     gtk_grid_set_row_spacing(GTK_GRID(time_grid), 10);
@@ -536,9 +906,7 @@ void ottsr_create_main_window(ottsr_app_t *app) {
     gtk_grid_attach(GTK_GRID(time_grid), study_label, 0, 0, 1, 1);
     
     app->study_time_spin = gtk_spin_button_new_with_range(1, 180, 1);
-    gtk_spin_button_set_value(GTK_SPIN_BUTTON(app->study_time_spin), 
-                             app->config.profiles[app->config.active_profile].study_minutes);
-    g_signal_connect(app->study_time_spin, "value-changed", G_CALLBACK(on_time_changed), app);
+    ottsr_model_bind(app, OTTSR_PROP_STUDY_MINUTES, OTTSR_PROFILE_ACTIVE, app->study_time_spin);
     gtk_grid_attach(GTK_GRID(time_grid), app->study_time_spin, 1, 0, 1, 1);
     
     // Break time
@@ -546,9 +914,7 @@ void ottsr_create_main_window(ottsr_app_t *app) {
     gtk_grid_attach(GTK_GRID(time_grid), break_label, 2, 0, 1, 1);
     
     app->break_time_spin = gtk_spin_button_new_with_range(1, 60, 1);
-    gtk_spin_button_set_value(GTK_SPIN_BUTTON(app->break_time_spin), 
-                             app->config.profiles[app->config.active_profile].break_minutes);
-    g_signal_connect(app->break_time_spin, "value-changed", G_CALLBACK(on_time_changed), app);
+    ottsr_model_bind(app, OTTSR_PROP_BREAK_MINUTES, OTTSR_PROFILE_ACTIVE, app->break_time_spin);
     gtk_grid_attach(GTK_GRID(time_grid), app->break_time_spin, 3, 0, 1, 1);
     
     // Timer display
@@ -627,20 +993,55 @@ void ottsr_create_main_window(ottsr_app_t *app) {
     g_signal_connect(settings_btn, "clicked", G_CALLBACK(on_settings_clicked), app);
     gtk_box_pack_start(GTK_BOX(bottom_box), settings_btn, FALSE, FALSE, 0);
     
+    GtkWidget *timeline_btn = gtk_button_new_with_label("Timeline");
+    gtk_style_context_add_class(gtk_widget_get_style_context(timeline_btn), "control-button");
+    g_signal_connect(timeline_btn, "clicked", G_CALLBACK(on_timeline_clicked), app);
+    gtk_box_pack_start(GTK_BOX(bottom_box), timeline_btn, FALSE, FALSE, 0);
+    
+    GtkWidget *search_btn = gtk_button_new_with_label("Search");
+    gtk_style_context_add_class(gtk_widget_get_style_context(search_btn), "control-button");
+    g_signal_connect(search_btn, "clicked", G_CALLBACK(on_search_clicked), app);
+    gtk_box_pack_start(GTK_BOX(bottom_box), search_btn, FALSE, FALSE, 0);
+    
     GtkWidget *about_btn = gtk_button_new_with_label("About");
     gtk_style_context_add_class(gtk_widget_get_style_context(about_btn), "control-button");
     g_signal_connect(about_btn, "clicked", G_CALLBACK(on_about_clicked), app);
     gtk_box_pack_start(GTK_BOX(bottom_box), about_btn, FALSE, FALSE, 0);
     
+    // The rest of the window follows the settings it shows
+    ottsr_model_connect(app, OTTSR_PROP_ACTIVE_PROFILE, 0, on_active_profile_notify, app, app->main_window);
+    ottsr_model_connect(app, OTTSR_PROP_PROFILE_NAME, OTTSR_PROFILE_ANY, on_profile_name_notify, app, app->main_window);
+    ottsr_model_connect(app, OTTSR_PROP_STUDY_MINUTES, OTTSR_PROFILE_ACTIVE, on_phase_length_notify, app, app->main_window);
+    ottsr_model_connect(app, OTTSR_PROP_BREAK_MINUTES, OTTSR_PROFILE_ACTIVE, on_phase_length_notify, app, app->main_window);
+    ottsr_model_connect(app, OTTSR_PROP_LONG_BREAK_MINUTES, OTTSR_PROFILE_ACTIVE, on_phase_length_notify, app, app->main_window);
+    
     // Initial display update
     ottsr_update_display(app);
 }
 
 // Session management
+// Buttons and editors that only make sense with or without a running session
+static void ottsr_controls_update(ottsr_app_t *app) {
+    if (!app->start_button) return;
+    
+    gboolean idle = app->session.state == OTTSR_STATE_IDLE;
+    gtk_widget_set_sensitive(app->start_button, idle);
+    gtk_widget_set_sensitive(app->pause_button, !idle);
+    gtk_widget_set_sensitive(app->stop_button, !idle);
+    gtk_widget_set_sensitive(app->profile_combo, idle);
+    gtk_widget_set_sensitive(app->catalog_entry, idle);
+    gtk_widget_set_sensitive(app->study_time_spin, idle);
+    gtk_widget_set_sensitive(app->break_time_spin, idle);
+    gtk_button_set_label(GTK_BUTTON(app->pause_button),
+                         app->session.state == OTTSR_STATE_PAUSED ? "Resume" : "Pause");
+}
+
 void ottsr_start_session(ottsr_app_t *app) {
     if (app->session.state != OTTSR_STATE_IDLE) return;
     
-    int profile_idx = gtk_combo_box_get_active(GTK_COMBO_BOX(app->profile_combo));
+    // Without the window (terminal frontend) the active profile and last subject apply
+    int profile_idx = app->profile_combo ?
+        gtk_combo_box_get_active(GTK_COMBO_BOX(app->profile_combo)) : app->config.active_profile;
     if (profile_idx < 0) profile_idx = 0;
     
     app->session.profile_index = profile_idx;
@@ -648,37 +1049,59 @@ void ottsr_start_session(ottsr_app_t *app) {
     app->session.session_start = time(NULL);
     app->session.elapsed_study_seconds = 0;
     app->session.elapsed_break_seconds = 0;
+    app->session.recorded_study_seconds = 0;
     app->session.pause_duration = 0;
     
-    const char *subject = gtk_entry_get_text(GTK_ENTRY(app->subject_entry));
+    char subject[OTTSR_MAX_NAME_LEN];
+    g_strlcpy(subject, app->subject_entry ? gtk_entry_get_text(GTK_ENTRY(app->subject_entry)) :
+              app->config.last_subject, sizeof(subject));
     strncpy(app->session.current_subject, subject, OTTSR_MAX_NAME_LEN - 1);
     app->session.current_subject[OTTSR_MAX_NAME_LEN - 1] = '\0';
     
     // Save subject for next time
     strncpy(app->config.last_subject, subject, OTTSR_MAX_NAME_LEN - 1);
     app->config.last_subject[OTTSR_MAX_NAME_LEN - 1] = '\0';
+    ottsr_subjects_record(app, app->session.current_subject);
     
     app->config.profiles[profile_idx].total_sessions++;
     
     // Start timers
+    ottsr_phase_resume(app);
     app->session_timer_id = g_timeout_add_seconds(1, ottsr_timer_callback, app);
-    app->ui_update_timer_id = g_timeout_add(100, ottsr_ui_update_callback, app);
+    ottsr_progress_start(app);
     
     // Update UI
-    gtk_widget_set_sensitive(app->start_button, FALSE);
-    gtk_widget_set_sensitive(app->pause_button, TRUE);
-    gtk_widget_set_sensitive(app->stop_button, TRUE);
-    gtk_widget_set_sensitive(app->profile_combo, FALSE);
-    gtk_widget_set_sensitive(app->study_time_spin, FALSE);
-    gtk_widget_set_sensitive(app->break_time_spin, FALSE);
-    gtk_label_set_text(GTK_LABEL(app->status_label), "Studying...");
+    ottsr_controls_update(app);
+    
+    ottsr_checkpoint_write(app);
+    ottsr_notify_state(app);
+    ottsr_hooks_fire(app, "study-start");
+    ottsr_update_display(app);
+}
+
+// Pick up a session whose state was restored from a checkpoint
+void ottsr_resume_session(ottsr_app_t *app) {
+    if (app->session.state == OTTSR_STATE_IDLE) return;
+    
+    if (app->profile_combo) {
+        gtk_combo_box_set_active(GTK_COMBO_BOX(app->profile_combo), app->session.profile_index);
+        gtk_entry_set_text(GTK_ENTRY(app->subject_entry), app->session.current_subject);
+    }
     
+    if (app->session.state != OTTSR_STATE_PAUSED) {
+        ottsr_phase_resume(app);
+        app->session_timer_id = g_timeout_add_seconds(1, ottsr_timer_callback, app);
+        ottsr_progress_start(app);
+    }
+    
+    ottsr_controls_update(app);
+    
+    ottsr_checkpoint_write(app);
     ottsr_update_display(app);
 }
 
 void ottsr_pause_session(ottsr_app_t *app) {
-    if (app->session.state != OTTSR_STATE_STUDYING && 
-        app->session.state != OTTSR_STATE_BREAKING) return;
+    if (app->session.state == OTTSR_STATE_IDLE) return;
     
     if (app->session.state == OTTSR_STATE_PAUSED) {
         // Resume session
@@ -686,36 +1109,33 @@ void ottsr_pause_session(ottsr_app_t *app) {
         
         if (app->session.elapsed_study_seconds > 0) {
             app->session.state = OTTSR_STATE_STUDYING;
-            gtk_label_set_text(GTK_LABEL(app->status_label), "Studying...");
         } else {
             app->session.state = OTTSR_STATE_BREAKING;
-            const char *break_type = app->session.is_long_break ? "Long Break" : "Break";
-            gtk_label_set_text(GTK_LABEL(app->status_label), break_type);
         }
         
-        gtk_button_set_label(GTK_BUTTON(app->pause_button), "Pause");
-        
         // Resume timers
+        ottsr_phase_resume(app);
         app->session_timer_id = g_timeout_add_seconds(1, ottsr_timer_callback, app);
-        app->ui_update_timer_id = g_timeout_add(100, ottsr_ui_update_callback, app);
+        ottsr_progress_start(app);
     } else {
         // Pause session
+        ottsr_session_sync(app);
+        if (app->clock) ottsr_clock_disarm(app->clock);
+        ottsr_hooks_fire(app, "pause");
         app->session.state = OTTSR_STATE_PAUSED;
         app->session.pause_start = time(NULL);
-        gtk_label_set_text(GTK_LABEL(app->status_label), "Paused");
-        gtk_button_set_label(GTK_BUTTON(app->pause_button), "Resume");
         
         // Stop timers
         if (app->session_timer_id > 0) {
             g_source_remove(app->session_timer_id);
             app->session_timer_id = 0;
         }
-        if (app->ui_update_timer_id > 0) {
-            g_source_remove(app->ui_update_timer_id);
-            app->ui_update_timer_id = 0;
-        }
+        ottsr_progress_stop(app);
     }
     
+    ottsr_controls_update(app);
+    ottsr_checkpoint_write(app);
+    ottsr_notify_state(app);
     ottsr_update_display(app);
 }
 
@@ -723,40 +1143,35 @@ void ottsr_stop_session(ottsr_app_t *app) {
     if (app->session.state == OTTSR_STATE_IDLE) return;
     
     // Stop timers
+    ottsr_session_sync(app);
+    if (app->clock) ottsr_clock_disarm(app->clock);
     if (app->session_timer_id > 0) {
         g_source_remove(app->session_timer_id);
         app->session_timer_id = 0;
     }
-    if (app->ui_update_timer_id > 0) {
-        g_source_remove(app->ui_update_timer_id);
-        app->ui_update_timer_id = 0;
-    }
+    ottsr_progress_stop(app);
     
     // Update statistics
     ottsr_profile_t *profile = &app->config.profiles[app->session.profile_index];
     profile->total_study_time += app->session.elapsed_study_seconds;
+    ottsr_history_record_study(app, FALSE);
+    ottsr_hooks_fire(app, "stop");
     
     // Reset state
     app->session.state = OTTSR_STATE_IDLE;
     app->session.current_sessions = 0;
     app->session.pause_duration = 0;
+    app->session.group_study_seconds = 0;
+    app->session.group_break_seconds = 0;
+    app->session.group_long_break_seconds = 0;
+    app->session.group_sessions_until_long_break = 0;
     
-    // Update UI
-    gtk_widget_set_sensitive(app->start_button, TRUE);
-    gtk_widget_set_sensitive(app->pause_button, FALSE);
-    gtk_widget_set_sensitive(app->stop_button, FALSE);
-    gtk_widget_set_sensitive(app->profile_combo, TRUE);
-    gtk_widget_set_sensitive(app->study_time_spin, TRUE);
-    gtk_widget_set_sensitive(app->break_time_spin, TRUE);
-    gtk_button_set_label(GTK_BUTTON(app->pause_button), "Pause");
-    gtk_label_set_text(GTK_LABEL(app->status_label), "Ready to start studying");
-    
-    gtk_progress_bar_set_fraction(GTK_PROGRESS_BAR(app->session_progress), 0.0);
-    gtk_progress_bar_set_fraction(GTK_PROGRESS_BAR(app->break_progress), 0.0);
-    gtk_progress_bar_set_text(GTK_PROGRESS_BAR(app->session_progress), "");
-    gtk_progress_bar_set_text(GTK_PROGRESS_BAR(app->break_progress), "");
+    // Update UI; the display refresh below empties the progress bars
+    ottsr_controls_update(app);
     
+    ottsr_checkpoint_clear(app);
     ottsr_save_config(app);
+    ottsr_notify_state(app);
     ottsr_update_display(app);
 }
 
@@ -773,6 +1188,10 @@ void ottsr_create_settings_window(ottsr_app_t *app) {
     gtk_window_set_transient_for(GTK_WINDOW(app->settings_window), 
                                 GTK_WINDOW(app->main_window));
     gtk_window_set_modal(GTK_WINDOW(app->settings_window), TRUE);
+    g_signal_connect(app->settings_window, "destroy", G_CALLBACK(on_settings_window_destroy), app);
+    
+    // Edits apply as they are made; closing without saving puts them back
+    app->settings_edits = ottsr_model_edits_new();
     
     GtkWidget *main_box = gtk_box_new(GTK_ORIENTATION_VERTICAL, 20);
     gtk_container_set_border_width(GTK_CONTAINER(main_box), 20);
@@ -791,7 +1210,7 @@ void ottsr_create_settings_window(ottsr_app_t *app) {
     gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(app->theme_combo), "Light");
     gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(app->theme_combo), "Dark");
     gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(app->theme_combo), "Auto");
-    gtk_combo_box_set_active(GTK_COMBO_BOX(app->theme_combo), app->config.theme);
+    ottsr_binding_track(ottsr_model_bind(app, OTTSR_PROP_THEME, 0, app->theme_combo), app->settings_edits);
     gtk_box_pack_start(GTK_BOX(theme_box), app->theme_combo, TRUE, TRUE, 0);
     
     // Sound settings
@@ -799,8 +1218,8 @@ void ottsr_create_settings_window(ottsr_app_t *app) {
     gtk_box_pack_start(GTK_BOX(main_box), sound_box, FALSE, FALSE, 0);
     
     app->sound_check = gtk_check_button_new_with_label("Enable notification sounds");
-    gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(app->sound_check), 
-                                app->config.profiles[app->config.active_profile].sound_enabled);
+    ottsr_binding_track(ottsr_model_bind(app, OTTSR_PROP_SOUND_ENABLED, OTTSR_PROFILE_ACTIVE, app->sound_check),
+                        app->settings_edits);
     gtk_box_pack_start(GTK_BOX(sound_box), app->sound_check, FALSE, FALSE, 0);
     
     // Volume setting
@@ -813,25 +1232,38 @@ void ottsr_create_settings_window(ottsr_app_t *app) {
     gtk_box_pack_start(GTK_BOX(volume_box), volume_label, FALSE, FALSE, 0);
     
     app->volume_scale = gtk_scale_new_with_range(GTK_ORIENTATION_HORIZONTAL, 0, 100, 5);
-    gtk_range_set_value(GTK_RANGE(app->volume_scale), app->config.sound_volume);
+    ottsr_binding_track(ottsr_model_bind(app, OTTSR_PROP_SOUND_VOLUME, 0, app->volume_scale), app->settings_edits);
     gtk_box_pack_start(GTK_BOX(volume_box), app->volume_scale, TRUE, TRUE, 0);
     
+    // Animation frame rate
+    GtkWidget *fps_box = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 10);
+    gtk_box_pack_start(GTK_BOX(main_box), fps_box, FALSE, FALSE, 0);
+    
+    GtkWidget *fps_label = gtk_label_new("Max FPS:");
+    gtk_widget_set_size_request(fps_label, 120, -1);
+    gtk_widget_set_halign(fps_label, GTK_ALIGN_START);
+    gtk_box_pack_start(GTK_BOX(fps_box), fps_label, FALSE, FALSE, 0);
+    
+    app->fps_spin = gtk_spin_button_new_with_range(1, 240, 1);
+    ottsr_binding_track(ottsr_model_bind(app, OTTSR_PROP_MAX_FPS, 0, app->fps_spin), app->settings_edits);
+    gtk_box_pack_start(GTK_BOX(fps_box), app->fps_spin, FALSE, FALSE, 0);
+    
     // Notification settings
     app->notifications_check = gtk_check_button_new_with_label("Enable desktop notifications");
-    gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(app->notifications_check), 
-                                app->config.profiles[app->config.active_profile].notifications_enabled);
+    ottsr_binding_track(ottsr_model_bind(app, OTTSR_PROP_NOTIFICATIONS_ENABLED, OTTSR_PROFILE_ACTIVE,
+                                         app->notifications_check), app->settings_edits);
     gtk_box_pack_start(GTK_BOX(main_box), app->notifications_check, FALSE, FALSE, 0);
     
     // Auto-start sessions
     app->autostart_check = gtk_check_button_new_with_label("Auto-start sessions after breaks");
-    gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(app->autostart_check), 
-                                app->config.autostart_sessions);
+    ottsr_binding_track(ottsr_model_bind(app, OTTSR_PROP_AUTOSTART_SESSIONS, 0, app->autostart_check),
+                        app->settings_edits);
     gtk_box_pack_start(GTK_BOX(main_box), app->autostart_check, FALSE, FALSE, 0);
     
     // Minimize to tray
     app->minimize_check = gtk_check_button_new_with_label("Minimize to system tray");
-    gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(app->minimize_check), 
-                                app->config.minimize_to_tray);
+    ottsr_binding_track(ottsr_model_bind(app, OTTSR_PROP_MINIMIZE_TO_TRAY, 0, app->minimize_check),
+                        app->settings_edits);
     gtk_box_pack_start(GTK_BOX(main_box), app->minimize_check, FALSE, FALSE, 0);
     
     // Buttons
@@ -853,6 +1285,16 @@ void ottsr_create_settings_window(ottsr_app_t *app) {
     gtk_widget_show_all(app->settings_window);
 }
 
+static void on_profile_row_name_notify(ottsr_property_t property, int profile, gpointer user_data) {
+    ottsr_app_t *app = user_data;
+    GtkListBoxRow *row = gtk_list_box_get_row_at_index(GTK_LIST_BOX(app->profile_list), profile);
+    GtkWidget *child = row ? gtk_bin_get_child(GTK_BIN(row)) : NULL;
+    
+    if (child && GTK_IS_LABEL(child)) {
+        gtk_label_set_text(GTK_LABEL(child), app->config.profiles[profile].name);
+    }
+}
+
 // Profile management window
 void ottsr_create_profiles_window(ottsr_app_t *app) {
     if (app->profiles_window) {
@@ -866,6 +1308,10 @@ void ottsr_create_profiles_window(ottsr_app_t *app) {
     gtk_window_set_transient_for(GTK_WINDOW(app->profiles_window), 
                                 GTK_WINDOW(app->main_window));
     gtk_window_set_modal(GTK_WINDOW(app->profiles_window), TRUE);
+    g_signal_connect(app->profiles_window, "destroy", G_CALLBACK(on_profiles_window_destroy), app);
+    
+    // Edits apply as they are made; Save Profile keeps them
+    app->profiles_edits = ottsr_model_edits_new();
     
     GtkWidget *main_box = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 20);
     gtk_container_set_border_width(GTK_CONTAINER(main_box), 20);
@@ -928,6 +1374,7 @@ void ottsr_create_profiles_window(ottsr_app_t *app) {
     gtk_box_pack_start(GTK_BOX(name_box), name_label, FALSE, FALSE, 0);
     
     app->profile_name_entry = gtk_entry_new();
+    app->profile_bindings[0] = ottsr_model_bind(app, OTTSR_PROP_PROFILE_NAME, 0, app->profile_name_entry);
     gtk_box_pack_start(GTK_BOX(name_box), app->profile_name_entry, TRUE, TRUE, 0);
     
     // Study time
@@ -940,6 +1387,7 @@ void ottsr_create_profiles_window(ottsr_app_t *app) {
     gtk_box_pack_start(GTK_BOX(study_box), study_label, FALSE, FALSE, 0);
     
     app->profile_study_spin = gtk_spin_button_new_with_range(1, 180, 1);
+    app->profile_bindings[1] = ottsr_model_bind(app, OTTSR_PROP_STUDY_MINUTES, 0, app->profile_study_spin);
     gtk_box_pack_start(GTK_BOX(study_box), app->profile_study_spin, TRUE, TRUE, 0);
     
     // Break time
@@ -952,6 +1400,7 @@ void ottsr_create_profiles_window(ottsr_app_t *app) {
     gtk_box_pack_start(GTK_BOX(break_box), break_label, FALSE, FALSE, 0);
     
     app->profile_break_spin = gtk_spin_button_new_with_range(1, 60, 1);
+    app->profile_bindings[2] = ottsr_model_bind(app, OTTSR_PROP_BREAK_MINUTES, 0, app->profile_break_spin);
     gtk_box_pack_start(GTK_BOX(break_box), app->profile_break_spin, TRUE, TRUE, 0);
     
     // Long break time
@@ -964,6 +1413,8 @@ void ottsr_create_profiles_window(ottsr_app_t *app) {
     gtk_box_pack_start(GTK_BOX(longbreak_box), longbreak_label, FALSE, FALSE, 0);
     
     app->profile_longbreak_spin = gtk_spin_button_new_with_range(5, 120, 1);
+    app->profile_bindings[3] = ottsr_model_bind(app, OTTSR_PROP_LONG_BREAK_MINUTES, 0,
+                                                app->profile_longbreak_spin);
     gtk_box_pack_start(GTK_BOX(longbreak_box), app->profile_longbreak_spin, TRUE, TRUE, 0);
     
     // Sessions until long break
@@ -976,7 +1427,27 @@ void ottsr_create_profiles_window(ottsr_app_t *app) {
     gtk_box_pack_start(GTK_BOX(sessions_box), sessions_label, FALSE, FALSE, 0);
     
     app->profile_sessions_spin = gtk_spin_button_new_with_range(1, 10, 1);
+    app->profile_bindings[4] = ottsr_model_bind(app, OTTSR_PROP_SESSIONS_UNTIL_LONG_BREAK, 0,
+                                                app->profile_sessions_spin);
     gtk_box_pack_start(GTK_BOX(sessions_box), app->profile_sessions_spin, TRUE, TRUE, 0);
+    for (guint i = 0; i < G_N_ELEMENTS(app->profile_bindings); i++) {
+        ottsr_binding_track(app->profile_bindings[i], app->profiles_edits);
+    }
+    
+    // Suggested study time from how past sessions ended
+    GtkWidget *suggestion_box = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 10);
+    gtk_box_pack_start(GTK_BOX(editor_box), suggestion_box, FALSE, FALSE, 0);
+    
+    app->profile_suggestion_label = gtk_label_new("");
+    gtk_label_set_line_wrap(GTK_LABEL(app->profile_suggestion_label), TRUE);
+    gtk_label_set_xalign(GTK_LABEL(app->profile_suggestion_label), 0.0);
+    gtk_box_pack_start(GTK_BOX(suggestion_box), app->profile_suggestion_label, TRUE, TRUE, 0);
+    
+    app->profile_suggestion_button = gtk_button_new_with_label("Use");
+    gtk_widget_set_valign(app->profile_suggestion_button, GTK_ALIGN_START);
+    gtk_widget_set_sensitive(app->profile_suggestion_button, FALSE);
+    g_signal_connect(app->profile_suggestion_button, "clicked", G_CALLBACK(on_profile_suggestion_clicked), app);
+    gtk_box_pack_start(GTK_BOX(suggestion_box), app->profile_suggestion_button, FALSE, FALSE, 0);
     
     // Buttons
     GtkWidget *button_box = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 10);
@@ -993,6 +1464,9 @@ void ottsr_create_profiles_window(ottsr_app_t *app) {
     g_signal_connect(save_btn, "clicked", G_CALLBACK(on_profile_save_clicked), app);
     gtk_box_pack_start(GTK_BOX(button_box), save_btn, FALSE, FALSE, 0);
     
+    ottsr_model_connect(app, OTTSR_PROP_PROFILE_NAME, OTTSR_PROFILE_ANY, on_profile_row_name_notify,
+                        app, app->profiles_window);
+    
     // Select first profile if available
     if (app->config.profile_count > 0) {
         GtkListBoxRow *first_row = gtk_list_box_get_row_at_index(GTK_LIST_BOX(app->profile_list), 0);
@@ -1011,14 +1485,45 @@ void ottsr_cleanup_app(ottsr_app_t *app) {
         g_source_remove(app->session_timer_id);
         app->session_timer_id = 0;
     }
-    if (app->ui_update_timer_id > 0) {
-        g_source_remove(app->ui_update_timer_id);
-        app->ui_update_timer_id = 0;
+    ottsr_progress_stop(app);
+    ottsr_clock_free(app->clock);
+    app->clock = NULL;
+    ottsr_hooks_stop(app);
+    ottsr_http_stop(app);
+    ottsr_group_stop(app);
+    
+    // Counts time spent in the tray up to now
+    ottsr_tray_stop(app);
+    
+    // Leave a running session checkpointed so the next launch picks it up
+    if (app->session.state != OTTSR_STATE_IDLE) {
+        ottsr_checkpoint_write(app);
     }
+    ottsr_checkpoint_close(app);
+    ottsr_config_monitor_stop(app);
+    ottsr_archive_cancel(app);
     
     // Save configuration
     ottsr_save_config(app);
     
+    ottsr_catalog_replace(app, NULL);
+    ottsr_subjects_clear(app);
+    if (app->pending_subjects) {
+        g_ptr_array_unref(app->pending_subjects);
+        app->pending_subjects = NULL;
+    }
+    ottsr_estimates_clear(app);
+    if (app->pending_estimates) {
+        g_array_unref(app->pending_estimates);
+        app->pending_estimates = NULL;
+    }
+    // After every write of this user's is queued; waits for them
+    ottsr_kiosk_stop(app);
+    ottsr_timeline_free(app->timeline);
+    app->timeline = NULL;
+    ottsr_search_clear(app);
+    ottsr_model_free(app);
+    
     // Clean up CSS provider
     if (app->css_provider) {
         g_object_unref(app->css_provider);
@@ -1028,11 +1533,7 @@ void ottsr_cleanup_app(ottsr_app_t *app) {
 
 // Callback implementations
 void on_profile_changed(GtkComboBox *combo, ottsr_app_t *app) {
-    int new_profile = gtk_combo_box_get_active(combo);
-    if (new_profile >= 0 && new_profile < app->config.profile_count) {
-        app->config.active_profile = new_profile;
-        ottsr_update_display(app);
-    }
+    ottsr_model_set(app, OTTSR_PROP_ACTIVE_PROFILE, 0, gtk_combo_box_get_active(combo));
 }
 
 void on_start_clicked(GtkButton *button, ottsr_app_t *app) {
@@ -1047,24 +1548,9 @@ void on_stop_clicked(GtkButton *button, ottsr_app_t *app) {
     ottsr_stop_session(app);
 }
 
-void on_time_changed(GtkSpinButton *spin, ottsr_app_t *app) {
-    if (app->session.state != OTTSR_STATE_IDLE) return;
-    
-    ottsr_profile_t *profile = &app->config.profiles[app->config.active_profile];
-    
-    if (spin == GTK_SPIN_BUTTON(app->study_time_spin)) {
-        profile->study_minutes = gtk_spin_button_get_value_as_int(spin);
-    } else if (spin == GTK_SPIN_BUTTON(app->break_time_spin)) {
-        profile->break_minutes = gtk_spin_button_get_value_as_int(spin);
-    }
-    
-    ottsr_update_display(app);
-}
-
 void on_subject_changed(GtkEntry *entry, ottsr_app_t *app) {
-    const char *text = gtk_entry_get_text(entry);
-    strncpy(app->config.last_subject, text, OTTSR_MAX_NAME_LEN - 1);
-    app->config.last_subject[OTTSR_MAX_NAME_LEN - 1] = '\0';
+    // last_subject is taken when a session starts, not on every keystroke
+    ottsr_subjects_update_completion(app, entry);
 }
 
 void on_settings_clicked(GtkButton *button, ottsr_app_t *app) {
@@ -1075,6 +1561,14 @@ void on_profiles_clicked(GtkButton *button, ottsr_app_t *app) {
     ottsr_create_profiles_window(app);
 }
 
+void on_timeline_clicked(GtkButton *button, ottsr_app_t *app) {
+    ottsr_create_timeline_window(app);
+}
+
+void on_search_clicked(GtkButton *button, ottsr_app_t *app) {
+    ottsr_create_search_window(app);
+}
+
 void on_about_clicked(GtkButton *button, ottsr_app_t *app) {
     GtkWidget *dialog = gtk_about_dialog_new();
     gtk_about_dialog_set_program_name(GTK_ABOUT_DIALOG(dialog), "Study Timer Pro");
@@ -1093,26 +1587,24 @@ void on_about_clicked(GtkButton *button, ottsr_app_t *app) {
 }
 
 // Settings callbacks
+// The bound widgets have already written the config; keep it
 void on_settings_save_clicked(GtkButton *button, ottsr_app_t *app) {
-    // Save settings
-    app->config.theme = gtk_combo_box_get_active(GTK_COMBO_BOX(app->theme_combo));
-    app->config.sound_volume = gtk_range_get_value(GTK_RANGE(app->volume_scale));
-    app->config.autostart_sessions = gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(app->autostart_check));
-    app->config.minimize_to_tray = gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(app->minimize_check));
-    
-    // Update current profile settings
-    ottsr_profile_t *profile = &app->config.profiles[app->config.active_profile];
-    profile->sound_enabled = gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(app->sound_check));
-    profile->notifications_enabled = gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(app->notifications_check));
-    
+    ottsr_model_edits_keep(app->settings_edits);
     ottsr_save_config(app);
     gtk_widget_destroy(app->settings_window);
-    app->settings_window = NULL;
 }
 
 void on_settings_cancel_clicked(GtkButton *button, ottsr_app_t *app) {
     gtk_widget_destroy(app->settings_window);
+}
+
+void on_settings_window_destroy(GtkWidget *widget, ottsr_app_t *app) {
     app->settings_window = NULL;
+    if (app->settings_edits) {
+        ottsr_model_restore(app, app->settings_edits);
+        ottsr_model_edits_free(app->settings_edits);
+        app->settings_edits = NULL;
+    }
 }
 
 // Profile callbacks
@@ -1158,6 +1650,9 @@ void on_profile_add_clicked(GtkButton *button, ottsr_app_t *app) {
     
     // Update main window combo box
     gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(app->profile_combo), new_profile->name);
+    
+    // Adding is not undone by closing the window, nor what came before it
+    ottsr_model_edits_keep(app->profiles_edits);
 }
 
 void on_profile_delete_clicked(GtkButton *button, ottsr_app_t *app) {
@@ -1189,6 +1684,9 @@ void on_profile_delete_clicked(GtkButton *button, ottsr_app_t *app) {
     
     if (response != GTK_RESPONSE_YES) return;
     
+    ottsr_config_t *before = g_new(ottsr_config_t, 1);
+    *before = app->config;
+    
     // Remove from array
     for (int i = index; i < app->config.profile_count - 1; i++) {
         app->config.profiles[i] = app->config.profiles[i + 1];
@@ -1211,9 +1709,13 @@ void on_profile_delete_clicked(GtkButton *button, ottsr_app_t *app) {
     }
     gtk_combo_box_set_active(GTK_COMBO_BOX(app->profile_combo), app->config.active_profile);
     
-    ottsr_update_display(app);
+    // Everything after the deleted slot moved up one
+    ottsr_model_changed(app, before);
+    g_free(before);
+    ottsr_model_edits_keep(app->profiles_edits);
 }
 
+// The bound editor has already written the profile; keep it
 void on_profile_save_clicked(GtkButton *button, ottsr_app_t *app) {
     GtkListBoxRow *selected = gtk_list_box_get_selected_row(GTK_LIST_BOX(app->profile_list));
     if (!selected) return;
@@ -1221,32 +1723,10 @@ void on_profile_save_clicked(GtkButton *button, ottsr_app_t *app) {
     int index = gtk_list_box_row_get_index(selected);
     ottsr_profile_t *profile = &app->config.profiles[index];
     
-    // Get values from widgets
-    const char *name = gtk_entry_get_text(GTK_ENTRY(app->profile_name_entry));
-    strncpy(profile->name, name, OTTSR_MAX_NAME_LEN - 1);
-    profile->name[OTTSR_MAX_NAME_LEN - 1] = '\0';
-    
-    profile->study_minutes = gtk_spin_button_get_value_as_int(GTK_SPIN_BUTTON(app->profile_study_spin));
-    profile->break_minutes = gtk_spin_button_get_value_as_int(GTK_SPIN_BUTTON(app->profile_break_spin));
-    profile->long_break_minutes = gtk_spin_button_get_value_as_int(GTK_SPIN_BUTTON(app->profile_longbreak_spin));
-    profile->sessions_until_long_break = gtk_spin_button_get_value_as_int(GTK_SPIN_BUTTON(app->profile_sessions_spin));
-    
-    // Update list display
-    GtkWidget *child = gtk_bin_get_child(GTK_BIN(selected));
-    if (GTK_IS_LABEL(child)) {
-        gtk_label_set_text(GTK_LABEL(child), profile->name);
-    }
-    
-    // Update main window combo box
-    gtk_combo_box_text_remove_all(GTK_COMBO_BOX_TEXT(app->profile_combo));
-    for (int i = 0; i < app->config.profile_count; i++) {
-        gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(app->profile_combo), 
-                                      app->config.profiles[i].name);
-    }
-    gtk_combo_box_set_active(GTK_COMBO_BOX(app->profile_combo), app->config.active_profile);
-    
+    // What is on disk now is what closing the window keeps
+    ottsr_model_edits_keep(app->profiles_edits);
     ottsr_save_config(app);
-    ottsr_update_display(app);
+    ottsr_estimates_show(app, profile);
     
     GtkWidget *dialog = gtk_message_dialog_new(GTK_WINDOW(app->profiles_window),
                                               GTK_DIALOG_MODAL,
@@ -1259,7 +1739,19 @@ void on_profile_save_clicked(GtkButton *button, ottsr_app_t *app) {
 
 void on_profile_cancel_clicked(GtkButton *button, ottsr_app_t *app) {
     gtk_widget_destroy(app->profiles_window);
+}
+
+// Profiles edited but not saved go back to how they were
+void on_profiles_window_destroy(GtkWidget *widget, ottsr_app_t *app) {
     app->profiles_window = NULL;
+    app->profile_list = NULL;
+    memset(app->profile_bindings, 0, sizeof(app->profile_bindings));
+    
+    if (app->profiles_edits) {
+        ottsr_model_restore(app, app->profiles_edits);
+        ottsr_model_edits_free(app->profiles_edits);
+        app->profiles_edits = NULL;
+    }
 }
 
 void on_profile_list_changed(GtkListBox *list, GtkListBoxRow *row, ottsr_app_t *app) {
@@ -1268,28 +1760,16 @@ void on_profile_list_changed(GtkListBox *list, GtkListBoxRow *row, ottsr_app_t *
     int index = gtk_list_box_row_get_index(row);
     if (index < 0 || index >= app->config.profile_count) return;
     
-    ottsr_profile_t *profile = &app->config.profiles[index];
-    
-    // Update editor widgets
-    gtk_entry_set_text(GTK_ENTRY(app->profile_name_entry), profile->name);
-    gtk_spin_button_set_value(GTK_SPIN_BUTTON(app->profile_study_spin), profile->study_minutes);
-    gtk_spin_button_set_value(GTK_SPIN_BUTTON(app->profile_break_spin), profile->break_minutes);
-    gtk_spin_button_set_value(GTK_SPIN_BUTTON(app->profile_longbreak_spin), profile->long_break_minutes);
-    gtk_spin_button_set_value(GTK_SPIN_BUTTON(app->profile_sessions_spin), profile->sessions_until_long_break);
+    // Point the editor at the selected profile
+    for (guint i = 0; i < G_N_ELEMENTS(app->profile_bindings); i++) {
+        if (app->profile_bindings[i]) ottsr_binding_set_profile(app->profile_bindings[i], index);
+    }
+    ottsr_estimates_show(app, &app->config.profiles[index]);
 }
 
-// Main function
-int main(int argc, char *argv[]) {
-    GtkApplication *app;
-    int status;
-    
-    app = gtk_application_new("com.github.g-flame.ottsr", G_APPLICATION_FLAGS_NONE);
-    g_signal_connect(app, "activate", G_CALLBACK(ottsr_activate), &g_app);
-    
-    status = g_application_run(G_APPLICATION(app), argc, argv);
-    
-    ottsr_cleanup_app(&g_app);
-    g_object_unref(app);
-    
-    return status;
+// Put the suggested length in the editor; Save Profile keeps it
+void on_profile_suggestion_clicked(GtkButton *button, ottsr_app_t *app) {
+    if (app->profile_suggested_minutes > 0) {
+        gtk_spin_button_set_value(GTK_SPIN_BUTTON(app->profile_study_spin), app->profile_suggested_minutes);
+    }
 }
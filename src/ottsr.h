@@ -10,15 +10,131 @@
 #include <string.h>
 #include <unistd.h>
 #include <sys/stat.h>
+#include <glib/gstdio.h>
 
 // Application Constants
 #define OTTSR_VERSION "2.0.0"
 #define OTTSR_CONFIG_DIR ".config/ottsr"
 #define OTTSR_CONFIG_FILE "settings.json"
+#define OTTSR_LEGACY_CONFIG_FILE "ottsr.conf"
 #define OTTSR_MAX_PROFILES 20
 #define OTTSR_MAX_NAME_LEN 128
 #define OTTSR_WINDOW_WIDTH 480
 #define OTTSR_WINDOW_HEIGHT 720
+#define OTTSR_DEFAULT_MAX_FPS 30
+#define OTTSR_TIME_TABLE_SECONDS (180 * 60)
+#define OTTSR_CLOCK_QUEUE_SIZE 64
+
+// Phase transition hooks
+#define OTTSR_HOOKS_DIR "hooks"
+#define OTTSR_HOOK_MAX_RUNNING 4
+#define OTTSR_HOOK_MAX_QUEUED 32
+#define OTTSR_HOOK_TIMEOUT 30
+
+// Dashboard status server
+#define OTTSR_HTTP_DEFAULT_ADDRESS "127.0.0.1"
+#define OTTSR_HTTP_REQUEST_MAX 4096
+#define OTTSR_HTTP_MAX_STREAMS 64
+#define OTTSR_HTTP_HEARTBEAT 15
+#define OTTSR_HTTP_TIMEOUT 10
+#define OTTSR_HTTP_BACKLOG 128
+
+// Study groups over LAN multicast
+#define OTTSR_GROUP_ADDRESS "239.255.77.77"
+#define OTTSR_GROUP_PORT 47777
+#define OTTSR_GROUP_DEFAULT_NAME "default"
+#define OTTSR_GROUP_MAGIC 0x4f544750u
+#define OTTSR_GROUP_VERSION 1
+#define OTTSR_GROUP_MESSAGE_SIZE 84
+#define OTTSR_GROUP_PROBES 8
+#define OTTSR_GROUP_RESYNC_PROBES 3
+#define OTTSR_GROUP_PROBE_MS 100
+#define OTTSR_GROUP_RETRY_MS 2000
+#define OTTSR_GROUP_REPEATS 3
+#define OTTSR_GROUP_REPEAT_MS 40
+
+// Shared kiosk mode
+#define OTTSR_KIOSK_ENV "OTTSR_KIOSK_DIR"
+#define OTTSR_KIOSK_GUEST "guest"
+#define OTTSR_KIOSK_MAX_USER 64
+#define OTTSR_KIOSK_CACHE_SIZE 16
+#define OTTSR_KIOSK_PREFETCH_THREADS 2
+
+// Session checkpointing
+#define OTTSR_CHECKPOINT_FILE "session.ckpt"
+#define OTTSR_CHECKPOINT_MAGIC 0x4f54434bu
+#define OTTSR_CHECKPOINT_VERSION 1
+#define OTTSR_CHECKPOINT_INTERVAL 5
+#define OTTSR_CHECKPOINT_RESUME_WINDOW 300
+
+// Parsed configuration snapshot cache
+#define OTTSR_CACHE_DIR "ottsr"
+#define OTTSR_SNAPSHOT_MAGIC 0x4f54534eu
+#define OTTSR_SNAPSHOT_VERSION 5
+
+// Live config reload
+#define OTTSR_RELOAD_DEBOUNCE_MS 500
+
+// Layered profile catalog
+#define OTTSR_CATALOG_SYSTEM_DIR "/etc/ottsr/profiles.d"
+#define OTTSR_CATALOG_SITE_ENV "OTTSR_SITE_PROFILES"
+#define OTTSR_CATALOG_USER_DIR "profiles.d"
+#define OTTSR_CATALOG_MAX_MATCHES 20
+#define OTTSR_CATALOG_FUZZY_BUDGET 4096
+
+// Subject history
+#define OTTSR_SUBJECTS_FILE "subjects.tsv"
+#define OTTSR_SUBJECT_TOP_K 8
+#define OTTSR_SUBJECT_INDEX_DEPTH 32
+#define OTTSR_SUBJECT_HALF_LIFE_DAYS 14.0
+#define OTTSR_SUBJECTS_REFRESH_DELAY 2
+
+// Session history
+#define OTTSR_HISTORY_FILE "history.dat"
+#define OTTSR_HISTORY_MAGIC 0x4f544853u
+#define OTTSR_HISTORY_VERSION 1
+
+// Session length recommendations
+#define OTTSR_ESTIMATES_FILE "estimates.dat"
+#define OTTSR_ESTIMATES_MAGIC 0x4f544553u
+#define OTTSR_ESTIMATES_VERSION 1
+#define OTTSR_ESTIMATE_MAX_ENTRIES 1024
+#define OTTSR_ESTIMATES_SAVE_DELAY 10
+#define OTTSR_ESTIMATE_QUANTILES 3
+#define OTTSR_ESTIMATE_MIN_SESSIONS 5
+#define OTTSR_ESTIMATE_MIN_SECONDS 60
+#define OTTSR_ESTIMATE_ALPHA 0.1
+#define OTTSR_ESTIMATE_TARGET 0.8
+#define OTTSR_ESTIMATE_STRETCH 0.95
+#define OTTSR_ESTIMATE_STEP 5
+
+// Cold history archive
+#define OTTSR_HISTORY_RETENTION_DAYS 90
+#define OTTSR_ARCHIVE_FILE "history.archive"
+#define OTTSR_ARCHIVE_MAGIC 0x4f544143u
+#define OTTSR_ARCHIVE_BATCH 256
+#define OTTSR_ARCHIVE_DELAY 30
+#define OTTSR_ROLLUP_FILE "history.rollup"
+#define OTTSR_ROLLUP_MAGIC 0x4f54524cu
+#define OTTSR_ROLLUP_VERSION 1
+
+// Session notes and search
+#define OTTSR_NOTES_FILE "notes.dat"
+#define OTTSR_NOTES_MAGIC 0x4f544e54u
+#define OTTSR_NOTES_VERSION 1
+#define OTTSR_NOTE_MAX_LEN 1024
+#define OTTSR_SEARCH_LIMIT 50
+
+// Calendar planning: the study day in minutes after midnight
+#define OTTSR_PLAN_DAY_START (8 * 60)
+#define OTTSR_PLAN_DAY_END (22 * 60)
+#define OTTSR_PLAN_MIN_STUDY 10
+
+// Study timeline
+#define OTTSR_TIMELINE_TILE_WIDTH 256
+#define OTTSR_TIMELINE_MAX_TILES 192
+#define OTTSR_TIMELINE_ZOOM_STEPS 12
+#define OTTSR_TIMELINE_DEFAULT_ZOOM 6
 
 // CSS for modern styling (removed problematic transform property)
 #define OTTSR_CSS_STYLE \
@@ -50,6 +166,26 @@ typedef enum {
     OTTSR_STATE_PAUSED
 } ottsr_state_t;
 
+typedef enum {
+    OTTSR_LAYER_SYSTEM,
+    OTTSR_LAYER_SITE,
+    OTTSR_LAYER_USER
+} ottsr_layer_t;
+
+// Timeline level of detail, coarsest last; SESSION draws raw history records
+typedef enum {
+    OTTSR_LOD_DAY,
+    OTTSR_LOD_WEEK,
+    OTTSR_LOD_MONTH,
+    OTTSR_LOD_SESSION
+} ottsr_lod_t;
+
+typedef enum {
+    OTTSR_GROUP_NONE,
+    OTTSR_GROUP_LEADER,
+    OTTSR_GROUP_FOLLOWER
+} ottsr_group_role_t;
+
 typedef enum {
     OTTSR_THEME_LIGHT,
     OTTSR_THEME_DARK,
@@ -78,9 +214,14 @@ typedef struct {
     gboolean minimize_to_tray;
     gboolean autostart_sessions;
     int sound_volume;
+    int max_fps;
     int window_width;
     int window_height;
     char last_subject[OTTSR_MAX_NAME_LEN];
+    int http_port;
+    char http_address[OTTSR_MAX_NAME_LEN];
+    ottsr_group_role_t group_role;
+    char group_name[OTTSR_MAX_NAME_LEN];
 } ottsr_config_t;
 
 typedef struct {
@@ -95,17 +236,278 @@ typedef struct {
     int profile_index;
     time_t pause_duration;
     gboolean is_long_break;
+    int recorded_study_seconds;
+    // A study group leader's phase lengths for this session only; 0 keeps
+    // the profile's. They are never saved.
+    int group_study_seconds;
+    int group_break_seconds;
+    int group_long_break_seconds;
+    int group_sessions_until_long_break;
 } ottsr_session_t;
 
+// One study phase in history.dat; fixed size so the file can be mapped
+typedef struct {
+    gint64 started_at;
+    gint32 study_seconds;
+    gint32 completed;
+    char profile[OTTSR_MAX_NAME_LEN];
+    char subject[OTTSR_MAX_NAME_LEN];
+} ottsr_history_record_t;
+
+// P-square running estimate of one quantile: five markers whose heights
+// converge on the quantile without keeping the observations
+typedef struct {
+    double p;
+    double heights[5];
+    double positions[5];
+    double desired[5];
+    guint32 count;
+} ottsr_quantile_t;
+
+// Online statistics for one profile, or one subject within it (subject
+// set); fixed size so estimates.dat is a plain array of these
+typedef struct {
+    char profile[OTTSR_MAX_NAME_LEN];
+    char subject[OTTSR_MAX_NAME_LEN];
+    guint32 sessions;
+    guint32 completed;
+    double completion;
+    guint32 stops;
+    double stop_mean;
+    double stop_m2;
+    ottsr_quantile_t stop_quantiles[OTTSR_ESTIMATE_QUANTILES];
+    gint64 updated_at;
+} ottsr_estimate_t;
+
+// One history record as the search window shows it
+typedef struct {
+    gint64 started_at;
+    gint32 study_seconds;
+    char *profile;
+    char *subject;
+    char *note;
+} ottsr_search_doc_t;
+
+// Inverted index over subjects and notes. Postings hold document ids in
+// ascending order; terms is the vocabulary sorted for prefix lookups.
+typedef struct {
+    GPtrArray *docs;
+    GHashTable *postings;
+    GPtrArray *terms;
+} ottsr_search_index_t;
+
+// Seconds studied per bucket for one level of detail
+typedef struct {
+    GArray *buckets;
+    guint32 max;
+} ottsr_timeline_level_t;
+
+// Day, week and month mipmaps over the history plus rendered tiles.
+// x = 0 is the Monday on or before the first recorded day.
+typedef struct {
+    GArray *records;
+    gint32 first_day;
+    gint32 first_month;
+    ottsr_timeline_level_t levels[3];
+    GHashTable *tiles;
+    int tile_height;
+    int zoom;
+    double origin;
+    gboolean placed;
+    double drag_x;
+    double drag_origin;
+    GtkWidget *area;
+} ottsr_timeline_t;
+
+// Study totals for one local day, profile and subject (ids into strings)
+typedef struct {
+    gint32 day;
+    guint32 profile;
+    guint32 subject;
+    guint32 seconds;
+    guint32 sessions;
+} ottsr_rollup_entry_t;
+
+// Summaries of everything moved to the archive, ordered by day
+typedef struct {
+    GArray *entries;
+    GPtrArray *strings;
+    GHashTable *ids;
+    guint32 archived_records;
+    gint64 archived_through;
+} ottsr_rollup_t;
+
+// A phase deadline reached on the timing thread; generation tells a
+// deadline that is still armed from one replaced since
+typedef struct {
+    guint64 generation;
+    gint64 deadline;
+    gint64 fired_at;
+} ottsr_clock_event_t;
+
+typedef struct ottsr_clock ottsr_clock_t;
+typedef struct ottsr_http_server ottsr_http_server_t;
+typedef struct ottsr_kiosk ottsr_kiosk_t;
+typedef struct ottsr_calendar ottsr_calendar_t;
+typedef struct ottsr_tui ottsr_tui_t;
+
+typedef enum {
+    OTTSR_PLAN_STUDY,
+    OTTSR_PLAN_BREAK,
+    OTTSR_PLAN_LONG_BREAK,
+    OTTSR_PLAN_BUSY,
+    OTTSR_PLAN_SKIPPED
+} ottsr_plan_kind_t;
+
+// One stretch of a planned day; shortened marks a block cut by a conflict
+typedef struct {
+    gint64 start;
+    gint64 end;
+    ottsr_plan_kind_t kind;
+    gboolean shortened;
+} ottsr_plan_block_t;
+
+// A group's phase as the leader announces it; anchor is on the monotonic
+// clock of whoever holds the struct, elapsed counts are for a paused phase
+typedef struct {
+    ottsr_state_t state;
+    gboolean is_long_break;
+    gint64 anchor;
+    int study_seconds;
+    int break_seconds;
+    int long_break_seconds;
+    int sessions_until_long_break;
+    int current_sessions;
+    int elapsed_study_seconds;
+    int elapsed_break_seconds;
+} ottsr_group_phase_t;
+
+typedef struct ottsr_group ottsr_group_t;
+typedef void (*ottsr_group_send_func_t)(const guint8 *data, gsize length, gpointer user_data);
+typedef gint64 (*ottsr_group_clock_func_t)(gpointer user_data);
+typedef void (*ottsr_group_phase_func_t)(const ottsr_group_phase_t *phase, gpointer user_data);
+typedef void (*ottsr_clock_func_t)(const ottsr_clock_event_t *event, gpointer user_data);
+
+// Observable config properties. Those from OTTSR_PROP_PROFILE_NAME on
+// belong to one profile, named by index or by the markers below.
+typedef enum {
+    OTTSR_PROP_ACTIVE_PROFILE,
+    OTTSR_PROP_THEME,
+    OTTSR_PROP_SOUND_VOLUME,
+    OTTSR_PROP_MAX_FPS,
+    OTTSR_PROP_AUTOSTART_SESSIONS,
+    OTTSR_PROP_MINIMIZE_TO_TRAY,
+    OTTSR_PROP_PROFILE_NAME,
+    OTTSR_PROP_STUDY_MINUTES,
+    OTTSR_PROP_BREAK_MINUTES,
+    OTTSR_PROP_LONG_BREAK_MINUTES,
+    OTTSR_PROP_SESSIONS_UNTIL_LONG_BREAK,
+    OTTSR_PROP_SOUND_ENABLED,
+    OTTSR_PROP_NOTIFICATIONS_ENABLED,
+    OTTSR_PROP_COUNT
+} ottsr_property_t;
+
+#define OTTSR_PROFILE_ACTIVE (-1)
+#define OTTSR_PROFILE_ANY (-2)
+
+typedef struct ottsr_binding ottsr_binding_t;
+typedef struct ottsr_model_edits ottsr_model_edits_t;
+typedef void (*ottsr_model_func_t)(ottsr_property_t property, int profile, gpointer user_data);
+
+typedef enum {
+    OTTSR_STATS_BY_SUBJECT,
+    OTTSR_STATS_BY_PROFILE,
+    OTTSR_STATS_BY_DAY
+} ottsr_stats_by_t;
+
+// One output row of `ottsr stats` / `ottsr aggregate`
+typedef struct {
+    char *label;
+    gint32 day;
+    guint64 seconds;
+    guint sessions;
+} ottsr_stats_row_t;
+
+// Catalog profile known only by file name until it is selected
+typedef struct {
+    char *name;
+    char *key;
+    char *path;
+    ottsr_layer_t layer;
+} ottsr_catalog_entry_t;
+
+typedef struct {
+    const char *key;
+    guint entry;
+} ottsr_catalog_word_t;
+
+typedef struct {
+    GPtrArray *entries;
+    GArray *words;
+} ottsr_catalog_t;
+
+typedef struct {
+    char *subject;
+    char *key;
+    guint32 count;
+    gint64 last_used;
+    double score;
+} ottsr_subject_t;
+
+// Trie node holding its own best completions, best first
+typedef struct {
+    guint32 first_child;
+    guint32 next_sibling;
+    guint32 top[OTTSR_SUBJECT_TOP_K];
+    guint8 byte;
+    guint8 top_count;
+} ottsr_trie_node_t;
+
+typedef struct {
+    GHashTable *by_subject;
+    GPtrArray *ranked;
+    GArray *nodes;
+} ottsr_subject_index_t;
+
+// One checkpoint slot; the file holds two and writes alternate between them
+// so a torn write never destroys the last good record.
+typedef struct {
+    guint32 magic;
+    guint32 version;
+    guint64 sequence;
+    gint64 written_at;
+    gint32 state;
+    gint32 profile_index;
+    gint32 elapsed_study_seconds;
+    gint32 elapsed_break_seconds;
+    gint32 current_sessions;
+    gint32 is_long_break;
+    char profile_name[OTTSR_MAX_NAME_LEN];
+    char subject[OTTSR_MAX_NAME_LEN];
+    guint32 checksum;
+    guint32 reserved;
+} ottsr_checkpoint_slot_t;
+
+typedef struct {
+    int fd;
+    ottsr_checkpoint_slot_t *slots;
+    guint64 sequence;
+    time_t last_write;
+} ottsr_checkpoint_t;
+
 typedef struct {
     GtkApplication *app;
     GtkWidget *main_window;
     GtkWidget *settings_window;
     GtkWidget *profiles_window;
+    GtkWidget *timeline_window;
+    GtkWidget *search_window;
     
     // Main window widgets
     GtkWidget *profile_combo;
+    GtkWidget *catalog_entry;
     GtkWidget *subject_entry;
+    GtkWidget *note_entry;
     GtkWidget *study_time_spin;
     GtkWidget *break_time_spin;
     GtkWidget *start_button;
@@ -124,6 +526,8 @@ typedef struct {
     GtkWidget *notifications_check;
     GtkWidget *minimize_check;
     GtkWidget *autostart_check;
+    GtkWidget *fps_spin;
+    ottsr_model_edits_t *settings_edits;
     
     // Profile widgets
     GtkWidget *profile_list;
@@ -132,38 +536,370 @@ typedef struct {
     GtkWidget *profile_break_spin;
     GtkWidget *profile_longbreak_spin;
     GtkWidget *profile_sessions_spin;
+    GtkWidget *profile_suggestion_label;
+    GtkWidget *profile_suggestion_button;
+    int profile_suggested_minutes;
+    ottsr_binding_t *profile_bindings[5];
+    ottsr_model_edits_t *profiles_edits;
+    
+    // Observable config
+    GArray *model_listeners;
+    guint model_next_id;
+    guint model_emitting;
     
     // Timers
     guint session_timer_id;
-    guint ui_update_timer_id;
+    guint progress_tick_id;
+    gint64 phase_anchor;
+    ottsr_clock_t *clock;
+    gint64 progress_last_frame;
+    
+    // Statistics line and the numbers it was built from
+    char stats_text[256];
+    int stats_completed;
+    int stats_minutes;
+    int stats_sessions;
+    
+    // Main window visibility
+    gboolean window_mapped;
+    gboolean window_iconified;
+    gboolean window_obscured;
     
     // State
     ottsr_config_t config;
     ottsr_session_t session;
+    ottsr_checkpoint_t checkpoint;
+    
+    // Live config reload
+    GFileMonitor *config_monitor;
+    guint config_reload_id;
+    guint64 saved_config_hash;
+    
+    // Profile catalog
+    ottsr_catalog_t *catalog;
+    GtkListStore *catalog_store;
+    
+    // Subject history
+    ottsr_subject_index_t *subjects;
+    GPtrArray *pending_subjects;
+    gboolean subjects_building;
+    guint subjects_refresh_id;
+    GtkListStore *subject_store;
+    guint32 subject_cursor;
+    char subject_prefix[OTTSR_MAX_NAME_LEN];
+    
+    // Session length estimates, keyed by profile and subject
+    GHashTable *estimates;
+    GArray *pending_estimates;
+    guint estimates_save_id;
+    
+    // Study timeline
+    ottsr_timeline_t *timeline;
+    
+    // History search
+    ottsr_search_index_t *search;
+    GPtrArray *pending_search;
+    gboolean search_building;
+    GtkWidget *search_entry;
+    GtkListStore *search_store;
+    GtkWidget *search_status;
+    
+    // History compaction
+    GCancellable *compaction_cancel;
+    guint compaction_id;
+    
+    // Transition hooks
+    GQueue *hook_queue;
+    guint hooks_running;
+    GCancellable *hooks_cancel;
+    
+    // Dashboard status server
+    ottsr_http_server_t *http;
+    
+    // Study group
+    ottsr_group_t *group;
+    GSocket *group_socket;
+    GSocketAddress *group_address;
+    GSource *group_source;
+    
+    // Shared kiosk; user_cancel stops background loads for the previous user
+    ottsr_kiosk_t *kiosk;
+    GCancellable *user_cancel;
+    
+    // Tray and background mode
+    GDBusConnection *tray_connection;
+    char *tray_name;
+    guint tray_owner_id;
+    guint tray_watch_id;
+    guint tray_object_id;
+    guint tray_tooltip_id;
+    gboolean tray_registered;
+    gboolean in_background;
+    int window_x;
+    int window_y;
+    gint64 mode_started_at;
+    gint64 mode_started_cpu;
+    
+    // Terminal frontend, instead of the main window
+    ottsr_tui_t *tui;
     
     // Styling
     GtkCssProvider *css_provider;
 } ottsr_app_t;
 
 // Function declarations
+void ottsr_activate(GtkApplication *app, gpointer user_data);
 void ottsr_init_app(ottsr_app_t *app);
 void ottsr_cleanup_app(ottsr_app_t *app);
 gboolean ottsr_load_config(ottsr_app_t *app);
+gboolean ottsr_config_load_file(const char *config_file, ottsr_config_t *config);
 gboolean ottsr_save_config(ottsr_app_t *app);
+gboolean ottsr_config_parse_json(ottsr_config_t *config, const char *data, gssize length);
+char* ottsr_config_to_json(const ottsr_config_t *config, gsize *length);
+void ottsr_config_set_defaults(ottsr_config_t *config);
 void ottsr_create_main_window(ottsr_app_t *app);
 void ottsr_create_settings_window(ottsr_app_t *app);
 void ottsr_create_profiles_window(ottsr_app_t *app);
 void ottsr_start_session(ottsr_app_t *app);
 void ottsr_stop_session(ottsr_app_t *app);
 void ottsr_pause_session(ottsr_app_t *app);
+void ottsr_resume_session(ottsr_app_t *app);
 void ottsr_update_display(ottsr_app_t *app);
 gboolean ottsr_timer_callback(gpointer user_data);
-gboolean ottsr_ui_update_callback(gpointer user_data);
 void ottsr_show_notification(ottsr_app_t *app, const char *title, const char *message);
 void ottsr_play_notification_sound(ottsr_app_t *app);
 void ottsr_format_time(int seconds, char *buffer, size_t buffer_size);
-void ottsr_format_stats(ottsr_app_t *app, char *buffer, size_t buffer_size);
+const char *ottsr_time_text(int seconds);
+const char *ottsr_stats_text(ottsr_app_t *app);
+const char *ottsr_status_text(ottsr_app_t *app);
+int ottsr_remaining_time(ottsr_app_t *app);
+int ottsr_phase_length(ottsr_app_t *app, const ottsr_profile_t *profile, gboolean breaking, gboolean is_long_break);
+int ottsr_long_break_interval(ottsr_app_t *app, const ottsr_profile_t *profile);
+int ottsr_phase_duration(ottsr_app_t *app);
+void ottsr_session_sync(ottsr_app_t *app);
+void ottsr_phase_resume(ottsr_app_t *app);
+void ottsr_phase_retime(ottsr_app_t *app);
+void ottsr_phase_enter(ottsr_app_t *app, ottsr_state_t state, gboolean is_long_break, gint64 anchor);
+void ottsr_phase_advance(ottsr_app_t *app, gint64 deadline);
+void ottsr_notify_state(ottsr_app_t *app);
 char* ottsr_get_config_path(void);
+char* ottsr_get_config_file(void);
+guint64 ottsr_hash_bytes(const void *data, gsize length);
+
+// Session checkpointing (ottsr_checkpoint.c)
+gboolean ottsr_checkpoint_open(ottsr_app_t *app);
+void ottsr_checkpoint_write(ottsr_app_t *app);
+void ottsr_checkpoint_clear(ottsr_app_t *app);
+void ottsr_checkpoint_close(ottsr_app_t *app);
+gboolean ottsr_checkpoint_recover(ottsr_app_t *app);
+
+// Config snapshot cache (ottsr_snapshot.c)
+gboolean ottsr_snapshot_load(const char *source_path, const GStatBuf *source_stat,
+                             guint64 source_hash, ottsr_config_t *config);
+void ottsr_snapshot_store(const char *source_path, const GStatBuf *source_stat,
+                          guint64 source_hash, const ottsr_config_t *config);
+
+// Live config reload (ottsr_reload.c)
+void ottsr_config_monitor_start(ottsr_app_t *app);
+void ottsr_config_monitor_stop(ottsr_app_t *app);
+void ottsr_config_apply(ottsr_app_t *app, const ottsr_config_t *incoming);
+void ottsr_config_replace(ottsr_app_t *app, const ottsr_config_t *incoming);
+
+// Layered profile catalog (ottsr_catalog.c)
+ottsr_catalog_t *ottsr_catalog_build(void);
+void ottsr_catalog_free(ottsr_catalog_t *catalog);
+guint ottsr_catalog_search(const ottsr_catalog_t *catalog, const char *query,
+                           ottsr_catalog_entry_t **results, guint max_results);
+gboolean ottsr_catalog_load_profile(const ottsr_catalog_entry_t *entry, ottsr_profile_t *profile);
+void ottsr_catalog_replace(ottsr_app_t *app, ottsr_catalog_t *catalog);
+void ottsr_catalog_load_async(ottsr_app_t *app);
+GtkWidget *ottsr_catalog_create_entry(ottsr_app_t *app);
+
+// Subject history (ottsr_subjects.c)
+ottsr_subject_index_t *ottsr_subject_index_build(GPtrArray *subjects);
+void ottsr_subject_index_free(ottsr_subject_index_t *index);
+void ottsr_subjects_load_async(ottsr_app_t *app);
+void ottsr_subjects_refresh(ottsr_app_t *app);
+void ottsr_subjects_clear(ottsr_app_t *app);
+void ottsr_subjects_record(ottsr_app_t *app, const char *text);
+guint ottsr_subjects_complete(ottsr_app_t *app, const char *text,
+                              const ottsr_subject_t **results, guint max_results);
+void ottsr_subjects_attach(ottsr_app_t *app, GtkWidget *entry);
+void ottsr_subjects_update_completion(ottsr_app_t *app, GtkEntry *entry);
+
+// Session history (ottsr_history.c)
+gboolean ottsr_history_append_at(const char *config_dir, const ottsr_history_record_t *record);
+gboolean ottsr_history_append(const ottsr_history_record_t *record);
+GArray *ottsr_history_read_file(const char *path, guint32 archived);
+GArray *ottsr_history_read(guint32 archived);
+GArray *ottsr_history_read_all(void);
+gboolean ottsr_history_compact_file(const char *path, guint32 archived);
+void ottsr_history_add(ottsr_app_t *app, const ottsr_history_record_t *record, const char *note);
+void ottsr_history_record_study(ottsr_app_t *app, gboolean completed);
+
+// Session length recommendations (ottsr_estimate.c)
+void ottsr_quantile_init(ottsr_quantile_t *quantile, double p);
+void ottsr_quantile_add(ottsr_quantile_t *quantile, double value);
+double ottsr_quantile_value(const ottsr_quantile_t *quantile);
+void ottsr_estimate_add(ottsr_estimate_t *estimate, double minutes, gboolean completed);
+int ottsr_estimate_recommend(const ottsr_estimate_t *estimate, int study_minutes);
+void ottsr_estimates_load_async(ottsr_app_t *app);
+void ottsr_estimates_clear(ottsr_app_t *app);
+void ottsr_estimates_record(ottsr_app_t *app, const ottsr_history_record_t *sample);
+const ottsr_estimate_t *ottsr_estimates_lookup(ottsr_app_t *app, const char *profile, const char *subject);
+void ottsr_estimates_show(ottsr_app_t *app, const ottsr_profile_t *profile);
+
+// Observable config (ottsr_model.c)
+int ottsr_model_get(ottsr_app_t *app, ottsr_property_t property, int profile);
+const char *ottsr_model_get_name(ottsr_app_t *app, int profile);
+gboolean ottsr_model_set(ottsr_app_t *app, ottsr_property_t property, int profile, int value);
+gboolean ottsr_model_set_name(ottsr_app_t *app, int profile, const char *name);
+void ottsr_model_changed(ottsr_app_t *app, const ottsr_config_t *before);
+ottsr_model_edits_t *ottsr_model_edits_new(void);
+void ottsr_model_edits_keep(ottsr_model_edits_t *edits);
+void ottsr_model_edits_free(ottsr_model_edits_t *edits);
+void ottsr_model_restore(ottsr_app_t *app, ottsr_model_edits_t *edits);
+guint ottsr_model_connect(ottsr_app_t *app, ottsr_property_t property, int profile,
+                          ottsr_model_func_t func, gpointer user_data, GtkWidget *owner);
+void ottsr_model_disconnect(ottsr_app_t *app, guint id);
+void ottsr_model_free(ottsr_app_t *app);
+ottsr_binding_t *ottsr_model_bind(ottsr_app_t *app, ottsr_property_t property, int profile, GtkWidget *widget);
+void ottsr_binding_set_profile(ottsr_binding_t *binding, int profile);
+void ottsr_binding_track(ottsr_binding_t *binding, ottsr_model_edits_t *edits);
+
+// Session notes and search (ottsr_notes.c)
+gboolean ottsr_notes_append_at(const char *config_dir, gint64 started_at, const char *note);
+gboolean ottsr_notes_append(gint64 started_at, const char *note);
+GHashTable *ottsr_notes_read_file(const char *path);
+GHashTable *ottsr_notes_read(void);
+ottsr_search_index_t *ottsr_search_index_build(GArray *records, GHashTable *notes);
+void ottsr_search_index_free(ottsr_search_index_t *index);
+void ottsr_search_index_add(ottsr_search_index_t *index, const ottsr_history_record_t *record, const char *note);
+void ottsr_search_load_async(ottsr_app_t *app);
+void ottsr_search_record(ottsr_app_t *app, const ottsr_history_record_t *record, const char *note);
+void ottsr_search_clear(ottsr_app_t *app);
+GPtrArray *ottsr_search_index_query(const ottsr_search_index_t *index, const char *query,
+                                    guint limit, guint *total);
+void ottsr_create_search_window(ottsr_app_t *app);
+int ottsr_search_main(int argc, char *argv[]);
+
+// Calendar planning (ottsr_plan.c)
+ottsr_calendar_t *ottsr_calendar_new(void);
+void ottsr_calendar_free(ottsr_calendar_t *calendar);
+gboolean ottsr_calendar_parse(ottsr_calendar_t *calendar, const char *data, gsize length);
+gboolean ottsr_calendar_load(ottsr_calendar_t *calendar, const char *path);
+void ottsr_calendar_index(ottsr_calendar_t *calendar);
+guint ottsr_calendar_event_count(const ottsr_calendar_t *calendar, guint *recurring);
+GArray *ottsr_calendar_busy(ottsr_calendar_t *calendar, gint64 from, gint64 to);
+GArray *ottsr_plan_layout(const ottsr_profile_t *profile, GArray *busy, gint64 from, gint64 to,
+                          int min_study_seconds);
+const char *ottsr_plan_kind_name(ottsr_plan_kind_t kind);
+gint64 ottsr_plan_to_unix(GTimeZone *tz, gint32 day, int seconds);
+int ottsr_plan_main(int argc, char *argv[]);
+
+// Study timeline (ottsr_timeline.c)
+ottsr_timeline_t *ottsr_timeline_build(GArray *records);
+void ottsr_timeline_free(ottsr_timeline_t *timeline);
+void ottsr_timeline_add(ottsr_timeline_t *timeline, const ottsr_history_record_t *record);
+void ottsr_create_timeline_window(ottsr_app_t *app);
+gint32 ottsr_local_day(gint64 timestamp, gint32 *month_index, int *seconds);
+gint32 ottsr_days_from_civil(int year, int month, int day);
+
+// Cold history archive (ottsr_archive.c)
+void ottsr_archive_read(GArray *records, guint32 archived_records);
+ottsr_rollup_t *ottsr_rollup_new(void);
+ottsr_rollup_t *ottsr_rollup_load_file(const char *path);
+ottsr_rollup_t *ottsr_rollup_load(void);
+void ottsr_rollup_free(ottsr_rollup_t *rollup);
+guint32 ottsr_rollup_string(ottsr_rollup_t *rollup, const char *text);
+void ottsr_rollup_add(ottsr_rollup_t *rollup, const ottsr_history_record_t *record);
+void ottsr_archive_schedule(ottsr_app_t *app);
+void ottsr_archive_cancel(ottsr_app_t *app);
+gboolean ottsr_archive_compact(guint *archived, gsize *raw_bytes, gsize *packed_bytes);
+
+// Command-line statistics (ottsr_stats.c)
+GHashTable *ottsr_stats_table_new(void);
+void ottsr_stats_count(GHashTable *rows, const char *label, gint32 day, guint64 seconds, guint sessions);
+const char *ottsr_stats_label(ottsr_stats_by_t by, const char *profile, const char *subject,
+                              gint32 day, char *buffer, size_t buffer_size);
+gboolean ottsr_stats_parse_by(const char *name, ottsr_stats_by_t *by);
+void ottsr_civil_from_days(gint32 days, int *year, int *month, int *day);
+void ottsr_stats_collect(GHashTable *table, ottsr_stats_by_t by, const ottsr_rollup_t *rollup, GArray *hot,
+                         gint32 first_day, gint32 last_day, gint64 from, gint64 to);
+void ottsr_stats_print(GHashTable *table, ottsr_stats_by_t by, gboolean json,
+                       const char *since, const char *until);
+int ottsr_stats_main(int argc, char *argv[]);
+
+// Legacy config migration (ottsr_migrate.c)
+gboolean ottsr_config_parse_legacy(ottsr_config_t *config, const char *data, gsize length);
+gboolean ottsr_legacy_import(const char *json_path);
+int ottsr_migrate_main(int argc, char *argv[]);
+
+// Multi-user aggregation (ottsr_aggregate.c)
+int ottsr_aggregate_main(int argc, char *argv[]);
+
+// Phase timing thread (ottsr_clock.c)
+ottsr_clock_t *ottsr_clock_new(ottsr_clock_func_t func, gpointer user_data);
+void ottsr_clock_arm(ottsr_clock_t *clock, gint64 deadline);
+void ottsr_clock_disarm(ottsr_clock_t *clock);
+void ottsr_clock_free(ottsr_clock_t *clock);
+
+// Transition hooks (ottsr_hooks.c)
+void ottsr_hooks_start(ottsr_app_t *app);
+void ottsr_hooks_stop(ottsr_app_t *app);
+void ottsr_hooks_fire(ottsr_app_t *app, const char *event);
+
+// Dashboard status server (ottsr_http.c)
+ottsr_http_server_t *ottsr_http_server_new(const char *address, int port);
+guint16 ottsr_http_server_get_port(ottsr_http_server_t *server);
+void ottsr_http_server_publish(ottsr_http_server_t *server, const char *json, gsize length);
+void ottsr_http_server_free(ottsr_http_server_t *server);
+void ottsr_http_start(ottsr_app_t *app);
+void ottsr_http_stop(ottsr_app_t *app);
+void ottsr_http_update(ottsr_app_t *app);
+
+// Study groups (ottsr_group.c)
+ottsr_group_t *ottsr_group_new(const char *name, gboolean leader, ottsr_group_send_func_t send,
+                               ottsr_group_clock_func_t clock, ottsr_group_phase_func_t follow,
+                               gpointer user_data);
+void ottsr_group_receive(ottsr_group_t *group, const guint8 *data, gsize length);
+void ottsr_group_publish(ottsr_group_t *group, const ottsr_group_phase_t *phase);
+void ottsr_group_join(ottsr_group_t *group);
+gboolean ottsr_group_get_offset(ottsr_group_t *group, gint64 *offset, gint64 *delay);
+void ottsr_group_free(ottsr_group_t *group);
+void ottsr_group_start(ottsr_app_t *app);
+void ottsr_group_stop(ottsr_app_t *app);
+void ottsr_group_announce(ottsr_app_t *app);
+
+// Shared kiosk mode (ottsr_kiosk.c)
+void ottsr_kiosk_init(ottsr_app_t *app);
+void ottsr_kiosk_stop(ottsr_app_t *app);
+char *ottsr_kiosk_dir(void);
+gboolean ottsr_kiosk_valid_user(const char *user);
+gboolean ottsr_kiosk_save(ottsr_app_t *app);
+void ottsr_kiosk_history_add(ottsr_app_t *app, const ottsr_history_record_t *record, const char *note);
+void ottsr_kiosk_write_file(ottsr_app_t *app, char *path, char *data, gsize length);
+gboolean ottsr_kiosk_switch(ottsr_app_t *app, const char *user);
+GtkWidget *ottsr_kiosk_create_bar(ottsr_app_t *app);
+
+// Frame-clock progress animation (ottsr_progress.c)
+double ottsr_phase_progress(ottsr_app_t *app, gint64 now);
+void ottsr_progress_attach(ottsr_app_t *app);
+void ottsr_progress_start(ottsr_app_t *app);
+void ottsr_progress_stop(ottsr_app_t *app);
+
+// Terminal frontend (ottsr_tui.c)
+void ottsr_tui_update(ottsr_app_t *app);
+int ottsr_tui_main(int argc, char *argv[]);
+
+// Tray and background mode (ottsr_tray.c)
+void ottsr_tray_start(ottsr_app_t *app);
+void ottsr_tray_stop(ottsr_app_t *app);
+void ottsr_tray_notify(ottsr_app_t *app);
+void ottsr_background_enter(ottsr_app_t *app);
+void ottsr_background_leave(ottsr_app_t *app);
+gboolean on_main_window_delete(GtkWidget *widget, GdkEvent *event, ottsr_app_t *app);
+gboolean on_main_window_state(GtkWidget *widget, GdkEventWindowState *event, ottsr_app_t *app);
 
 // Callback declarations
 void on_profile_changed(GtkComboBox *combo, ottsr_app_t *app);
@@ -173,12 +909,15 @@ void on_stop_clicked(GtkButton *button, ottsr_app_t *app);
 void on_settings_clicked(GtkButton *button, ottsr_app_t *app);
 void on_profiles_clicked(GtkButton *button, ottsr_app_t *app);
 void on_about_clicked(GtkButton *button, ottsr_app_t *app);
-void on_time_changed(GtkSpinButton *spin, ottsr_app_t *app);
+void on_timeline_clicked(GtkButton *button, ottsr_app_t *app);
+void on_search_clicked(GtkButton *button, ottsr_app_t *app);
 void on_subject_changed(GtkEntry *entry, ottsr_app_t *app);
+void on_catalog_search_changed(GtkEditable *editable, ottsr_app_t *app);
 
 // Settings callbacks
 void on_settings_save_clicked(GtkButton *button, ottsr_app_t *app);
 void on_settings_cancel_clicked(GtkButton *button, ottsr_app_t *app);
+void on_settings_window_destroy(GtkWidget *widget, ottsr_app_t *app);
 
 // Profile callbacks
 void on_profile_add_clicked(GtkButton *button, ottsr_app_t *app);
@@ -186,5 +925,7 @@ void on_profile_delete_clicked(GtkButton *button, ottsr_app_t *app);
 void on_profile_save_clicked(GtkButton *button, ottsr_app_t *app);
 void on_profile_cancel_clicked(GtkButton *button, ottsr_app_t *app);
 void on_profile_list_changed(GtkListBox *list, GtkListBoxRow *row, ottsr_app_t *app);
+void on_profile_suggestion_clicked(GtkButton *button, ottsr_app_t *app);
+void on_profiles_window_destroy(GtkWidget *widget, ottsr_app_t *app);
 
 #endif // OTTSR_H
@@ -0,0 +1,215 @@
+#include "ottsr.h"
+
+// Per-thread partial rollup; threads never share one, so no locking
+typedef struct {
+    GPtrArray *dirs;
+    gint *next;
+    ottsr_stats_by_t by;
+    GHashTable *rows;
+    guint with_history;
+    guint from_settings;
+    guint64 records;
+} ottsr_aggregate_worker_t;
+
+static gboolean ottsr_aggregate_is_data_dir(const char *dir) {
+    static const char *files[] = { OTTSR_HISTORY_FILE, OTTSR_ROLLUP_FILE, OTTSR_CONFIG_FILE };
+
+    for (guint i = 0; i < G_N_ELEMENTS(files); i++) {
+        char *path = g_build_filename(dir, files[i], NULL);
+        gboolean found = g_file_test(path, G_FILE_TEST_IS_REGULAR);
+        g_free(path);
+        if (found) return TRUE;
+    }
+    return FALSE;
+}
+
+// ROOT itself when it is an ottsr data directory, otherwise ROOT/*/.config/ottsr
+static void ottsr_aggregate_discover(const char *root, GPtrArray *dirs) {
+    if (ottsr_aggregate_is_data_dir(root)) {
+        g_ptr_array_add(dirs, g_strdup(root));
+        return;
+    }
+
+    GDir *dir = g_dir_open(root, 0, NULL);
+    if (!dir) {
+        g_printerr("ottsr aggregate: cannot open %s\n", root);
+        return;
+    }
+
+    const char *name;
+    while ((name = g_dir_read_name(dir)) != NULL) {
+        char *path = g_build_filename(root, name, OTTSR_CONFIG_DIR, NULL);
+        if (ottsr_aggregate_is_data_dir(path)) {
+            g_ptr_array_add(dirs, path);
+        } else {
+            g_free(path);
+        }
+    }
+    g_dir_close(dir);
+}
+
+// Lifetime profile totals from settings.json, less what history already
+// counted per profile (covered, keyed by profile name). That leaves the
+// study done before history was recorded, or all of it for a user with no
+// history. It has no date, so it is left out of --by day.
+static gboolean ottsr_aggregate_settings(ottsr_aggregate_worker_t *worker, const char *dir, GHashTable *covered) {
+    if (worker->by == OTTSR_STATS_BY_DAY) return FALSE;
+
+    char *path = g_build_filename(dir, OTTSR_CONFIG_FILE, NULL);
+    GMappedFile *mapped = g_mapped_file_new(path, FALSE, NULL);
+    g_free(path);
+    if (!mapped) return FALSE;
+
+    ottsr_config_t config;
+    memset(&config, 0, sizeof(config));
+
+    gboolean parsed = ottsr_config_parse_json(&config, g_mapped_file_get_contents(mapped),
+                                              g_mapped_file_get_length(mapped));
+    for (int i = 0; parsed && i < config.profile_count; i++) {
+        const ottsr_profile_t *profile = &config.profiles[i];
+        const ottsr_stats_row_t *seen = g_hash_table_lookup(covered, profile->name);
+        gint64 seconds = (gint64)profile->total_study_time - (seen ? (gint64)seen->seconds : 0);
+        gint64 sessions = (gint64)profile->total_sessions - (seen ? (gint64)seen->sessions : 0);
+        if (seconds <= 0) continue;
+
+        const char *label = worker->by == OTTSR_STATS_BY_PROFILE ? profile->name : "(none)";
+        ottsr_stats_count(worker->rows, label, 0, (guint64)seconds, (guint)MAX(0, sessions));
+    }
+    g_mapped_file_unref(mapped);
+    return parsed;
+}
+
+static void ottsr_aggregate_user(ottsr_aggregate_worker_t *worker, const char *dir) {
+    char *rollup_path = g_build_filename(dir, OTTSR_ROLLUP_FILE, NULL);
+    char *history_path = g_build_filename(dir, OTTSR_HISTORY_FILE, NULL);
+    ottsr_rollup_t *rollup = ottsr_rollup_load_file(rollup_path);
+    GArray *hot = ottsr_history_read_file(history_path, rollup->archived_records);
+
+    GHashTable *covered = ottsr_stats_table_new();
+    if (rollup->entries->len > 0 || hot->len > 0) {
+        ottsr_stats_collect(worker->rows, worker->by, rollup, hot,
+                            G_MININT32, G_MAXINT32, G_MININT64, G_MAXINT64);
+        ottsr_stats_collect(covered, OTTSR_STATS_BY_PROFILE, rollup, hot,
+                            G_MININT32, G_MAXINT32, G_MININT64, G_MAXINT64);
+        worker->with_history++;
+        worker->records += rollup->entries->len + hot->len;
+    }
+
+    // Profiles used before history existed keep their older study time
+    if (ottsr_aggregate_settings(worker, dir, covered) && g_hash_table_size(covered) == 0) {
+        worker->from_settings++;
+    }
+
+    g_hash_table_destroy(covered);
+    g_array_unref(hot);
+    ottsr_rollup_free(rollup);
+    g_free(history_path);
+    g_free(rollup_path);
+}
+
+// Threads claim the next directory from a shared cursor, so a thread that
+// lands on small homes simply takes more of them
+static gpointer ottsr_aggregate_thread(gpointer data) {
+    ottsr_aggregate_worker_t *worker = data;
+
+    for (;;) {
+        gint index = g_atomic_int_add(worker->next, 1);
+        if (index >= (gint)worker->dirs->len) break;
+        ottsr_aggregate_user(worker, g_ptr_array_index(worker->dirs, index));
+    }
+    return NULL;
+}
+
+// `ottsr aggregate DIR...`: study totals across many users' data directories
+int ottsr_aggregate_main(int argc, char *argv[]) {
+    int jobs = 0;
+    char *by_name = NULL;
+    gboolean json = FALSE;
+
+    GOptionEntry entries[] = {
+        { "jobs", 'j', 0, G_OPTION_ARG_INT, &jobs, "Worker threads (default: one per CPU)", "N" },
+        { "by", 'b', 0, G_OPTION_ARG_STRING, &by_name, "Group by profile (default), subject or day", "KEY" },
+        { "json", 0, 0, G_OPTION_ARG_NONE, &json, "Print JSON instead of a table", NULL },
+        { NULL }
+    };
+
+    GOptionContext *context = g_option_context_new("DIR... - total study time over DIR/*/" OTTSR_CONFIG_DIR);
+    g_option_context_add_main_entries(context, entries, NULL);
+
+    GError *error = NULL;
+    gboolean ok = g_option_context_parse(context, &argc, &argv, &error);
+    g_option_context_free(context);
+    if (!ok) {
+        g_printerr("ottsr aggregate: %s\n", error->message);
+        g_error_free(error);
+        return 1;
+    }
+
+    ottsr_stats_by_t by = OTTSR_STATS_BY_PROFILE;
+    ok = argc >= 2;
+    if (!ok) {
+        g_printerr("ottsr aggregate: no directory given\n");
+    } else if (by_name && !(ok = ottsr_stats_parse_by(by_name, &by))) {
+        g_printerr("ottsr aggregate: --by must be subject, profile or day\n");
+    }
+    g_free(by_name);
+    if (!ok) return 1;
+
+    gint64 start = g_get_monotonic_time();
+    GPtrArray *dirs = g_ptr_array_new_with_free_func(g_free);
+    for (int i = 1; i < argc; i++) {
+        ottsr_aggregate_discover(argv[i], dirs);
+    }
+
+    if (jobs <= 0) jobs = (int)g_get_num_processors();
+    jobs = MAX(1, MIN(jobs, (int)dirs->len));
+
+    gint next = 0;
+    ottsr_aggregate_worker_t *workers = g_new0(ottsr_aggregate_worker_t, jobs);
+    GThread **threads = g_new0(GThread *, jobs);
+
+    for (int i = 0; i < jobs; i++) {
+        workers[i].dirs = dirs;
+        workers[i].next = &next;
+        workers[i].by = by;
+        workers[i].rows = ottsr_stats_table_new();
+        threads[i] = g_thread_new("ottsr-aggregate", ottsr_aggregate_thread, &workers[i]);
+    }
+
+    // Merge the partial rollups once every thread is done
+    GHashTable *table = ottsr_stats_table_new();
+    guint with_history = 0, from_settings = 0;
+    guint64 records = 0;
+
+    for (int i = 0; i < jobs; i++) {
+        g_thread_join(threads[i]);
+
+        GHashTableIter iter;
+        gpointer value;
+        g_hash_table_iter_init(&iter, workers[i].rows);
+        while (g_hash_table_iter_next(&iter, NULL, &value)) {
+            const ottsr_stats_row_t *row = value;
+            ottsr_stats_count(table, row->label, row->day, row->seconds, row->sessions);
+        }
+
+        with_history += workers[i].with_history;
+        from_settings += workers[i].from_settings;
+        records += workers[i].records;
+        g_hash_table_destroy(workers[i].rows);
+    }
+
+    double seconds = (g_get_monotonic_time() - start) / (double)G_USEC_PER_SEC;
+    ottsr_stats_print(table, by, json, NULL, NULL);
+
+    // Keep stdout clean for --json
+    g_printerr("Aggregated %u users (%u from history, %u from settings only, %" G_GUINT64_FORMAT
+               " records) with %d threads in %.2f s (%.0f users/s)\n",
+               dirs->len, with_history, from_settings, records, jobs, seconds,
+               seconds > 0 ? dirs->len / seconds : 0.0);
+
+    g_hash_table_destroy(table);
+    g_free(threads);
+    g_free(workers);
+    g_ptr_array_unref(dirs);
+    return 0;
+}
@@ -0,0 +1,589 @@
+#include "ottsr.h"
+
+// Each compaction step appends one self-contained chunk:
+// this header followed by a zlib stream of the encoded records
+typedef struct {
+    guint32 magic;
+    guint32 count;
+    guint32 raw_size;
+    guint32 packed_size;
+    gint64 first_started_at;
+    gint64 last_started_at;
+} ottsr_archive_chunk_t;
+
+typedef struct {
+    guint32 magic;
+    guint32 version;
+    guint32 entry_count;
+    guint32 string_count;
+    guint32 strings_size;
+    guint32 archived_records;
+    gint64 archived_through;
+} ottsr_rollup_header_t;
+
+// A compaction run, owned by its worker thread. Paths are fixed when it
+// starts, so a kiosk user switch cannot redirect it.
+typedef struct {
+    char *archive_path;
+    char *rollup_path;
+    char *history_path;
+    guint archived;
+    gsize raw_bytes;
+    gsize packed_bytes;
+    gint64 busy_usec;
+    gboolean failed;
+} ottsr_compaction_t;
+
+static char *ottsr_archive_path(const char *name) {
+    char *config_dir = ottsr_get_config_path();
+    if (!config_dir) return NULL;
+
+    char *path = g_build_filename(config_dir, name, NULL);
+    g_free(config_dir);
+    return path;
+}
+
+static void ottsr_put_varint(GByteArray *out, guint64 value) {
+    while (value >= 0x80) {
+        guint8 byte = (value & 0x7f) | 0x80;
+        g_byte_array_append(out, &byte, 1);
+        value >>= 7;
+    }
+    guint8 byte = (guint8)value;
+    g_byte_array_append(out, &byte, 1);
+}
+
+static gboolean ottsr_get_varint(const guint8 **cursor, const guint8 *end, guint64 *value) {
+    guint64 result = 0;
+    for (int shift = 0; *cursor < end && shift < 64; shift += 7) {
+        guint8 byte = *(*cursor)++;
+        result |= (guint64)(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            *value = result;
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+// Zigzag so small negative deltas (clock adjustments) stay small
+static guint64 ottsr_zigzag(gint64 value) {
+    return ((guint64)value << 1) ^ (guint64)(value >> 63);
+}
+
+static gint64 ottsr_unzigzag(guint64 value) {
+    return (gint64)(value >> 1) ^ -(gint64)(value & 1);
+}
+
+// Run a whole buffer through a zlib (de)compressor
+static GByteArray *ottsr_zlib_convert(GConverter *converter, const guint8 *data, gsize length) {
+    GByteArray *out = g_byte_array_sized_new(length);
+    guint8 buffer[16384];
+    gsize consumed = 0;
+
+    for (;;) {
+        gsize bytes_read = 0, bytes_written = 0;
+        GError *error = NULL;
+        GConverterResult result = g_converter_convert(converter, data + consumed, length - consumed,
+                                                      buffer, sizeof(buffer), G_CONVERTER_INPUT_AT_END,
+                                                      &bytes_read, &bytes_written, &error);
+        if (result == G_CONVERTER_ERROR) {
+            g_warning("History archive: %s", error->message);
+            g_error_free(error);
+            g_byte_array_unref(out);
+            return NULL;
+        }
+
+        consumed += bytes_read;
+        g_byte_array_append(out, buffer, bytes_written);
+        if (result == G_CONVERTER_FINISHED) return out;
+    }
+}
+
+static guint32 ottsr_dictionary_id(GHashTable *ids, GPtrArray *dictionary, const char *text) {
+    gpointer id;
+    if (g_hash_table_lookup_extended(ids, text, NULL, &id)) return GPOINTER_TO_UINT(id);
+
+    guint32 next = dictionary->len;
+    g_ptr_array_add(dictionary, (gpointer)text);
+    g_hash_table_insert(ids, (gpointer)text, GUINT_TO_POINTER(next));
+    return next;
+}
+
+// Chunk payload: a string dictionary for profiles and subjects, then per
+// record the start delta, duration, profile id + completed bit, subject id
+static GByteArray *ottsr_archive_encode(const ottsr_history_record_t *records, guint count) {
+    GHashTable *ids = g_hash_table_new(g_str_hash, g_str_equal);
+    GPtrArray *dictionary = g_ptr_array_new();
+    guint32 *profile_ids = g_new(guint32, count);
+    guint32 *subject_ids = g_new(guint32, count);
+
+    for (guint i = 0; i < count; i++) {
+        profile_ids[i] = ottsr_dictionary_id(ids, dictionary, records[i].profile);
+        subject_ids[i] = ottsr_dictionary_id(ids, dictionary, records[i].subject);
+    }
+
+    GByteArray *raw = g_byte_array_new();
+    ottsr_put_varint(raw, dictionary->len);
+    for (guint i = 0; i < dictionary->len; i++) {
+        const char *text = g_ptr_array_index(dictionary, i);
+        gsize length = strlen(text);
+        ottsr_put_varint(raw, length);
+        g_byte_array_append(raw, (const guint8 *)text, length);
+    }
+
+    gint64 previous = records[0].started_at;
+    for (guint i = 0; i < count; i++) {
+        ottsr_put_varint(raw, ottsr_zigzag(records[i].started_at - previous));
+        ottsr_put_varint(raw, (guint32)records[i].study_seconds);
+        ottsr_put_varint(raw, ((guint64)profile_ids[i] << 1) | (records[i].completed ? 1 : 0));
+        ottsr_put_varint(raw, subject_ids[i]);
+        previous = records[i].started_at;
+    }
+
+    g_free(profile_ids);
+    g_free(subject_ids);
+    g_ptr_array_unref(dictionary);
+    g_hash_table_destroy(ids);
+    return raw;
+}
+
+static gboolean ottsr_archive_decode(const ottsr_archive_chunk_t *chunk, const guint8 *data, gsize length,
+                                     GArray *records) {
+    const guint8 *cursor = data;
+    const guint8 *end = data + length;
+    guint64 string_count = 0;
+    gboolean ok = ottsr_get_varint(&cursor, end, &string_count) && string_count <= length;
+
+    guint64 dictionary_size = ok ? string_count : 0;
+    char **dictionary = g_new0(char *, dictionary_size);
+    for (guint64 i = 0; ok && i < dictionary_size; i++) {
+        guint64 size = 0;
+        ok = ottsr_get_varint(&cursor, end, &size) && size <= (guint64)(end - cursor);
+        if (ok) {
+            dictionary[i] = g_strndup((const char *)cursor, size);
+            cursor += size;
+        }
+    }
+
+    gint64 started_at = chunk->first_started_at;
+    for (guint32 i = 0; ok && i < chunk->count; i++) {
+        guint64 delta, seconds, profile, subject;
+        ok = ottsr_get_varint(&cursor, end, &delta) && ottsr_get_varint(&cursor, end, &seconds) &&
+             ottsr_get_varint(&cursor, end, &profile) && ottsr_get_varint(&cursor, end, &subject) &&
+             (profile >> 1) < string_count && subject < string_count;
+        if (!ok) break;
+
+        ottsr_history_record_t record = {0};
+        started_at += ottsr_unzigzag(delta);
+        record.started_at = started_at;
+        record.study_seconds = (gint32)seconds;
+        record.completed = profile & 1;
+        g_strlcpy(record.profile, dictionary[profile >> 1], OTTSR_MAX_NAME_LEN);
+        g_strlcpy(record.subject, dictionary[subject], OTTSR_MAX_NAME_LEN);
+        g_array_append_val(records, record);
+    }
+
+    for (guint64 i = 0; i < dictionary_size; i++) {
+        g_free(dictionary[i]);
+    }
+    g_free(dictionary);
+    return ok;
+}
+
+// Walk the chunks holding the first archived_records records, decoding
+// them into records if given. Stops at a torn tail or at a chunk written by
+// a step that never committed its rollup. Returns the length of the valid
+// prefix.
+static gsize ottsr_archive_walk(const char *data, gsize length, guint32 archived_records, GArray *records) {
+    GConverter *inflater = records ? G_CONVERTER(g_zlib_decompressor_new(G_ZLIB_COMPRESSOR_FORMAT_ZLIB)) : NULL;
+    guint64 total = 0;
+    gsize offset = 0;
+
+    while (offset + sizeof(ottsr_archive_chunk_t) <= length) {
+        ottsr_archive_chunk_t chunk;
+        memcpy(&chunk, data + offset, sizeof(chunk));
+        const guint8 *packed = (const guint8 *)data + offset + sizeof(chunk);
+
+        if (chunk.magic != OTTSR_ARCHIVE_MAGIC || chunk.packed_size > length - offset - sizeof(chunk)) break;
+        if (chunk.count == 0 || total + chunk.count > archived_records) break;
+
+        if (records) {
+            g_converter_reset(inflater);
+            GByteArray *raw = ottsr_zlib_convert(inflater, packed, chunk.packed_size);
+            gboolean ok = raw && raw->len == chunk.raw_size &&
+                          ottsr_archive_decode(&chunk, raw->data, raw->len, records);
+            if (raw) g_byte_array_unref(raw);
+            if (!ok) {
+                g_warning("Damaged chunk in history archive; later sessions are skipped");
+                break;
+            }
+        }
+
+        total += chunk.count;
+        offset += sizeof(chunk) + chunk.packed_size;
+    }
+
+    if (inflater) g_object_unref(inflater);
+    return offset;
+}
+
+// Append every archived record to records
+void ottsr_archive_read(GArray *records, guint32 archived_records) {
+    char *path = ottsr_archive_path(OTTSR_ARCHIVE_FILE);
+    GMappedFile *mapped = path ? g_mapped_file_new(path, FALSE, NULL) : NULL;
+    g_free(path);
+    if (!mapped) return;
+
+    ottsr_archive_walk(g_mapped_file_get_contents(mapped), g_mapped_file_get_length(mapped),
+                       archived_records, records);
+    g_mapped_file_unref(mapped);
+}
+
+ottsr_rollup_t *ottsr_rollup_new(void) {
+    ottsr_rollup_t *rollup = g_new0(ottsr_rollup_t, 1);
+    rollup->entries = g_array_new(FALSE, FALSE, sizeof(ottsr_rollup_entry_t));
+    rollup->strings = g_ptr_array_new_with_free_func(g_free);
+    rollup->ids = g_hash_table_new(g_str_hash, g_str_equal);
+    rollup->archived_through = G_MININT64;
+    return rollup;
+}
+
+void ottsr_rollup_free(ottsr_rollup_t *rollup) {
+    if (!rollup) return;
+    g_array_unref(rollup->entries);
+    g_hash_table_destroy(rollup->ids);
+    g_ptr_array_unref(rollup->strings);
+    g_free(rollup);
+}
+
+guint32 ottsr_rollup_string(ottsr_rollup_t *rollup, const char *text) {
+    gpointer id;
+    if (g_hash_table_lookup_extended(rollup->ids, text, NULL, &id)) return GPOINTER_TO_UINT(id);
+
+    char *copy = g_strdup(text);
+    guint32 next = rollup->strings->len;
+    g_ptr_array_add(rollup->strings, copy);
+    g_hash_table_insert(rollup->ids, copy, GUINT_TO_POINTER(next));
+    return next;
+}
+
+// Daily totals per profile and subject; entries stay ordered by day
+void ottsr_rollup_add(ottsr_rollup_t *rollup, const ottsr_history_record_t *record) {
+    gint32 day = ottsr_local_day(record->started_at, NULL, NULL);
+    guint32 profile = ottsr_rollup_string(rollup, record->profile);
+    guint32 subject = ottsr_rollup_string(rollup, record->subject);
+
+    // Records arrive in time order, so the match is among the last day's entries
+    guint i = rollup->entries->len;
+    while (i > 0) {
+        ottsr_rollup_entry_t *entry = &g_array_index(rollup->entries, ottsr_rollup_entry_t, i - 1);
+        if (entry->day < day) break;
+        if (entry->day == day && entry->profile == profile && entry->subject == subject) {
+            entry->seconds += record->study_seconds;
+            entry->sessions++;
+            return;
+        }
+        i--;
+    }
+
+    ottsr_rollup_entry_t entry = { day, profile, subject, (guint32)record->study_seconds, 1 };
+    g_array_insert_val(rollup->entries, i, entry);
+}
+
+// An empty rollup when the file is missing or damaged
+ottsr_rollup_t *ottsr_rollup_load_file(const char *path) {
+    ottsr_rollup_t *rollup = ottsr_rollup_new();
+    GMappedFile *mapped = g_mapped_file_new(path, FALSE, NULL);
+    if (!mapped) return rollup;
+
+    gsize length = g_mapped_file_get_length(mapped);
+    const char *data = g_mapped_file_get_contents(mapped);
+    ottsr_rollup_header_t header;
+
+    if (length >= sizeof(header)) {
+        memcpy(&header, data, sizeof(header));
+        gsize entries_size = (gsize)header.entry_count * sizeof(ottsr_rollup_entry_t);
+
+        if (header.magic == OTTSR_ROLLUP_MAGIC && header.version == OTTSR_ROLLUP_VERSION &&
+            length == sizeof(header) + entries_size + header.strings_size) {
+            const char *strings = data + sizeof(header) + entries_size;
+            const char *end = strings + header.strings_size;
+
+            for (guint32 i = 0; i < header.string_count && strings < end; i++) {
+                gsize size = strnlen(strings, end - strings);
+                char *text = g_strndup(strings, size);
+                ottsr_rollup_string(rollup, text);
+                g_free(text);
+                strings += size + 1;
+            }
+
+            if (rollup->strings->len == header.string_count) {
+                g_array_append_vals(rollup->entries, data + sizeof(header), header.entry_count);
+                rollup->archived_records = header.archived_records;
+                rollup->archived_through = header.archived_through;
+            } else {
+                g_warning("Ignoring damaged history rollup");
+            }
+        }
+    }
+
+    g_mapped_file_unref(mapped);
+    return rollup;
+}
+
+ottsr_rollup_t *ottsr_rollup_load(void) {
+    char *path = ottsr_archive_path(OTTSR_ROLLUP_FILE);
+    if (!path) return ottsr_rollup_new();
+
+    ottsr_rollup_t *rollup = ottsr_rollup_load_file(path);
+    g_free(path);
+    return rollup;
+}
+
+static gboolean ottsr_rollup_save(const ottsr_rollup_t *rollup, const char *path) {
+    GByteArray *strings = g_byte_array_new();
+    for (guint i = 0; i < rollup->strings->len; i++) {
+        const char *text = g_ptr_array_index(rollup->strings, i);
+        g_byte_array_append(strings, (const guint8 *)text, strlen(text) + 1);
+    }
+
+    ottsr_rollup_header_t header = {0};
+    header.magic = OTTSR_ROLLUP_MAGIC;
+    header.version = OTTSR_ROLLUP_VERSION;
+    header.entry_count = rollup->entries->len;
+    header.string_count = rollup->strings->len;
+    header.strings_size = strings->len;
+    header.archived_records = rollup->archived_records;
+    header.archived_through = rollup->archived_through;
+
+    GByteArray *out = g_byte_array_new();
+    g_byte_array_append(out, (const guint8 *)&header, sizeof(header));
+    g_byte_array_append(out, (const guint8 *)rollup->entries->data,
+                        rollup->entries->len * sizeof(ottsr_rollup_entry_t));
+    g_byte_array_append(out, strings->data, strings->len);
+
+    GError *error = NULL;
+    gboolean ok = g_file_set_contents(path, (const char *)out->data, out->len, &error);
+    if (!ok) {
+        g_warning("Failed to write history rollup: %s", error->message);
+        g_error_free(error);
+    }
+
+    g_byte_array_unref(out);
+    g_byte_array_unref(strings);
+    return ok;
+}
+
+// Append a chunk and make it durable before the rollup claims it
+static gboolean ottsr_archive_append(const char *path, const ottsr_archive_chunk_t *chunk,
+                                     const GByteArray *packed) {
+    FILE *file = fopen(path, "ab");
+    if (!file) return FALSE;
+
+    gboolean ok = fwrite(chunk, sizeof(*chunk), 1, file) == 1 &&
+                  fwrite(packed->data, 1, packed->len, file) == packed->len &&
+                  fflush(file) == 0 && g_fsync(fileno(file)) == 0;
+    ok = (fclose(file) == 0) && ok;
+    return ok;
+}
+
+static void ottsr_compaction_free(ottsr_compaction_t *job) {
+    g_free(job->archive_path);
+    g_free(job->rollup_path);
+    g_free(job->history_path);
+    g_free(job);
+}
+
+static ottsr_compaction_t *ottsr_compaction_new(void) {
+    ottsr_compaction_t *job = g_new0(ottsr_compaction_t, 1);
+    job->archive_path = ottsr_archive_path(OTTSR_ARCHIVE_FILE);
+    job->rollup_path = ottsr_archive_path(OTTSR_ROLLUP_FILE);
+    job->history_path = ottsr_archive_path(OTTSR_HISTORY_FILE);
+    if (!job->archive_path) {
+        ottsr_compaction_free(job);
+        return NULL;
+    }
+    return job;
+}
+
+// Encode, compress and commit one batch: the chunk is made durable first,
+// then the rollup that counts it
+static gboolean ottsr_compaction_step(ottsr_compaction_t *job, ottsr_rollup_t *rollup,
+                                      const ottsr_history_record_t *records, guint count) {
+    gint64 start = g_get_monotonic_time();
+
+    GByteArray *raw = ottsr_archive_encode(records, count);
+    GConverter *deflater = G_CONVERTER(g_zlib_compressor_new(G_ZLIB_COMPRESSOR_FORMAT_ZLIB, 9));
+    GByteArray *packed = ottsr_zlib_convert(deflater, raw->data, raw->len);
+    g_object_unref(deflater);
+
+    ottsr_archive_chunk_t chunk = {0};
+    chunk.magic = OTTSR_ARCHIVE_MAGIC;
+    chunk.count = count;
+    chunk.raw_size = raw->len;
+    chunk.first_started_at = records[0].started_at;
+    chunk.last_started_at = records[count - 1].started_at;
+
+    gboolean ok = packed != NULL;
+    if (ok) {
+        chunk.packed_size = packed->len;
+        ok = ottsr_archive_append(job->archive_path, &chunk, packed);
+    }
+
+    if (ok) {
+        for (guint i = 0; i < count; i++) {
+            ottsr_rollup_add(rollup, &records[i]);
+            rollup->archived_through = MAX(rollup->archived_through, records[i].started_at);
+        }
+        rollup->archived_records += count;
+        ok = ottsr_rollup_save(rollup, job->rollup_path);
+    }
+
+    if (ok) {
+        job->raw_bytes += count * sizeof(ottsr_history_record_t);
+        job->packed_bytes += sizeof(chunk) + packed->len;
+        job->archived += count;
+    }
+
+    g_byte_array_unref(raw);
+    if (packed) g_byte_array_unref(packed);
+    job->busy_usec += g_get_monotonic_time() - start;
+    return ok;
+}
+
+// Drop chunks a crashed step wrote without committing its rollup
+static void ottsr_archive_trim(const char *path, guint32 archived_records) {
+    GMappedFile *mapped = g_mapped_file_new(path, FALSE, NULL);
+    if (!mapped) return;
+
+    const char *data = g_mapped_file_get_contents(mapped);
+    gsize length = g_mapped_file_get_length(mapped);
+    gsize valid = ottsr_archive_walk(data, length, archived_records, NULL);
+
+    if (valid < length) {
+        g_debug("Dropping %" G_GSIZE_FORMAT " uncommitted archive bytes", length - valid);
+        g_file_set_contents(path, data, valid, NULL);
+    }
+    g_mapped_file_unref(mapped);
+}
+
+// Archive the leading run of history.dat older than the retention period.
+// Records are archived in file order and counted by sequence number, so an
+// interrupted run resumes exactly where it stopped.
+static gboolean ottsr_compaction_run(ottsr_compaction_t *job, GCancellable *cancellable) {
+    ottsr_rollup_t *rollup = ottsr_rollup_load_file(job->rollup_path);
+
+    // Rollups from before sequence numbers only know a timestamp
+    if (rollup->archived_records == 0 && rollup->archived_through != G_MININT64) {
+        g_warning("History rollup has no record count; not compacting");
+        ottsr_rollup_free(rollup);
+        return TRUE;
+    }
+
+    gint64 cutoff = g_get_real_time() / G_USEC_PER_SEC - (gint64)OTTSR_HISTORY_RETENTION_DAYS * 86400;
+    GArray *hot = ottsr_history_read_file(job->history_path, rollup->archived_records);
+    guint pending = 0;
+    while (pending < hot->len && g_array_index(hot, ottsr_history_record_t, pending).started_at < cutoff) {
+        pending++;
+    }
+
+    if (pending > 0) {
+        ottsr_archive_trim(job->archive_path, rollup->archived_records);
+
+        guint next = 0;
+        while (next < pending && !g_cancellable_is_cancelled(cancellable)) {
+            guint count = MIN(OTTSR_ARCHIVE_BATCH, pending - next);
+            if (!ottsr_compaction_step(job, rollup, &g_array_index(hot, ottsr_history_record_t, next), count)) {
+                job->failed = TRUE;
+                break;
+            }
+            next += count;
+        }
+
+        // Everything archived leaves the hot file; appends since are kept
+        if (next == pending && !ottsr_history_compact_file(job->history_path, rollup->archived_records)) {
+            job->failed = TRUE;
+        }
+    }
+
+    g_array_unref(hot);
+    ottsr_rollup_free(rollup);
+    return !job->failed;
+}
+
+// All file work happens here, off the main thread
+static void ottsr_compaction_thread(GTask *task, gpointer source, gpointer task_data,
+                                    GCancellable *cancellable) {
+    g_task_return_boolean(task, ottsr_compaction_run((ottsr_compaction_t *)task_data, cancellable));
+}
+
+static void ottsr_compaction_done(GObject *source, GAsyncResult *result, gpointer user_data) {
+    ottsr_app_t *app = (ottsr_app_t *)user_data;
+    ottsr_compaction_t *job = g_task_get_task_data(G_TASK(result));
+    GError *error = NULL;
+
+    // Cancelled runs belong to a user who has left, or to shutdown
+    if (!g_task_propagate_boolean(G_TASK(result), &error)) {
+        if (error && g_error_matches(error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+            g_error_free(error);
+            return;
+        }
+        g_clear_error(&error);
+        g_warning("History compaction stopped; it will resume next launch");
+    } else if (job->archived > 0) {
+        g_debug("Archived %u sessions: %" G_GSIZE_FORMAT " bytes -> %" G_GSIZE_FORMAT
+                " bytes (%.1fx) in %.1f ms",
+                job->archived, job->raw_bytes, job->packed_bytes,
+                job->packed_bytes ? (double)job->raw_bytes / job->packed_bytes : 0.0,
+                job->busy_usec / 1000.0);
+    }
+
+    g_clear_object(&app->compaction_cancel);
+}
+
+static gboolean ottsr_compaction_begin(gpointer user_data) {
+    ottsr_app_t *app = (ottsr_app_t *)user_data;
+    app->compaction_id = 0;
+
+    ottsr_compaction_t *job = ottsr_compaction_new();
+    if (!job) return G_SOURCE_REMOVE;
+
+    app->compaction_cancel = g_cancellable_new();
+    GTask *task = g_task_new(NULL, app->compaction_cancel, ottsr_compaction_done, app);
+    g_task_set_task_data(task, job, (GDestroyNotify)ottsr_compaction_free);
+    g_task_run_in_thread(task, ottsr_compaction_thread);
+    g_object_unref(task);
+    return G_SOURCE_REMOVE;
+}
+
+// Compact old history a while after startup, once the UI has settled
+void ottsr_archive_schedule(ottsr_app_t *app) {
+    app->compaction_id = g_timeout_add_seconds(OTTSR_ARCHIVE_DELAY, ottsr_compaction_begin, app);
+}
+
+// Every step commits on its own, so the worker may stop after any of them
+void ottsr_archive_cancel(ottsr_app_t *app) {
+    if (app->compaction_id > 0) {
+        g_source_remove(app->compaction_id);
+        app->compaction_id = 0;
+    }
+    if (app->compaction_cancel) {
+        g_cancellable_cancel(app->compaction_cancel);
+        g_clear_object(&app->compaction_cancel);
+    }
+}
+
+// Compact the current user's history on the calling thread, as the
+// scheduled run would; for the archive benchmark
+gboolean ottsr_archive_compact(guint *archived, gsize *raw_bytes, gsize *packed_bytes) {
+    ottsr_compaction_t *job = ottsr_compaction_new();
+    if (!job) return FALSE;
+
+    gboolean ok = ottsr_compaction_run(job, NULL);
+    *archived = job->archived;
+    *raw_bytes = job->raw_bytes;
+    *packed_bytes = job->packed_bytes;
+    ottsr_compaction_free(job);
+    return ok;
+}
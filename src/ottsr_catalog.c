@@ -0,0 +1,361 @@
+#include "ottsr.h"
+
+enum {
+    CATALOG_COL_LABEL,
+    CATALOG_COL_PROFILE,
+    CATALOG_COL_ENTRY,
+    CATALOG_N_COLS
+};
+
+static const char *ottsr_layer_names[] = {"system", "site", "user"};
+
+static void ottsr_catalog_entry_free(gpointer data) {
+    ottsr_catalog_entry_t *entry = data;
+    g_free(entry->name);
+    g_free(entry->key);
+    g_free(entry->path);
+    g_free(entry);
+}
+
+void ottsr_catalog_free(ottsr_catalog_t *catalog) {
+    if (!catalog) return;
+    g_ptr_array_unref(catalog->entries);
+    g_array_unref(catalog->words);
+    g_free(catalog);
+}
+
+static char *ottsr_catalog_layer_dir(ottsr_layer_t layer) {
+    switch (layer) {
+        case OTTSR_LAYER_SYSTEM:
+            return g_strdup(OTTSR_CATALOG_SYSTEM_DIR);
+        case OTTSR_LAYER_SITE: {
+            const char *site = g_getenv(OTTSR_CATALOG_SITE_ENV);
+            return site && *site ? g_strdup(site) : NULL;
+        }
+        case OTTSR_LAYER_USER: {
+            char *config_dir = ottsr_get_config_path();
+            char *dir = config_dir ? g_build_filename(config_dir, OTTSR_CATALOG_USER_DIR, NULL) : NULL;
+            g_free(config_dir);
+            return dir;
+        }
+    }
+    return NULL;
+}
+
+// Names only: the directory listing is the index, files are parsed on selection
+static void ottsr_catalog_scan_layer(GHashTable *by_key, ottsr_layer_t layer) {
+    char *dir_path = ottsr_catalog_layer_dir(layer);
+    if (!dir_path) return;
+
+    GDir *dir = g_dir_open(dir_path, 0, NULL);
+    if (!dir) {
+        g_free(dir_path);
+        return;
+    }
+
+    const char *file_name;
+    while ((file_name = g_dir_read_name(dir)) != NULL) {
+        if (!g_str_has_suffix(file_name, ".json")) continue;
+
+        ottsr_catalog_entry_t *entry = g_new0(ottsr_catalog_entry_t, 1);
+        entry->name = g_strndup(file_name, strlen(file_name) - strlen(".json"));
+        entry->key = g_utf8_casefold(entry->name, -1);
+        entry->path = g_build_filename(dir_path, file_name, NULL);
+        entry->layer = layer;
+
+        // Later layers override earlier ones with the same name
+        ottsr_catalog_entry_t *shadowed = g_hash_table_lookup(by_key, entry->key);
+        g_hash_table_replace(by_key, entry->key, entry);
+        if (shadowed) ottsr_catalog_entry_free(shadowed);
+    }
+
+    g_dir_close(dir);
+    g_free(dir_path);
+}
+
+static gint ottsr_catalog_entry_cmp(gconstpointer a, gconstpointer b) {
+    const ottsr_catalog_entry_t *ea = *(ottsr_catalog_entry_t * const *)a;
+    const ottsr_catalog_entry_t *eb = *(ottsr_catalog_entry_t * const *)b;
+    return strcmp(ea->key, eb->key);
+}
+
+static gint ottsr_catalog_word_cmp(gconstpointer a, gconstpointer b) {
+    return strcmp(((const ottsr_catalog_word_t *)a)->key, ((const ottsr_catalog_word_t *)b)->key);
+}
+
+// Build the sorted name index plus a sorted index of every word start,
+// so "alg" finds "MATH101 Linear Algebra" with the same binary search.
+ottsr_catalog_t *ottsr_catalog_build(void) {
+    GHashTable *by_key = g_hash_table_new(g_str_hash, g_str_equal);
+
+    ottsr_catalog_scan_layer(by_key, OTTSR_LAYER_SYSTEM);
+    ottsr_catalog_scan_layer(by_key, OTTSR_LAYER_SITE);
+    ottsr_catalog_scan_layer(by_key, OTTSR_LAYER_USER);
+
+    ottsr_catalog_t *catalog = g_new0(ottsr_catalog_t, 1);
+    catalog->entries = g_ptr_array_new_with_free_func(ottsr_catalog_entry_free);
+    catalog->words = g_array_new(FALSE, FALSE, sizeof(ottsr_catalog_word_t));
+
+    GHashTableIter iter;
+    gpointer value;
+    g_hash_table_iter_init(&iter, by_key);
+    while (g_hash_table_iter_next(&iter, NULL, &value)) {
+        g_ptr_array_add(catalog->entries, value);
+    }
+    g_hash_table_destroy(by_key);
+
+    g_ptr_array_sort(catalog->entries, ottsr_catalog_entry_cmp);
+
+    for (guint i = 0; i < catalog->entries->len; i++) {
+        ottsr_catalog_entry_t *entry = g_ptr_array_index(catalog->entries, i);
+        for (const char *p = entry->key; *p; p++) {
+            if (p != entry->key && p[-1] != ' ' && p[-1] != '-' && p[-1] != '_') continue;
+            if (*p == ' ' || *p == '-' || *p == '_') continue;
+            ottsr_catalog_word_t word = { p, i };
+            g_array_append_val(catalog->words, word);
+        }
+    }
+    g_array_sort(catalog->words, ottsr_catalog_word_cmp);
+
+    return catalog;
+}
+
+// First word whose key is >= prefix
+static guint ottsr_catalog_lower_bound(const GArray *words, const char *prefix) {
+    guint lo = 0, hi = words->len;
+    while (lo < hi) {
+        guint mid = lo + (hi - lo) / 2;
+        if (strcmp(g_array_index(words, ottsr_catalog_word_t, mid).key, prefix) < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+// Characters of needle appear in order in haystack
+static gboolean ottsr_fuzzy_match(const char *haystack, const char *needle) {
+    for (; *haystack && *needle; haystack++) {
+        if (*haystack == *needle) needle++;
+    }
+    return *needle == '\0';
+}
+
+static gboolean ottsr_catalog_contains(ottsr_catalog_entry_t **results, guint count,
+                                       const ottsr_catalog_entry_t *entry) {
+    for (guint i = 0; i < count; i++) {
+        if (results[i] == entry) return TRUE;
+    }
+    return FALSE;
+}
+
+// Word-prefix matches first, then a bounded fuzzy pass to fill up
+guint ottsr_catalog_search(const ottsr_catalog_t *catalog, const char *query,
+                           ottsr_catalog_entry_t **results, guint max_results) {
+    if (!catalog || !query || !*query) return 0;
+
+    char *key = g_utf8_casefold(query, -1);
+    gsize key_len = strlen(key);
+    guint count = 0;
+
+    for (guint i = ottsr_catalog_lower_bound(catalog->words, key);
+         i < catalog->words->len && count < max_results; i++) {
+        const ottsr_catalog_word_t *word = &g_array_index(catalog->words, ottsr_catalog_word_t, i);
+        if (strncmp(word->key, key, key_len) != 0) break;
+
+        ottsr_catalog_entry_t *entry = g_ptr_array_index(catalog->entries, word->entry);
+        if (!ottsr_catalog_contains(results, count, entry)) {
+            results[count++] = entry;
+        }
+    }
+
+    guint budget = OTTSR_CATALOG_FUZZY_BUDGET;
+    for (guint i = 0; i < catalog->entries->len && count < max_results && budget > 0; i++, budget--) {
+        ottsr_catalog_entry_t *entry = g_ptr_array_index(catalog->entries, i);
+        if (ottsr_fuzzy_match(entry->key, key) && !ottsr_catalog_contains(results, count, entry)) {
+            results[count++] = entry;
+        }
+    }
+
+    g_free(key);
+    return count;
+}
+
+// Parse a single catalog profile file; missing fields keep the usual defaults
+gboolean ottsr_catalog_load_profile(const ottsr_catalog_entry_t *entry, ottsr_profile_t *profile) {
+    GError *error = NULL;
+    JsonParser *parser = json_parser_new();
+
+    if (!json_parser_load_from_file(parser, entry->path, &error)) {
+        g_warning("Failed to load profile %s: %s", entry->path, error->message);
+        g_error_free(error);
+        g_object_unref(parser);
+        return FALSE;
+    }
+
+    JsonNode *root = json_parser_get_root(parser);
+    if (!root || !JSON_NODE_HOLDS_OBJECT(root)) {
+        g_object_unref(parser);
+        return FALSE;
+    }
+
+    JsonObject *obj = json_node_get_object(root);
+    memset(profile, 0, sizeof(*profile));
+
+    const char *name = json_object_get_string_member_with_default(obj, "name", entry->name);
+    g_strlcpy(profile->name, name, OTTSR_MAX_NAME_LEN);
+    profile->study_minutes = json_object_get_int_member_with_default(obj, "study_minutes", 25);
+    profile->break_minutes = json_object_get_int_member_with_default(obj, "break_minutes", 5);
+    profile->long_break_minutes = json_object_get_int_member_with_default(obj, "long_break_minutes", 15);
+    profile->sessions_until_long_break = json_object_get_int_member_with_default(obj, "sessions_until_long_break", 4);
+    profile->sound_enabled = json_object_get_boolean_member_with_default(obj, "sound_enabled", TRUE);
+    profile->notifications_enabled = json_object_get_boolean_member_with_default(obj, "notifications_enabled", TRUE);
+
+    g_object_unref(parser);
+    return TRUE;
+}
+
+static void ottsr_catalog_build_thread(GTask *task, gpointer source, gpointer task_data,
+                                       GCancellable *cancellable) {
+    g_task_return_pointer(task, ottsr_catalog_build(), (GDestroyNotify)ottsr_catalog_free);
+}
+
+static void ottsr_catalog_build_done(GObject *source, GAsyncResult *result, gpointer user_data) {
+    ottsr_app_t *app = (ottsr_app_t *)user_data;
+    ottsr_catalog_t *catalog = g_task_propagate_pointer(G_TASK(result), NULL);
+    if (!catalog) return;
+
+    ottsr_catalog_replace(app, catalog);
+    g_debug("Profile catalog indexed: %u entries", catalog ? catalog->entries->len : 0);
+}
+
+// Rows of the completion popup point into the catalog, so they go first
+void ottsr_catalog_replace(ottsr_app_t *app, ottsr_catalog_t *catalog) {
+    if (app->catalog_store) gtk_list_store_clear(app->catalog_store);
+    ottsr_catalog_free(app->catalog);
+    app->catalog = catalog;
+}
+
+// Index the catalog off the main thread once the window is up
+void ottsr_catalog_load_async(ottsr_app_t *app) {
+    GTask *task = g_task_new(NULL, app->user_cancel, ottsr_catalog_build_done, app);
+    g_task_run_in_thread(task, ottsr_catalog_build_thread);
+    g_object_unref(task);
+}
+
+// Refill the completion popup: the user's own profiles first, then catalog
+// entries they do not already override.
+void on_catalog_search_changed(GtkEditable *editable, ottsr_app_t *app) {
+    const char *query = gtk_entry_get_text(GTK_ENTRY(editable));
+    GtkListStore *store = app->catalog_store;
+    gtk_list_store_clear(store);
+
+    if (!query || !*query) return;
+
+    char *key = g_utf8_casefold(query, -1);
+    guint shown = 0;
+
+    for (int i = 0; i < app->config.profile_count && shown < OTTSR_CATALOG_MAX_MATCHES; i++) {
+        char *name_key = g_utf8_casefold(app->config.profiles[i].name, -1);
+        if (strstr(name_key, key) || ottsr_fuzzy_match(name_key, key)) {
+            GtkTreeIter iter;
+            gtk_list_store_append(store, &iter);
+            gtk_list_store_set(store, &iter,
+                               CATALOG_COL_LABEL, app->config.profiles[i].name,
+                               CATALOG_COL_PROFILE, i,
+                               CATALOG_COL_ENTRY, NULL,
+                               -1);
+            shown++;
+        }
+        g_free(name_key);
+    }
+    g_free(key);
+
+    ottsr_catalog_entry_t *results[OTTSR_CATALOG_MAX_MATCHES];
+    guint count = ottsr_catalog_search(app->catalog, query, results, OTTSR_CATALOG_MAX_MATCHES - shown);
+
+    for (guint i = 0; i < count; i++) {
+        gboolean overridden = FALSE;
+        for (int p = 0; p < app->config.profile_count; p++) {
+            if (g_utf8_collate(app->config.profiles[p].name, results[i]->name) == 0) {
+                overridden = TRUE;
+                break;
+            }
+        }
+        if (overridden) continue;
+
+        char *label = g_strdup_printf("%s  (%s)", results[i]->name, ottsr_layer_names[results[i]->layer]);
+        GtkTreeIter iter;
+        gtk_list_store_append(store, &iter);
+        gtk_list_store_set(store, &iter,
+                           CATALOG_COL_LABEL, label,
+                           CATALOG_COL_PROFILE, -1,
+                           CATALOG_COL_ENTRY, results[i],
+                           -1);
+        g_free(label);
+    }
+
+    gtk_entry_completion_complete(gtk_entry_get_completion(GTK_ENTRY(editable)));
+}
+
+static gboolean ottsr_catalog_match_all(GtkEntryCompletion *completion, const gchar *key,
+                                        GtkTreeIter *iter, gpointer user_data) {
+    // The store already holds exactly the matches to show
+    return TRUE;
+}
+
+static gboolean on_catalog_match_selected(GtkEntryCompletion *completion, GtkTreeModel *model,
+                                          GtkTreeIter *iter, ottsr_app_t *app) {
+    int profile_index = -1;
+    ottsr_catalog_entry_t *entry = NULL;
+    gtk_tree_model_get(model, iter, CATALOG_COL_PROFILE, &profile_index, CATALOG_COL_ENTRY, &entry, -1);
+
+    if (profile_index < 0 && entry) {
+        if (app->config.profile_count >= OTTSR_MAX_PROFILES) {
+            GtkWidget *dialog = gtk_message_dialog_new(GTK_WINDOW(app->main_window),
+                                                      GTK_DIALOG_MODAL,
+                                                      GTK_MESSAGE_WARNING,
+                                                      GTK_BUTTONS_OK,
+                                                      "Maximum number of profiles reached (%d)",
+                                                      OTTSR_MAX_PROFILES);
+            gtk_dialog_run(GTK_DIALOG(dialog));
+            gtk_widget_destroy(dialog);
+            return TRUE;
+        }
+
+        ottsr_profile_t *profile = &app->config.profiles[app->config.profile_count];
+        if (!ottsr_catalog_load_profile(entry, profile)) return TRUE;
+
+        profile_index = app->config.profile_count++;
+        gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(app->profile_combo), profile->name);
+        ottsr_save_config(app);
+    }
+
+    if (profile_index >= 0) {
+        gtk_combo_box_set_active(GTK_COMBO_BOX(app->profile_combo), profile_index);
+    }
+
+    gtk_entry_set_text(GTK_ENTRY(app->catalog_entry), "");
+    return TRUE;
+}
+
+GtkWidget *ottsr_catalog_create_entry(ottsr_app_t *app) {
+    app->catalog_store = gtk_list_store_new(CATALOG_N_COLS, G_TYPE_STRING, G_TYPE_INT, G_TYPE_POINTER);
+
+    app->catalog_entry = gtk_search_entry_new();
+    gtk_style_context_add_class(gtk_widget_get_style_context(app->catalog_entry), "settings-entry");
+    gtk_entry_set_placeholder_text(GTK_ENTRY(app->catalog_entry), "Find a course profile...");
+
+    GtkEntryCompletion *completion = gtk_entry_completion_new();
+    gtk_entry_completion_set_model(completion, GTK_TREE_MODEL(app->catalog_store));
+    gtk_entry_completion_set_text_column(completion, CATALOG_COL_LABEL);
+    gtk_entry_completion_set_match_func(completion, ottsr_catalog_match_all, NULL, NULL);
+    gtk_entry_completion_set_minimum_key_length(completion, 1);
+    g_signal_connect(completion, "match-selected", G_CALLBACK(on_catalog_match_selected), app);
+    gtk_entry_set_completion(GTK_ENTRY(app->catalog_entry), completion);
+    g_object_unref(completion);
+
+    g_signal_connect(app->catalog_entry, "changed", G_CALLBACK(on_catalog_search_changed), app);
+    return app->catalog_entry;
+}
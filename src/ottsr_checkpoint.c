@@ -0,0 +1,239 @@
+#include "ottsr.h"
+#include <fcntl.h>
+#include <errno.h>
+
+#ifndef G_OS_WIN32
+#include <sys/mman.h>
+#else
+#include <io.h>
+#endif
+
+#define OTTSR_CHECKPOINT_SLOTS 2
+#define OTTSR_CHECKPOINT_SIZE (sizeof(ottsr_checkpoint_slot_t) * OTTSR_CHECKPOINT_SLOTS)
+
+// FNV-1a over everything but the trailing checksum fields
+static guint32 ottsr_checkpoint_checksum(const ottsr_checkpoint_slot_t *slot) {
+    const guchar *bytes = (const guchar *)slot;
+    guint32 hash = 2166136261u;
+
+    for (size_t i = 0; i < offsetof(ottsr_checkpoint_slot_t, checksum); i++) {
+        hash ^= bytes[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static gboolean ottsr_checkpoint_slot_valid(const ottsr_checkpoint_slot_t *slot) {
+    return slot->magic == OTTSR_CHECKPOINT_MAGIC &&
+           slot->version == OTTSR_CHECKPOINT_VERSION &&
+           slot->checksum == ottsr_checkpoint_checksum(slot);
+}
+
+// Pick the newest intact slot, or NULL if neither survived
+static const ottsr_checkpoint_slot_t *ottsr_checkpoint_latest(const ottsr_checkpoint_slot_t *slots) {
+    const ottsr_checkpoint_slot_t *latest = NULL;
+
+    for (int i = 0; i < OTTSR_CHECKPOINT_SLOTS; i++) {
+        if (!ottsr_checkpoint_slot_valid(&slots[i])) continue;
+        if (!latest || slots[i].sequence > latest->sequence) {
+            latest = &slots[i];
+        }
+    }
+    return latest;
+}
+
+// Open (or create) the fixed-size checkpoint file and map it shared
+gboolean ottsr_checkpoint_open(ottsr_app_t *app) {
+    ottsr_checkpoint_t *ckpt = &app->checkpoint;
+    ckpt->fd = -1;
+    ckpt->slots = NULL;
+
+    char *config_dir = ottsr_get_config_path();
+    if (!config_dir) return FALSE;
+
+    g_mkdir_with_parents(config_dir, 0755);
+    char *path = g_build_filename(config_dir, OTTSR_CHECKPOINT_FILE, NULL);
+    g_free(config_dir);
+
+    ckpt->fd = open(path, O_RDWR | O_CREAT, 0600);
+    if (ckpt->fd < 0) {
+        g_warning("Failed to open checkpoint %s: %s", path, g_strerror(errno));
+        g_free(path);
+        return FALSE;
+    }
+    g_free(path);
+
+    if (ftruncate(ckpt->fd, OTTSR_CHECKPOINT_SIZE) != 0) {
+        g_warning("Failed to size checkpoint: %s", g_strerror(errno));
+        close(ckpt->fd);
+        ckpt->fd = -1;
+        return FALSE;
+    }
+
+#ifndef G_OS_WIN32
+    void *map = mmap(NULL, OTTSR_CHECKPOINT_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, ckpt->fd, 0);
+    if (map == MAP_FAILED) {
+        g_warning("Failed to map checkpoint: %s", g_strerror(errno));
+        close(ckpt->fd);
+        ckpt->fd = -1;
+        return FALSE;
+    }
+    ckpt->slots = map;
+#else
+    // No shared mappings here; keep a private copy and write slots back with one write()
+    ckpt->slots = g_malloc0(OTTSR_CHECKPOINT_SIZE);
+    if (read(ckpt->fd, ckpt->slots, OTTSR_CHECKPOINT_SIZE) < 0) {
+        memset(ckpt->slots, 0, OTTSR_CHECKPOINT_SIZE);
+    }
+#endif
+
+    const ottsr_checkpoint_slot_t *latest = ottsr_checkpoint_latest(ckpt->slots);
+    ckpt->sequence = latest ? latest->sequence : 0;
+    ckpt->last_write = 0;
+    return TRUE;
+}
+
+// Flush one slot to disk; constant cost regardless of history or config size
+static void ottsr_checkpoint_commit(ottsr_checkpoint_t *ckpt, ottsr_checkpoint_slot_t *slot) {
+#ifndef G_OS_WIN32
+    // msync needs a page-aligned address; the whole record fits in one page
+    msync(ckpt->slots, OTTSR_CHECKPOINT_SIZE, MS_ASYNC);
+#else
+    off_t offset = (off_t)((char *)slot - (char *)ckpt->slots);
+    if (lseek(ckpt->fd, offset, SEEK_SET) == offset) {
+        if (write(ckpt->fd, slot, sizeof(*slot)) != sizeof(*slot)) {
+            g_warning("Failed to write checkpoint");
+        }
+    }
+#endif
+}
+
+static void ottsr_checkpoint_store(ottsr_app_t *app, ottsr_state_t state) {
+    ottsr_checkpoint_t *ckpt = &app->checkpoint;
+    if (!ckpt->slots) return;
+
+    ckpt->sequence++;
+    ottsr_checkpoint_slot_t *slot = &ckpt->slots[ckpt->sequence % OTTSR_CHECKPOINT_SLOTS];
+    ottsr_profile_t *profile = &app->config.profiles[app->session.profile_index];
+
+    // Invalidate first so a crash mid-copy leaves the slot unreadable, never half-new
+    slot->magic = 0;
+    slot->version = OTTSR_CHECKPOINT_VERSION;
+    slot->sequence = ckpt->sequence;
+    slot->written_at = time(NULL);
+    slot->state = state;
+    slot->profile_index = app->session.profile_index;
+    slot->elapsed_study_seconds = app->session.elapsed_study_seconds;
+    slot->elapsed_break_seconds = app->session.elapsed_break_seconds;
+    slot->current_sessions = app->session.current_sessions;
+    slot->is_long_break = app->session.is_long_break;
+    g_strlcpy(slot->profile_name, profile->name, OTTSR_MAX_NAME_LEN);
+    g_strlcpy(slot->subject, app->session.current_subject, OTTSR_MAX_NAME_LEN);
+    slot->reserved = 0;
+    slot->magic = OTTSR_CHECKPOINT_MAGIC;
+    slot->checksum = ottsr_checkpoint_checksum(slot);
+
+    ottsr_checkpoint_commit(ckpt, slot);
+    ckpt->last_write = slot->written_at;
+}
+
+// Record the running session
+void ottsr_checkpoint_write(ottsr_app_t *app) {
+    ottsr_session_sync(app);
+    ottsr_checkpoint_store(app, app->session.state);
+}
+
+// Mark the session as finished so nothing is recovered on next launch
+void ottsr_checkpoint_clear(ottsr_app_t *app) {
+    ottsr_checkpoint_store(app, OTTSR_STATE_IDLE);
+}
+
+void ottsr_checkpoint_close(ottsr_app_t *app) {
+    ottsr_checkpoint_t *ckpt = &app->checkpoint;
+    if (!ckpt->slots) return;
+
+#ifndef G_OS_WIN32
+    msync(ckpt->slots, OTTSR_CHECKPOINT_SIZE, MS_SYNC);
+    munmap(ckpt->slots, OTTSR_CHECKPOINT_SIZE);
+#else
+    g_free(ckpt->slots);
+#endif
+    ckpt->slots = NULL;
+
+    close(ckpt->fd);
+    ckpt->fd = -1;
+}
+
+// Recover a session interrupted by a crash, logout or power loss. Recent
+// checkpoints are resumed where they left off; stale ones are credited to
+// the profile's statistics. Returns TRUE if a session was resumed.
+gboolean ottsr_checkpoint_recover(ottsr_app_t *app) {
+    ottsr_checkpoint_t *ckpt = &app->checkpoint;
+    if (!ckpt->slots) return FALSE;
+
+    const ottsr_checkpoint_slot_t *latest = ottsr_checkpoint_latest(ckpt->slots);
+    if (!latest || latest->state == OTTSR_STATE_IDLE) return FALSE;
+
+    // The profile list may have changed since the checkpoint was taken
+    int index = latest->profile_index;
+    if (index < 0 || index >= app->config.profile_count ||
+        strcmp(app->config.profiles[index].name, latest->profile_name) != 0) {
+        index = -1;
+        for (int i = 0; i < app->config.profile_count; i++) {
+            if (strcmp(app->config.profiles[i].name, latest->profile_name) == 0) {
+                index = i;
+                break;
+            }
+        }
+    }
+
+    ottsr_checkpoint_slot_t saved = *latest;
+    if (index < 0) {
+        g_warning("Discarding checkpoint for unknown profile '%s'", saved.profile_name);
+        ottsr_checkpoint_clear(app);
+        return FALSE;
+    }
+
+    time_t age = time(NULL) - saved.written_at;
+
+    if (age >= 0 && age <= OTTSR_CHECKPOINT_RESUME_WINDOW) {
+        app->config.active_profile = index;
+        app->session.profile_index = index;
+        app->session.state = saved.state;
+        app->session.elapsed_study_seconds = saved.elapsed_study_seconds;
+        app->session.elapsed_break_seconds = saved.elapsed_break_seconds;
+        app->session.current_sessions = saved.current_sessions;
+        app->session.is_long_break = saved.is_long_break;
+        // A study phase that finished before the checkpoint is already in history
+        app->session.recorded_study_seconds =
+            saved.state == OTTSR_STATE_BREAKING ? saved.elapsed_study_seconds : 0;
+        app->session.pause_duration = 0;
+        app->session.pause_start = time(NULL);
+        app->session.session_start = time(NULL) - saved.elapsed_study_seconds;
+        app->session.break_start = time(NULL) - saved.elapsed_break_seconds;
+        g_strlcpy(app->session.current_subject, saved.subject, OTTSR_MAX_NAME_LEN);
+
+        g_print("Resuming interrupted session (%d min studied)\n", saved.elapsed_study_seconds / 60);
+        ottsr_resume_session(app);
+        return TRUE;
+    }
+
+    ottsr_profile_t *profile = &app->config.profiles[index];
+    profile->total_study_time += saved.elapsed_study_seconds;
+
+    if (saved.state != OTTSR_STATE_BREAKING && saved.elapsed_study_seconds > 0) {
+        ottsr_history_record_t record = {0};
+        record.started_at = saved.written_at - saved.elapsed_study_seconds;
+        record.study_seconds = saved.elapsed_study_seconds;
+        g_strlcpy(record.profile, profile->name, OTTSR_MAX_NAME_LEN);
+        g_strlcpy(record.subject, saved.subject, OTTSR_MAX_NAME_LEN);
+        ottsr_history_add(app, &record, NULL);
+    }
+
+    g_print("Credited %d min from interrupted session to '%s'\n",
+            saved.elapsed_study_seconds / 60, profile->name);
+
+    ottsr_checkpoint_clear(app);
+    ottsr_save_config(app);
+    return FALSE;
+}
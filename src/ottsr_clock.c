@@ -0,0 +1,168 @@
+#include "ottsr.h"
+
+// Phase deadlines are kept by a dedicated thread so that anything slow on
+// the GTK main loop (relayout, config saves, nested dialog loops) can delay
+// how quickly a transition is shown, but never when it is due.
+//
+// The thread is the only producer and the main loop the only consumer of
+// the event ring, so head and tail each have a single writer and the ring
+// needs no lock. Arming and disarming go the other way through a mutex the
+// thread only holds while deciding how long to sleep.
+struct ottsr_clock {
+    GThread *thread;
+    GMutex lock;
+    GCond cond;
+    gint64 deadline;
+    guint64 generation;
+    gboolean quit;
+
+    ottsr_clock_event_t events[OTTSR_CLOCK_QUEUE_SIZE];
+    gint head;
+    gint tail;
+    gint dropped;
+
+    GMainContext *context;
+    GSource *source;
+    ottsr_clock_func_t func;
+    gpointer user_data;
+};
+
+typedef struct {
+    GSource source;
+    ottsr_clock_t *clock;
+} ottsr_clock_source_t;
+
+// Producer side: the timing thread
+static void ottsr_clock_push(ottsr_clock_t *clock, const ottsr_clock_event_t *event) {
+    gint head = clock->head;
+    if (head - g_atomic_int_get(&clock->tail) >= OTTSR_CLOCK_QUEUE_SIZE) {
+        g_atomic_int_inc(&clock->dropped);
+        return;
+    }
+
+    clock->events[head % OTTSR_CLOCK_QUEUE_SIZE] = *event;
+    g_atomic_int_set(&clock->head, head + 1);
+    g_main_context_wakeup(clock->context);
+}
+
+static gpointer ottsr_clock_thread(gpointer data) {
+    ottsr_clock_t *clock = data;
+
+    g_mutex_lock(&clock->lock);
+    while (!clock->quit) {
+        if (clock->deadline == 0) {
+            g_cond_wait(&clock->cond, &clock->lock);
+            continue;
+        }
+        if (g_get_monotonic_time() < clock->deadline) {
+            g_cond_wait_until(&clock->cond, &clock->lock, clock->deadline);
+            continue;
+        }
+
+        ottsr_clock_event_t event;
+        event.generation = clock->generation;
+        event.deadline = clock->deadline;
+        event.fired_at = g_get_monotonic_time();
+        clock->deadline = 0;
+
+        g_mutex_unlock(&clock->lock);
+        ottsr_clock_push(clock, &event);
+        g_mutex_lock(&clock->lock);
+    }
+    g_mutex_unlock(&clock->lock);
+    return NULL;
+}
+
+static gboolean ottsr_clock_pending(ottsr_clock_t *clock) {
+    return g_atomic_int_get(&clock->head) != clock->tail;
+}
+
+static gboolean ottsr_clock_source_prepare(GSource *source, gint *timeout) {
+    *timeout = -1;
+    return ottsr_clock_pending(((ottsr_clock_source_t *)source)->clock);
+}
+
+static gboolean ottsr_clock_source_check(GSource *source) {
+    return ottsr_clock_pending(((ottsr_clock_source_t *)source)->clock);
+}
+
+// Consumer side: the main loop. Events for a deadline that has since been
+// re-armed or disarmed are dropped here.
+static gboolean ottsr_clock_source_dispatch(GSource *source, GSourceFunc callback, gpointer user_data) {
+    ottsr_clock_t *clock = ((ottsr_clock_source_t *)source)->clock;
+
+    while (ottsr_clock_pending(clock)) {
+        gint tail = clock->tail;
+        ottsr_clock_event_t event = clock->events[tail % OTTSR_CLOCK_QUEUE_SIZE];
+        g_atomic_int_set(&clock->tail, tail + 1);
+
+        if (event.generation == clock->generation) {
+            clock->func(&event, clock->user_data);
+        }
+    }
+
+    gint dropped = g_atomic_int_get(&clock->dropped);
+    if (dropped > 0) {
+        g_atomic_int_add(&clock->dropped, -dropped);
+        g_warning("Phase clock dropped %d events", dropped);
+    }
+    return G_SOURCE_CONTINUE;
+}
+
+static GSourceFuncs ottsr_clock_source_funcs = {
+    ottsr_clock_source_prepare,
+    ottsr_clock_source_check,
+    ottsr_clock_source_dispatch,
+    NULL
+};
+
+ottsr_clock_t *ottsr_clock_new(ottsr_clock_func_t func, gpointer user_data) {
+    ottsr_clock_t *clock = g_new0(ottsr_clock_t, 1);
+    g_mutex_init(&clock->lock);
+    g_cond_init(&clock->cond);
+    clock->func = func;
+    clock->user_data = user_data;
+    clock->context = g_main_context_ref(g_main_context_default());
+
+    clock->source = g_source_new(&ottsr_clock_source_funcs, sizeof(ottsr_clock_source_t));
+    ((ottsr_clock_source_t *)clock->source)->clock = clock;
+    g_source_set_priority(clock->source, G_PRIORITY_HIGH);
+    g_source_attach(clock->source, clock->context);
+
+    clock->thread = g_thread_new("ottsr-clock", ottsr_clock_thread, clock);
+    return clock;
+}
+
+// Fire once at a monotonic time; replaces any deadline already armed
+void ottsr_clock_arm(ottsr_clock_t *clock, gint64 deadline) {
+    g_mutex_lock(&clock->lock);
+    clock->generation++;
+    clock->deadline = deadline;
+    g_cond_signal(&clock->cond);
+    g_mutex_unlock(&clock->lock);
+}
+
+void ottsr_clock_disarm(ottsr_clock_t *clock) {
+    g_mutex_lock(&clock->lock);
+    clock->generation++;
+    clock->deadline = 0;
+    g_cond_signal(&clock->cond);
+    g_mutex_unlock(&clock->lock);
+}
+
+void ottsr_clock_free(ottsr_clock_t *clock) {
+    if (!clock) return;
+
+    g_mutex_lock(&clock->lock);
+    clock->quit = TRUE;
+    g_cond_signal(&clock->cond);
+    g_mutex_unlock(&clock->lock);
+    g_thread_join(clock->thread);
+
+    g_source_destroy(clock->source);
+    g_source_unref(clock->source);
+    g_main_context_unref(clock->context);
+    g_cond_clear(&clock->cond);
+    g_mutex_clear(&clock->lock);
+    g_free(clock);
+}
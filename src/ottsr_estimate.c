@@ -0,0 +1,493 @@
+#include "ottsr.h"
+#include <math.h>
+
+// Suggested study lengths. Every study phase that ends, finished or
+// stopped, updates a handful of running statistics for its profile and for
+// its subject within that profile: an exponentially weighted completion
+// rate, the mean and variance of where early stops happen (Welford), and
+// P-square sketches of the quartiles of early stops. Each update is O(1)
+// and history is only read once, to seed the estimates on first run.
+typedef struct {
+    guint32 magic;
+    guint32 version;
+    guint32 entry_size;
+    guint32 count;
+} ottsr_estimates_header_t;
+
+static const double ottsr_estimate_levels[OTTSR_ESTIMATE_QUANTILES] = { 0.25, 0.5, 0.75 };
+
+// estimates.dat is rewritten from a worker a little after sessions end.
+// Snapshots are numbered so one that finishes late never replaces a newer.
+typedef struct {
+    char *path;
+    GByteArray *data;
+    guint64 generation;
+} ottsr_estimates_save_t;
+
+G_LOCK_DEFINE_STATIC(estimates_file);
+static guint64 ottsr_estimates_generation;
+static guint64 ottsr_estimates_written;
+
+void ottsr_quantile_init(ottsr_quantile_t *quantile, double p) {
+    memset(quantile, 0, sizeof(*quantile));
+    quantile->p = p;
+}
+
+// Piecewise-parabolic step of marker i towards its desired position
+static double ottsr_quantile_parabolic(const ottsr_quantile_t *q, int i, double d) {
+    const double *h = q->heights;
+    const double *n = q->positions;
+    return h[i] + d / (n[i + 1] - n[i - 1]) *
+        ((n[i] - n[i - 1] + d) * (h[i + 1] - h[i]) / (n[i + 1] - n[i]) +
+         (n[i + 1] - n[i] - d) * (h[i] - h[i - 1]) / (n[i] - n[i - 1]));
+}
+
+void ottsr_quantile_add(ottsr_quantile_t *quantile, double value) {
+    double *h = quantile->heights;
+    double *n = quantile->positions;
+    double p = quantile->p;
+
+    // The first five observations become the markers
+    if (quantile->count < 5) {
+        int i = (int)quantile->count++;
+        for (; i > 0 && h[i - 1] > value; i--) h[i] = h[i - 1];
+        h[i] = value;
+        if (quantile->count == 5) {
+            for (int j = 0; j < 5; j++) n[j] = j + 1;
+            quantile->desired[0] = 1;
+            quantile->desired[1] = 1 + 2 * p;
+            quantile->desired[2] = 1 + 4 * p;
+            quantile->desired[3] = 3 + 2 * p;
+            quantile->desired[4] = 5;
+        }
+        return;
+    }
+
+    int k;
+    if (value < h[0]) {
+        h[0] = value;
+        k = 0;
+    } else if (value >= h[4]) {
+        h[4] = value;
+        k = 3;
+    } else {
+        for (k = 0; k < 3 && value >= h[k + 1]; k++);
+    }
+
+    const double increments[5] = { 0, p / 2, p, (1 + p) / 2, 1 };
+    for (int i = k + 1; i < 5; i++) n[i] += 1;
+    for (int i = 0; i < 5; i++) quantile->desired[i] += increments[i];
+
+    for (int i = 1; i < 4; i++) {
+        double d = quantile->desired[i] - n[i];
+        if ((d >= 1 && n[i + 1] - n[i] > 1) || (d <= -1 && n[i - 1] - n[i] < -1)) {
+            d = d > 0 ? 1 : -1;
+            double candidate = ottsr_quantile_parabolic(quantile, i, d);
+            if (h[i - 1] < candidate && candidate < h[i + 1]) {
+                h[i] = candidate;
+            } else {
+                int j = i + (int)d;
+                h[i] += d * (h[j] - h[i]) / (n[j] - n[i]);
+            }
+            n[i] += d;
+        }
+    }
+    quantile->count++;
+}
+
+double ottsr_quantile_value(const ottsr_quantile_t *quantile) {
+    if (quantile->count == 0) return 0.0;
+    if (quantile->count >= 5) return quantile->heights[2];
+
+    // Still exact: the markers are the sorted observations
+    int index = (int)(quantile->p * (quantile->count - 1) + 0.5);
+    return quantile->heights[index];
+}
+
+void ottsr_estimate_add(ottsr_estimate_t *estimate, double minutes, gboolean completed) {
+    double done = completed ? 1.0 : 0.0;
+
+    estimate->sessions++;
+    if (completed) estimate->completed++;
+    estimate->completion = estimate->sessions == 1 ? done :
+        estimate->completion + OTTSR_ESTIMATE_ALPHA * (done - estimate->completion);
+
+    if (!completed) {
+        estimate->stops++;
+        double delta = minutes - estimate->stop_mean;
+        estimate->stop_mean += delta / estimate->stops;
+        estimate->stop_m2 += delta * (minutes - estimate->stop_mean);
+        for (int i = 0; i < OTTSR_ESTIMATE_QUANTILES; i++) {
+            ottsr_quantile_add(&estimate->stop_quantiles[i], minutes);
+        }
+    }
+    estimate->updated_at = g_get_real_time() / G_USEC_PER_SEC;
+}
+
+// Study length in minutes to suggest, or 0 without enough sessions. Nearly
+// always finishing earns a longer phase; finishing too rarely suggests the
+// longest early-stop quartile that would bring completion up to target.
+int ottsr_estimate_recommend(const ottsr_estimate_t *estimate, int study_minutes) {
+    if (!estimate || estimate->sessions < OTTSR_ESTIMATE_MIN_SESSIONS) return 0;
+
+    double rate = estimate->completion;
+    if (rate >= OTTSR_ESTIMATE_STRETCH) return MIN(180, study_minutes + OTTSR_ESTIMATE_STEP);
+    if (rate >= OTTSR_ESTIMATE_TARGET || estimate->stops == 0) return study_minutes;
+
+    // Stopping at the p quantile or later means 1 - p of early stops would
+    // have finished a phase that long
+    double allowed = 1.0 - (OTTSR_ESTIMATE_TARGET - rate) / (1.0 - rate);
+    int level = 0;
+    for (int i = OTTSR_ESTIMATE_QUANTILES - 1; i > 0; i--) {
+        if (ottsr_estimate_levels[i] <= allowed) {
+            level = i;
+            break;
+        }
+    }
+
+    int minutes = (int)ottsr_quantile_value(&estimate->stop_quantiles[level]);
+    minutes = minutes / OTTSR_ESTIMATE_STEP * OTTSR_ESTIMATE_STEP;
+    return CLAMP(minutes, OTTSR_ESTIMATE_STEP, MAX(OTTSR_ESTIMATE_STEP, study_minutes));
+}
+
+static char *ottsr_estimates_path(void) {
+    char *config_dir = ottsr_get_config_path();
+    if (!config_dir) return NULL;
+
+    char *path = g_build_filename(config_dir, OTTSR_ESTIMATES_FILE, NULL);
+    g_free(config_dir);
+    return path;
+}
+
+static char *ottsr_estimate_key(const char *profile, const char *subject) {
+    return g_strconcat(profile, "\x1f", subject, NULL);
+}
+
+static GHashTable *ottsr_estimates_table_new(void) {
+    return g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+}
+
+static ottsr_estimate_t *ottsr_estimates_get(GHashTable *table, const char *profile, const char *subject) {
+    char *key = ottsr_estimate_key(profile, subject);
+    ottsr_estimate_t *estimate = g_hash_table_lookup(table, key);
+    if (estimate) {
+        g_free(key);
+        return estimate;
+    }
+
+    // Profiles always get an entry; past the cap new subjects do not
+    if (*subject && g_hash_table_size(table) >= OTTSR_ESTIMATE_MAX_ENTRIES) {
+        g_free(key);
+        return NULL;
+    }
+
+    estimate = g_new0(ottsr_estimate_t, 1);
+    g_strlcpy(estimate->profile, profile, OTTSR_MAX_NAME_LEN);
+    g_strlcpy(estimate->subject, subject, OTTSR_MAX_NAME_LEN);
+    for (int i = 0; i < OTTSR_ESTIMATE_QUANTILES; i++) {
+        ottsr_quantile_init(&estimate->stop_quantiles[i], ottsr_estimate_levels[i]);
+    }
+    g_hash_table_insert(table, key, estimate);
+    return estimate;
+}
+
+static void ottsr_estimates_apply(GHashTable *table, const ottsr_history_record_t *sample) {
+    double minutes = sample->study_seconds / 60.0;
+
+    ottsr_estimate_add(ottsr_estimates_get(table, sample->profile, ""), minutes, sample->completed);
+    if (*sample->subject) {
+        ottsr_estimate_t *estimate = ottsr_estimates_get(table, sample->profile, sample->subject);
+        if (estimate) ottsr_estimate_add(estimate, minutes, sample->completed);
+    }
+}
+
+static GHashTable *ottsr_estimates_read(const char *path) {
+    char *contents = NULL;
+    gsize length = 0;
+    if (!path || !g_file_get_contents(path, &contents, &length, NULL)) return NULL;
+
+    GHashTable *table = NULL;
+    ottsr_estimates_header_t header;
+    if (length >= sizeof(header)) {
+        memcpy(&header, contents, sizeof(header));
+        if (header.magic == OTTSR_ESTIMATES_MAGIC &&
+            header.version == OTTSR_ESTIMATES_VERSION &&
+            header.entry_size == sizeof(ottsr_estimate_t) &&
+            header.count <= (length - sizeof(header)) / sizeof(ottsr_estimate_t)) {
+            table = ottsr_estimates_table_new();
+            for (guint32 i = 0; i < header.count; i++) {
+                ottsr_estimate_t *estimate = g_new(ottsr_estimate_t, 1);
+                memcpy(estimate, contents + sizeof(header) + i * sizeof(ottsr_estimate_t), sizeof(*estimate));
+                estimate->profile[OTTSR_MAX_NAME_LEN - 1] = '\0';
+                estimate->subject[OTTSR_MAX_NAME_LEN - 1] = '\0';
+                g_hash_table_insert(table, ottsr_estimate_key(estimate->profile, estimate->subject), estimate);
+            }
+        } else {
+            g_warning("Ignoring session estimates with unknown format");
+        }
+    }
+
+    g_free(contents);
+    return table;
+}
+
+static GByteArray *ottsr_estimates_serialize(GHashTable *table) {
+    ottsr_estimates_header_t header = {0};
+    header.magic = OTTSR_ESTIMATES_MAGIC;
+    header.version = OTTSR_ESTIMATES_VERSION;
+    header.entry_size = sizeof(ottsr_estimate_t);
+    header.count = g_hash_table_size(table);
+
+    GByteArray *out = g_byte_array_sized_new(sizeof(header) + header.count * sizeof(ottsr_estimate_t));
+    g_byte_array_append(out, (const guint8 *)&header, sizeof(header));
+
+    GHashTableIter iter;
+    gpointer value;
+    g_hash_table_iter_init(&iter, table);
+    while (g_hash_table_iter_next(&iter, NULL, &value)) {
+        g_byte_array_append(out, value, sizeof(ottsr_estimate_t));
+    }
+    return out;
+}
+
+static guint64 ottsr_estimates_next(void) {
+    G_LOCK(estimates_file);
+    guint64 generation = ++ottsr_estimates_generation;
+    G_UNLOCK(estimates_file);
+    return generation;
+}
+
+// A snapshot has been taken that is not on disk yet
+static gboolean ottsr_estimates_unsaved(void) {
+    G_LOCK(estimates_file);
+    gboolean unsaved = ottsr_estimates_written < ottsr_estimates_generation;
+    G_UNLOCK(estimates_file);
+    return unsaved;
+}
+
+// Hand out a generation that counts as written, so saves in flight with an
+// older one are dropped; for data written outside ottsr_estimates_store
+static void ottsr_estimates_supersede(void) {
+    G_LOCK(estimates_file);
+    ottsr_estimates_written = ++ottsr_estimates_generation;
+    G_UNLOCK(estimates_file);
+}
+
+static void ottsr_estimates_store(const char *path, GByteArray *data, guint64 generation) {
+    G_LOCK(estimates_file);
+    if (generation > ottsr_estimates_written) {
+        GError *error = NULL;
+        if (!g_file_set_contents(path, (const char *)data->data, data->len, &error)) {
+            g_warning("Failed to save session estimates %s: %s", path, error->message);
+            g_error_free(error);
+        }
+        ottsr_estimates_written = generation;
+    }
+    G_UNLOCK(estimates_file);
+}
+
+static void ottsr_estimates_write(const char *path, GHashTable *table) {
+    if (!path) return;
+
+    GByteArray *data = ottsr_estimates_serialize(table);
+    ottsr_estimates_store(path, data, ottsr_estimates_next());
+    g_byte_array_unref(data);
+}
+
+// No estimates yet: build them once from the whole history
+static GHashTable *ottsr_estimates_seed(void) {
+    GHashTable *table = ottsr_estimates_table_new();
+    GArray *records = ottsr_history_read_all();
+
+    for (guint i = 0; i < records->len; i++) {
+        const ottsr_history_record_t *record = &g_array_index(records, ottsr_history_record_t, i);
+        if (record->completed || record->study_seconds >= OTTSR_ESTIMATE_MIN_SECONDS) {
+            ottsr_estimates_apply(table, record);
+        }
+    }
+
+    g_array_unref(records);
+    return table;
+}
+
+static void ottsr_estimates_load_thread(GTask *task, gpointer source, gpointer task_data,
+                                        GCancellable *cancellable) {
+    const char *path = task_data;
+    GHashTable *table = ottsr_estimates_read(path);
+
+    if (!table) {
+        table = ottsr_estimates_seed();
+        if (!g_cancellable_is_cancelled(cancellable)) ottsr_estimates_write(path, table);
+    }
+    g_task_return_pointer(task, table, (GDestroyNotify)g_hash_table_unref);
+}
+
+static void ottsr_estimates_save_schedule(ottsr_app_t *app);
+
+static void ottsr_estimates_load_done(GObject *source, GAsyncResult *result, gpointer user_data) {
+    ottsr_app_t *app = (ottsr_app_t *)user_data;
+    GHashTable *table = g_task_propagate_pointer(G_TASK(result), NULL);
+
+    // Cancelled because a kiosk switched user
+    if (!table) return;
+
+    if (app->estimates) g_hash_table_destroy(app->estimates);
+    app->estimates = table;
+
+    // Sessions that ended while loading
+    if (app->pending_estimates->len > 0) {
+        for (guint i = 0; i < app->pending_estimates->len; i++) {
+            ottsr_estimates_apply(table, &g_array_index(app->pending_estimates, ottsr_history_record_t, i));
+        }
+        g_array_set_size(app->pending_estimates, 0);
+        ottsr_estimates_save_schedule(app);
+    }
+
+    g_debug("Session estimates ready: %u entries", g_hash_table_size(table));
+}
+
+static void ottsr_estimates_save_free(ottsr_estimates_save_t *save) {
+    g_free(save->path);
+    g_byte_array_unref(save->data);
+    g_free(save);
+}
+
+static void ottsr_estimates_save_thread(GTask *task, gpointer source, gpointer task_data,
+                                        GCancellable *cancellable) {
+    ottsr_estimates_save_t *save = task_data;
+    ottsr_estimates_store(save->path, save->data, save->generation);
+    g_task_return_boolean(task, TRUE);
+}
+
+// Snapshot the table here, where it is only ever touched, and write it there
+static gboolean ottsr_estimates_save_begin(gpointer user_data) {
+    ottsr_app_t *app = (ottsr_app_t *)user_data;
+    app->estimates_save_id = 0;
+
+    char *path = ottsr_estimates_path();
+    if (!path || !app->estimates) {
+        g_free(path);
+        return G_SOURCE_REMOVE;
+    }
+
+    ottsr_estimates_save_t *save = g_new0(ottsr_estimates_save_t, 1);
+    save->path = path;
+    save->data = ottsr_estimates_serialize(app->estimates);
+    save->generation = ottsr_estimates_next();
+
+    GTask *task = g_task_new(NULL, NULL, NULL, NULL);
+    g_task_set_task_data(task, save, (GDestroyNotify)ottsr_estimates_save_free);
+    g_task_run_in_thread(task, ottsr_estimates_save_thread);
+    g_object_unref(task);
+    return G_SOURCE_REMOVE;
+}
+
+// Sessions ending close together share one rewrite
+static void ottsr_estimates_save_schedule(ottsr_app_t *app) {
+    if (app->estimates_save_id > 0) return;
+    app->estimates_save_id = g_timeout_add_seconds(OTTSR_ESTIMATES_SAVE_DELAY, ottsr_estimates_save_begin, app);
+}
+
+void ottsr_estimates_load_async(ottsr_app_t *app) {
+    if (!app->pending_estimates) {
+        app->pending_estimates = g_array_new(FALSE, FALSE, sizeof(ottsr_history_record_t));
+    }
+
+    GTask *task = g_task_new(NULL, app->user_cancel, ottsr_estimates_load_done, app);
+    g_task_set_task_data(task, ottsr_estimates_path(), g_free);
+    g_task_run_in_thread(task, ottsr_estimates_load_thread);
+    g_object_unref(task);
+}
+
+void ottsr_estimates_clear(ottsr_app_t *app) {
+    // Quitting or switching user: changes not on disk yet are written while
+    // the path is still this user's, superseding any save in flight. A kiosk
+    // switch leaves the write to the kiosk writer.
+    gboolean unsaved = ottsr_estimates_unsaved();
+    if (app->estimates_save_id > 0) {
+        g_source_remove(app->estimates_save_id);
+        app->estimates_save_id = 0;
+        unsaved = TRUE;
+    }
+    if (unsaved && app->estimates) {
+        char *path = ottsr_estimates_path();
+        if (path && app->kiosk) {
+            GByteArray *data = ottsr_estimates_serialize(app->estimates);
+            ottsr_estimates_supersede();
+            gsize length = data->len;
+            ottsr_kiosk_write_file(app, path, (char *)g_byte_array_free(data, FALSE), length);
+        } else {
+            ottsr_estimates_write(path, app->estimates);
+            g_free(path);
+        }
+    }
+    if (app->estimates) {
+        g_hash_table_destroy(app->estimates);
+        app->estimates = NULL;
+    }
+    if (app->pending_estimates) g_array_set_size(app->pending_estimates, 0);
+}
+
+// A study phase ended; sample holds the whole phase's study time
+void ottsr_estimates_record(ottsr_app_t *app, const ottsr_history_record_t *sample) {
+    if (!app->pending_estimates) return;
+
+    // Stopped within a minute: a misclick or a false start, not a preference
+    if (!sample->completed && sample->study_seconds < OTTSR_ESTIMATE_MIN_SECONDS) return;
+
+    if (!app->estimates) {
+        g_array_append_val(app->pending_estimates, *sample);
+        return;
+    }
+
+    ottsr_estimates_apply(app->estimates, sample);
+    ottsr_estimates_save_schedule(app);
+}
+
+const ottsr_estimate_t *ottsr_estimates_lookup(ottsr_app_t *app, const char *profile, const char *subject) {
+    if (!app->estimates) return NULL;
+
+    char *key = ottsr_estimate_key(profile, subject ? subject : "");
+    const ottsr_estimate_t *estimate = g_hash_table_lookup(app->estimates, key);
+    g_free(key);
+    return estimate;
+}
+
+// Fill the profile editor's suggestion for profile
+void ottsr_estimates_show(ottsr_app_t *app, const ottsr_profile_t *profile) {
+    if (!app->profile_suggestion_label) return;
+
+    const ottsr_estimate_t *estimate = ottsr_estimates_lookup(app, profile->name, "");
+    int suggested = ottsr_estimate_recommend(estimate, profile->study_minutes);
+    GString *text = g_string_new(NULL);
+
+    if (!app->estimates) {
+        g_string_assign(text, "Reading past sessions...");
+    } else if (suggested == 0) {
+        g_string_printf(text, "A suggested study time appears after %u more sessions",
+                        OTTSR_ESTIMATE_MIN_SESSIONS - (estimate ? estimate->sessions : 0));
+    } else {
+        g_string_printf(text, "Suggested study time: %d min\n%.0f%% of recent sessions finished",
+                        suggested, estimate->completion * 100.0);
+        if (estimate->stops > 0) {
+            double spread = estimate->stops > 1 ? sqrt(estimate->stop_m2 / (estimate->stops - 1)) : 0.0;
+            g_string_append_printf(text, "; early stops after %.0f ± %.0f min, half before %.0f",
+                                   estimate->stop_mean, spread,
+                                   ottsr_quantile_value(&estimate->stop_quantiles[1]));
+        }
+
+        const char *subject = app->config.last_subject;
+        const ottsr_estimate_t *by_subject = *subject ? ottsr_estimates_lookup(app, profile->name, subject) : NULL;
+        int subject_minutes = ottsr_estimate_recommend(by_subject, profile->study_minutes);
+        if (subject_minutes > 0) {
+            g_string_append_printf(text, "\nFor %s: %d min (%.0f%% finished)",
+                                   subject, subject_minutes, by_subject->completion * 100.0);
+        }
+    }
+
+    gtk_label_set_text(GTK_LABEL(app->profile_suggestion_label), text->str);
+    g_string_free(text, TRUE);
+
+    app->profile_suggested_minutes = suggested;
+    gtk_widget_set_sensitive(app->profile_suggestion_button, suggested > 0 && suggested != profile->study_minutes);
+}
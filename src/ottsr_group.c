@@ -0,0 +1,566 @@
+#include "ottsr.h"
+
+// Study groups: one leader announces its phases over UDP multicast and the
+// followers run the same schedule on their own phase clocks.
+//
+// Nothing is sent per tick. A joining follower sends a short burst of
+// probes; the leader stamps when it got each one and when it answered, and
+// the follower estimates the offset between the two monotonic clocks the
+// way NTP does, keeping the sample with the least round-trip delay (its
+// error is at most half that delay). The leader announces each phase once,
+// as an anchor on its own clock, repeated a few times against loss, and
+// followers arm from the anchor mapped onto their clock. A shorter burst
+// after each announcement keeps clock drift in check.
+typedef enum {
+    OTTSR_GROUP_PROBE = 1,
+    OTTSR_GROUP_REPLY,
+    OTTSR_GROUP_ANNOUNCE
+} ottsr_group_kind_t;
+
+#define OTTSR_GROUP_WANT_PHASE 0x01
+#define OTTSR_GROUP_LONG_BREAK 0x02
+
+// Monotonic clocks drift apart by up to this much; an old sample's delay is
+// aged by it so a fresh one can replace it
+#define OTTSR_GROUP_DRIFT_PPM 100
+
+// Big-endian on the wire, OTTSR_GROUP_MESSAGE_SIZE bytes: magic, version,
+// kind, state, flags, then group, sender, target and sequence, then t1, t2,
+// t3 and anchor as 64-bit values, then the phase lengths and counters
+
+typedef struct {
+    guint8 kind;
+    guint8 flags;
+    guint32 group;
+    guint32 sender;
+    guint32 target;
+    guint32 sequence;
+    gint64 t1;
+    gint64 t2;
+    gint64 t3;
+    ottsr_group_phase_t phase;
+} ottsr_group_message_t;
+
+struct ottsr_group {
+    guint32 id;
+    guint32 group_id;
+    gboolean leader;
+    ottsr_group_send_func_t send;
+    ottsr_group_clock_func_t clock;
+    ottsr_group_phase_func_t follow;
+    gpointer user_data;
+
+    // Leader: the phase being announced
+    ottsr_group_phase_t phase;
+    gboolean has_phase;
+    guint32 sequence;
+    int repeats_left;
+    guint repeat_id;
+
+    // Follower: the leader's clock relative to ours, and its last phase
+    // (anchored on the leader's clock)
+    guint32 leader_id;
+    guint32 probe;
+    int probes_left;
+    guint probe_id;
+    guint retry_id;
+    int samples;
+    gint64 offset;
+    gint64 delay;
+    gint64 sampled_at;
+    gint64 applied_offset;
+    ottsr_group_phase_t leader_phase;
+    gboolean has_leader_phase;
+    guint32 leader_sequence;
+};
+
+static void ottsr_group_put32(guint8 **cursor, guint32 value) {
+    value = GUINT32_TO_BE(value);
+    memcpy(*cursor, &value, sizeof(value));
+    *cursor += sizeof(value);
+}
+
+static void ottsr_group_put64(guint8 **cursor, gint64 value) {
+    guint64 bits = GUINT64_TO_BE((guint64)value);
+    memcpy(*cursor, &bits, sizeof(bits));
+    *cursor += sizeof(bits);
+}
+
+static guint32 ottsr_group_get32(const guint8 **cursor) {
+    guint32 value;
+    memcpy(&value, *cursor, sizeof(value));
+    *cursor += sizeof(value);
+    return GUINT32_FROM_BE(value);
+}
+
+static gint64 ottsr_group_get64(const guint8 **cursor) {
+    guint64 bits;
+    memcpy(&bits, *cursor, sizeof(bits));
+    *cursor += sizeof(bits);
+    return (gint64)GUINT64_FROM_BE(bits);
+}
+
+static void ottsr_group_encode(const ottsr_group_message_t *message, guint8 *buffer) {
+    guint8 *cursor = buffer;
+    const ottsr_group_phase_t *phase = &message->phase;
+
+    ottsr_group_put32(&cursor, OTTSR_GROUP_MAGIC);
+    *cursor++ = OTTSR_GROUP_VERSION;
+    *cursor++ = message->kind;
+    *cursor++ = (guint8)phase->state;
+    *cursor++ = message->flags | (phase->is_long_break ? OTTSR_GROUP_LONG_BREAK : 0);
+    ottsr_group_put32(&cursor, message->group);
+    ottsr_group_put32(&cursor, message->sender);
+    ottsr_group_put32(&cursor, message->target);
+    ottsr_group_put32(&cursor, message->sequence);
+    ottsr_group_put64(&cursor, message->t1);
+    ottsr_group_put64(&cursor, message->t2);
+    ottsr_group_put64(&cursor, message->t3);
+    ottsr_group_put64(&cursor, phase->anchor);
+    ottsr_group_put32(&cursor, (guint32)phase->study_seconds);
+    ottsr_group_put32(&cursor, (guint32)phase->break_seconds);
+    ottsr_group_put32(&cursor, (guint32)phase->long_break_seconds);
+    ottsr_group_put32(&cursor, (guint32)phase->sessions_until_long_break);
+    ottsr_group_put32(&cursor, (guint32)phase->current_sessions);
+    ottsr_group_put32(&cursor, (guint32)phase->elapsed_study_seconds);
+    ottsr_group_put32(&cursor, (guint32)phase->elapsed_break_seconds);
+}
+
+static gboolean ottsr_group_decode(const guint8 *buffer, gsize length, ottsr_group_message_t *message) {
+    if (length != OTTSR_GROUP_MESSAGE_SIZE) return FALSE;
+
+    const guint8 *cursor = buffer;
+    if (ottsr_group_get32(&cursor) != OTTSR_GROUP_MAGIC || *cursor++ != OTTSR_GROUP_VERSION) return FALSE;
+
+    ottsr_group_phase_t *phase = &message->phase;
+    message->kind = *cursor++;
+    guint8 state = *cursor++;
+    message->flags = *cursor++;
+    if (state > OTTSR_STATE_PAUSED) return FALSE;
+    phase->state = (ottsr_state_t)state;
+    phase->is_long_break = (message->flags & OTTSR_GROUP_LONG_BREAK) != 0;
+
+    message->group = ottsr_group_get32(&cursor);
+    message->sender = ottsr_group_get32(&cursor);
+    message->target = ottsr_group_get32(&cursor);
+    message->sequence = ottsr_group_get32(&cursor);
+    message->t1 = ottsr_group_get64(&cursor);
+    message->t2 = ottsr_group_get64(&cursor);
+    message->t3 = ottsr_group_get64(&cursor);
+    phase->anchor = ottsr_group_get64(&cursor);
+    phase->study_seconds = (gint32)ottsr_group_get32(&cursor);
+    phase->break_seconds = (gint32)ottsr_group_get32(&cursor);
+    phase->long_break_seconds = (gint32)ottsr_group_get32(&cursor);
+    phase->sessions_until_long_break = (gint32)ottsr_group_get32(&cursor);
+    phase->current_sessions = (gint32)ottsr_group_get32(&cursor);
+    phase->elapsed_study_seconds = (gint32)ottsr_group_get32(&cursor);
+    phase->elapsed_break_seconds = (gint32)ottsr_group_get32(&cursor);
+    return TRUE;
+}
+
+static void ottsr_group_send(ottsr_group_t *group, ottsr_group_message_t *message) {
+    guint8 buffer[OTTSR_GROUP_MESSAGE_SIZE];
+    message->group = group->group_id;
+    message->sender = group->id;
+    ottsr_group_encode(message, buffer);
+    group->send(buffer, sizeof(buffer), group->user_data);
+}
+
+// Leader side
+static void ottsr_group_send_phase(ottsr_group_t *group) {
+    ottsr_group_message_t message = {0};
+    message.kind = OTTSR_GROUP_ANNOUNCE;
+    message.sequence = group->sequence;
+    message.t3 = group->clock(group->user_data);
+    message.phase = group->phase;
+    ottsr_group_send(group, &message);
+}
+
+static gboolean ottsr_group_repeat(gpointer user_data) {
+    ottsr_group_t *group = user_data;
+    ottsr_group_send_phase(group);
+    if (--group->repeats_left > 0) return G_SOURCE_CONTINUE;
+    group->repeat_id = 0;
+    return G_SOURCE_REMOVE;
+}
+
+// Announce a phase (anchored on our clock); followers skip the repeats
+void ottsr_group_publish(ottsr_group_t *group, const ottsr_group_phase_t *phase) {
+    if (!group->leader) return;
+
+    group->phase = *phase;
+    group->has_phase = TRUE;
+    group->sequence++;
+    ottsr_group_send_phase(group);
+
+    group->repeats_left = OTTSR_GROUP_REPEATS - 1;
+    if (group->repeats_left > 0 && group->repeat_id == 0) {
+        group->repeat_id = g_timeout_add(OTTSR_GROUP_REPEAT_MS, ottsr_group_repeat, group);
+    }
+}
+
+static void ottsr_group_answer(ottsr_group_t *group, const ottsr_group_message_t *probe, gint64 received_at) {
+    ottsr_group_message_t reply = {0};
+    reply.kind = OTTSR_GROUP_REPLY;
+    reply.target = probe->sender;
+    reply.sequence = probe->sequence;
+    reply.t1 = probe->t1;
+    reply.t2 = received_at;
+    reply.t3 = group->clock(group->user_data);
+    ottsr_group_send(group, &reply);
+
+    if ((probe->flags & OTTSR_GROUP_WANT_PHASE) && group->has_phase) {
+        ottsr_group_send_phase(group);
+    }
+}
+
+// Follower side
+static void ottsr_group_apply(ottsr_group_t *group) {
+    ottsr_group_phase_t phase = group->leader_phase;
+    phase.anchor -= group->offset;
+    group->applied_offset = group->offset;
+    group->follow(&phase, group->user_data);
+}
+
+static void ottsr_group_send_probe(ottsr_group_t *group) {
+    ottsr_group_message_t probe = {0};
+    probe.kind = OTTSR_GROUP_PROBE;
+    probe.flags = group->has_leader_phase ? 0 : OTTSR_GROUP_WANT_PHASE;
+    probe.target = group->leader_id;
+    probe.sequence = ++group->probe;
+    probe.t1 = group->clock(group->user_data);
+    group->probes_left--;
+    ottsr_group_send(group, &probe);
+}
+
+static void ottsr_group_burst(ottsr_group_t *group, int probes);
+
+static gboolean ottsr_group_retry(gpointer user_data) {
+    ottsr_group_t *group = user_data;
+    group->retry_id = 0;
+    ottsr_group_burst(group, OTTSR_GROUP_PROBES);
+    return G_SOURCE_REMOVE;
+}
+
+static gboolean ottsr_group_probe_tick(gpointer user_data) {
+    ottsr_group_t *group = user_data;
+    if (group->probes_left > 0) {
+        ottsr_group_send_probe(group);
+        return G_SOURCE_CONTINUE;
+    }
+
+    // Nobody answered, or the phase never came: try again in a while
+    group->probe_id = 0;
+    if (group->samples == 0 || !group->has_leader_phase) {
+        group->retry_id = g_timeout_add(OTTSR_GROUP_RETRY_MS, ottsr_group_retry, group);
+    }
+    return G_SOURCE_REMOVE;
+}
+
+static void ottsr_group_burst(ottsr_group_t *group, int probes) {
+    if (group->probe_id > 0) return;
+    if (group->retry_id > 0) {
+        g_source_remove(group->retry_id);
+        group->retry_id = 0;
+    }
+
+    group->probes_left = probes;
+    ottsr_group_send_probe(group);
+    group->probe_id = g_timeout_add(OTTSR_GROUP_PROBE_MS, ottsr_group_probe_tick, group);
+}
+
+static void ottsr_group_sample(ottsr_group_t *group, const ottsr_group_message_t *reply, gint64 received_at) {
+    if (reply->sender != group->leader_id) return;
+
+    gint64 delay = (received_at - reply->t1) - (reply->t3 - reply->t2);
+    gint64 offset = ((reply->t2 - reply->t1) + (reply->t3 - received_at)) / 2;
+    if (delay < 0) return;
+
+    if (group->samples > 0) {
+        gint64 aged = group->delay + (received_at - group->sampled_at) * 2 * OTTSR_GROUP_DRIFT_PPM / 1000000;
+        if (delay >= aged) {
+            group->samples++;
+            return;
+        }
+    }
+
+    group->offset = offset;
+    group->delay = delay;
+    group->sampled_at = received_at;
+    gboolean first = group->samples++ == 0;
+
+    if (group->has_leader_phase && (first || ABS(offset - group->applied_offset) > 1000)) {
+        ottsr_group_apply(group);
+    }
+}
+
+static void ottsr_group_adopt(ottsr_group_t *group, guint32 leader_id) {
+    if (group->leader_id != 0) g_debug("Study group leader changed to %08x", leader_id);
+    group->leader_id = leader_id;
+    group->samples = 0;
+    group->has_leader_phase = FALSE;
+    group->leader_sequence = 0;
+}
+
+static void ottsr_group_announced(ottsr_group_t *group, const ottsr_group_message_t *message) {
+    if (message->sender != group->leader_id) {
+        ottsr_group_adopt(group, message->sender);
+    } else if (group->has_leader_phase && message->sequence <= group->leader_sequence) {
+        return;
+    }
+
+    group->leader_phase = message->phase;
+    group->leader_sequence = message->sequence;
+    group->has_leader_phase = TRUE;
+
+    if (group->samples > 0) {
+        ottsr_group_apply(group);
+        ottsr_group_burst(group, OTTSR_GROUP_RESYNC_PROBES);
+    } else {
+        ottsr_group_burst(group, OTTSR_GROUP_PROBES);
+    }
+}
+
+void ottsr_group_receive(ottsr_group_t *group, const guint8 *data, gsize length) {
+    gint64 received_at = group->clock(group->user_data);
+    ottsr_group_message_t message = {0};
+
+    if (!ottsr_group_decode(data, length, &message)) return;
+    if (message.group != group->group_id || message.sender == group->id) return;
+
+    switch (message.kind) {
+        case OTTSR_GROUP_PROBE:
+            if (group->leader && (message.target == 0 || message.target == group->id)) {
+                ottsr_group_answer(group, &message, received_at);
+            }
+            break;
+        case OTTSR_GROUP_REPLY:
+            if (!group->leader && message.target == group->id) {
+                if (group->leader_id == 0) ottsr_group_adopt(group, message.sender);
+                ottsr_group_sample(group, &message, received_at);
+            }
+            break;
+        case OTTSR_GROUP_ANNOUNCE:
+            if (!group->leader) ottsr_group_announced(group, &message);
+            break;
+    }
+}
+
+// Start (or restart) synchronizing with whoever leads the group
+void ottsr_group_join(ottsr_group_t *group) {
+    if (group->leader) return;
+    ottsr_group_burst(group, OTTSR_GROUP_PROBES);
+}
+
+// The leader's clock minus ours, and the round trip it was measured over
+gboolean ottsr_group_get_offset(ottsr_group_t *group, gint64 *offset, gint64 *delay) {
+    if (group->samples == 0) return FALSE;
+    if (offset) *offset = group->offset;
+    if (delay) *delay = group->delay;
+    return TRUE;
+}
+
+ottsr_group_t *ottsr_group_new(const char *name, gboolean leader, ottsr_group_send_func_t send,
+                               ottsr_group_clock_func_t clock, ottsr_group_phase_func_t follow,
+                               gpointer user_data) {
+    ottsr_group_t *group = g_new0(ottsr_group_t, 1);
+    group->id = g_random_int() | 1;
+    group->group_id = (guint32)ottsr_hash_bytes(name, strlen(name));
+    group->leader = leader;
+    group->send = send;
+    group->clock = clock;
+    group->follow = follow;
+    group->user_data = user_data;
+    return group;
+}
+
+void ottsr_group_free(ottsr_group_t *group) {
+    if (!group) return;
+    if (group->repeat_id > 0) g_source_remove(group->repeat_id);
+    if (group->probe_id > 0) g_source_remove(group->probe_id);
+    if (group->retry_id > 0) g_source_remove(group->retry_id);
+    g_free(group);
+}
+
+// The app over a multicast socket
+static void ottsr_group_socket_send(const guint8 *data, gsize length, gpointer user_data) {
+    ottsr_app_t *app = user_data;
+    GError *error = NULL;
+
+    if (g_socket_send_to(app->group_socket, app->group_address, (const gchar *)data, length, NULL, &error) < 0) {
+        g_debug("Study group send failed: %s", error->message);
+        g_error_free(error);
+    }
+}
+
+static gint64 ottsr_group_monotonic(gpointer user_data) {
+    return g_get_monotonic_time();
+}
+
+static gboolean ottsr_group_readable(GSocket *socket, GIOCondition condition, gpointer user_data) {
+    ottsr_app_t *app = user_data;
+    guint8 buffer[OTTSR_GROUP_MESSAGE_SIZE + 1];
+
+    for (;;) {
+        GError *error = NULL;
+        gssize length = g_socket_receive(socket, (gchar *)buffer, sizeof(buffer), NULL, &error);
+        if (length < 0) {
+            if (!g_error_matches(error, G_IO_ERROR, G_IO_ERROR_WOULD_BLOCK)) {
+                g_debug("Study group receive failed: %s", error->message);
+            }
+            g_error_free(error);
+            break;
+        }
+        ottsr_group_receive(app->group, buffer, (gsize)length);
+    }
+    return G_SOURCE_CONTINUE;
+}
+
+static int ottsr_group_profile(ottsr_app_t *app) {
+    int index = app->session.state == OTTSR_STATE_IDLE ? app->config.active_profile : app->session.profile_index;
+    return CLAMP(index, 0, MAX(0, app->config.profile_count - 1));
+}
+
+// The leader's lengths must be ones its profile editor allows, so a stray
+// or corrupt datagram cannot stall the timer or spin it through phases
+static gboolean ottsr_group_lengths_valid(const ottsr_group_phase_t *phase) {
+    return phase->study_seconds >= 60 && phase->study_seconds <= 180 * 60 &&
+           phase->break_seconds >= 60 && phase->break_seconds <= 60 * 60 &&
+           phase->long_break_seconds >= 5 * 60 && phase->long_break_seconds <= 120 * 60 &&
+           phase->sessions_until_long_break >= 1 && phase->sessions_until_long_break <= 10;
+}
+
+// The group runs on the leader's lengths for this session only; stopping it
+// drops them and the follower's own profile is never touched
+static void ottsr_group_lengths_apply(ottsr_app_t *app, const ottsr_group_phase_t *phase) {
+    app->session.group_study_seconds = phase->study_seconds;
+    app->session.group_break_seconds = phase->break_seconds;
+    app->session.group_long_break_seconds = phase->long_break_seconds;
+    app->session.group_sessions_until_long_break = phase->sessions_until_long_break;
+}
+
+// Take on the leader's phase. A phase this follower's own clock has not
+// finished yet is finished as the clock would have; anything further off
+// (joining mid-break, a leader that paused) is entered directly.
+static void ottsr_group_follow(const ottsr_group_phase_t *phase, gpointer user_data) {
+    ottsr_app_t *app = user_data;
+
+    if (!ottsr_group_lengths_valid(phase)) {
+        g_debug("Study group: ignoring phase with out-of-range lengths (%d/%d/%d s, every %d)",
+                phase->study_seconds, phase->break_seconds, phase->long_break_seconds,
+                phase->sessions_until_long_break);
+        return;
+    }
+
+    if (phase->state == OTTSR_STATE_IDLE) {
+        ottsr_stop_session(app);
+        return;
+    }
+
+    gboolean running = app->session.state == OTTSR_STATE_STUDYING || app->session.state == OTTSR_STATE_BREAKING;
+    ottsr_group_lengths_apply(app, phase);
+    if (app->session.state == OTTSR_STATE_IDLE) ottsr_start_session(app);
+
+    if (phase->state == OTTSR_STATE_PAUSED) {
+        if (app->session.state != OTTSR_STATE_PAUSED) ottsr_pause_session(app);
+        app->session.is_long_break = phase->is_long_break;
+        app->session.current_sessions = phase->current_sessions;
+        app->session.elapsed_study_seconds = phase->elapsed_study_seconds;
+        app->session.elapsed_break_seconds = phase->elapsed_break_seconds;
+        ottsr_update_display(app);
+        return;
+    }
+
+    if (app->session.state == OTTSR_STATE_PAUSED) ottsr_pause_session(app);
+    if (running && app->session.state != phase->state) ottsr_phase_advance(app, phase->anchor);
+
+    // A break that ended without autostart leaves the session stopped
+    if (app->session.state == OTTSR_STATE_IDLE) {
+        ottsr_group_lengths_apply(app, phase);
+        ottsr_start_session(app);
+    }
+    app->session.current_sessions = phase->current_sessions;
+    ottsr_phase_enter(app, phase->state, phase->is_long_break, phase->anchor);
+}
+
+// Announce the session as it now stands, if this instance leads a group
+void ottsr_group_announce(ottsr_app_t *app) {
+    if (!app->group || app->config.group_role != OTTSR_GROUP_LEADER) return;
+
+    ottsr_session_sync(app);
+    const ottsr_profile_t *profile = &app->config.profiles[ottsr_group_profile(app)];
+
+    ottsr_group_phase_t phase = {0};
+    phase.state = app->session.state;
+    phase.is_long_break = app->session.is_long_break;
+    phase.anchor = app->phase_anchor;
+    phase.study_seconds = profile->study_minutes * 60;
+    phase.break_seconds = profile->break_minutes * 60;
+    phase.long_break_seconds = profile->long_break_minutes * 60;
+    phase.sessions_until_long_break = profile->sessions_until_long_break;
+    phase.current_sessions = app->session.current_sessions;
+    phase.elapsed_study_seconds = app->session.elapsed_study_seconds;
+    phase.elapsed_break_seconds = app->session.elapsed_break_seconds;
+    ottsr_group_publish(app->group, &phase);
+}
+
+void ottsr_group_start(ottsr_app_t *app) {
+    if (app->config.group_role == OTTSR_GROUP_NONE) return;
+
+    GError *error = NULL;
+    GInetAddress *address = g_inet_address_new_from_string(OTTSR_GROUP_ADDRESS);
+    GInetAddress *any = g_inet_address_new_any(G_SOCKET_FAMILY_IPV4);
+    GSocketAddress *bind_address = g_inet_socket_address_new(any, OTTSR_GROUP_PORT);
+
+    // Several instances on one machine share the port, hence the reuse
+    GSocket *socket = g_socket_new(G_SOCKET_FAMILY_IPV4, G_SOCKET_TYPE_DATAGRAM, G_SOCKET_PROTOCOL_UDP, &error);
+    gboolean ok = socket &&
+        g_socket_bind(socket, bind_address, TRUE, &error) &&
+        g_socket_join_multicast_group(socket, address, FALSE, NULL, &error);
+    g_object_unref(bind_address);
+    g_object_unref(any);
+
+    if (!ok) {
+        g_warning("Failed to join study group %s: %s", app->config.group_name, error->message);
+        g_error_free(error);
+        if (socket) g_object_unref(socket);
+        g_object_unref(address);
+        return;
+    }
+
+    g_socket_set_blocking(socket, FALSE);
+    g_socket_set_multicast_ttl(socket, 1);
+    g_socket_set_multicast_loopback(socket, TRUE);
+    app->group_socket = socket;
+    app->group_address = g_inet_socket_address_new(address, OTTSR_GROUP_PORT);
+    g_object_unref(address);
+
+    app->group_source = g_socket_create_source(socket, G_IO_IN, NULL);
+    g_source_set_callback(app->group_source, G_SOURCE_FUNC(ottsr_group_readable), app, NULL);
+    g_source_attach(app->group_source, NULL);
+
+    gboolean leader = app->config.group_role == OTTSR_GROUP_LEADER;
+    app->group = ottsr_group_new(app->config.group_name, leader, ottsr_group_socket_send,
+                                 ottsr_group_monotonic, ottsr_group_follow, app);
+    g_print("%s study group \"%s\" on %s:%d\n", leader ? "Leading" : "Following",
+            app->config.group_name, OTTSR_GROUP_ADDRESS, OTTSR_GROUP_PORT);
+
+    if (leader) {
+        ottsr_group_announce(app);
+    } else {
+        ottsr_group_join(app->group);
+    }
+}
+
+void ottsr_group_stop(ottsr_app_t *app) {
+    if (!app->group) return;
+
+    ottsr_group_free(app->group);
+    app->group = NULL;
+    g_source_destroy(app->group_source);
+    g_source_unref(app->group_source);
+    app->group_source = NULL;
+    g_clear_object(&app->group_address);
+    g_socket_close(app->group_socket, NULL);
+    g_clear_object(&app->group_socket);
+}
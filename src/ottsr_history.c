@@ -0,0 +1,208 @@
+#include "ottsr.h"
+
+typedef struct {
+    guint32 magic;
+    guint32 version;
+    guint32 record_size;
+    guint32 first_sequence;
+} ottsr_history_header_t;
+
+// Appends and the compactor's rewrite of the file must not interleave
+G_LOCK_DEFINE_STATIC(history);
+
+static char *ottsr_history_path(void) {
+    char *config_dir = ottsr_get_config_path();
+    if (!config_dir) return NULL;
+
+    char *path = g_build_filename(config_dir, OTTSR_HISTORY_FILE, NULL);
+    g_free(config_dir);
+    return path;
+}
+
+static void ottsr_history_header_init(ottsr_history_header_t *header, guint32 first_sequence) {
+    memset(header, 0, sizeof(*header));
+    header->magic = OTTSR_HISTORY_MAGIC;
+    header->version = OTTSR_HISTORY_VERSION;
+    header->record_size = sizeof(ottsr_history_record_t);
+    header->first_sequence = first_sequence;
+}
+
+// Append one record to the history in config_dir; the file is only ever
+// written at its end
+gboolean ottsr_history_append_at(const char *config_dir, const ottsr_history_record_t *record) {
+    char *path = g_build_filename(config_dir, OTTSR_HISTORY_FILE, NULL);
+
+    G_LOCK(history);
+    FILE *file = fopen(path, "ab");
+    if (!file) {
+        G_UNLOCK(history);
+        g_warning("Failed to open history %s", path);
+        g_free(path);
+        return FALSE;
+    }
+    g_free(path);
+
+    // A write cut short by a crash leaves a partial record (or header) at
+    // the end; drop it so this one lands on a record boundary
+    gboolean ok = TRUE;
+    fseek(file, 0, SEEK_END);
+    long length = ftell(file);
+    long whole = length < (long)sizeof(ottsr_history_header_t) ? 0 :
+        length - (long)((length - sizeof(ottsr_history_header_t)) % sizeof(*record));
+    if (whole != length && ftruncate(fileno(file), whole) != 0) {
+        g_warning("Failed to drop a torn record from session history");
+        ok = FALSE;
+    }
+    if (ok && whole == 0) {
+        // A new file continues numbering after whatever is archived
+        char *rollup_path = g_build_filename(config_dir, OTTSR_ROLLUP_FILE, NULL);
+        ottsr_rollup_t *rollup = ottsr_rollup_load_file(rollup_path);
+        g_free(rollup_path);
+        ottsr_history_header_t header;
+        ottsr_history_header_init(&header, rollup->archived_records);
+        ottsr_rollup_free(rollup);
+        ok = fwrite(&header, sizeof(header), 1, file) == 1;
+    }
+    ok = ok && fwrite(record, sizeof(*record), 1, file) == 1;
+    ok = (fclose(file) == 0) && ok;
+    G_UNLOCK(history);
+
+    if (!ok) g_warning("Failed to append to session history");
+    return ok;
+}
+
+gboolean ottsr_history_append(const ottsr_history_record_t *record) {
+    char *config_dir = ottsr_get_config_path();
+    if (!config_dir) return FALSE;
+
+    gboolean ok = ottsr_history_append_at(config_dir, record);
+    g_free(config_dir);
+    return ok;
+}
+
+// Records of a history file in file order, without the ones whose sequence
+// number is below archived (those are in the archive). A torn trailing
+// record is ignored.
+GArray *ottsr_history_read_file(const char *path, guint32 archived) {
+    GArray *records = g_array_new(FALSE, FALSE, sizeof(ottsr_history_record_t));
+    GMappedFile *mapped = g_mapped_file_new(path, FALSE, NULL);
+    if (!mapped) return records;
+
+    gsize length = g_mapped_file_get_length(mapped);
+    const char *data = g_mapped_file_get_contents(mapped);
+
+    if (length >= sizeof(ottsr_history_header_t)) {
+        ottsr_history_header_t header;
+        memcpy(&header, data, sizeof(header));
+
+        if (header.magic == OTTSR_HISTORY_MAGIC &&
+            header.version == OTTSR_HISTORY_VERSION &&
+            header.record_size == sizeof(ottsr_history_record_t)) {
+            guint count = (length - sizeof(header)) / sizeof(ottsr_history_record_t);
+            guint skip = archived > header.first_sequence ?
+                MIN(count, archived - header.first_sequence) : 0;
+            g_array_append_vals(records, data + sizeof(header) + skip * sizeof(ottsr_history_record_t),
+                                count - skip);
+
+            for (guint i = 0; i < records->len; i++) {
+                ottsr_history_record_t *record = &g_array_index(records, ottsr_history_record_t, i);
+                record->profile[OTTSR_MAX_NAME_LEN - 1] = '\0';
+                record->subject[OTTSR_MAX_NAME_LEN - 1] = '\0';
+            }
+        } else {
+            g_warning("Ignoring session history with unknown format");
+        }
+    }
+
+    g_mapped_file_unref(mapped);
+    return records;
+}
+
+GArray *ottsr_history_read(guint32 archived) {
+    char *path = ottsr_history_path();
+    if (!path) return g_array_new(FALSE, FALSE, sizeof(ottsr_history_record_t));
+
+    GArray *records = ottsr_history_read_file(path, archived);
+    g_free(path);
+    return records;
+}
+
+// Archived records followed by the hot ones not yet compacted
+GArray *ottsr_history_read_all(void) {
+    ottsr_rollup_t *rollup = ottsr_rollup_load();
+    GArray *records = g_array_new(FALSE, FALSE, sizeof(ottsr_history_record_t));
+    ottsr_archive_read(records, rollup->archived_records);
+
+    GArray *hot = ottsr_history_read(rollup->archived_records);
+    g_array_append_vals(records, hot->data, hot->len);
+
+    g_array_unref(hot);
+    ottsr_rollup_free(rollup);
+    return records;
+}
+
+// Atomically drop the records below archived from a history file; the
+// survivors keep their sequence numbers
+gboolean ottsr_history_compact_file(const char *path, guint32 archived) {
+    G_LOCK(history);
+    GArray *kept = ottsr_history_read_file(path, archived);
+
+    ottsr_history_header_t header;
+    ottsr_history_header_init(&header, archived);
+
+    GByteArray *out = g_byte_array_new();
+    g_byte_array_append(out, (const guint8 *)&header, sizeof(header));
+    g_byte_array_append(out, (const guint8 *)kept->data, kept->len * sizeof(ottsr_history_record_t));
+
+    GError *error = NULL;
+    gboolean ok = g_file_set_contents(path, (const char *)out->data, out->len, &error);
+    G_UNLOCK(history);
+    if (!ok) {
+        g_warning("Failed to rewrite history %s: %s", path, error->message);
+        g_error_free(error);
+    }
+
+    g_byte_array_unref(out);
+    g_array_unref(kept);
+    return ok;
+}
+
+// Persist a record with its note and feed both to whatever is loaded
+void ottsr_history_add(ottsr_app_t *app, const ottsr_history_record_t *record, const char *note) {
+    if (app->kiosk) {
+        ottsr_kiosk_history_add(app, record, note);
+    } else {
+        ottsr_history_append(record);
+        if (note && *note) {
+            ottsr_notes_append(record->started_at, note);
+        }
+    }
+    if (app->timeline) {
+        ottsr_timeline_add(app->timeline, record);
+    }
+    ottsr_search_record(app, record, note);
+}
+
+// Record the part of the current study phase not yet in history
+void ottsr_history_record_study(ottsr_app_t *app, gboolean completed) {
+    ottsr_session_sync(app);
+    int seconds = app->session.elapsed_study_seconds - app->session.recorded_study_seconds;
+    if (seconds <= 0) return;
+
+    ottsr_history_record_t record = {0};
+    record.started_at = app->session.session_start + app->session.recorded_study_seconds;
+    record.study_seconds = seconds;
+    record.completed = completed;
+    g_strlcpy(record.profile, app->config.profiles[app->session.profile_index].name, OTTSR_MAX_NAME_LEN);
+    g_strlcpy(record.subject, app->session.current_subject, OTTSR_MAX_NAME_LEN);
+
+    // The note covers the phase it was written in; the next one starts blank
+    const char *note = app->note_entry ? gtk_entry_get_text(GTK_ENTRY(app->note_entry)) : NULL;
+    ottsr_history_add(app, &record, note);
+    if (note && *note) gtk_entry_set_text(GTK_ENTRY(app->note_entry), "");
+    app->session.recorded_study_seconds = app->session.elapsed_study_seconds;
+
+    // Estimates look at the whole phase, not just the part recorded now
+    record.study_seconds = app->session.elapsed_study_seconds;
+    ottsr_estimates_record(app, &record);
+}
@@ -0,0 +1,135 @@
+#include "ottsr.h"
+
+// One queued or running hook; the environment is captured when the event
+// fires, so a hook started late still sees the phase it was fired for
+typedef struct {
+    ottsr_app_t *app;
+    char *path;
+    GSubprocessLauncher *launcher;
+    GSubprocess *process;
+    guint timeout_id;
+    gboolean timed_out;
+} ottsr_hook_t;
+
+static void ottsr_hook_free(ottsr_hook_t *hook) {
+    if (hook->timeout_id > 0) g_source_remove(hook->timeout_id);
+    if (hook->process) g_object_unref(hook->process);
+    g_object_unref(hook->launcher);
+    g_free(hook->path);
+    g_free(hook);
+}
+
+static void ottsr_hooks_pump(ottsr_app_t *app);
+
+static gboolean ottsr_hook_timeout(gpointer user_data) {
+    ottsr_hook_t *hook = user_data;
+    hook->timeout_id = 0;
+    hook->timed_out = TRUE;
+    g_subprocess_force_exit(hook->process);
+    return G_SOURCE_REMOVE;
+}
+
+static void ottsr_hook_done(GObject *source, GAsyncResult *result, gpointer user_data) {
+    ottsr_hook_t *hook = user_data;
+    GError *error = NULL;
+
+    // Cancelled at shutdown: the app is going away, just let go of the hook
+    if (!g_subprocess_wait_finish(hook->process, result, &error)) {
+        g_error_free(error);
+        ottsr_hook_free(hook);
+        return;
+    }
+
+    if (hook->timed_out) {
+        g_warning("Hook %s killed after %d s", hook->path, OTTSR_HOOK_TIMEOUT);
+    } else if (g_subprocess_get_if_exited(hook->process) && g_subprocess_get_exit_status(hook->process) != 0) {
+        g_warning("Hook %s exited with status %d", hook->path, g_subprocess_get_exit_status(hook->process));
+    }
+
+    ottsr_app_t *app = hook->app;
+    app->hooks_running--;
+    ottsr_hook_free(hook);
+    ottsr_hooks_pump(app);
+}
+
+// Start queued hooks while below the concurrency limit
+static void ottsr_hooks_pump(ottsr_app_t *app) {
+    while (app->hooks_running < OTTSR_HOOK_MAX_RUNNING && !g_queue_is_empty(app->hook_queue)) {
+        ottsr_hook_t *hook = g_queue_pop_head(app->hook_queue);
+        GError *error = NULL;
+
+        hook->process = g_subprocess_launcher_spawn(hook->launcher, &error, hook->path, NULL);
+        if (!hook->process) {
+            g_warning("Failed to run hook %s: %s", hook->path, error->message);
+            g_error_free(error);
+            ottsr_hook_free(hook);
+            continue;
+        }
+
+        app->hooks_running++;
+        hook->timeout_id = g_timeout_add_seconds(OTTSR_HOOK_TIMEOUT, ottsr_hook_timeout, hook);
+        g_subprocess_wait_async(hook->process, app->hooks_cancel, ottsr_hook_done, hook);
+    }
+}
+
+static void ottsr_hook_setenv_int(GSubprocessLauncher *launcher, const char *name, gint64 value) {
+    char text[32];
+    snprintf(text, sizeof(text), "%" G_GINT64_FORMAT, value);
+    g_subprocess_launcher_setenv(launcher, name, text, TRUE);
+}
+
+// Queue the executable hooks/<event> in the config directory, if there is one
+void ottsr_hooks_fire(ottsr_app_t *app, const char *event) {
+    if (!app->hook_queue) return;
+
+    char *config_dir = ottsr_get_config_path();
+    if (!config_dir) return;
+    char *path = g_build_filename(config_dir, OTTSR_HOOKS_DIR, event, NULL);
+    g_free(config_dir);
+
+    if (!g_file_test(path, G_FILE_TEST_IS_EXECUTABLE) || g_file_test(path, G_FILE_TEST_IS_DIR)) {
+        g_free(path);
+        return;
+    }
+    if (g_queue_get_length(app->hook_queue) >= OTTSR_HOOK_MAX_QUEUED) {
+        g_warning("Hook queue full, skipping %s", path);
+        g_free(path);
+        return;
+    }
+
+    ottsr_session_sync(app);
+    int elapsed = app->session.state == OTTSR_STATE_BREAKING ?
+        app->session.elapsed_break_seconds : app->session.elapsed_study_seconds;
+
+    ottsr_hook_t *hook = g_new0(ottsr_hook_t, 1);
+    hook->app = app;
+    hook->path = path;
+    hook->launcher = g_subprocess_launcher_new(G_SUBPROCESS_FLAGS_STDIN_INHERIT);
+    g_subprocess_launcher_setenv(hook->launcher, "OTTSR_EVENT", event, TRUE);
+    g_subprocess_launcher_setenv(hook->launcher, "OTTSR_PROFILE",
+                                 app->config.profiles[app->session.profile_index].name, TRUE);
+    g_subprocess_launcher_setenv(hook->launcher, "OTTSR_SUBJECT", app->session.current_subject, TRUE);
+    g_subprocess_launcher_setenv(hook->launcher, "OTTSR_LONG_BREAK", app->session.is_long_break ? "1" : "0", TRUE);
+    ottsr_hook_setenv_int(hook->launcher, "OTTSR_PHASE_SECONDS", ottsr_phase_duration(app));
+    ottsr_hook_setenv_int(hook->launcher, "OTTSR_ELAPSED_SECONDS", elapsed);
+    ottsr_hook_setenv_int(hook->launcher, "OTTSR_SESSIONS", app->session.current_sessions);
+    ottsr_hook_setenv_int(hook->launcher, "OTTSR_TIMESTAMP", g_get_real_time() / G_USEC_PER_SEC);
+
+    g_queue_push_tail(app->hook_queue, hook);
+    ottsr_hooks_pump(app);
+}
+
+void ottsr_hooks_start(ottsr_app_t *app) {
+    app->hook_queue = g_queue_new();
+    app->hooks_cancel = g_cancellable_new();
+}
+
+// Hooks already running are left to finish on their own
+void ottsr_hooks_stop(ottsr_app_t *app) {
+    if (!app->hook_queue) return;
+
+    g_cancellable_cancel(app->hooks_cancel);
+    g_queue_free_full(app->hook_queue, (GDestroyNotify)ottsr_hook_free);
+    app->hook_queue = NULL;
+    g_clear_object(&app->hooks_cancel);
+}
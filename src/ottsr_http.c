@@ -0,0 +1,515 @@
+#include "ottsr.h"
+
+// A small status server for wall dashboards. It runs on its own thread and
+// main context, so neither polling nor slow clients cost the UI a frame.
+// The main loop only rebuilds the status when the session state changes;
+// every GET /status is then answered from that prebuilt response, and
+// GET /events streams each new status as a server-sent event.
+struct ottsr_http_server {
+    GThread *thread;
+    GMainContext *context;
+    GMainLoop *loop;
+    GSocketService *service;
+    char *address;
+    int port;
+    guint16 bound_port;
+
+    // Startup handshake: 0 binding, 1 listening, -1 failed
+    GMutex lock;
+    GCond ready_cond;
+    int ready;
+
+    // Guarded by lock; swapped whole by ottsr_http_server_publish
+    GBytes *response;
+    GBytes *event;
+    guint64 sequence;
+    guint64 event_sequence;
+
+    // Server thread only
+    GPtrArray *streams;
+    guint64 broadcast_sequence;
+    GSource *heartbeat;
+    gint requests;
+};
+
+typedef struct {
+    ottsr_http_server_t *server;
+    GSocketConnection *connection;
+    GBytes *reply;
+    char request[OTTSR_HTTP_REQUEST_MAX];
+    gsize length;
+} ottsr_http_client_t;
+
+typedef struct {
+    ottsr_http_server_t *server;
+    GBytes *event;
+    guint64 sequence;
+} ottsr_http_broadcast_t;
+
+#define OTTSR_HTTP_REPLY(status) \
+    "HTTP/1.1 " status "\r\nContent-Length: 0\r\nConnection: close\r\n\r\n"
+
+static const char ottsr_http_not_found[] = OTTSR_HTTP_REPLY("404 Not Found");
+static const char ottsr_http_bad_method[] = OTTSR_HTTP_REPLY("405 Method Not Allowed");
+static const char ottsr_http_too_large[] = OTTSR_HTTP_REPLY("431 Request Header Fields Too Large");
+static const char ottsr_http_busy[] = OTTSR_HTTP_REPLY("503 Service Unavailable");
+
+static const char ottsr_http_stream_head[] =
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Type: text/event-stream\r\n"
+    "Cache-Control: no-store\r\n"
+    "Access-Control-Allow-Origin: *\r\n"
+    "Connection: keep-alive\r\n"
+    "\r\n"
+    "retry: 5000\n\n";
+
+static void ottsr_http_client_free(ottsr_http_client_t *client) {
+    g_io_stream_close(G_IO_STREAM(client->connection), NULL, NULL);
+    g_object_unref(client->connection);
+    if (client->reply) g_bytes_unref(client->reply);
+    g_free(client);
+}
+
+// Event streams are written without blocking; a client whose socket buffer
+// is full would get a torn event, so it is dropped instead
+static gboolean ottsr_http_stream_send(GSocketConnection *connection, GBytes *bytes) {
+    gsize length;
+    const void *data = g_bytes_get_data(bytes, &length);
+    GOutputStream *out = g_io_stream_get_output_stream(G_IO_STREAM(connection));
+
+    gssize written = g_pollable_output_stream_write_nonblocking(G_POLLABLE_OUTPUT_STREAM(out),
+                                                                data, length, NULL, NULL);
+    return written == (gssize)length;
+}
+
+static void ottsr_http_stream_drop(ottsr_http_server_t *server, guint index) {
+    GSocketConnection *connection = g_ptr_array_index(server->streams, index);
+    g_io_stream_close(G_IO_STREAM(connection), NULL, NULL);
+    g_object_unref(connection);
+    g_ptr_array_remove_index_fast(server->streams, index);
+}
+
+static void ottsr_http_streams_send(ottsr_http_server_t *server, GBytes *bytes) {
+    for (guint i = server->streams->len; i > 0; i--) {
+        if (!ottsr_http_stream_send(g_ptr_array_index(server->streams, i - 1), bytes)) {
+            ottsr_http_stream_drop(server, i - 1);
+        }
+    }
+}
+
+static gboolean ottsr_http_broadcast(gpointer user_data) {
+    ottsr_http_broadcast_t *broadcast = user_data;
+    ottsr_http_streams_send(broadcast->server, broadcast->event);
+    broadcast->server->broadcast_sequence = broadcast->sequence;
+    return G_SOURCE_REMOVE;
+}
+
+static void ottsr_http_broadcast_free(gpointer user_data) {
+    ottsr_http_broadcast_t *broadcast = user_data;
+    g_bytes_unref(broadcast->event);
+    g_free(broadcast);
+}
+
+// Comment lines keep proxies from timing the stream out and find dead peers
+static gboolean ottsr_http_heartbeat(gpointer user_data) {
+    ottsr_http_server_t *server = user_data;
+    static const char ping[] = ": ping\n\n";
+
+    GBytes *bytes = g_bytes_new_static(ping, sizeof(ping) - 1);
+    ottsr_http_streams_send(server, bytes);
+    g_bytes_unref(bytes);
+    return G_SOURCE_CONTINUE;
+}
+
+static void ottsr_http_written(GObject *source, GAsyncResult *result, gpointer user_data) {
+    g_output_stream_write_all_finish(G_OUTPUT_STREAM(source), result, NULL, NULL);
+    ottsr_http_client_free(user_data);
+}
+
+static void ottsr_http_reply(ottsr_http_client_t *client, GBytes *reply) {
+    gsize length;
+    const void *data = g_bytes_get_data(reply, &length);
+    client->reply = reply;
+
+    GOutputStream *out = g_io_stream_get_output_stream(G_IO_STREAM(client->connection));
+    g_output_stream_write_all_async(out, data, length, G_PRIORITY_DEFAULT, NULL,
+                                    ottsr_http_written, client);
+}
+
+static void ottsr_http_reply_static(ottsr_http_client_t *client, const char *reply, gsize size) {
+    ottsr_http_reply(client, g_bytes_new_static(reply, size - 1));
+}
+
+// Hand the connection over to the event stream list
+static void ottsr_http_subscribe(ottsr_http_client_t *client) {
+    ottsr_http_server_t *server = client->server;
+
+    if (server->streams->len >= OTTSR_HTTP_MAX_STREAMS) {
+        ottsr_http_reply_static(client, ottsr_http_busy, sizeof(ottsr_http_busy));
+        return;
+    }
+
+    // A status whose broadcast is still queued reaches the new stream through
+    // that broadcast; sending it now as well would deliver it twice
+    g_mutex_lock(&server->lock);
+    GBytes *event = server->event_sequence > server->broadcast_sequence ? NULL : g_bytes_ref(server->event);
+    g_mutex_unlock(&server->lock);
+
+    // Streams stay open indefinitely; the heartbeat finds dead ones
+    g_socket_set_timeout(g_socket_connection_get_socket(client->connection), 0);
+    GBytes *head = g_bytes_new_static(ottsr_http_stream_head, sizeof(ottsr_http_stream_head) - 1);
+    gboolean ok = ottsr_http_stream_send(client->connection, head) &&
+                  (!event || ottsr_http_stream_send(client->connection, event));
+    g_bytes_unref(head);
+    if (event) g_bytes_unref(event);
+
+    if (!ok) {
+        ottsr_http_client_free(client);
+        return;
+    }
+
+    // The stream list takes over the connection; only the request goes
+    g_ptr_array_add(server->streams, client->connection);
+    g_free(client);
+}
+
+static void ottsr_http_dispatch(ottsr_http_client_t *client) {
+    char method[8] = "";
+    char path[256] = "";
+    sscanf(client->request, "%7s %255s", method, path);
+
+    // Dashboards poll with query strings to dodge caches; ignore them
+    char *query = strchr(path, '?');
+    if (query) *query = '\0';
+
+    g_atomic_int_inc(&client->server->requests);
+
+    if (strcmp(method, "GET") != 0) {
+        ottsr_http_reply_static(client, ottsr_http_bad_method, sizeof(ottsr_http_bad_method));
+    } else if (strcmp(path, "/") == 0 || strcmp(path, "/status") == 0) {
+        g_mutex_lock(&client->server->lock);
+        GBytes *response = g_bytes_ref(client->server->response);
+        g_mutex_unlock(&client->server->lock);
+        ottsr_http_reply(client, response);
+    } else if (strcmp(path, "/events") == 0) {
+        ottsr_http_subscribe(client);
+    } else {
+        ottsr_http_reply_static(client, ottsr_http_not_found, sizeof(ottsr_http_not_found));
+    }
+}
+
+static void ottsr_http_read(ottsr_http_client_t *client);
+
+static void ottsr_http_read_done(GObject *source, GAsyncResult *result, gpointer user_data) {
+    ottsr_http_client_t *client = user_data;
+    gssize count = g_input_stream_read_finish(G_INPUT_STREAM(source), result, NULL);
+
+    if (count <= 0) {
+        ottsr_http_client_free(client);
+        return;
+    }
+
+    client->length += count;
+    client->request[client->length] = '\0';
+
+    // Only the request line matters; wait for the end of the headers so the
+    // reply is not sent into a half-written request
+    if (strstr(client->request, "\r\n\r\n") || strstr(client->request, "\n\n")) {
+        ottsr_http_dispatch(client);
+    } else if (client->length >= sizeof(client->request) - 1) {
+        ottsr_http_reply_static(client, ottsr_http_too_large, sizeof(ottsr_http_too_large));
+    } else {
+        ottsr_http_read(client);
+    }
+}
+
+static void ottsr_http_read(ottsr_http_client_t *client) {
+    GInputStream *in = g_io_stream_get_input_stream(G_IO_STREAM(client->connection));
+    g_input_stream_read_async(in, client->request + client->length,
+                              sizeof(client->request) - 1 - client->length,
+                              G_PRIORITY_DEFAULT, NULL, ottsr_http_read_done, client);
+}
+
+static gboolean ottsr_http_incoming(GSocketService *service, GSocketConnection *connection,
+                                    GObject *source_object, gpointer user_data) {
+    ottsr_http_client_t *client = g_new0(ottsr_http_client_t, 1);
+    client->server = user_data;
+    client->connection = g_object_ref(connection);
+
+    // Bounds how long a silent client can hold on to a connection
+    g_socket_set_timeout(g_socket_connection_get_socket(connection), OTTSR_HTTP_TIMEOUT);
+    ottsr_http_read(client);
+    return TRUE;
+}
+
+// Runs on the server thread so the listener's sources land on its context
+static gboolean ottsr_http_listen(ottsr_http_server_t *server) {
+    GInetAddress *inet = g_inet_address_new_from_string(server->address);
+    if (!inet) {
+        g_warning("Invalid status server address: %s", server->address);
+        return FALSE;
+    }
+
+    GSocketAddress *address = g_inet_socket_address_new(inet, (guint16)server->port);
+    GSocketAddress *effective = NULL;
+    GError *error = NULL;
+    g_object_unref(inet);
+
+    server->service = g_socket_service_new();
+    g_socket_listener_set_backlog(G_SOCKET_LISTENER(server->service), OTTSR_HTTP_BACKLOG);
+    gboolean ok = g_socket_listener_add_address(G_SOCKET_LISTENER(server->service), address,
+                                                G_SOCKET_TYPE_STREAM, G_SOCKET_PROTOCOL_TCP,
+                                                NULL, &effective, &error);
+    g_object_unref(address);
+
+    if (!ok) {
+        g_warning("Failed to start status server on %s:%d: %s",
+                  server->address, server->port, error->message);
+        g_error_free(error);
+        g_clear_object(&server->service);
+        return FALSE;
+    }
+
+    server->bound_port = g_inet_socket_address_get_port(G_INET_SOCKET_ADDRESS(effective));
+    g_object_unref(effective);
+
+    g_signal_connect(server->service, "incoming", G_CALLBACK(ottsr_http_incoming), server);
+    g_socket_service_start(server->service);
+
+    server->heartbeat = g_timeout_source_new_seconds(OTTSR_HTTP_HEARTBEAT);
+    g_source_set_callback(server->heartbeat, ottsr_http_heartbeat, server, NULL);
+    g_source_attach(server->heartbeat, server->context);
+    return TRUE;
+}
+
+static gpointer ottsr_http_thread(gpointer data) {
+    ottsr_http_server_t *server = data;
+    g_main_context_push_thread_default(server->context);
+
+    gboolean ok = ottsr_http_listen(server);
+
+    g_mutex_lock(&server->lock);
+    server->ready = ok ? 1 : -1;
+    g_cond_signal(&server->ready_cond);
+    g_mutex_unlock(&server->lock);
+
+    if (ok) {
+        g_main_loop_run(server->loop);
+
+        while (server->streams->len > 0) {
+            ottsr_http_stream_drop(server, server->streams->len - 1);
+        }
+        g_source_destroy(server->heartbeat);
+        g_source_unref(server->heartbeat);
+        g_socket_service_stop(server->service);
+        g_socket_listener_close(G_SOCKET_LISTENER(server->service));
+        g_object_unref(server->service);
+    }
+
+    g_main_context_pop_thread_default(server->context);
+    return NULL;
+}
+
+static gboolean ottsr_http_quit(gpointer user_data) {
+    g_main_loop_quit(user_data);
+    return G_SOURCE_REMOVE;
+}
+
+// Port 0 picks a free port; see ottsr_http_server_get_port
+ottsr_http_server_t *ottsr_http_server_new(const char *address, int port) {
+    if (port < 0 || port > G_MAXUINT16) {
+        g_warning("Invalid status server port: %d", port);
+        return NULL;
+    }
+
+    ottsr_http_server_t *server = g_new0(ottsr_http_server_t, 1);
+    g_mutex_init(&server->lock);
+    g_cond_init(&server->ready_cond);
+    server->address = g_strdup(address && *address ? address : OTTSR_HTTP_DEFAULT_ADDRESS);
+    server->port = port;
+    server->context = g_main_context_new();
+    server->loop = g_main_loop_new(server->context, FALSE);
+    server->streams = g_ptr_array_new();
+    ottsr_http_server_publish(server, "{}", 2);
+
+    server->thread = g_thread_new("ottsr-http", ottsr_http_thread, server);
+
+    g_mutex_lock(&server->lock);
+    while (server->ready == 0) {
+        g_cond_wait(&server->ready_cond, &server->lock);
+    }
+    g_mutex_unlock(&server->lock);
+
+    if (server->ready < 0) {
+        ottsr_http_server_free(server);
+        return NULL;
+    }
+    return server;
+}
+
+guint16 ottsr_http_server_get_port(ottsr_http_server_t *server) {
+    return server->bound_port;
+}
+
+// Replace the status served to pollers and push it to every event stream.
+// json must be a single line, as json-glib writes it when not pretty.
+void ottsr_http_server_publish(ottsr_http_server_t *server, const char *json, gsize length) {
+    GString *response = g_string_sized_new(length + 192);
+    g_string_append_printf(response,
+                           "HTTP/1.1 200 OK\r\n"
+                           "Content-Type: application/json\r\n"
+                           "Content-Length: %" G_GSIZE_FORMAT "\r\n"
+                           "Cache-Control: no-store\r\n"
+                           "Access-Control-Allow-Origin: *\r\n"
+                           "Connection: close\r\n"
+                           "\r\n", length);
+    g_string_append_len(response, json, length);
+
+    g_mutex_lock(&server->lock);
+    guint64 sequence = ++server->sequence;
+    g_mutex_unlock(&server->lock);
+
+    GString *event = g_string_sized_new(length + 48);
+    g_string_append_printf(event, "id: %" G_GUINT64_FORMAT "\nevent: status\ndata: ", sequence);
+    g_string_append_len(event, json, length);
+    g_string_append(event, "\n\n");
+
+    GBytes *response_bytes = g_string_free_to_bytes(response);
+    GBytes *event_bytes = g_string_free_to_bytes(event);
+
+    g_mutex_lock(&server->lock);
+    GBytes *old_response = server->response;
+    GBytes *old_event = server->event;
+    server->response = response_bytes;
+    server->event = g_bytes_ref(event_bytes);
+    server->event_sequence = sequence;
+    g_mutex_unlock(&server->lock);
+
+    if (old_response) g_bytes_unref(old_response);
+    if (old_event) g_bytes_unref(old_event);
+
+    // Before the thread starts there are no streams to reach
+    if (!server->thread) {
+        server->broadcast_sequence = sequence;
+        g_bytes_unref(event_bytes);
+        return;
+    }
+
+    ottsr_http_broadcast_t *broadcast = g_new0(ottsr_http_broadcast_t, 1);
+    broadcast->server = server;
+    broadcast->event = event_bytes;
+    broadcast->sequence = sequence;
+    g_main_context_invoke_full(server->context, G_PRIORITY_DEFAULT, ottsr_http_broadcast,
+                               broadcast, ottsr_http_broadcast_free);
+}
+
+void ottsr_http_server_free(ottsr_http_server_t *server) {
+    if (!server) return;
+
+    // Quit from inside the loop, in case it has not started running yet
+    if (server->ready > 0) {
+        g_main_context_invoke(server->context, ottsr_http_quit, server->loop);
+    }
+    g_thread_join(server->thread);
+    g_debug("Status server answered %d requests", g_atomic_int_get(&server->requests));
+
+    g_ptr_array_unref(server->streams);
+    g_main_loop_unref(server->loop);
+    g_main_context_unref(server->context);
+    g_bytes_unref(server->response);
+    g_bytes_unref(server->event);
+    g_cond_clear(&server->ready_cond);
+    g_mutex_clear(&server->lock);
+    g_free(server->address);
+    g_free(server);
+}
+
+static const char *ottsr_http_state_name(ottsr_state_t state) {
+    switch (state) {
+        case OTTSR_STATE_STUDYING: return "studying";
+        case OTTSR_STATE_BREAKING: return "breaking";
+        case OTTSR_STATE_PAUSED: return "paused";
+        default: return "idle";
+    }
+}
+
+// Rebuild the published status; call whenever the session changes state
+void ottsr_http_update(ottsr_app_t *app) {
+    if (!app->http) return;
+
+    ottsr_session_t *session = &app->session;
+    int index = session->state == OTTSR_STATE_IDLE ? app->config.active_profile : session->profile_index;
+    ottsr_profile_t *profile = &app->config.profiles[index];
+    ottsr_session_sync(app);
+
+    // A paused session is in whichever phase it has counted time for
+    gboolean breaking = session->state == OTTSR_STATE_BREAKING ||
+        (session->state == OTTSR_STATE_PAUSED && session->elapsed_study_seconds == 0);
+    int phase_seconds = 0, elapsed = 0;
+    if (session->state != OTTSR_STATE_IDLE) {
+        phase_seconds = ottsr_phase_length(app, profile, breaking, session->is_long_break);
+        elapsed = breaking ? session->elapsed_break_seconds : session->elapsed_study_seconds;
+    }
+
+    gint64 now = g_get_real_time();
+    JsonBuilder *builder = json_builder_new();
+    json_builder_begin_object(builder);
+
+    json_builder_set_member_name(builder, "state");
+    json_builder_add_string_value(builder, ottsr_http_state_name(session->state));
+    json_builder_set_member_name(builder, "phase");
+    json_builder_add_string_value(builder, session->state == OTTSR_STATE_IDLE ? "none" :
+                                  breaking ? (session->is_long_break ? "long-break" : "break") : "study");
+    json_builder_set_member_name(builder, "profile");
+    json_builder_add_string_value(builder, profile->name);
+    json_builder_set_member_name(builder, "subject");
+    json_builder_add_string_value(builder, session->current_subject);
+    json_builder_set_member_name(builder, "sessions");
+    json_builder_add_int_value(builder, session->current_sessions);
+    json_builder_set_member_name(builder, "phase_seconds");
+    json_builder_add_int_value(builder, phase_seconds);
+    json_builder_set_member_name(builder, "elapsed_seconds");
+    json_builder_add_int_value(builder, elapsed);
+
+    // Dashboards count down from this rather than polling every second
+    json_builder_set_member_name(builder, "ends_at");
+    if (session->state == OTTSR_STATE_STUDYING || session->state == OTTSR_STATE_BREAKING) {
+        gint64 left = app->phase_anchor + (gint64)phase_seconds * G_USEC_PER_SEC - g_get_monotonic_time();
+        json_builder_add_int_value(builder, (now + left) / G_USEC_PER_SEC);
+    } else {
+        json_builder_add_null_value(builder);
+    }
+
+    json_builder_set_member_name(builder, "updated_at");
+    json_builder_add_int_value(builder, now / G_USEC_PER_SEC);
+    json_builder_end_object(builder);
+
+    JsonGenerator *generator = json_generator_new();
+    JsonNode *root = json_builder_get_root(builder);
+    json_generator_set_root(generator, root);
+
+    gsize length;
+    char *json = json_generator_to_data(generator, &length);
+    ottsr_http_server_publish(app->http, json, length);
+
+    g_free(json);
+    json_node_free(root);
+    g_object_unref(generator);
+    g_object_unref(builder);
+}
+
+void ottsr_http_start(ottsr_app_t *app) {
+    if (app->config.http_port <= 0) return;
+
+    app->http = ottsr_http_server_new(app->config.http_address, app->config.http_port);
+    if (app->http) {
+        g_print("Status server listening on %s:%u\n", app->config.http_address,
+                ottsr_http_server_get_port(app->http));
+        ottsr_http_update(app);
+    }
+}
+
+void ottsr_http_stop(ottsr_app_t *app) {
+    ottsr_http_server_free(app->http);
+    app->http = NULL;
+}
@@ -0,0 +1,557 @@
+#include "ottsr.h"
+#include <errno.h>
+
+// Kiosk mode: one window shared by students who sign in and out every few
+// minutes. Each student has a data directory under the kiosk root. A user
+// switch keeps every widget, swaps the config in from an LRU cache that is
+// filled ahead of time, and leaves the outgoing user's writes to a
+// background writer so the switch never waits on the disk.
+
+// A user's settings as last loaded or saved. mtime/size identify the
+// settings.json it matches; while writes are queued the entry is newer
+// than the file and wins regardless.
+typedef struct {
+    char *user;
+    ottsr_config_t config;
+    gint64 mtime;
+    gint64 size;
+    int flushing;
+} ottsr_kiosk_entry_t;
+
+typedef enum {
+    OTTSR_KIOSK_WRITE_CONFIG,
+    OTTSR_KIOSK_WRITE_FILE,
+    OTTSR_KIOSK_WRITE_HISTORY
+} ottsr_kiosk_write_kind_t;
+
+// path is settings.json, a whole file, or for history the user's
+// directory; a history write carries its note in data
+typedef struct {
+    ottsr_kiosk_write_kind_t kind;
+    char *user;
+    char *path;
+    char *data;
+    gsize length;
+    ottsr_history_record_t record;
+} ottsr_kiosk_write_t;
+
+struct ottsr_kiosk {
+    char *root;
+    char *user;
+
+    // Cache and prefetch bookkeeping, shared with the pools
+    GMutex lock;
+    GHashTable *entries;
+    GQueue lru;
+    GHashTable *pending;
+
+    GThreadPool *writer;
+    GThreadPool *prefetcher;
+    gboolean stopping;
+    GtkWidget *user_entry;
+};
+
+// Directory get_config_path hands out; read from worker threads
+G_LOCK_DEFINE_STATIC(kiosk_dir);
+static char *ottsr_kiosk_user_dir = NULL;
+
+char *ottsr_kiosk_dir(void) {
+    G_LOCK(kiosk_dir);
+    char *dir = g_strdup(ottsr_kiosk_user_dir);
+    G_UNLOCK(kiosk_dir);
+    return dir;
+}
+
+static void ottsr_kiosk_set_dir(char *dir) {
+    G_LOCK(kiosk_dir);
+    g_free(ottsr_kiosk_user_dir);
+    ottsr_kiosk_user_dir = dir;
+    G_UNLOCK(kiosk_dir);
+}
+
+// Names become directory names: no separators, no dot files
+gboolean ottsr_kiosk_valid_user(const char *user) {
+    if (!user || !*user || *user == '.' || strlen(user) > OTTSR_KIOSK_MAX_USER) return FALSE;
+
+    for (const char *p = user; *p; p++) {
+        if (!g_ascii_isalnum(*p) && *p != '.' && *p != '-' && *p != '_') return FALSE;
+    }
+    return TRUE;
+}
+
+static char *ottsr_kiosk_config_file(ottsr_kiosk_t *kiosk, const char *user) {
+    return g_build_filename(kiosk->root, user, OTTSR_CONFIG_FILE, NULL);
+}
+
+// A missing file stamps as size -1, so a new user's defaults stay valid
+// until something is written
+static void ottsr_kiosk_stamp(const char *path, gint64 *mtime, gint64 *size) {
+    GStatBuf st;
+    if (g_stat(path, &st) == 0) {
+        *mtime = st.st_mtime;
+        *size = st.st_size;
+    } else {
+        *mtime = 0;
+        *size = -1;
+    }
+}
+
+static void ottsr_kiosk_entry_free(ottsr_kiosk_entry_t *entry) {
+    g_free(entry->user);
+    g_free(entry);
+}
+
+static ottsr_kiosk_entry_t *ottsr_kiosk_load(ottsr_kiosk_t *kiosk, const char *user) {
+    ottsr_kiosk_entry_t *entry = g_new0(ottsr_kiosk_entry_t, 1);
+    entry->user = g_strdup(user);
+    ottsr_config_set_defaults(&entry->config);
+
+    char *path = ottsr_kiosk_config_file(kiosk, user);
+    ottsr_kiosk_stamp(path, &entry->mtime, &entry->size);
+    if (entry->size >= 0) {
+        ottsr_config_load_file(path, &entry->config);
+    }
+    g_free(path);
+    return entry;
+}
+
+// Caller holds the lock. Entries with writes in flight are never evicted,
+// or a prefetch could read the file back before it is written.
+static void ottsr_kiosk_insert(ottsr_kiosk_t *kiosk, ottsr_kiosk_entry_t *entry) {
+    g_queue_push_head(&kiosk->lru, entry);
+    g_hash_table_insert(kiosk->entries, entry->user, kiosk->lru.head);
+
+    GList *link = kiosk->lru.tail;
+    while (g_queue_get_length(&kiosk->lru) > OTTSR_KIOSK_CACHE_SIZE && link) {
+        GList *prev = link->prev;
+        ottsr_kiosk_entry_t *victim = link->data;
+
+        if (victim->flushing == 0 && victim != entry) {
+            g_hash_table_remove(kiosk->entries, victim->user);
+            g_queue_delete_link(&kiosk->lru, link);
+            ottsr_kiosk_entry_free(victim);
+        }
+        link = prev;
+    }
+}
+
+static ottsr_kiosk_entry_t *ottsr_kiosk_lookup(ottsr_kiosk_t *kiosk, const char *user) {
+    GList *link = g_hash_table_lookup(kiosk->entries, user);
+    if (!link) return NULL;
+
+    g_queue_unlink(&kiosk->lru, link);
+    g_queue_push_head_link(&kiosk->lru, link);
+    return link->data;
+}
+
+static void ottsr_kiosk_write_free(ottsr_kiosk_write_t *write) {
+    g_free(write->user);
+    g_free(write->path);
+    g_free(write->data);
+    g_free(write);
+}
+
+// Paths were fixed when the write was queued, so a switch in between does
+// not send it to the next user
+static void ottsr_kiosk_write_history(ottsr_kiosk_write_t *write) {
+    g_mkdir_with_parents(write->path, 0755);
+    ottsr_history_append_at(write->path, &write->record);
+    if (write->data) ottsr_notes_append_at(write->path, write->record.started_at, write->data);
+}
+
+static void ottsr_kiosk_write_job(gpointer data, gpointer user_data) {
+    ottsr_kiosk_write_t *write = data;
+    ottsr_kiosk_t *kiosk = user_data;
+    GError *error = NULL;
+
+    if (write->kind == OTTSR_KIOSK_WRITE_HISTORY) {
+        ottsr_kiosk_write_history(write);
+        ottsr_kiosk_write_free(write);
+        return;
+    }
+
+    char *dir = g_path_get_dirname(write->path);
+    g_mkdir_with_parents(dir, 0755);
+    g_free(dir);
+
+    gboolean ok = g_file_set_contents(write->path, write->data, write->length, &error);
+    if (!ok) {
+        g_warning("Failed to save %s for %s: %s", write->path, write->user, error->message);
+        g_error_free(error);
+    }
+    if (write->kind == OTTSR_KIOSK_WRITE_FILE) {
+        ottsr_kiosk_write_free(write);
+        return;
+    }
+
+    gint64 mtime, size;
+    ottsr_kiosk_stamp(write->path, &mtime, &size);
+
+    // Writes run in order, so the last one out matches the cached config
+    g_mutex_lock(&kiosk->lock);
+    GList *link = g_hash_table_lookup(kiosk->entries, write->user);
+    if (link) {
+        ottsr_kiosk_entry_t *entry = link->data;
+        if (--entry->flushing == 0 && ok) {
+            entry->mtime = mtime;
+            entry->size = size;
+        }
+    }
+    g_mutex_unlock(&kiosk->lock);
+
+    ottsr_kiosk_write_free(write);
+}
+
+// Queue the current user's settings for writing and remember them as the
+// freshest copy, so switching back does not read them off the disk again
+gboolean ottsr_kiosk_save(ottsr_app_t *app) {
+    ottsr_kiosk_t *kiosk = app->kiosk;
+
+    ottsr_kiosk_write_t *write = g_new0(ottsr_kiosk_write_t, 1);
+    write->kind = OTTSR_KIOSK_WRITE_CONFIG;
+    write->user = g_strdup(kiosk->user);
+    write->path = ottsr_kiosk_config_file(kiosk, kiosk->user);
+    write->data = ottsr_config_to_json(&app->config, &write->length);
+    app->saved_config_hash = ottsr_hash_bytes(write->data, write->length);
+
+    g_mutex_lock(&kiosk->lock);
+    ottsr_kiosk_entry_t *entry = ottsr_kiosk_lookup(kiosk, kiosk->user);
+    if (!entry) {
+        entry = g_new0(ottsr_kiosk_entry_t, 1);
+        entry->user = g_strdup(kiosk->user);
+        ottsr_kiosk_insert(kiosk, entry);
+    }
+    entry->config = app->config;
+    entry->flushing++;
+    g_mutex_unlock(&kiosk->lock);
+
+    g_thread_pool_push(kiosk->writer, write, NULL);
+    return TRUE;
+}
+
+// Queue a finished study phase and its note for the current user, behind
+// any settings already queued
+void ottsr_kiosk_history_add(ottsr_app_t *app, const ottsr_history_record_t *record, const char *note) {
+    ottsr_kiosk_t *kiosk = app->kiosk;
+
+    ottsr_kiosk_write_t *write = g_new0(ottsr_kiosk_write_t, 1);
+    write->kind = OTTSR_KIOSK_WRITE_HISTORY;
+    write->user = g_strdup(kiosk->user);
+    write->path = g_build_filename(kiosk->root, kiosk->user, NULL);
+    write->data = note && *note ? g_strdup(note) : NULL;
+    write->record = *record;
+    g_thread_pool_push(kiosk->writer, write, NULL);
+}
+
+// Queue a whole file of the current user's, e.g. estimates flushed on a
+// switch; the caller has already serialized it
+void ottsr_kiosk_write_file(ottsr_app_t *app, char *path, char *data, gsize length) {
+    ottsr_kiosk_write_t *write = g_new0(ottsr_kiosk_write_t, 1);
+    write->kind = OTTSR_KIOSK_WRITE_FILE;
+    write->user = g_strdup(app->kiosk->user);
+    write->path = path;
+    write->data = data;
+    write->length = length;
+    g_thread_pool_push(app->kiosk->writer, write, NULL);
+}
+
+// Prefetch jobs are user names; the empty name asks for the users who
+// signed in most recently. Pushed under the lock, so nothing reaches the
+// pool once ottsr_kiosk_stop has set stopping.
+static void ottsr_kiosk_prefetch(ottsr_kiosk_t *kiosk, const char *user) {
+    g_mutex_lock(&kiosk->lock);
+    if (!kiosk->stopping && !g_hash_table_contains(kiosk->entries, user) &&
+        !g_hash_table_contains(kiosk->pending, user)) {
+        g_hash_table_add(kiosk->pending, g_strdup(user));
+        g_thread_pool_push(kiosk->prefetcher, g_strdup(user), NULL);
+    }
+    g_mutex_unlock(&kiosk->lock);
+}
+
+static gint ottsr_kiosk_compare_recent(gconstpointer a, gconstpointer b) {
+    const ottsr_kiosk_entry_t *x = *(ottsr_kiosk_entry_t *const *)a;
+    const ottsr_kiosk_entry_t *y = *(ottsr_kiosk_entry_t *const *)b;
+    return (x->mtime < y->mtime) - (x->mtime > y->mtime);
+}
+
+static void ottsr_kiosk_prefetch_recent(ottsr_kiosk_t *kiosk) {
+    GDir *dir = g_dir_open(kiosk->root, 0, NULL);
+    if (!dir) return;
+
+    // Only stamps here; configs are loaded for the winners
+    GPtrArray *users = g_ptr_array_new_with_free_func((GDestroyNotify)ottsr_kiosk_entry_free);
+    const char *name;
+    while ((name = g_dir_read_name(dir)) != NULL) {
+        if (!ottsr_kiosk_valid_user(name)) continue;
+
+        ottsr_kiosk_entry_t *entry = g_new0(ottsr_kiosk_entry_t, 1);
+        entry->user = g_strdup(name);
+        char *path = ottsr_kiosk_config_file(kiosk, name);
+        ottsr_kiosk_stamp(path, &entry->mtime, &entry->size);
+        g_free(path);
+
+        if (entry->size >= 0) {
+            g_ptr_array_add(users, entry);
+        } else {
+            ottsr_kiosk_entry_free(entry);
+        }
+    }
+    g_dir_close(dir);
+
+    g_ptr_array_sort(users, ottsr_kiosk_compare_recent);
+    for (guint i = 0; i < MIN(users->len, OTTSR_KIOSK_CACHE_SIZE - 1); i++) {
+        ottsr_kiosk_entry_t *entry = g_ptr_array_index(users, i);
+        ottsr_kiosk_prefetch(kiosk, entry->user);
+    }
+    g_ptr_array_unref(users);
+}
+
+static void ottsr_kiosk_prefetch_job(gpointer data, gpointer user_data) {
+    char *user = data;
+    ottsr_kiosk_t *kiosk = user_data;
+
+    if (!*user) {
+        ottsr_kiosk_prefetch_recent(kiosk);
+        g_free(user);
+        return;
+    }
+
+    ottsr_kiosk_entry_t *entry = ottsr_kiosk_load(kiosk, user);
+
+    g_mutex_lock(&kiosk->lock);
+    g_hash_table_remove(kiosk->pending, user);
+    if (!g_hash_table_contains(kiosk->entries, user)) {
+        ottsr_kiosk_insert(kiosk, entry);
+        entry = NULL;
+    }
+    g_mutex_unlock(&kiosk->lock);
+
+    if (entry) ottsr_kiosk_entry_free(entry);
+    g_free(user);
+}
+
+// Set up kiosk mode when OTTSR_KIOSK_DIR is set; runs before the config loads
+void ottsr_kiosk_init(ottsr_app_t *app) {
+    const char *root = g_getenv(OTTSR_KIOSK_ENV);
+    if (!root || !*root) return;
+
+    if (g_mkdir_with_parents(root, 0755) != 0) {
+        g_warning("Cannot use kiosk directory %s: %s", root, g_strerror(errno));
+        return;
+    }
+
+    ottsr_kiosk_t *kiosk = g_new0(ottsr_kiosk_t, 1);
+    kiosk->root = g_strdup(root);
+    kiosk->user = g_strdup(OTTSR_KIOSK_GUEST);
+    g_mutex_init(&kiosk->lock);
+    g_queue_init(&kiosk->lru);
+    kiosk->entries = g_hash_table_new(g_str_hash, g_str_equal);
+    kiosk->pending = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+
+    // One writer keeps each user's saves in order
+    kiosk->writer = g_thread_pool_new(ottsr_kiosk_write_job, kiosk, 1, TRUE, NULL);
+    kiosk->prefetcher = g_thread_pool_new(ottsr_kiosk_prefetch_job, kiosk,
+                                          OTTSR_KIOSK_PREFETCH_THREADS, FALSE, NULL);
+
+    ottsr_kiosk_set_dir(g_build_filename(root, kiosk->user, NULL));
+    app->kiosk = kiosk;
+    app->user_cancel = g_cancellable_new();
+
+    g_thread_pool_push(kiosk->prefetcher, g_strdup(""), NULL);
+    g_print("Kiosk mode: users in %s\n", root);
+}
+
+// Finish every queued write; prefetches not yet started are dropped
+void ottsr_kiosk_stop(ottsr_app_t *app) {
+    ottsr_kiosk_t *kiosk = app->kiosk;
+    if (!kiosk) return;
+
+    // A running prefetch_recent may still queue users; stop it first, then
+    // drop what is queued and wait for the jobs already running
+    g_mutex_lock(&kiosk->lock);
+    kiosk->stopping = TRUE;
+    g_mutex_unlock(&kiosk->lock);
+    g_thread_pool_free(kiosk->prefetcher, TRUE, TRUE);
+    g_thread_pool_free(kiosk->writer, FALSE, TRUE);
+
+    g_queue_clear_full(&kiosk->lru, (GDestroyNotify)ottsr_kiosk_entry_free);
+    g_hash_table_destroy(kiosk->entries);
+    g_hash_table_destroy(kiosk->pending);
+    g_mutex_clear(&kiosk->lock);
+    g_free(kiosk->root);
+    g_free(kiosk->user);
+    g_free(kiosk);
+
+    ottsr_kiosk_set_dir(NULL);
+    g_clear_object(&app->user_cancel);
+    app->kiosk = NULL;
+}
+
+// Drop everything derived from the outgoing user's files; nothing of one
+// student may show up on the next student's screen
+static void ottsr_kiosk_release_user(ottsr_app_t *app) {
+    g_cancellable_cancel(app->user_cancel);
+    g_object_unref(app->user_cancel);
+    app->user_cancel = g_cancellable_new();
+
+    ottsr_archive_cancel(app);
+    ottsr_config_monitor_stop(app);
+    ottsr_checkpoint_close(app);
+
+    if (app->settings_window) {
+        gtk_widget_destroy(app->settings_window);
+        app->settings_window = NULL;
+    }
+    if (app->profiles_window) {
+        gtk_widget_destroy(app->profiles_window);
+        app->profiles_window = NULL;
+    }
+    if (app->timeline_window) {
+        gtk_widget_destroy(app->timeline_window);
+    }
+    ottsr_timeline_free(app->timeline);
+    app->timeline = NULL;
+    if (app->search_window) {
+        gtk_widget_destroy(app->search_window);
+    }
+    ottsr_search_clear(app);
+
+    ottsr_subjects_clear(app);
+    ottsr_estimates_clear(app);
+    ottsr_catalog_replace(app, NULL);
+}
+
+static void ottsr_kiosk_attach_user(ottsr_app_t *app) {
+    app->saved_config_hash = 0;
+    ottsr_checkpoint_open(app);
+    ottsr_config_monitor_start(app);
+    ottsr_subjects_load_async(app);
+    ottsr_estimates_load_async(app);
+    ottsr_catalog_load_async(app);
+    ottsr_archive_schedule(app);
+}
+
+// Hand the window to another student. A running session is ended and
+// credited to the outgoing user first; its history, notes, estimates and
+// settings go to the writer, so nothing here waits on the disk.
+gboolean ottsr_kiosk_switch(ottsr_app_t *app, const char *user) {
+    ottsr_kiosk_t *kiosk = app->kiosk;
+    if (!kiosk) return FALSE;
+    if (!ottsr_kiosk_valid_user(user)) {
+        g_warning("Invalid kiosk user name: %s", user);
+        return FALSE;
+    }
+    if (strcmp(user, kiosk->user) == 0) return TRUE;
+
+    gint64 start = g_get_monotonic_time();
+
+    if (app->session.state != OTTSR_STATE_IDLE) {
+        ottsr_stop_session(app);
+    } else {
+        ottsr_save_config(app);
+    }
+    ottsr_kiosk_release_user(app);
+
+    g_free(kiosk->user);
+    kiosk->user = g_strdup(user);
+    ottsr_kiosk_set_dir(g_build_filename(kiosk->root, user, NULL));
+
+    char *path = ottsr_kiosk_config_file(kiosk, user);
+    gint64 mtime, size;
+    ottsr_kiosk_stamp(path, &mtime, &size);
+    g_free(path);
+
+    ottsr_config_t *incoming = g_new(ottsr_config_t, 1);
+    gboolean cached = FALSE;
+
+    g_mutex_lock(&kiosk->lock);
+    ottsr_kiosk_entry_t *entry = ottsr_kiosk_lookup(kiosk, user);
+    if (entry && (entry->flushing > 0 || (entry->mtime == mtime && entry->size == size))) {
+        *incoming = entry->config;
+        cached = TRUE;
+    }
+    g_mutex_unlock(&kiosk->lock);
+
+    // Not prefetched, or changed on disk since: read it now
+    if (!cached) {
+        ottsr_kiosk_entry_t *loaded = ottsr_kiosk_load(kiosk, user);
+        *incoming = loaded->config;
+
+        // Look again: a prefetch may have evicted or added it meanwhile
+        g_mutex_lock(&kiosk->lock);
+        GList *link = g_hash_table_lookup(kiosk->entries, user);
+        if (!link) {
+            ottsr_kiosk_insert(kiosk, loaded);
+            loaded = NULL;
+        } else if (((ottsr_kiosk_entry_t *)link->data)->flushing == 0) {
+            ottsr_kiosk_entry_t *stale = link->data;
+            stale->config = loaded->config;
+            stale->mtime = loaded->mtime;
+            stale->size = loaded->size;
+        }
+        g_mutex_unlock(&kiosk->lock);
+        if (loaded) ottsr_kiosk_entry_free(loaded);
+    }
+
+    ottsr_config_replace(app, incoming);
+    g_free(incoming);
+
+    memset(&app->session, 0, sizeof(app->session));
+    app->session.state = OTTSR_STATE_IDLE;
+    app->session.profile_index = app->config.active_profile;
+
+    gtk_entry_set_text(GTK_ENTRY(app->subject_entry), app->config.last_subject);
+    if (kiosk->user_entry) gtk_entry_set_text(GTK_ENTRY(kiosk->user_entry), user);
+
+    ottsr_kiosk_attach_user(app);
+    ottsr_update_display(app);
+    ottsr_http_update(app);
+
+    g_debug("Switched to %s in %.1f ms (%s)", user,
+            (g_get_monotonic_time() - start) / 1000.0, cached ? "cached" : "loaded");
+    return TRUE;
+}
+
+static void on_kiosk_switch(GtkWidget *widget, ottsr_app_t *app) {
+    const char *user = gtk_entry_get_text(GTK_ENTRY(app->kiosk->user_entry));
+    if (!ottsr_kiosk_switch(app, user)) {
+        gtk_entry_set_text(GTK_ENTRY(app->kiosk->user_entry), app->kiosk->user);
+    }
+}
+
+// Start reading a returning student's settings while they are still typing
+static void on_kiosk_user_changed(GtkEditable *editable, ottsr_app_t *app) {
+    const char *user = gtk_entry_get_text(GTK_ENTRY(editable));
+    if (!ottsr_kiosk_valid_user(user)) return;
+
+    char *dir = g_build_filename(app->kiosk->root, user, NULL);
+    if (g_file_test(dir, G_FILE_TEST_IS_DIR)) {
+        ottsr_kiosk_prefetch(app->kiosk, user);
+    }
+    g_free(dir);
+}
+
+// Student name entry for the main window, or NULL outside kiosk mode
+GtkWidget *ottsr_kiosk_create_bar(ottsr_app_t *app) {
+    if (!app->kiosk) return NULL;
+
+    GtkWidget *box = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 10);
+
+    GtkWidget *label = gtk_label_new("Student:");
+    gtk_box_pack_start(GTK_BOX(box), label, FALSE, FALSE, 0);
+
+    app->kiosk->user_entry = gtk_entry_new();
+    gtk_style_context_add_class(gtk_widget_get_style_context(app->kiosk->user_entry), "settings-entry");
+    gtk_entry_set_max_length(GTK_ENTRY(app->kiosk->user_entry), OTTSR_KIOSK_MAX_USER);
+    gtk_entry_set_text(GTK_ENTRY(app->kiosk->user_entry), app->kiosk->user);
+    g_signal_connect(app->kiosk->user_entry, "changed", G_CALLBACK(on_kiosk_user_changed), app);
+    g_signal_connect(app->kiosk->user_entry, "activate", G_CALLBACK(on_kiosk_switch), app);
+    gtk_box_pack_start(GTK_BOX(box), app->kiosk->user_entry, TRUE, TRUE, 0);
+
+    GtkWidget *button = gtk_button_new_with_label("Switch");
+    gtk_style_context_add_class(gtk_widget_get_style_context(button), "control-button");
+    g_signal_connect(button, "clicked", G_CALLBACK(on_kiosk_switch), app);
+    gtk_box_pack_start(GTK_BOX(box), button, FALSE, FALSE, 0);
+
+    return box;
+}
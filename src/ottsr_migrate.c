@@ -0,0 +1,449 @@
+#include "ottsr.h"
+#include <errno.h>
+#ifdef G_OS_UNIX
+#include <fcntl.h>
+#endif
+
+// One legacy config found by the scan: the directory holding it, relative
+// to the directory the administrator named
+typedef struct {
+    char *root;
+    char *relative;
+} ottsr_migrate_job_t;
+
+typedef struct {
+    gboolean force;
+    gint converted;
+    gint skipped;
+    gint failed;
+    gint64 bytes;
+    GMutex lock;
+    GPtrArray *failures;
+} ottsr_migration_t;
+
+static int ottsr_legacy_int(const char *value, int fallback) {
+    char *end = NULL;
+    gint64 number = g_ascii_strtoll(value, &end, 10);
+    return (end && end != value && *end == '\0') ? (int)CLAMP(number, G_MININT, G_MAXINT) : fallback;
+}
+
+static void ottsr_legacy_string(char *dest, const char *value) {
+    g_strlcpy(dest, value, OTTSR_MAX_NAME_LEN);
+}
+
+static gboolean ottsr_legacy_profile_key(ottsr_profile_t *profile, const char *field, const char *value) {
+    if (strcmp(field, "name") == 0) {
+        ottsr_legacy_string(profile->name, value);
+    } else if (strcmp(field, "study_minutes") == 0) {
+        profile->study_minutes = ottsr_legacy_int(value, profile->study_minutes);
+    } else if (strcmp(field, "break_minutes") == 0) {
+        profile->break_minutes = ottsr_legacy_int(value, profile->break_minutes);
+    } else if (strcmp(field, "long_break_minutes") == 0) {
+        profile->long_break_minutes = ottsr_legacy_int(value, profile->long_break_minutes);
+    } else if (strcmp(field, "sessions_until_long_break") == 0) {
+        profile->sessions_until_long_break = ottsr_legacy_int(value, profile->sessions_until_long_break);
+    } else if (strcmp(field, "sound_enabled") == 0) {
+        profile->sound_enabled = ottsr_legacy_int(value, profile->sound_enabled) != 0;
+    } else if (strcmp(field, "notifications_enabled") == 0) {
+        profile->notifications_enabled = ottsr_legacy_int(value, profile->notifications_enabled) != 0;
+    } else if (strcmp(field, "total_study_time") == 0) {
+        profile->total_study_time = ottsr_legacy_int(value, profile->total_study_time);
+    } else if (strcmp(field, "total_sessions") == 0) {
+        profile->total_sessions = ottsr_legacy_int(value, profile->total_sessions);
+    } else if (strcmp(field, "completed_sessions") == 0) {
+        profile->completed_sessions = ottsr_legacy_int(value, profile->completed_sessions);
+    } else {
+        return FALSE;
+    }
+    return TRUE;
+}
+
+// Decode a 1.x key=value config on top of the values already in config.
+// Unknown keys (window_x, window_y, ...) are ignored.
+gboolean ottsr_config_parse_legacy(ottsr_config_t *config, const char *data, gsize length) {
+    char *text = g_strndup(data, length);
+    char **lines = g_strsplit(text, "\n", -1);
+    int profile_count = -1;
+    int highest_profile = -1;
+    guint recognized = 0;
+
+    // Profiles the defaults do not cover start from the usual Pomodoro timings
+    for (int i = config->profile_count; i < OTTSR_MAX_PROFILES; i++) {
+        ottsr_profile_t *profile = &config->profiles[i];
+        memset(profile, 0, sizeof(*profile));
+        snprintf(profile->name, sizeof(profile->name), "Profile %d", i + 1);
+        profile->study_minutes = 25;
+        profile->break_minutes = 5;
+        profile->long_break_minutes = 15;
+        profile->sessions_until_long_break = 4;
+        profile->sound_enabled = TRUE;
+        profile->notifications_enabled = TRUE;
+    }
+
+    for (char **line = lines; *line; line++) {
+        char *entry = g_strstrip(*line);
+        if (entry[0] == '\0' || entry[0] == '#') continue;
+
+        char *equals = strchr(entry, '=');
+        if (!equals) continue;
+        *equals = '\0';
+        const char *key = g_strstrip(entry);
+        const char *value = g_strstrip(equals + 1);
+        gboolean known = TRUE;
+
+        if (strcmp(key, "theme") == 0) {
+            config->theme = CLAMP(ottsr_legacy_int(value, config->theme), OTTSR_THEME_LIGHT, OTTSR_THEME_AUTO);
+        } else if (strcmp(key, "minimize_to_tray") == 0) {
+            config->minimize_to_tray = ottsr_legacy_int(value, config->minimize_to_tray) != 0;
+        } else if (strcmp(key, "autostart_sessions") == 0) {
+            config->autostart_sessions = ottsr_legacy_int(value, config->autostart_sessions) != 0;
+        } else if (strcmp(key, "sound_volume") == 0) {
+            config->sound_volume = CLAMP(ottsr_legacy_int(value, config->sound_volume), 0, 100);
+        } else if (strcmp(key, "profile_count") == 0) {
+            profile_count = ottsr_legacy_int(value, -1);
+        } else if (strcmp(key, "active_profile") == 0) {
+            config->active_profile = ottsr_legacy_int(value, config->active_profile);
+        } else if (strcmp(key, "last_subject") == 0) {
+            ottsr_legacy_string(config->last_subject, value);
+        } else if (g_str_has_prefix(key, "profile_")) {
+            char *field = NULL;
+            gint64 index = g_ascii_strtoll(key + strlen("profile_"), &field, 10);
+            known = field && *field == '_' && index >= 0 && index < OTTSR_MAX_PROFILES &&
+                    ottsr_legacy_profile_key(&config->profiles[index], field + 1, value);
+            if (known) highest_profile = MAX(highest_profile, (int)index);
+        } else {
+            known = FALSE;
+        }
+
+        if (known) recognized++;
+    }
+
+    g_strfreev(lines);
+    g_free(text);
+
+    if (recognized == 0) return FALSE;
+
+    if (profile_count < 0) profile_count = MAX(config->profile_count, highest_profile + 1);
+    config->profile_count = CLAMP(profile_count, 1, OTTSR_MAX_PROFILES);
+    if (config->active_profile < 0 || config->active_profile >= config->profile_count) {
+        config->active_profile = 0;
+    }
+    return TRUE;
+}
+
+// Parse legacy contents into JSON settings
+static char *ottsr_legacy_to_json(const char *contents, gsize length, gsize *json_length, GError **error) {
+    ottsr_config_t config;
+    memset(&config, 0, sizeof(config));
+    ottsr_config_set_defaults(&config);
+
+    if (!ottsr_config_parse_legacy(&config, contents, length)) {
+        g_set_error(error, G_FILE_ERROR, G_FILE_ERROR_INVAL, "no recognized settings");
+        return NULL;
+    }
+    return ottsr_config_to_json(&config, json_length);
+}
+
+#ifdef G_OS_UNIX
+static gboolean ottsr_legacy_fail(GError **error, const char *what) {
+    int saved = errno;
+    g_set_error(error, G_FILE_ERROR, g_file_error_from_errno(saved), "%s: %s", what, g_strerror(saved));
+    return FALSE;
+}
+
+// Read a legacy file inside dir_fd without following a symlink and convert it
+static char *ottsr_legacy_read_at(int dir_fd, const char *name, struct stat *st, gsize *length,
+                                  gsize *json_length, GError **error) {
+    int fd = openat(dir_fd, name, O_RDONLY | O_NOFOLLOW | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0) {
+        ottsr_legacy_fail(error, "cannot open");
+        return NULL;
+    }
+    if (fstat(fd, st) != 0) {
+        ottsr_legacy_fail(error, "cannot stat");
+        close(fd);
+        return NULL;
+    }
+    if (!S_ISREG(st->st_mode)) {
+        g_set_error(error, G_FILE_ERROR, G_FILE_ERROR_INVAL, "not a regular file");
+        close(fd);
+        return NULL;
+    }
+
+    char *json = NULL;
+    GMappedFile *mapped = st->st_size > 0 ? g_mapped_file_new_from_fd(fd, FALSE, error) : NULL;
+    if (mapped || st->st_size == 0) {
+        *length = mapped ? g_mapped_file_get_length(mapped) : 0;
+        json = ottsr_legacy_to_json(mapped ? g_mapped_file_get_contents(mapped) : "", *length, json_length, error);
+    }
+
+    if (mapped) g_mapped_file_unref(mapped);
+    close(fd);
+    return json;
+}
+
+// Write a fresh temporary file inside dir_fd, give it the owner and
+// permissions of source by descriptor and rename it over name; the rename
+// replaces whatever entry is there rather than writing through it
+static gboolean ottsr_legacy_write_at(int dir_fd, const char *name, const char *json, gsize json_length,
+                                      const struct stat *source, GError **error) {
+    char *temp_name = g_strdup_printf(".%s.%08x", name, g_random_int());
+    int fd = openat(dir_fd, temp_name, O_WRONLY | O_CREAT | O_EXCL | O_NOFOLLOW | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        g_free(temp_name);
+        return ottsr_legacy_fail(error, "cannot create temporary file");
+    }
+
+    gboolean ok = FALSE;
+    if (write(fd, json, json_length) != (gssize)json_length) {
+        ottsr_legacy_fail(error, "write failed");
+    } else if (fchown(fd, source->st_uid, source->st_gid) != 0 && errno != EPERM) {
+        ottsr_legacy_fail(error, "chown failed");
+    } else if (fchmod(fd, source->st_mode & 0777) != 0) {
+        ottsr_legacy_fail(error, "chmod failed");
+    } else if (fsync(fd) != 0) {
+        ottsr_legacy_fail(error, "fsync failed");
+    } else {
+        ok = TRUE;
+    }
+    close(fd);
+
+    if (ok && renameat(dir_fd, temp_name, dir_fd, name) != 0) {
+        ok = ottsr_legacy_fail(error, "rename failed");
+    }
+    if (!ok) unlinkat(dir_fd, temp_name, 0);
+
+    g_free(temp_name);
+    return ok;
+}
+
+// Open root, then each directory of relative below it in turn, refusing a
+// symlink at every step; a user can swap any component of their own home
+// for a link between the scan and the conversion
+static int ottsr_legacy_open_dir(const char *root, const char *relative, GError **error) {
+    int dir_fd = open(root, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir_fd < 0) {
+        ottsr_legacy_fail(error, "cannot open directory");
+        return -1;
+    }
+
+    char **components = g_strsplit(relative, G_DIR_SEPARATOR_S, -1);
+    for (char **component = components; *component && dir_fd >= 0; component++) {
+        if (**component == '\0' || strcmp(*component, ".") == 0) continue;
+        if (strcmp(*component, "..") == 0) {
+            g_set_error(error, G_FILE_ERROR, G_FILE_ERROR_INVAL, "path leaves the scanned directory");
+            close(dir_fd);
+            dir_fd = -1;
+            break;
+        }
+
+        int next = openat(dir_fd, *component, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+        if (next < 0) ottsr_legacy_fail(error, "cannot open directory");
+        close(dir_fd);
+        dir_fd = next;
+    }
+
+    g_strfreev(components);
+    return dir_fd;
+}
+
+// Convert the legacy file in root/relative to settings.json, atomically and
+// owned like the original. migrate runs as root over users' homes, so
+// nothing below root is reached through a symlink: the directories are
+// walked with O_NOFOLLOW and both files are opened relative to the last.
+static gboolean ottsr_legacy_convert(const char *root, const char *relative, gsize *bytes, GError **error) {
+    int dir_fd = ottsr_legacy_open_dir(root, relative, error);
+    if (dir_fd < 0) return FALSE;
+
+    struct stat st;
+    gsize length = 0, json_length = 0;
+
+    char *json = ottsr_legacy_read_at(dir_fd, OTTSR_LEGACY_CONFIG_FILE, &st, &length, &json_length, error);
+    gboolean ok = json && ottsr_legacy_write_at(dir_fd, OTTSR_CONFIG_FILE, json, json_length, &st, error);
+
+    g_free(json);
+    close(dir_fd);
+
+    if (ok && bytes) *bytes = length;
+    return ok;
+}
+#else
+static gboolean ottsr_legacy_convert(const char *root, const char *relative, gsize *bytes, GError **error) {
+    char *legacy_path = g_build_filename(root, relative, OTTSR_LEGACY_CONFIG_FILE, NULL);
+    char *contents = NULL;
+    gsize length = 0;
+    gboolean read = g_file_get_contents(legacy_path, &contents, &length, error);
+    g_free(legacy_path);
+    if (!read) return FALSE;
+
+    gsize json_length = 0;
+    char *json = ottsr_legacy_to_json(contents, length, &json_length, error);
+    g_free(contents);
+    if (!json) return FALSE;
+
+    char *json_path = g_build_filename(root, relative, OTTSR_CONFIG_FILE, NULL);
+    gboolean ok = g_file_set_contents(json_path, json, json_length, error);
+    g_free(json_path);
+    g_free(json);
+
+    if (ok && bytes) *bytes = length;
+    return ok;
+}
+#endif
+
+// 1.x installs only have the key=value file; convert it once on first start
+gboolean ottsr_legacy_import(const char *json_path) {
+    char *config_dir = g_path_get_dirname(json_path);
+    char *legacy_path = g_build_filename(config_dir, OTTSR_LEGACY_CONFIG_FILE, NULL);
+
+    gboolean ok = FALSE;
+    if (g_file_test(legacy_path, G_FILE_TEST_IS_REGULAR)) {
+        GError *error = NULL;
+        ok = ottsr_legacy_convert(config_dir, "", NULL, &error);
+        if (ok) {
+            g_print("Imported legacy configuration from %s\n", legacy_path);
+        } else {
+            g_warning("Failed to import legacy configuration %s: %s", legacy_path, error->message);
+            g_error_free(error);
+        }
+    }
+
+    g_free(legacy_path);
+    g_free(config_dir);
+    return ok;
+}
+
+static void ottsr_migrate_job_free(ottsr_migrate_job_t *job) {
+    g_free(job->root);
+    g_free(job->relative);
+    g_free(job);
+}
+
+static void ottsr_migrate_worker(gpointer data, gpointer user_data) {
+    ottsr_migrate_job_t *job = data;
+    ottsr_migration_t *migration = user_data;
+    char *legacy_path = g_build_filename(job->root, job->relative, OTTSR_LEGACY_CONFIG_FILE, NULL);
+    char *json_path = g_build_filename(job->root, job->relative, OTTSR_CONFIG_FILE, NULL);
+
+    if (!migration->force && g_file_test(json_path, G_FILE_TEST_EXISTS)) {
+        g_atomic_int_inc(&migration->skipped);
+    } else {
+        GError *error = NULL;
+        gsize bytes = 0;
+
+        if (ottsr_legacy_convert(job->root, job->relative, &bytes, &error)) {
+            g_atomic_int_inc(&migration->converted);
+            g_mutex_lock(&migration->lock);
+            migration->bytes += bytes;
+            g_mutex_unlock(&migration->lock);
+        } else {
+            g_atomic_int_inc(&migration->failed);
+            g_mutex_lock(&migration->lock);
+            g_ptr_array_add(migration->failures, g_strdup_printf("%s: %s", legacy_path, error->message));
+            g_mutex_unlock(&migration->lock);
+            g_error_free(error);
+        }
+    }
+
+    g_free(json_path);
+    g_free(legacy_path);
+    ottsr_migrate_job_free(job);
+}
+
+// Depth-first walk below root handing every legacy config to the pool as it
+// is found. Symlinks are not followed so a hostile home directory cannot
+// redirect writes; the workers check that again for each directory.
+static void ottsr_migrate_scan(const char *root, const char *relative, GThreadPool *pool, guint *queued) {
+    char *directory = g_build_filename(root, relative, NULL);
+    GDir *dir = g_dir_open(directory, 0, NULL);
+    if (!dir) {
+        g_free(directory);
+        return;
+    }
+
+    const char *name;
+    while ((name = g_dir_read_name(dir)) != NULL) {
+        char *path = g_build_filename(directory, name, NULL);
+
+        if (g_file_test(path, G_FILE_TEST_IS_SYMLINK)) {
+            g_free(path);
+            continue;
+        }
+        if (g_file_test(path, G_FILE_TEST_IS_DIR)) {
+            char *child = g_build_filename(relative, name, NULL);
+            ottsr_migrate_scan(root, child, pool, queued);
+            g_free(child);
+        } else if (strcmp(name, OTTSR_LEGACY_CONFIG_FILE) == 0) {
+            ottsr_migrate_job_t *job = g_new0(ottsr_migrate_job_t, 1);
+            job->root = g_strdup(root);
+            job->relative = g_strdup(relative);
+            g_thread_pool_push(pool, job, NULL);
+            (*queued)++;
+        }
+        g_free(path);
+    }
+
+    g_dir_close(dir);
+    g_free(directory);
+}
+
+// `ottsr migrate DIR...`: admin batch conversion of legacy configs
+int ottsr_migrate_main(int argc, char *argv[]) {
+    int jobs = 0;
+    gboolean force = FALSE;
+
+    GOptionEntry entries[] = {
+        { "jobs", 'j', 0, G_OPTION_ARG_INT, &jobs, "Worker threads (default: one per CPU)", "N" },
+        { "force", 'f', 0, G_OPTION_ARG_NONE, &force, "Overwrite existing settings.json files", NULL },
+        { NULL }
+    };
+
+    GOptionContext *context = g_option_context_new("DIR... - convert " OTTSR_LEGACY_CONFIG_FILE
+                                                   " files under DIR to " OTTSR_CONFIG_FILE);
+    g_option_context_add_main_entries(context, entries, NULL);
+
+    GError *error = NULL;
+    gboolean ok = g_option_context_parse(context, &argc, &argv, &error);
+    g_option_context_free(context);
+
+    if (!ok) {
+        g_printerr("ottsr migrate: %s\n", error->message);
+        g_error_free(error);
+        return 1;
+    }
+    if (argc < 2) {
+        g_printerr("ottsr migrate: no directory given\n");
+        return 1;
+    }
+
+    ottsr_migration_t migration = {0};
+    migration.force = force;
+    migration.failures = g_ptr_array_new_with_free_func(g_free);
+    g_mutex_init(&migration.lock);
+
+    if (jobs <= 0) jobs = (int)g_get_num_processors();
+    GThreadPool *pool = g_thread_pool_new(ottsr_migrate_worker, &migration, jobs, TRUE, NULL);
+
+    gint64 start = g_get_monotonic_time();
+    guint queued = 0;
+    for (int i = 1; i < argc; i++) {
+        ottsr_migrate_scan(argv[i], "", pool, &queued);
+    }
+    g_thread_pool_free(pool, FALSE, TRUE);
+    double seconds = (g_get_monotonic_time() - start) / (double)G_USEC_PER_SEC;
+
+    for (guint i = 0; i < migration.failures->len; i++) {
+        g_printerr("failed: %s\n", (const char *)g_ptr_array_index(migration.failures, i));
+    }
+
+    g_print("Migrated %d of %u configs (%d already converted, %d failed) with %d threads in %.2f s"
+            " (%.0f files/s, %.2f MB/s)\n",
+            migration.converted, queued, migration.skipped, migration.failed, jobs, seconds,
+            seconds > 0 ? queued / seconds : 0.0,
+            seconds > 0 ? migration.bytes / seconds / (1024.0 * 1024.0) : 0.0);
+
+    int status = migration.failed > 0 ? 1 : 0;
+    g_ptr_array_unref(migration.failures);
+    g_mutex_clear(&migration.lock);
+    return status;
+}
@@ -0,0 +1,425 @@
+#include "ottsr.h"
+
+// Observable config: every setting a window shows is read and written
+// through here, and each write notifies only the listeners of that one
+// property. Bindings tie a widget to a property both ways, so widgets no
+// longer copy values in and out or refresh what did not change.
+
+typedef struct {
+    guint id;
+    ottsr_property_t property;
+    int profile;
+    ottsr_model_func_t func;
+    gpointer user_data;
+    GtkWidget *owner;
+    gulong owner_handler;
+} ottsr_model_listener_t;
+
+struct ottsr_binding {
+    ottsr_app_t *app;
+    GtkWidget *widget;
+    ottsr_property_t property;
+    int profile;
+    guint listener;
+    gulong handler;
+    ottsr_model_edits_t *edits;
+};
+
+// One property a window's bindings changed: what it held before the first
+// change and what they last wrote. profile is an index, never
+// OTTSR_PROFILE_ACTIVE, so a later switch does not move the edit.
+typedef struct {
+    ottsr_property_t property;
+    int profile;
+    int before;
+    int after;
+    char before_name[OTTSR_MAX_NAME_LEN];
+    char after_name[OTTSR_MAX_NAME_LEN];
+} ottsr_model_edit_t;
+
+struct ottsr_model_edits {
+    GArray *edits;
+};
+
+typedef struct {
+    ottsr_app_t *app;
+    guint id;
+} ottsr_model_owner_t;
+
+static gboolean ottsr_model_is_profile_property(ottsr_property_t property) {
+    return property >= OTTSR_PROP_PROFILE_NAME;
+}
+
+static int ottsr_model_resolve(ottsr_app_t *app, int profile) {
+    if (profile == OTTSR_PROFILE_ACTIVE) profile = app->config.active_profile;
+    return profile >= 0 && profile < app->config.profile_count ? profile : -1;
+}
+
+static int *ottsr_model_field(ottsr_config_t *config, ottsr_property_t property, int index) {
+    switch (property) {
+        case OTTSR_PROP_ACTIVE_PROFILE: return &config->active_profile;
+        case OTTSR_PROP_THEME: return (int *)&config->theme;
+        case OTTSR_PROP_SOUND_VOLUME: return &config->sound_volume;
+        case OTTSR_PROP_MAX_FPS: return &config->max_fps;
+        case OTTSR_PROP_AUTOSTART_SESSIONS: return &config->autostart_sessions;
+        case OTTSR_PROP_MINIMIZE_TO_TRAY: return &config->minimize_to_tray;
+        default: break;
+    }
+
+    if (index < 0) return NULL;
+    ottsr_profile_t *profile = &config->profiles[index];
+    switch (property) {
+        case OTTSR_PROP_STUDY_MINUTES: return &profile->study_minutes;
+        case OTTSR_PROP_BREAK_MINUTES: return &profile->break_minutes;
+        case OTTSR_PROP_LONG_BREAK_MINUTES: return &profile->long_break_minutes;
+        case OTTSR_PROP_SESSIONS_UNTIL_LONG_BREAK: return &profile->sessions_until_long_break;
+        case OTTSR_PROP_SOUND_ENABLED: return &profile->sound_enabled;
+        case OTTSR_PROP_NOTIFICATIONS_ENABLED: return &profile->notifications_enabled;
+        default: return NULL;
+    }
+}
+
+// Listeners removed while a notification is running are compacted after it
+static void ottsr_model_compact(ottsr_app_t *app) {
+    GArray *listeners = app->model_listeners;
+    guint kept = 0;
+    for (guint i = 0; i < listeners->len; i++) {
+        ottsr_model_listener_t *listener = &g_array_index(listeners, ottsr_model_listener_t, i);
+        if (listener->func) g_array_index(listeners, ottsr_model_listener_t, kept++) = *listener;
+    }
+    g_array_set_size(listeners, kept);
+}
+
+// With active_only, reach just the listeners following the active profile:
+// after a switch their property has a new value without having been set.
+static void ottsr_model_emit(ottsr_app_t *app, ottsr_property_t property, int index, gboolean active_only) {
+    if (!app->model_listeners) return;
+
+    gboolean per_profile = ottsr_model_is_profile_property(property);
+    guint count = app->model_listeners->len;
+    app->model_emitting++;
+
+    for (guint i = 0; i < count; i++) {
+        ottsr_model_listener_t listener = g_array_index(app->model_listeners, ottsr_model_listener_t, i);
+        if (!listener.func || listener.property != property) continue;
+
+        gboolean match;
+        if (active_only) {
+            match = listener.profile == OTTSR_PROFILE_ACTIVE;
+        } else {
+            match = !per_profile || listener.profile == OTTSR_PROFILE_ANY || listener.profile == index ||
+                    (listener.profile == OTTSR_PROFILE_ACTIVE && index == app->config.active_profile);
+        }
+        if (match) listener.func(property, index, listener.user_data);
+    }
+
+    if (--app->model_emitting == 0) ottsr_model_compact(app);
+}
+
+static void ottsr_model_emit_active(ottsr_app_t *app) {
+    int active = app->config.active_profile;
+    ottsr_model_emit(app, OTTSR_PROP_ACTIVE_PROFILE, active, FALSE);
+    for (int property = OTTSR_PROP_PROFILE_NAME; property < OTTSR_PROP_COUNT; property++) {
+        ottsr_model_emit(app, property, active, TRUE);
+    }
+}
+
+int ottsr_model_get(ottsr_app_t *app, ottsr_property_t property, int profile) {
+    int *field = ottsr_model_field(&app->config, property, ottsr_model_resolve(app, profile));
+    return field ? *field : 0;
+}
+
+const char *ottsr_model_get_name(ottsr_app_t *app, int profile) {
+    int index = ottsr_model_resolve(app, profile);
+    return index >= 0 ? app->config.profiles[index].name : "";
+}
+
+// Store value and notify, unless it is what the property already holds.
+// The profile is ignored for config-wide properties.
+gboolean ottsr_model_set(ottsr_app_t *app, ottsr_property_t property, int profile, int value) {
+    int index = ottsr_model_resolve(app, profile);
+    int *field = ottsr_model_field(&app->config, property, index);
+    if (!field || *field == value) return FALSE;
+
+    if (property == OTTSR_PROP_ACTIVE_PROFILE) {
+        if (value < 0 || value >= app->config.profile_count) return FALSE;
+        *field = value;
+        ottsr_model_emit_active(app);
+        return TRUE;
+    }
+
+    *field = value;
+    ottsr_model_emit(app, property, index, FALSE);
+    return TRUE;
+}
+
+gboolean ottsr_model_set_name(ottsr_app_t *app, int profile, const char *name) {
+    int index = ottsr_model_resolve(app, profile);
+    if (index < 0 || strcmp(app->config.profiles[index].name, name) == 0) return FALSE;
+
+    g_strlcpy(app->config.profiles[index].name, name, OTTSR_MAX_NAME_LEN);
+    ottsr_model_emit(app, OTTSR_PROP_PROFILE_NAME, index, FALSE);
+    return TRUE;
+}
+
+// Notify every property that differs from before, for code that rewrites
+// the config wholesale (reload, user switch, deleting a profile)
+void ottsr_model_changed(ottsr_app_t *app, const ottsr_config_t *before) {
+    ottsr_config_t *config = &app->config;
+    ottsr_config_t *old = (ottsr_config_t *)before;
+
+    for (int property = OTTSR_PROP_THEME; property < OTTSR_PROP_PROFILE_NAME; property++) {
+        if (*ottsr_model_field(config, property, -1) != *ottsr_model_field(old, property, -1)) {
+            ottsr_model_emit(app, property, 0, FALSE);
+        }
+    }
+
+    for (int i = 0; i < MIN(config->profile_count, before->profile_count); i++) {
+        if (strcmp(config->profiles[i].name, before->profiles[i].name) != 0) {
+            ottsr_model_emit(app, OTTSR_PROP_PROFILE_NAME, i, FALSE);
+        }
+        for (int property = OTTSR_PROP_STUDY_MINUTES; property < OTTSR_PROP_COUNT; property++) {
+            if (*ottsr_model_field(config, property, i) != *ottsr_model_field(old, property, i)) {
+                ottsr_model_emit(app, property, i, FALSE);
+            }
+        }
+    }
+
+    if (config->active_profile != before->active_profile) ottsr_model_emit_active(app);
+}
+
+// The edits a window that applies them live has made through its bindings
+ottsr_model_edits_t *ottsr_model_edits_new(void) {
+    ottsr_model_edits_t *edits = g_new(ottsr_model_edits_t, 1);
+    edits->edits = g_array_new(FALSE, FALSE, sizeof(ottsr_model_edit_t));
+    return edits;
+}
+
+// The edits so far are saved (or profiles moved under them): forget them
+void ottsr_model_edits_keep(ottsr_model_edits_t *edits) {
+    g_array_set_size(edits->edits, 0);
+}
+
+void ottsr_model_edits_free(ottsr_model_edits_t *edits) {
+    if (!edits) return;
+    g_array_unref(edits->edits);
+    g_free(edits);
+}
+
+static ottsr_model_edit_t *ottsr_model_edits_find(ottsr_model_edits_t *edits, ottsr_property_t property,
+                                                  int profile) {
+    for (guint i = 0; i < edits->edits->len; i++) {
+        ottsr_model_edit_t *edit = &g_array_index(edits->edits, ottsr_model_edit_t, i);
+        if (edit->property == property && edit->profile == profile) return edit;
+    }
+    return NULL;
+}
+
+// Put back what the window's own edits replaced, as it does when closed
+// without saving. A property someone else has set since is left as it is.
+void ottsr_model_restore(ottsr_app_t *app, ottsr_model_edits_t *edits) {
+    for (guint i = 0; i < edits->edits->len; i++) {
+        const ottsr_model_edit_t *edit = &g_array_index(edits->edits, ottsr_model_edit_t, i);
+        if (edit->profile >= app->config.profile_count) continue;
+
+        if (edit->property == OTTSR_PROP_PROFILE_NAME) {
+            if (strcmp(ottsr_model_get_name(app, edit->profile), edit->after_name) == 0) {
+                ottsr_model_set_name(app, edit->profile, edit->before_name);
+            }
+        } else if (ottsr_model_get(app, edit->property, edit->profile) == edit->after) {
+            ottsr_model_set(app, edit->property, edit->profile, edit->before);
+        }
+    }
+    ottsr_model_edits_keep(edits);
+}
+
+static void on_model_owner_destroy(GtkWidget *widget, ottsr_model_owner_t *owner) {
+    ottsr_model_disconnect(owner->app, owner->id);
+}
+
+static void ottsr_model_owner_free(gpointer data, GClosure *closure) {
+    g_free(data);
+}
+
+// Call func whenever property changes for profile (an index,
+// OTTSR_PROFILE_ACTIVE or OTTSR_PROFILE_ANY). With an owner widget the
+// listener goes away when the widget is destroyed.
+guint ottsr_model_connect(ottsr_app_t *app, ottsr_property_t property, int profile,
+                          ottsr_model_func_t func, gpointer user_data, GtkWidget *owner) {
+    if (!app->model_listeners) {
+        app->model_listeners = g_array_new(FALSE, FALSE, sizeof(ottsr_model_listener_t));
+    }
+
+    ottsr_model_listener_t listener = {0};
+    listener.id = ++app->model_next_id;
+    listener.property = property;
+    listener.profile = profile;
+    listener.func = func;
+    listener.user_data = user_data;
+
+    if (owner) {
+        ottsr_model_owner_t *data = g_new(ottsr_model_owner_t, 1);
+        data->app = app;
+        data->id = listener.id;
+        listener.owner = owner;
+        listener.owner_handler = g_signal_connect_data(owner, "destroy", G_CALLBACK(on_model_owner_destroy),
+                                                       data, ottsr_model_owner_free, 0);
+    }
+
+    g_array_append_val(app->model_listeners, listener);
+    return listener.id;
+}
+
+void ottsr_model_disconnect(ottsr_app_t *app, guint id) {
+    if (!app->model_listeners || id == 0) return;
+
+    for (guint i = 0; i < app->model_listeners->len; i++) {
+        ottsr_model_listener_t *listener = &g_array_index(app->model_listeners, ottsr_model_listener_t, i);
+        if (listener->id != id || !listener->func) continue;
+
+        if (listener->owner) g_signal_handler_disconnect(listener->owner, listener->owner_handler);
+        if (app->model_emitting > 0) {
+            listener->func = NULL;
+        } else {
+            g_array_remove_index(app->model_listeners, i);
+        }
+        return;
+    }
+}
+
+void ottsr_model_free(ottsr_app_t *app) {
+    if (!app->model_listeners) return;
+    g_array_unref(app->model_listeners);
+    app->model_listeners = NULL;
+}
+
+// Bindings
+
+static int ottsr_binding_read(ottsr_binding_t *binding) {
+    GtkWidget *widget = binding->widget;
+    if (GTK_IS_SPIN_BUTTON(widget)) return gtk_spin_button_get_value_as_int(GTK_SPIN_BUTTON(widget));
+    if (GTK_IS_TOGGLE_BUTTON(widget)) return gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(widget));
+    if (GTK_IS_COMBO_BOX(widget)) return gtk_combo_box_get_active(GTK_COMBO_BOX(widget));
+    if (GTK_IS_RANGE(widget)) return (int)gtk_range_get_value(GTK_RANGE(widget));
+    return 0;
+}
+
+// Model to widget; the widget's own handler is blocked so this is not
+// written straight back
+static void ottsr_binding_push(ottsr_binding_t *binding) {
+    ottsr_app_t *app = binding->app;
+    GtkWidget *widget = binding->widget;
+    g_signal_handler_block(widget, binding->handler);
+
+    if (binding->property == OTTSR_PROP_PROFILE_NAME) {
+        const char *name = ottsr_model_get_name(app, binding->profile);
+        if (strcmp(gtk_entry_get_text(GTK_ENTRY(widget)), name) != 0) {
+            gtk_entry_set_text(GTK_ENTRY(widget), name);
+        }
+    } else {
+        int value = ottsr_model_get(app, binding->property, binding->profile);
+        if (ottsr_binding_read(binding) != value) {
+            if (GTK_IS_SPIN_BUTTON(widget)) {
+                gtk_spin_button_set_value(GTK_SPIN_BUTTON(widget), value);
+            } else if (GTK_IS_TOGGLE_BUTTON(widget)) {
+                gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(widget), value);
+            } else if (GTK_IS_COMBO_BOX(widget)) {
+                gtk_combo_box_set_active(GTK_COMBO_BOX(widget), value);
+            } else if (GTK_IS_RANGE(widget)) {
+                gtk_range_set_value(GTK_RANGE(widget), value);
+            }
+        }
+    }
+
+    g_signal_handler_unblock(widget, binding->handler);
+}
+
+static void on_binding_model_changed(ottsr_property_t property, int profile, gpointer user_data) {
+    ottsr_binding_push(user_data);
+}
+
+// Note a change the user made through a tracked binding
+static void ottsr_binding_record(ottsr_binding_t *binding, int profile, int before, const char *before_name) {
+    ottsr_model_edits_t *edits = binding->edits;
+    ottsr_model_edit_t *edit = ottsr_model_edits_find(edits, binding->property, profile);
+    if (!edit) {
+        ottsr_model_edit_t added = {0};
+        added.property = binding->property;
+        added.profile = profile;
+        added.before = before;
+        g_strlcpy(added.before_name, before_name, OTTSR_MAX_NAME_LEN);
+        g_array_append_val(edits->edits, added);
+        edit = &g_array_index(edits->edits, ottsr_model_edit_t, edits->edits->len - 1);
+    }
+
+    if (binding->property == OTTSR_PROP_PROFILE_NAME) {
+        g_strlcpy(edit->after_name, ottsr_model_get_name(binding->app, profile), OTTSR_MAX_NAME_LEN);
+    } else {
+        edit->after = ottsr_model_get(binding->app, binding->property, profile);
+    }
+}
+
+static void on_binding_widget_changed(GtkWidget *widget, ottsr_binding_t *binding) {
+    ottsr_app_t *app = binding->app;
+    int profile = ottsr_model_is_profile_property(binding->property) ?
+        ottsr_model_resolve(app, binding->profile) : 0;
+    char before_name[OTTSR_MAX_NAME_LEN];
+    g_strlcpy(before_name, ottsr_model_get_name(app, profile), sizeof(before_name));
+    int before = ottsr_model_get(app, binding->property, profile);
+
+    gboolean changed;
+    if (binding->property == OTTSR_PROP_PROFILE_NAME) {
+        changed = ottsr_model_set_name(app, binding->profile, gtk_entry_get_text(GTK_ENTRY(widget)));
+    } else {
+        changed = ottsr_model_set(app, binding->property, binding->profile, ottsr_binding_read(binding));
+    }
+    if (changed && binding->edits && profile >= 0) ottsr_binding_record(binding, profile, before, before_name);
+}
+
+static void on_binding_widget_destroy(GtkWidget *widget, ottsr_binding_t *binding) {
+    ottsr_model_disconnect(binding->app, binding->listener);
+    g_free(binding);
+}
+
+// Keep widget and property in step both ways for the widget's lifetime.
+// Spin buttons, toggles, combo boxes and ranges carry numbers; an entry
+// carries the profile name.
+ottsr_binding_t *ottsr_model_bind(ottsr_app_t *app, ottsr_property_t property, int profile, GtkWidget *widget) {
+    ottsr_binding_t *binding = g_new0(ottsr_binding_t, 1);
+    binding->app = app;
+    binding->widget = widget;
+    binding->property = property;
+    binding->profile = profile;
+
+    // A spin button is also an entry, so it is checked first
+    const char *signal = "changed";
+    if (GTK_IS_SPIN_BUTTON(widget) || GTK_IS_RANGE(widget)) {
+        signal = "value-changed";
+    } else if (GTK_IS_TOGGLE_BUTTON(widget)) {
+        signal = "toggled";
+    }
+    binding->handler = g_signal_connect(widget, signal, G_CALLBACK(on_binding_widget_changed), binding);
+    g_signal_connect(widget, "destroy", G_CALLBACK(on_binding_widget_destroy), binding);
+
+    binding->listener = ottsr_model_connect(app, property, profile, on_binding_model_changed, binding, NULL);
+    ottsr_binding_push(binding);
+    return binding;
+}
+
+// Record what the user changes through binding in edits, so closing the
+// window without saving can put back exactly that
+void ottsr_binding_track(ottsr_binding_t *binding, ottsr_model_edits_t *edits) {
+    binding->edits = edits;
+}
+
+// Point a binding at another profile, as an editor does when the
+// selection moves
+void ottsr_binding_set_profile(ottsr_binding_t *binding, int profile) {
+    if (binding->profile != profile) {
+        ottsr_model_disconnect(binding->app, binding->listener);
+        binding->profile = profile;
+        binding->listener = ottsr_model_connect(binding->app, binding->property, profile,
+                                                on_binding_model_changed, binding, NULL);
+    }
+    ottsr_binding_push(binding);
+}
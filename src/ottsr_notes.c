@@ -0,0 +1,605 @@
+#include "ottsr.h"
+
+// Notes live beside history.dat rather than in it so history records keep
+// their fixed size. Each entry names the record it belongs to by its
+// started_at, which survives compaction into the archive.
+typedef struct {
+    guint32 magic;
+    guint32 version;
+} ottsr_notes_header_t;
+
+typedef struct {
+    gint64 started_at;
+    guint32 length;
+    guint32 reserved;
+} ottsr_notes_entry_t;
+
+static char *ottsr_notes_path(void) {
+    char *config_dir = ottsr_get_config_path();
+    if (!config_dir) return NULL;
+
+    char *path = g_build_filename(config_dir, OTTSR_NOTES_FILE, NULL);
+    g_free(config_dir);
+    return path;
+}
+
+// Append the note for one history record to the notes in config_dir; the
+// file is only written at its end
+gboolean ottsr_notes_append_at(const char *config_dir, gint64 started_at, const char *note) {
+    char *path = g_build_filename(config_dir, OTTSR_NOTES_FILE, NULL);
+
+    FILE *file = fopen(path, "ab");
+    if (!file) {
+        g_warning("Failed to open notes %s", path);
+        g_free(path);
+        return FALSE;
+    }
+    g_free(path);
+
+    gboolean ok = TRUE;
+    fseek(file, 0, SEEK_END);
+    if (ftell(file) == 0) {
+        ottsr_notes_header_t header = {0};
+        header.magic = OTTSR_NOTES_MAGIC;
+        header.version = OTTSR_NOTES_VERSION;
+        ok = fwrite(&header, sizeof(header), 1, file) == 1;
+    }
+
+    // A long note is cut at the last whole character that fits
+    gsize length = strlen(note);
+    if (length > OTTSR_NOTE_MAX_LEN) {
+        const char *end = g_utf8_find_prev_char(note, note + OTTSR_NOTE_MAX_LEN + 1);
+        length = end ? (gsize)(end - note) : 0;
+    }
+
+    ottsr_notes_entry_t entry = {0};
+    entry.started_at = started_at;
+    entry.length = (guint32)length;
+    ok = ok && fwrite(&entry, sizeof(entry), 1, file) == 1;
+    ok = ok && fwrite(note, 1, entry.length, file) == entry.length;
+    ok = (fclose(file) == 0) && ok;
+
+    if (!ok) g_warning("Failed to append session note");
+    return ok;
+}
+
+gboolean ottsr_notes_append(gint64 started_at, const char *note) {
+    char *config_dir = ottsr_get_config_path();
+    if (!config_dir) return FALSE;
+
+    gboolean ok = ottsr_notes_append_at(config_dir, started_at, note);
+    g_free(config_dir);
+    return ok;
+}
+
+// Notes by started_at (gint64 * -> char *). A torn trailing entry is ignored;
+// notes cut mid-character by older versions are repaired.
+GHashTable *ottsr_notes_read_file(const char *path) {
+    GHashTable *notes = g_hash_table_new_full(g_int64_hash, g_int64_equal, g_free, g_free);
+    GMappedFile *mapped = g_mapped_file_new(path, FALSE, NULL);
+    if (!mapped) return notes;
+
+    gsize length = g_mapped_file_get_length(mapped);
+    const char *data = g_mapped_file_get_contents(mapped);
+
+    ottsr_notes_header_t header = {0};
+    if (length >= sizeof(header)) memcpy(&header, data, sizeof(header));
+
+    if (header.magic == OTTSR_NOTES_MAGIC && header.version == OTTSR_NOTES_VERSION) {
+        gsize offset = sizeof(header);
+        while (offset + sizeof(ottsr_notes_entry_t) <= length) {
+            ottsr_notes_entry_t entry;
+            memcpy(&entry, data + offset, sizeof(entry));
+            offset += sizeof(entry);
+            if (entry.length > OTTSR_NOTE_MAX_LEN || offset + entry.length > length) break;
+
+            gint64 *key = g_new(gint64, 1);
+            *key = entry.started_at;
+            g_hash_table_replace(notes, key, g_utf8_make_valid(data + offset, entry.length));
+            offset += entry.length;
+        }
+    } else if (length > 0) {
+        g_warning("Ignoring session notes with unknown format");
+    }
+
+    g_mapped_file_unref(mapped);
+    return notes;
+}
+
+GHashTable *ottsr_notes_read(void) {
+    char *path = ottsr_notes_path();
+    if (!path) return g_hash_table_new_full(g_int64_hash, g_int64_equal, g_free, g_free);
+
+    GHashTable *notes = ottsr_notes_read_file(path);
+    g_free(path);
+    return notes;
+}
+
+// Casefolded, accent-stripped runs of letters and digits
+static void ottsr_search_tokenize(const char *text, GPtrArray *tokens) {
+    if (!text || !*text) return;
+
+    char *folded = g_utf8_casefold(text, -1);
+    char *normal = g_utf8_normalize(folded, -1, G_NORMALIZE_NFKD);
+    GString *token = g_string_new(NULL);
+
+    for (const char *p = normal ? normal : folded; *p; p = g_utf8_next_char(p)) {
+        gunichar c = g_utf8_get_char(p);
+        if (g_unichar_ismark(c)) continue;
+        if (g_unichar_isalnum(c)) {
+            g_string_append_unichar(token, c);
+        } else if (token->len > 0) {
+            g_ptr_array_add(tokens, g_strndup(token->str, token->len));
+            g_string_truncate(token, 0);
+        }
+    }
+    if (token->len > 0) g_ptr_array_add(tokens, g_strndup(token->str, token->len));
+
+    g_string_free(token, TRUE);
+    g_free(normal);
+    g_free(folded);
+}
+
+static void ottsr_search_doc_free(gpointer data) {
+    ottsr_search_doc_t *doc = data;
+    g_free(doc->profile);
+    g_free(doc->subject);
+    g_free(doc->note);
+    g_free(doc);
+}
+
+static gint ottsr_search_term_compare(gconstpointer a, gconstpointer b) {
+    return strcmp(*(const char *const *)a, *(const char *const *)b);
+}
+
+// First term not less than key
+static guint ottsr_search_lower_bound(const ottsr_search_index_t *index, const char *key) {
+    guint low = 0, high = index->terms->len;
+    while (low < high) {
+        guint mid = low + (high - low) / 2;
+        if (strcmp(g_ptr_array_index(index->terms, mid), key) < 0) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+static void ottsr_search_post(ottsr_search_index_t *index, const char *term, guint32 id, gboolean sorted) {
+    GArray *postings = g_hash_table_lookup(index->postings, term);
+    if (!postings) {
+        char *key = g_strdup(term);
+        postings = g_array_new(FALSE, FALSE, sizeof(guint32));
+        g_hash_table_insert(index->postings, key, postings);
+
+        // The build sorts the vocabulary once at the end
+        if (sorted) {
+            g_ptr_array_insert(index->terms, ottsr_search_lower_bound(index, key), key);
+        } else {
+            g_ptr_array_add(index->terms, key);
+        }
+    }
+
+    // Ids only grow, so a repeat of the term in this document is the last entry
+    if (postings->len > 0 && g_array_index(postings, guint32, postings->len - 1) == id) return;
+    g_array_append_val(postings, id);
+}
+
+static void ottsr_search_index_insert(ottsr_search_index_t *index, const ottsr_history_record_t *record,
+                                      const char *note, gboolean sorted) {
+    ottsr_search_doc_t *doc = g_new0(ottsr_search_doc_t, 1);
+    doc->started_at = record->started_at;
+    doc->study_seconds = record->study_seconds;
+    doc->profile = g_strdup(record->profile);
+    doc->subject = g_strdup(record->subject);
+    doc->note = g_strdup(note ? note : "");
+
+    guint32 id = index->docs->len;
+    g_ptr_array_add(index->docs, doc);
+
+    GPtrArray *tokens = g_ptr_array_new_with_free_func(g_free);
+    ottsr_search_tokenize(doc->profile, tokens);
+    ottsr_search_tokenize(doc->subject, tokens);
+    ottsr_search_tokenize(doc->note, tokens);
+    for (guint i = 0; i < tokens->len; i++) {
+        ottsr_search_post(index, g_ptr_array_index(tokens, i), id, sorted);
+    }
+    g_ptr_array_unref(tokens);
+}
+
+static gint ottsr_search_record_compare(gconstpointer a, gconstpointer b) {
+    gint64 ta = ((const ottsr_history_record_t *)a)->started_at;
+    gint64 tb = ((const ottsr_history_record_t *)b)->started_at;
+    return ta < tb ? -1 : ta > tb;
+}
+
+// Takes ownership of records. Documents are numbered oldest first, so every
+// posting list is sorted by time without storing the time in it.
+ottsr_search_index_t *ottsr_search_index_build(GArray *records, GHashTable *notes) {
+    ottsr_search_index_t *index = g_new0(ottsr_search_index_t, 1);
+    index->docs = g_ptr_array_new_with_free_func(ottsr_search_doc_free);
+    index->postings = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify)g_array_unref);
+    index->terms = g_ptr_array_new();
+
+    g_array_sort(records, ottsr_search_record_compare);
+    for (guint i = 0; i < records->len; i++) {
+        const ottsr_history_record_t *record = &g_array_index(records, ottsr_history_record_t, i);
+        ottsr_search_index_insert(index, record, g_hash_table_lookup(notes, &record->started_at), FALSE);
+    }
+    g_ptr_array_sort(index->terms, ottsr_search_term_compare);
+
+    g_array_unref(records);
+    return index;
+}
+
+void ottsr_search_index_free(ottsr_search_index_t *index) {
+    if (!index) return;
+    g_ptr_array_unref(index->terms);
+    g_hash_table_unref(index->postings);
+    g_ptr_array_unref(index->docs);
+    g_free(index);
+}
+
+// New sessions go on the end of every list. One credited after a crash can
+// be older than the last document, which only moves it in the result order.
+void ottsr_search_index_add(ottsr_search_index_t *index, const ottsr_history_record_t *record, const char *note) {
+    ottsr_search_index_insert(index, record, note, TRUE);
+}
+
+static gint ottsr_search_id_compare(gconstpointer a, gconstpointer b) {
+    guint32 x = *(const guint32 *)a;
+    guint32 y = *(const guint32 *)b;
+    return x < y ? -1 : x > y;
+}
+
+// Documents containing a term that starts with prefix, ascending
+static GArray *ottsr_search_prefix(const ottsr_search_index_t *index, const char *prefix) {
+    GArray *ids = g_array_new(FALSE, FALSE, sizeof(guint32));
+    guint lists = 0;
+
+    for (guint i = ottsr_search_lower_bound(index, prefix); i < index->terms->len; i++) {
+        const char *term = g_ptr_array_index(index->terms, i);
+        if (!g_str_has_prefix(term, prefix)) break;
+
+        GArray *postings = g_hash_table_lookup(index->postings, term);
+        g_array_append_vals(ids, postings->data, postings->len);
+        lists++;
+    }
+
+    if (lists > 1) {
+        g_array_sort(ids, ottsr_search_id_compare);
+        guint kept = 0;
+        for (guint i = 0; i < ids->len; i++) {
+            guint32 id = g_array_index(ids, guint32, i);
+            if (kept == 0 || g_array_index(ids, guint32, kept - 1) != id) {
+                g_array_index(ids, guint32, kept++) = id;
+            }
+        }
+        g_array_set_size(ids, kept);
+    }
+    return ids;
+}
+
+// Keep the ids of a that are also in b; both ascending
+static void ottsr_search_intersect(GArray *a, const GArray *b) {
+    guint i = 0, j = 0, kept = 0;
+    while (i < a->len && j < b->len) {
+        guint32 x = g_array_index(a, guint32, i);
+        guint32 y = g_array_index(b, guint32, j);
+        if (x < y) {
+            i++;
+        } else if (y < x) {
+            j++;
+        } else {
+            g_array_index(a, guint32, kept++) = x;
+            i++;
+            j++;
+        }
+    }
+    g_array_set_size(a, kept);
+}
+
+// Sessions matching every word of query as a word prefix, newest first.
+// At most limit documents are returned; total gets the full match count.
+GPtrArray *ottsr_search_index_query(const ottsr_search_index_t *index, const char *query,
+                                    guint limit, guint *total) {
+    GPtrArray *results = g_ptr_array_new();
+    GPtrArray *tokens = g_ptr_array_new_with_free_func(g_free);
+    ottsr_search_tokenize(query, tokens);
+
+    GArray *matches = NULL;
+    for (guint i = 0; i < tokens->len; i++) {
+        GArray *ids = ottsr_search_prefix(index, g_ptr_array_index(tokens, i));
+        if (!matches) {
+            matches = ids;
+        } else {
+            ottsr_search_intersect(matches, ids);
+            g_array_unref(ids);
+        }
+        if (matches->len == 0) break;
+    }
+
+    if (total) *total = matches ? matches->len : 0;
+    if (matches) {
+        for (guint i = matches->len; i > 0 && results->len < limit; i--) {
+            g_ptr_array_add(results, g_ptr_array_index(index->docs, g_array_index(matches, guint32, i - 1)));
+        }
+        g_array_unref(matches);
+    }
+
+    g_ptr_array_unref(tokens);
+    return results;
+}
+
+static ottsr_search_index_t *ottsr_search_index_load(void) {
+    gint64 start = g_get_monotonic_time();
+    GHashTable *notes = ottsr_notes_read();
+    ottsr_search_index_t *index = ottsr_search_index_build(ottsr_history_read_all(), notes);
+    g_hash_table_unref(notes);
+
+    g_debug("Search indexed %u sessions, %u terms in %.2f ms", index->docs->len, index->terms->len,
+            (g_get_monotonic_time() - start) / 1000.0);
+    return index;
+}
+
+// A session that ended while the index was being built
+typedef struct {
+    ottsr_history_record_t record;
+    char *note;
+} ottsr_search_pending_t;
+
+static void ottsr_search_pending_free(gpointer data) {
+    ottsr_search_pending_t *pending = data;
+    g_free(pending->note);
+    g_free(pending);
+}
+
+// Whether the build already read record from history. Documents are in
+// time order, so only the newest few need looking at.
+static gboolean ottsr_search_index_has(const ottsr_search_index_t *index, const ottsr_history_record_t *record) {
+    for (guint i = index->docs->len; i > 0; i--) {
+        const ottsr_search_doc_t *doc = g_ptr_array_index(index->docs, i - 1);
+        if (doc->started_at < record->started_at) break;
+        if (doc->started_at == record->started_at && doc->study_seconds == record->study_seconds) return TRUE;
+    }
+    return FALSE;
+}
+
+static void on_search_changed(GtkSearchEntry *entry, ottsr_app_t *app);
+
+static void ottsr_search_load_thread(GTask *task, gpointer source, gpointer task_data,
+                                     GCancellable *cancellable) {
+    g_task_return_pointer(task, ottsr_search_index_load(), (GDestroyNotify)ottsr_search_index_free);
+}
+
+static void ottsr_search_load_done(GObject *source, GAsyncResult *result, gpointer user_data) {
+    ottsr_app_t *app = (ottsr_app_t *)user_data;
+    ottsr_search_index_t *index = g_task_propagate_pointer(G_TASK(result), NULL);
+
+    // Cancelled because a kiosk switched user
+    if (!index) return;
+    app->search_building = FALSE;
+    app->search = index;
+
+    for (guint i = 0; i < app->pending_search->len; i++) {
+        ottsr_search_pending_t *pending = g_ptr_array_index(app->pending_search, i);
+        if (!ottsr_search_index_has(index, &pending->record)) {
+            ottsr_search_index_add(index, &pending->record, pending->note);
+        }
+    }
+    g_ptr_array_set_size(app->pending_search, 0);
+
+    if (app->search_entry) on_search_changed(GTK_SEARCH_ENTRY(app->search_entry), app);
+}
+
+// Read history and notes and build the index in the background
+void ottsr_search_load_async(ottsr_app_t *app) {
+    if (app->search || app->search_building) return;
+    if (!app->pending_search) {
+        app->pending_search = g_ptr_array_new_with_free_func(ottsr_search_pending_free);
+    }
+    app->search_building = TRUE;
+
+    GTask *task = g_task_new(NULL, app->user_cancel, ottsr_search_load_done, app);
+    g_task_run_in_thread(task, ottsr_search_load_thread);
+    g_object_unref(task);
+}
+
+// A session ended: into the index, or queued for it while it is built
+void ottsr_search_record(ottsr_app_t *app, const ottsr_history_record_t *record, const char *note) {
+    if (app->search) {
+        ottsr_search_index_add(app->search, record, note);
+    } else if (app->search_building) {
+        ottsr_search_pending_t *pending = g_new0(ottsr_search_pending_t, 1);
+        pending->record = *record;
+        pending->note = g_strdup(note);
+        g_ptr_array_add(app->pending_search, pending);
+    }
+}
+
+void ottsr_search_clear(ottsr_app_t *app) {
+    ottsr_search_index_free(app->search);
+    app->search = NULL;
+    app->search_building = FALSE;
+    if (app->pending_search) {
+        g_ptr_array_unref(app->pending_search);
+        app->pending_search = NULL;
+    }
+}
+
+static void ottsr_search_format_time(gint64 timestamp, char *buffer, size_t buffer_size) {
+    GDateTime *dt = g_date_time_new_from_unix_local(timestamp);
+    char *text = g_date_time_format(dt, "%Y-%m-%d %H:%M");
+    g_strlcpy(buffer, text, buffer_size);
+    g_free(text);
+    g_date_time_unref(dt);
+}
+
+enum {
+    OTTSR_SEARCH_COLUMN_WHEN,
+    OTTSR_SEARCH_COLUMN_MINUTES,
+    OTTSR_SEARCH_COLUMN_SUBJECT,
+    OTTSR_SEARCH_COLUMN_NOTE,
+    OTTSR_SEARCH_COLUMNS
+};
+
+static void on_search_changed(GtkSearchEntry *entry, ottsr_app_t *app) {
+    const char *query = gtk_entry_get_text(GTK_ENTRY(entry));
+    gtk_list_store_clear(app->search_store);
+
+    if (!app->search) {
+        gtk_label_set_text(GTK_LABEL(app->search_status), "Indexing past sessions...");
+        return;
+    }
+    if (!*query) {
+        char status[64];
+        snprintf(status, sizeof(status), "%u sessions indexed", app->search->docs->len);
+        gtk_label_set_text(GTK_LABEL(app->search_status), status);
+        return;
+    }
+
+    gint64 start = g_get_monotonic_time();
+    guint total = 0;
+    GPtrArray *results = ottsr_search_index_query(app->search, query, OTTSR_SEARCH_LIMIT, &total);
+    double elapsed = (g_get_monotonic_time() - start) / 1000.0;
+
+    for (guint i = 0; i < results->len; i++) {
+        const ottsr_search_doc_t *doc = g_ptr_array_index(results, i);
+        char when[32];
+        ottsr_search_format_time(doc->started_at, when, sizeof(when));
+
+        GtkTreeIter iter;
+        gtk_list_store_append(app->search_store, &iter);
+        gtk_list_store_set(app->search_store, &iter,
+                           OTTSR_SEARCH_COLUMN_WHEN, when,
+                           OTTSR_SEARCH_COLUMN_MINUTES, doc->study_seconds / 60,
+                           OTTSR_SEARCH_COLUMN_SUBJECT, doc->subject,
+                           OTTSR_SEARCH_COLUMN_NOTE, doc->note,
+                           -1);
+    }
+
+    char status[96];
+    if (total > results->len) {
+        snprintf(status, sizeof(status), "%u matching sessions, newest %u shown (%.2f ms)",
+                 total, results->len, elapsed);
+    } else {
+        snprintf(status, sizeof(status), "%u matching sessions (%.2f ms)", total, elapsed);
+    }
+    gtk_label_set_text(GTK_LABEL(app->search_status), status);
+    g_ptr_array_unref(results);
+}
+
+static void on_search_window_destroy(GtkWidget *widget, ottsr_app_t *app) {
+    // The index stays for the next open and keeps taking new sessions
+    app->search_window = NULL;
+    app->search_entry = NULL;
+    app->search_store = NULL;
+    app->search_status = NULL;
+}
+
+void ottsr_create_search_window(ottsr_app_t *app) {
+    if (app->search_window) {
+        gtk_window_present(GTK_WINDOW(app->search_window));
+        return;
+    }
+
+    ottsr_search_load_async(app);
+
+    app->search_window = gtk_window_new(GTK_WINDOW_TOPLEVEL);
+    gtk_window_set_title(GTK_WINDOW(app->search_window), "Search History");
+    gtk_window_set_default_size(GTK_WINDOW(app->search_window), 640, 420);
+    gtk_window_set_transient_for(GTK_WINDOW(app->search_window),
+                                GTK_WINDOW(app->main_window));
+    g_signal_connect(app->search_window, "destroy", G_CALLBACK(on_search_window_destroy), app);
+
+    GtkWidget *main_box = gtk_box_new(GTK_ORIENTATION_VERTICAL, 10);
+    gtk_container_set_border_width(GTK_CONTAINER(main_box), 20);
+    gtk_container_add(GTK_CONTAINER(app->search_window), main_box);
+
+    GtkWidget *entry = gtk_search_entry_new();
+    gtk_entry_set_placeholder_text(GTK_ENTRY(entry), "Search subjects and notes...");
+    g_signal_connect(entry, "search-changed", G_CALLBACK(on_search_changed), app);
+    gtk_box_pack_start(GTK_BOX(main_box), entry, FALSE, FALSE, 0);
+    app->search_entry = entry;
+
+    app->search_store = gtk_list_store_new(OTTSR_SEARCH_COLUMNS, G_TYPE_STRING, G_TYPE_INT,
+                                           G_TYPE_STRING, G_TYPE_STRING);
+    GtkWidget *view = gtk_tree_view_new_with_model(GTK_TREE_MODEL(app->search_store));
+    g_object_unref(app->search_store);
+
+    const char *titles[] = { "When", "Min", "Subject", "Note" };
+    for (int i = 0; i < OTTSR_SEARCH_COLUMNS; i++) {
+        GtkCellRenderer *renderer = gtk_cell_renderer_text_new();
+        if (i == OTTSR_SEARCH_COLUMN_NOTE) g_object_set(renderer, "ellipsize", PANGO_ELLIPSIZE_END, NULL);
+        GtkTreeViewColumn *column = gtk_tree_view_column_new_with_attributes(titles[i], renderer, "text", i, NULL);
+        gtk_tree_view_column_set_resizable(column, TRUE);
+        gtk_tree_view_column_set_expand(column, i == OTTSR_SEARCH_COLUMN_NOTE);
+        gtk_tree_view_append_column(GTK_TREE_VIEW(view), column);
+    }
+
+    GtkWidget *scrolled = gtk_scrolled_window_new(NULL, NULL);
+    gtk_scrolled_window_set_policy(GTK_SCROLLED_WINDOW(scrolled), GTK_POLICY_AUTOMATIC, GTK_POLICY_AUTOMATIC);
+    gtk_container_add(GTK_CONTAINER(scrolled), view);
+    gtk_box_pack_start(GTK_BOX(main_box), scrolled, TRUE, TRUE, 0);
+
+    app->search_status = gtk_label_new("");
+    gtk_widget_set_halign(app->search_status, GTK_ALIGN_START);
+    gtk_box_pack_start(GTK_BOX(main_box), app->search_status, FALSE, FALSE, 0);
+
+    on_search_changed(GTK_SEARCH_ENTRY(entry), app);
+    gtk_widget_show_all(app->search_window);
+    gtk_widget_grab_focus(entry);
+}
+
+// `ottsr search WORDS...`: the same index and query as the search window.
+// A one-shot command has no index kept from before, so it builds one and
+// the time it reports includes the build.
+int ottsr_search_main(int argc, char *argv[]) {
+    int limit = OTTSR_SEARCH_LIMIT;
+
+    GOptionEntry entries[] = {
+        { "limit", 'n', 0, G_OPTION_ARG_INT, &limit, "Most sessions to print (default: 50)", "N" },
+        { NULL }
+    };
+
+    GOptionContext *context = g_option_context_new("WORDS... - search session subjects and notes");
+    g_option_context_add_main_entries(context, entries, NULL);
+    GError *error = NULL;
+    gboolean ok = g_option_context_parse(context, &argc, &argv, &error);
+    g_option_context_free(context);
+    if (!ok) {
+        g_printerr("ottsr search: %s\n", error->message);
+        g_error_free(error);
+        return 1;
+    }
+    if (argc < 2) {
+        g_printerr("ottsr search: nothing to search for\n");
+        return 1;
+    }
+
+    char *query = g_strjoinv(" ", argv + 1);
+
+    gint64 start = g_get_monotonic_time();
+    ottsr_search_index_t *index = ottsr_search_index_load();
+    gint64 built = g_get_monotonic_time();
+    guint total = 0;
+    GPtrArray *results = ottsr_search_index_query(index, query, (guint)MAX(0, limit), &total);
+    gint64 queried = g_get_monotonic_time();
+
+    for (guint i = 0; i < results->len; i++) {
+        const ottsr_search_doc_t *doc = g_ptr_array_index(results, i);
+        char when[32];
+        ottsr_search_format_time(doc->started_at, when, sizeof(when));
+        g_print("%s  %3d min  %-20s  %s\n", when, doc->study_seconds / 60,
+                *doc->subject ? doc->subject : doc->profile, doc->note);
+    }
+    g_print("%u of %u matching sessions in %.1f ms (indexing %u sessions %.1f ms, lookup %.2f ms)\n",
+            results->len, total, (queried - start) / 1000.0,
+            index->docs->len, (built - start) / 1000.0, (queried - built) / 1000.0);
+
+    g_ptr_array_unref(results);
+    ottsr_search_index_free(index);
+    g_free(query);
+    return total > 0 ? 0 : 1;
+}
@@ -0,0 +1,879 @@
+#include "ottsr.h"
+
+// Study plans around a timetable. One-off events from .ics files go into
+// an interval tree; recurring ones stay rules, kept in a second tree by the
+// span they cover, and are expanded only for the days being planned. Each
+// candidate day is checked against a rule arithmetically, so a series with
+// thousands of instances costs the same as one with ten.
+//
+// Supported: DTSTART/DTEND/DURATION with UTC, TZID or floating times,
+// RRULE FREQ=DAILY/WEEKLY/MONTHLY/YEARLY with INTERVAL, COUNT, UNTIL,
+// BYDAY (plain weekdays) and BYMONTHDAY (one day), EXDATE and
+// RECURRENCE-ID. All-day, transparent and cancelled events are not busy.
+
+typedef enum {
+    OTTSR_RRULE_NONE,
+    OTTSR_RRULE_DAILY,
+    OTTSR_RRULE_WEEKLY,
+    OTTSR_RRULE_MONTHLY,
+    OTTSR_RRULE_YEARLY
+} ottsr_rrule_freq_t;
+
+typedef struct {
+    gint64 start;
+    gint64 duration;
+    GTimeZone *tz;
+    gint32 start_day;
+    int start_seconds;
+
+    ottsr_rrule_freq_t freq;
+    int interval;
+    int count;
+    gint64 until;
+    guint8 weekdays;
+    int month_day;
+    GArray *exdates;
+
+    char *uid;
+    gboolean all_day;
+    gboolean transparent;
+} ottsr_ics_event_t;
+
+typedef struct {
+    char *uid;
+    gint64 original;
+} ottsr_ics_override_t;
+
+typedef struct {
+    gint64 start;
+    gint64 end;
+    guint32 item;
+} ottsr_interval_t;
+
+// Intervals sorted by start, read as an implicit balanced tree (the middle
+// of each range is its root) with the largest end below every node
+typedef struct {
+    GArray *nodes;
+    GArray *max_end;
+} ottsr_interval_tree_t;
+
+struct ottsr_calendar {
+    GPtrArray *events;
+    GHashTable *zones;
+    ottsr_interval_tree_t singles;
+    ottsr_interval_tree_t series;
+    GArray *candidates;
+};
+
+static const char *ottsr_plan_kind_names[] = { "study", "break", "long break", "busy", "skipped" };
+
+// Interval tree
+
+static gint ottsr_interval_compare(gconstpointer a, gconstpointer b) {
+    gint64 x = ((const ottsr_interval_t *)a)->start;
+    gint64 y = ((const ottsr_interval_t *)b)->start;
+    return x < y ? -1 : x > y;
+}
+
+static gint64 ottsr_interval_tree_fill(ottsr_interval_tree_t *tree, guint low, guint high) {
+    if (low >= high) return G_MININT64;
+
+    guint mid = low + (high - low) / 2;
+    gint64 max_end = g_array_index(tree->nodes, ottsr_interval_t, mid).end;
+    max_end = MAX(max_end, ottsr_interval_tree_fill(tree, low, mid));
+    max_end = MAX(max_end, ottsr_interval_tree_fill(tree, mid + 1, high));
+    g_array_index(tree->max_end, gint64, mid) = max_end;
+    return max_end;
+}
+
+static void ottsr_interval_tree_build(ottsr_interval_tree_t *tree) {
+    g_array_sort(tree->nodes, ottsr_interval_compare);
+    g_array_set_size(tree->max_end, tree->nodes->len);
+    ottsr_interval_tree_fill(tree, 0, tree->nodes->len);
+}
+
+// Items of every interval overlapping [from, to)
+static void ottsr_interval_tree_query(const ottsr_interval_tree_t *tree, guint low, guint high,
+                                      gint64 from, gint64 to, GArray *items) {
+    if (low >= high) return;
+
+    guint mid = low + (high - low) / 2;
+    if (g_array_index(tree->max_end, gint64, mid) <= from) return;
+
+    ottsr_interval_tree_query(tree, low, mid, from, to, items);
+
+    const ottsr_interval_t *node = &g_array_index(tree->nodes, ottsr_interval_t, mid);
+    if (node->start >= to) return;
+    if (node->end > from) g_array_append_val(items, node->item);
+
+    ottsr_interval_tree_query(tree, mid + 1, high, from, to, items);
+}
+
+// Time zones and civil days
+
+// Local civil day of t in tz and the seconds since its midnight
+static gint32 ottsr_plan_day_of(GTimeZone *tz, gint64 t, int *seconds) {
+    int interval = g_time_zone_find_interval(tz, G_TIME_TYPE_UNIVERSAL, t);
+    gint64 local = t + g_time_zone_get_offset(tz, interval);
+    gint64 day = local >= 0 ? local / 86400 : (local - 86399) / 86400;
+    if (seconds) *seconds = (int)(local - day * 86400);
+    return (gint32)day;
+}
+
+// A wall-clock time on a civil day as a timestamp; times skipped by a
+// clock change are moved past it
+gint64 ottsr_plan_to_unix(GTimeZone *tz, gint32 day, int seconds) {
+    gint64 local = (gint64)day * 86400 + seconds;
+    int interval = g_time_zone_adjust_time(tz, G_TIME_TYPE_STANDARD, &local);
+    return local - g_time_zone_get_offset(tz, interval);
+}
+
+// 0 is Monday; 1970-01-01 was a Thursday
+static int ottsr_plan_weekday(gint32 day) {
+    return ((day + 3) % 7 + 7) % 7;
+}
+
+static int ottsr_plan_bits(guint mask) {
+    int bits = 0;
+    for (; mask; mask &= mask - 1) bits++;
+    return bits;
+}
+
+static GTimeZone *ottsr_calendar_zone(ottsr_calendar_t *calendar, const char *tzid) {
+    if (!tzid) tzid = "";
+
+    GTimeZone *tz = g_hash_table_lookup(calendar->zones, tzid);
+    if (tz) return tz;
+
+    if (!*tzid) {
+        tz = g_time_zone_new_local();
+    } else if (strcmp(tzid, "UTC") == 0) {
+        tz = g_time_zone_new_utc();
+    } else {
+#if GLIB_CHECK_VERSION(2, 68, 0)
+        tz = g_time_zone_new_identifier(tzid);
+#else
+        tz = g_time_zone_new(tzid);
+#endif
+        if (!tz) {
+            g_debug("Unknown time zone %s in calendar, using local time", tzid);
+            tz = g_time_zone_new_local();
+        }
+    }
+    g_hash_table_insert(calendar->zones, g_strdup(tzid), tz);
+    return tz;
+}
+
+// ICS parsing
+
+// A DATE or DATE-TIME value. Trailing Z means UTC; otherwise tzid applies,
+// and without one the time is floating and read as local.
+static gboolean ottsr_ics_parse_time(ottsr_calendar_t *calendar, const char *value, const char *tzid,
+                                     gint64 *timestamp, GTimeZone **zone, gboolean *all_day) {
+    int year, month, day, hour = 0, minute = 0, second = 0;
+    if (strlen(value) < 8 || sscanf(value, "%4d%2d%2d", &year, &month, &day) != 3) return FALSE;
+
+    gboolean date_only = value[8] != 'T';
+    if (!date_only && sscanf(value + 9, "%2d%2d%2d", &hour, &minute, &second) != 3) return FALSE;
+
+    GTimeZone *tz = ottsr_calendar_zone(calendar, !date_only && strchr(value, 'Z') ? "UTC" : tzid);
+    *timestamp = ottsr_plan_to_unix(tz, ottsr_days_from_civil(year, month, day),
+                                    hour * 3600 + minute * 60 + second);
+    if (zone) *zone = tz;
+    if (all_day) *all_day = date_only;
+    return TRUE;
+}
+
+// [+-]P[nW][nD][T[nH][nM][nS]]
+static gint64 ottsr_ics_parse_duration(const char *value) {
+    gint64 seconds = 0;
+    gboolean negative = *value == '-';
+    if (*value == '+' || *value == '-') value++;
+    if (*value++ != 'P') return 0;
+
+    while (*value) {
+        if (*value == 'T') {
+            value++;
+            continue;
+        }
+        char *end;
+        gint64 number = g_ascii_strtoll(value, &end, 10);
+        if (end == value) return 0;
+
+        switch (*end) {
+            case 'W': seconds += number * 7 * 86400; break;
+            case 'D': seconds += number * 86400; break;
+            case 'H': seconds += number * 3600; break;
+            case 'M': seconds += number * 60; break;
+            case 'S': seconds += number; break;
+            default: return 0;
+        }
+        value = end + 1;
+    }
+    return negative ? -seconds : seconds;
+}
+
+static const char *ottsr_ics_weekdays[] = { "MO", "TU", "WE", "TH", "FR", "SA", "SU" };
+
+// Rules outside the supported subset keep their first instance only
+static void ottsr_ics_parse_rrule(ottsr_ics_event_t *event, ottsr_calendar_t *calendar, const char *value) {
+    char **parts = g_strsplit(value, ";", -1);
+    gboolean supported = TRUE;
+
+    for (char **part = parts; *part; part++) {
+        char *equals = strchr(*part, '=');
+        if (!equals) continue;
+        *equals = '\0';
+        const char *name = *part;
+        const char *arg = equals + 1;
+
+        if (strcmp(name, "FREQ") == 0) {
+            if (strcmp(arg, "DAILY") == 0) event->freq = OTTSR_RRULE_DAILY;
+            else if (strcmp(arg, "WEEKLY") == 0) event->freq = OTTSR_RRULE_WEEKLY;
+            else if (strcmp(arg, "MONTHLY") == 0) event->freq = OTTSR_RRULE_MONTHLY;
+            else if (strcmp(arg, "YEARLY") == 0) event->freq = OTTSR_RRULE_YEARLY;
+            else supported = FALSE;
+        } else if (strcmp(name, "INTERVAL") == 0) {
+            event->interval = MAX(1, atoi(arg));
+        } else if (strcmp(name, "COUNT") == 0) {
+            event->count = MAX(1, atoi(arg));
+        } else if (strcmp(name, "UNTIL") == 0) {
+            if (!ottsr_ics_parse_time(calendar, arg, NULL, &event->until, NULL, NULL)) supported = FALSE;
+        } else if (strcmp(name, "BYDAY") == 0) {
+            char **days = g_strsplit(arg, ",", -1);
+            for (char **day = days; *day; day++) {
+                int i = 0;
+                while (i < 7 && strcmp(*day, ottsr_ics_weekdays[i]) != 0) i++;
+                // Ordinals such as 2TU need month arithmetic this does not do
+                if (i < 7) event->weekdays |= 1 << i;
+                else supported = FALSE;
+            }
+            g_strfreev(days);
+        } else if (strcmp(name, "BYMONTHDAY") == 0) {
+            event->month_day = atoi(arg);
+            if (strchr(arg, ',') || event->month_day <= 0) supported = FALSE;
+        } else if (strcmp(name, "WKST") != 0) {
+            supported = FALSE;
+        }
+    }
+    g_strfreev(parts);
+
+    if (event->weekdays && event->freq != OTTSR_RRULE_WEEKLY) supported = FALSE;
+    if (!supported) {
+        g_debug("Calendar rule %s not supported, keeping the first instance", value);
+        event->freq = OTTSR_RRULE_NONE;
+    }
+}
+
+static void ottsr_ics_add_exdates(ottsr_ics_event_t *event, ottsr_calendar_t *calendar,
+                                  const char *value, const char *tzid) {
+    char **dates = g_strsplit(value, ",", -1);
+    for (char **date = dates; *date; date++) {
+        gint64 timestamp;
+        if (!ottsr_ics_parse_time(calendar, *date, tzid, &timestamp, NULL, NULL)) continue;
+        if (!event->exdates) event->exdates = g_array_new(FALSE, FALSE, sizeof(gint64));
+        g_array_append_val(event->exdates, timestamp);
+    }
+    g_strfreev(dates);
+}
+
+static ottsr_ics_event_t *ottsr_ics_event_new(void) {
+    ottsr_ics_event_t *event = g_new0(ottsr_ics_event_t, 1);
+    event->interval = 1;
+    event->until = G_MAXINT64;
+    return event;
+}
+
+static void ottsr_ics_event_free(gpointer data) {
+    ottsr_ics_event_t *event = data;
+    if (event->exdates) g_array_unref(event->exdates);
+    g_free(event->uid);
+    g_free(event);
+}
+
+// NAME;PARAM=x;TZID=y:VALUE, split in place into name, TZID and value
+static gboolean ottsr_ics_split(char *line, char **name, char **tzid, char **value) {
+    char *colon = NULL;
+    gboolean quoted = FALSE;
+    for (char *p = line; *p && !colon; p++) {
+        if (*p == '"') quoted = !quoted;
+        else if (*p == ':' && !quoted) colon = p;
+    }
+    if (!colon) return FALSE;
+
+    *colon = '\0';
+    *name = line;
+    *value = colon + 1;
+    *tzid = NULL;
+
+    char *param = strchr(line, ';');
+    if (param) *param++ = '\0';
+    while (param) {
+        char *next = strchr(param, ';');
+        if (next) *next++ = '\0';
+        if (g_str_has_prefix(param, "TZID=")) {
+            char *id = param + 5;
+            if (*id == '"') {
+                id++;
+                char *quote = strchr(id, '"');
+                if (quote) *quote = '\0';
+            }
+            *tzid = id;
+        }
+        param = next;
+    }
+    return TRUE;
+}
+
+// Whether an event ends up busy time, filling in its derived fields
+static gboolean ottsr_ics_event_finish(ottsr_ics_event_t *event, gint64 end) {
+    if (!event->tz || event->all_day || event->transparent) return FALSE;
+    if (event->duration == 0 && end != G_MININT64) event->duration = end - event->start;
+    if (event->duration <= 0) return FALSE;
+
+    event->start_day = ottsr_plan_day_of(event->tz, event->start, &event->start_seconds);
+    if (event->freq == OTTSR_RRULE_WEEKLY && event->weekdays == 0) {
+        event->weekdays = 1 << ottsr_plan_weekday(event->start_day);
+    }
+    if (event->month_day == 0) {
+        int year, month;
+        ottsr_civil_from_days(event->start_day, &year, &month, &event->month_day);
+    }
+    return TRUE;
+}
+
+// Add the events of one calendar. Moved instances (RECURRENCE-ID) are
+// events of their own and excluded from the series with the same UID.
+gboolean ottsr_calendar_parse(ottsr_calendar_t *calendar, const char *data, gsize length) {
+    GString *unfolded = g_string_sized_new(length);
+    for (gsize i = 0; i < length; i++) {
+        if (data[i] == '\r') continue;
+        if (data[i] == '\n' && i + 1 < length && (data[i + 1] == ' ' || data[i + 1] == '\t')) {
+            i++;
+            continue;
+        }
+        g_string_append_c(unfolded, data[i]);
+    }
+
+    gboolean seen_calendar = FALSE;
+    GArray *overrides = g_array_new(FALSE, FALSE, sizeof(ottsr_ics_override_t));
+    ottsr_ics_event_t *event = NULL;
+    gint64 end = G_MININT64;
+    gint64 recurrence_id = G_MININT64;
+    gboolean cancelled = FALSE;
+    int depth = 0;
+
+    for (char *line = unfolded->str; line && *line; ) {
+        char *next = strchr(line, '\n');
+        if (next) *next++ = '\0';
+
+        char *name, *tzid, *value;
+        if (!ottsr_ics_split(line, &name, &tzid, &value)) {
+            line = next;
+            continue;
+        }
+
+        if (strcmp(name, "BEGIN") == 0) {
+            if (event) {
+                // Alarms nest inside events
+                depth++;
+            } else if (strcmp(value, "VEVENT") == 0) {
+                event = ottsr_ics_event_new();
+                end = G_MININT64;
+                recurrence_id = G_MININT64;
+                cancelled = FALSE;
+            } else if (strcmp(value, "VCALENDAR") == 0) {
+                seen_calendar = TRUE;
+            }
+        } else if (strcmp(name, "END") == 0 && event) {
+            if (depth > 0) {
+                depth--;
+            } else {
+                if (recurrence_id != G_MININT64 && event->uid) {
+                    ottsr_ics_override_t override = { g_strdup(event->uid), recurrence_id };
+                    g_array_append_val(overrides, override);
+                    event->freq = OTTSR_RRULE_NONE;
+                }
+                if (!cancelled && ottsr_ics_event_finish(event, end)) {
+                    g_ptr_array_add(calendar->events, event);
+                } else {
+                    ottsr_ics_event_free(event);
+                }
+                event = NULL;
+            }
+        } else if (event && depth == 0) {
+            if (strcmp(name, "DTSTART") == 0) {
+                ottsr_ics_parse_time(calendar, value, tzid, &event->start, &event->tz, &event->all_day);
+            } else if (strcmp(name, "DTEND") == 0) {
+                ottsr_ics_parse_time(calendar, value, tzid, &end, NULL, NULL);
+            } else if (strcmp(name, "DURATION") == 0) {
+                event->duration = ottsr_ics_parse_duration(value);
+            } else if (strcmp(name, "RRULE") == 0) {
+                ottsr_ics_parse_rrule(event, calendar, value);
+            } else if (strcmp(name, "EXDATE") == 0) {
+                ottsr_ics_add_exdates(event, calendar, value, tzid);
+            } else if (strcmp(name, "RECURRENCE-ID") == 0) {
+                ottsr_ics_parse_time(calendar, value, tzid, &recurrence_id, NULL, NULL);
+            } else if (strcmp(name, "UID") == 0) {
+                g_free(event->uid);
+                event->uid = g_strdup(value);
+            } else if (strcmp(name, "TRANSP") == 0) {
+                event->transparent = strcmp(value, "TRANSPARENT") == 0;
+            } else if (strcmp(name, "STATUS") == 0) {
+                cancelled = strcmp(value, "CANCELLED") == 0;
+            }
+        }
+        line = next;
+    }
+    if (event) ottsr_ics_event_free(event);
+
+    if (overrides->len > 0) {
+        GHashTable *series = g_hash_table_new(g_str_hash, g_str_equal);
+        for (guint i = 0; i < calendar->events->len; i++) {
+            ottsr_ics_event_t *candidate = g_ptr_array_index(calendar->events, i);
+            if (candidate->freq != OTTSR_RRULE_NONE && candidate->uid) {
+                g_hash_table_insert(series, candidate->uid, candidate);
+            }
+        }
+        for (guint i = 0; i < overrides->len; i++) {
+            ottsr_ics_override_t *override = &g_array_index(overrides, ottsr_ics_override_t, i);
+            ottsr_ics_event_t *owner = g_hash_table_lookup(series, override->uid);
+            if (owner) {
+                if (!owner->exdates) owner->exdates = g_array_new(FALSE, FALSE, sizeof(gint64));
+                g_array_append_val(owner->exdates, override->original);
+            }
+            g_free(override->uid);
+        }
+        g_hash_table_destroy(series);
+    }
+
+    g_array_unref(overrides);
+    g_string_free(unfolded, TRUE);
+    return seen_calendar;
+}
+
+// Calendar
+
+ottsr_calendar_t *ottsr_calendar_new(void) {
+    ottsr_calendar_t *calendar = g_new0(ottsr_calendar_t, 1);
+    calendar->events = g_ptr_array_new_with_free_func(ottsr_ics_event_free);
+    calendar->zones = g_hash_table_new_full(g_str_hash, g_str_equal, g_free,
+                                            (GDestroyNotify)g_time_zone_unref);
+    calendar->singles.nodes = g_array_new(FALSE, FALSE, sizeof(ottsr_interval_t));
+    calendar->singles.max_end = g_array_new(FALSE, FALSE, sizeof(gint64));
+    calendar->series.nodes = g_array_new(FALSE, FALSE, sizeof(ottsr_interval_t));
+    calendar->series.max_end = g_array_new(FALSE, FALSE, sizeof(gint64));
+    calendar->candidates = g_array_new(FALSE, FALSE, sizeof(guint32));
+    return calendar;
+}
+
+void ottsr_calendar_free(ottsr_calendar_t *calendar) {
+    if (!calendar) return;
+    g_ptr_array_unref(calendar->events);
+    g_hash_table_destroy(calendar->zones);
+    g_array_unref(calendar->singles.nodes);
+    g_array_unref(calendar->singles.max_end);
+    g_array_unref(calendar->series.nodes);
+    g_array_unref(calendar->series.max_end);
+    g_array_unref(calendar->candidates);
+    g_free(calendar);
+}
+
+gboolean ottsr_calendar_load(ottsr_calendar_t *calendar, const char *path) {
+    char *data = NULL;
+    gsize length = 0;
+    GError *error = NULL;
+
+    if (!g_file_get_contents(path, &data, &length, &error)) {
+        g_warning("Failed to read calendar %s: %s", path, error->message);
+        g_error_free(error);
+        return FALSE;
+    }
+
+    gboolean ok = ottsr_calendar_parse(calendar, data, length);
+    if (!ok) g_warning("%s is not an iCalendar file", path);
+    g_free(data);
+    return ok;
+}
+
+// Last moment a series can be busy. COUNT bounds it from above; the exact
+// end falls out when the days are expanded.
+static gint64 ottsr_calendar_series_end(const ottsr_ics_event_t *event) {
+    gint64 end = event->until;
+    if (event->count > 0) {
+        gint64 days;
+        switch (event->freq) {
+            case OTTSR_RRULE_DAILY:
+                days = (gint64)event->count * event->interval;
+                break;
+            case OTTSR_RRULE_WEEKLY: {
+                int per_week = ottsr_plan_bits(event->weekdays);
+                days = ((gint64)(event->count + per_week - 1) / per_week + 1) * event->interval * 7;
+                break;
+            }
+            case OTTSR_RRULE_MONTHLY:
+                days = (gint64)event->count * event->interval * 31;
+                break;
+            default:
+                days = (gint64)event->count * event->interval * 366;
+                break;
+        }
+        // A day of slack for clock changes along the way
+        end = MIN(end, event->start + (days + 1) * 86400);
+    }
+    return end == G_MAXINT64 ? end : end + event->duration;
+}
+
+// Build the trees once every file is parsed
+void ottsr_calendar_index(ottsr_calendar_t *calendar) {
+    g_array_set_size(calendar->singles.nodes, 0);
+    g_array_set_size(calendar->series.nodes, 0);
+
+    for (guint i = 0; i < calendar->events->len; i++) {
+        const ottsr_ics_event_t *event = g_ptr_array_index(calendar->events, i);
+        ottsr_interval_t node = { event->start, event->start + event->duration, i };
+
+        if (event->freq == OTTSR_RRULE_NONE) {
+            g_array_append_val(calendar->singles.nodes, node);
+        } else {
+            node.end = ottsr_calendar_series_end(event);
+            g_array_append_val(calendar->series.nodes, node);
+        }
+    }
+
+    ottsr_interval_tree_build(&calendar->singles);
+    ottsr_interval_tree_build(&calendar->series);
+}
+
+guint ottsr_calendar_event_count(const ottsr_calendar_t *calendar, guint *recurring) {
+    if (recurring) *recurring = calendar->series.nodes->len;
+    return calendar->events->len;
+}
+
+// Occurrence number of a series on a civil day of its own zone, or -1
+static gint64 ottsr_calendar_occurrence(const ottsr_ics_event_t *event, gint32 day) {
+    gint32 diff = day - event->start_day;
+    if (diff < 0) return -1;
+
+    switch (event->freq) {
+        case OTTSR_RRULE_DAILY:
+            return diff % event->interval == 0 ? diff / event->interval : -1;
+
+        case OTTSR_RRULE_WEEKLY: {
+            int weekday = ottsr_plan_weekday(day);
+            if (!(event->weekdays & (1 << weekday))) return -1;
+
+            int start_weekday = ottsr_plan_weekday(event->start_day);
+            gint32 weeks = ((day - weekday) - (event->start_day - start_weekday)) / 7;
+            if (weeks % event->interval != 0) return -1;
+
+            return (gint64)(weeks / event->interval) * ottsr_plan_bits(event->weekdays) -
+                   ottsr_plan_bits(event->weekdays & ((1u << start_weekday) - 1)) +
+                   ottsr_plan_bits(event->weekdays & ((1u << weekday) - 1));
+        }
+
+        case OTTSR_RRULE_MONTHLY:
+        case OTTSR_RRULE_YEARLY: {
+            int year, month, month_day, start_year, start_month, start_day;
+            ottsr_civil_from_days(day, &year, &month, &month_day);
+            if (month_day != event->month_day) return -1;
+            ottsr_civil_from_days(event->start_day, &start_year, &start_month, &start_day);
+
+            int steps;
+            if (event->freq == OTTSR_RRULE_MONTHLY) {
+                steps = (year - start_year) * 12 + month - start_month;
+            } else {
+                if (month != start_month) return -1;
+                steps = year - start_year;
+            }
+            return steps % event->interval == 0 ? steps / event->interval : -1;
+        }
+
+        default:
+            return -1;
+    }
+}
+
+static gboolean ottsr_calendar_excluded(const ottsr_ics_event_t *event, gint64 start) {
+    if (!event->exdates) return FALSE;
+    for (guint i = 0; i < event->exdates->len; i++) {
+        if (g_array_index(event->exdates, gint64, i) == start) return TRUE;
+    }
+    return FALSE;
+}
+
+static void ottsr_calendar_add_busy(GArray *busy, gint64 start, gint64 end, gint64 from, gint64 to) {
+    if (end <= from || start >= to) return;
+    ottsr_plan_block_t block = { MAX(start, from), MIN(end, to), OTTSR_PLAN_BUSY, FALSE };
+    g_array_append_val(busy, block);
+}
+
+static gint ottsr_plan_block_compare(gconstpointer a, gconstpointer b) {
+    gint64 x = ((const ottsr_plan_block_t *)a)->start;
+    gint64 y = ((const ottsr_plan_block_t *)b)->start;
+    return x < y ? -1 : x > y;
+}
+
+// Busy time in [from, to) as sorted, non-overlapping blocks
+GArray *ottsr_calendar_busy(ottsr_calendar_t *calendar, gint64 from, gint64 to) {
+    GArray *busy = g_array_new(FALSE, FALSE, sizeof(ottsr_plan_block_t));
+    GArray *candidates = calendar->candidates;
+
+    g_array_set_size(candidates, 0);
+    ottsr_interval_tree_query(&calendar->singles, 0, calendar->singles.nodes->len, from, to, candidates);
+    for (guint i = 0; i < candidates->len; i++) {
+        const ottsr_ics_event_t *event = g_ptr_array_index(calendar->events, g_array_index(candidates, guint32, i));
+        ottsr_calendar_add_busy(busy, event->start, event->start + event->duration, from, to);
+    }
+
+    g_array_set_size(candidates, 0);
+    ottsr_interval_tree_query(&calendar->series, 0, calendar->series.nodes->len, from, to, candidates);
+    for (guint i = 0; i < candidates->len; i++) {
+        const ottsr_ics_event_t *event = g_ptr_array_index(calendar->events, g_array_index(candidates, guint32, i));
+
+        // Only the days whose instances could reach into the window
+        gint32 first = ottsr_plan_day_of(event->tz, from - event->duration, NULL);
+        gint32 last = ottsr_plan_day_of(event->tz, to, NULL);
+        for (gint32 day = first; day <= last; day++) {
+            gint64 occurrence = ottsr_calendar_occurrence(event, day);
+            if (occurrence < 0 || (event->count > 0 && occurrence >= event->count)) continue;
+
+            gint64 start = ottsr_plan_to_unix(event->tz, day, event->start_seconds);
+            if (start > event->until || ottsr_calendar_excluded(event, start)) continue;
+            ottsr_calendar_add_busy(busy, start, start + event->duration, from, to);
+        }
+    }
+
+    g_array_sort(busy, ottsr_plan_block_compare);
+    guint merged = 0;
+    for (guint i = 0; i < busy->len; i++) {
+        ottsr_plan_block_t block = g_array_index(busy, ottsr_plan_block_t, i);
+        ottsr_plan_block_t *last = merged > 0 ? &g_array_index(busy, ottsr_plan_block_t, merged - 1) : NULL;
+        if (last && block.start <= last->end) {
+            last->end = MAX(last->end, block.end);
+        } else {
+            g_array_index(busy, ottsr_plan_block_t, merged++) = block;
+        }
+    }
+    g_array_set_size(busy, merged);
+    return busy;
+}
+
+// Planning
+
+static void ottsr_plan_add(GArray *plan, gint64 start, gint64 end, ottsr_plan_kind_t kind, gboolean shortened) {
+    ottsr_plan_block_t block = { start, end, kind, shortened };
+    g_array_append_val(plan, block);
+}
+
+// Lay the profile's study/break pattern into the gaps between busy blocks.
+// A study block that runs into a conflict is shortened when at least
+// min_study_seconds of it fit, and the rest of the gap is skipped
+// otherwise; the conflict then stands in for the break.
+GArray *ottsr_plan_layout(const ottsr_profile_t *profile, GArray *busy, gint64 from, gint64 to,
+                          int min_study_seconds) {
+    GArray *plan = g_array_new(FALSE, FALSE, sizeof(ottsr_plan_block_t));
+    gint64 study = (gint64)MAX(1, profile->study_minutes) * 60;
+    int until_long = MAX(1, profile->sessions_until_long_break);
+    int sessions = 0;
+    gint64 cursor = from;
+
+    for (guint i = 0; i <= busy->len; i++) {
+        const ottsr_plan_block_t *conflict = i < busy->len ? &g_array_index(busy, ottsr_plan_block_t, i) : NULL;
+        gint64 gap_end = conflict ? conflict->start : to;
+
+        while (cursor < gap_end) {
+            if (cursor + study <= gap_end) {
+                ottsr_plan_add(plan, cursor, cursor + study, OTTSR_PLAN_STUDY, FALSE);
+                cursor += study;
+            } else if (gap_end - cursor >= min_study_seconds) {
+                ottsr_plan_add(plan, cursor, gap_end, OTTSR_PLAN_STUDY, TRUE);
+                cursor = gap_end;
+            } else {
+                ottsr_plan_add(plan, cursor, gap_end, OTTSR_PLAN_SKIPPED, FALSE);
+                cursor = gap_end;
+                break;
+            }
+            sessions++;
+            if (cursor >= gap_end) break;
+
+            gboolean long_break = sessions % until_long == 0;
+            gint64 pause = (gint64)MAX(1, long_break ? profile->long_break_minutes : profile->break_minutes) * 60;
+            gint64 pause_end = MIN(cursor + pause, gap_end);
+            ottsr_plan_add(plan, cursor, pause_end, long_break ? OTTSR_PLAN_LONG_BREAK : OTTSR_PLAN_BREAK,
+                           pause_end < cursor + pause);
+            cursor = pause_end;
+        }
+
+        if (conflict) {
+            g_array_append_val(plan, *conflict);
+            cursor = MAX(cursor, conflict->end);
+        }
+    }
+    return plan;
+}
+
+const char *ottsr_plan_kind_name(ottsr_plan_kind_t kind) {
+    return ottsr_plan_kind_names[kind];
+}
+
+// Command line
+
+static void ottsr_plan_format_time(GTimeZone *local, gint64 t, char *buffer, size_t buffer_size) {
+    int seconds;
+    ottsr_plan_day_of(local, t, &seconds);
+    snprintf(buffer, buffer_size, "%02d:%02d", seconds / 3600, seconds / 60 % 60);
+}
+
+static gboolean ottsr_plan_parse_clock(const char *text, int *minutes) {
+    int hour, minute;
+    char extra;
+    if (sscanf(text, "%d:%d%c", &hour, &minute, &extra) != 2) return FALSE;
+    if (hour < 0 || minute < 0 || minute > 59 || hour * 60 + minute > 24 * 60) return FALSE;
+    *minutes = hour * 60 + minute;
+    return TRUE;
+}
+
+static void ottsr_plan_print_day(const GArray *plan, GTimeZone *local, gint32 day) {
+    int year, month, month_day;
+    ottsr_civil_from_days(day, &year, &month, &month_day);
+    g_print("\n%04d-%02d-%02d\n", year, month, month_day);
+
+    gint64 studied = 0;
+    guint sessions = 0;
+    for (guint i = 0; i < plan->len; i++) {
+        const ottsr_plan_block_t *block = &g_array_index(plan, ottsr_plan_block_t, i);
+        char begin[8], end[8];
+        ottsr_plan_format_time(local, block->start, begin, sizeof(begin));
+        ottsr_plan_format_time(local, block->end, end, sizeof(end));
+        g_print("  %s-%s  %s%s\n", begin, end, ottsr_plan_kind_name(block->kind),
+                block->shortened ? " (shortened)" : "");
+
+        if (block->kind == OTTSR_PLAN_STUDY) {
+            studied += block->end - block->start;
+            sessions++;
+        }
+    }
+    g_print("  %u sessions, %dh%02d of study\n", sessions, (int)(studied / 3600), (int)(studied / 60 % 60));
+}
+
+int ottsr_plan_main(int argc, char *argv[]) {
+    char *date = NULL;
+    char *from_text = NULL;
+    char *to_text = NULL;
+    char *profile_name = NULL;
+    int days = 1;
+    int min_study = OTTSR_PLAN_MIN_STUDY;
+
+    GOptionEntry entries[] = {
+        { "date", 'd', 0, G_OPTION_ARG_STRING, &date, "First day to plan: today, tomorrow or YYYY-MM-DD", "DAY" },
+        { "days", 'n', 0, G_OPTION_ARG_INT, &days, "Number of days to plan", "N" },
+        { "from", 0, 0, G_OPTION_ARG_STRING, &from_text, "Start of the study day (default: 08:00)", "HH:MM" },
+        { "to", 0, 0, G_OPTION_ARG_STRING, &to_text, "End of the study day (default: 22:00)", "HH:MM" },
+        { "profile", 'p', 0, G_OPTION_ARG_STRING, &profile_name, "Profile to plan with (default: the active one)", "NAME" },
+        { "min-study", 0, 0, G_OPTION_ARG_INT, &min_study, "Shortest study block worth keeping in minutes", "MIN" },
+        { NULL }
+    };
+
+    GOptionContext *context = g_option_context_new("FILE.ics... - plan study sessions around a timetable");
+    g_option_context_add_main_entries(context, entries, NULL);
+    GError *error = NULL;
+    gboolean ok = g_option_context_parse(context, &argc, &argv, &error);
+    g_option_context_free(context);
+
+    int from_minutes = OTTSR_PLAN_DAY_START;
+    int to_minutes = OTTSR_PLAN_DAY_END;
+    gint32 first_day = ottsr_local_day(g_get_real_time() / G_USEC_PER_SEC, NULL, NULL);
+    if (!ok) {
+        g_printerr("ottsr plan: %s\n", error->message);
+        g_error_free(error);
+    } else if ((from_text && !ottsr_plan_parse_clock(from_text, &from_minutes)) ||
+               (to_text && !ottsr_plan_parse_clock(to_text, &to_minutes)) || from_minutes >= to_minutes) {
+        g_printerr("ottsr plan: --from and --to need HH:MM with --from first\n");
+        ok = FALSE;
+    } else if (g_strcmp0(date, "tomorrow") == 0) {
+        first_day++;
+    } else if (date && g_strcmp0(date, "today") != 0) {
+        int year, month, day;
+        char extra;
+        if (sscanf(date, "%d-%d-%d%c", &year, &month, &day, &extra) != 3 ||
+            month < 1 || month > 12 || day < 1 || day > 31) {
+            g_printerr("ottsr plan: cannot read date %s\n", date);
+            ok = FALSE;
+        } else {
+            first_day = ottsr_days_from_civil(year, month, day);
+        }
+    }
+    if (ok && argc < 2) {
+        g_printerr("ottsr plan: no calendar files given\n");
+        ok = FALSE;
+    }
+
+    ottsr_config_t config = {0};
+    ottsr_config_set_defaults(&config);
+    char *config_file = ottsr_get_config_file();
+    if (ok && config_file && g_file_test(config_file, G_FILE_TEST_EXISTS)) {
+        ottsr_config_load_file(config_file, &config);
+    }
+    g_free(config_file);
+
+    const ottsr_profile_t *profile = NULL;
+    if (ok) {
+        int index = CLAMP(config.active_profile, 0, MAX(0, config.profile_count - 1));
+        for (int i = 0; profile_name && i < config.profile_count; i++) {
+            if (g_ascii_strcasecmp(config.profiles[i].name, profile_name) == 0) index = i;
+        }
+        if (profile_name && g_ascii_strcasecmp(config.profiles[index].name, profile_name) != 0) {
+            g_printerr("ottsr plan: no profile named %s\n", profile_name);
+            ok = FALSE;
+        }
+        profile = &config.profiles[index];
+    }
+
+    int status = 1;
+    if (ok) {
+        ottsr_calendar_t *calendar = ottsr_calendar_new();
+        GTimeZone *local = g_time_zone_new_local();
+
+        status = 0;
+        gint64 start = g_get_monotonic_time();
+        for (int i = 1; i < argc; i++) {
+            if (!ottsr_calendar_load(calendar, argv[i])) status = 1;
+        }
+        ottsr_calendar_index(calendar);
+        gint64 loaded = g_get_monotonic_time();
+        gint64 planning = 0;
+
+        g_print("Planning with %s: %d min study, %d min break, %d min long break every %d sessions\n",
+                profile->name, profile->study_minutes, profile->break_minutes,
+                profile->long_break_minutes, profile->sessions_until_long_break);
+
+        for (int i = 0; i < MAX(1, days); i++) {
+            gint64 from = ottsr_plan_to_unix(local, first_day + i, from_minutes * 60);
+            gint64 to = ottsr_plan_to_unix(local, first_day + i, to_minutes * 60);
+
+            gint64 day_start = g_get_monotonic_time();
+            GArray *busy = ottsr_calendar_busy(calendar, from, to);
+            GArray *plan = ottsr_plan_layout(profile, busy, from, to, MAX(1, min_study) * 60);
+            planning += g_get_monotonic_time() - day_start;
+
+            ottsr_plan_print_day(plan, local, first_day + i);
+            g_array_unref(plan);
+            g_array_unref(busy);
+        }
+
+        guint recurring = 0;
+        guint events = ottsr_calendar_event_count(calendar, &recurring);
+        g_print("\nLoaded %u events (%u recurring) in %.2f ms, planned %d days in %.2f ms\n",
+                events, recurring, (loaded - start) / 1000.0, MAX(1, days), planning / 1000.0);
+
+        g_time_zone_unref(local);
+        ottsr_calendar_free(calendar);
+    }
+
+    g_free(date);
+    g_free(from_text);
+    g_free(to_text);
+    g_free(profile_name);
+    return status;
+}
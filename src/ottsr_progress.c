@@ -0,0 +1,109 @@
+#include "ottsr.h"
+
+// Fraction of the current phase done at a monotonic time, measured from
+// the same anchor the phase clock uses
+double ottsr_phase_progress(ottsr_app_t *app, gint64 now) {
+    if (app->session.state != OTTSR_STATE_STUDYING && app->session.state != OTTSR_STATE_BREAKING) {
+        return 0.0;
+    }
+
+    int duration = ottsr_phase_duration(app);
+    if (duration <= 0) return 0.0;
+
+    double done = (now - app->phase_anchor) / (double)((gint64)duration * G_USEC_PER_SEC);
+    return CLAMP(done, 0.0, 1.0);
+}
+
+static void ottsr_progress_draw(ottsr_app_t *app, gint64 now) {
+    double progress = ottsr_phase_progress(app, now);
+
+    if (app->session.state == OTTSR_STATE_STUDYING) {
+        gtk_progress_bar_set_fraction(GTK_PROGRESS_BAR(app->session_progress), progress);
+    } else if (app->session.state == OTTSR_STATE_BREAKING) {
+        gtk_progress_bar_set_fraction(GTK_PROGRESS_BAR(app->break_progress), progress);
+    }
+}
+
+// GTK keeps the frame clock running while a tick callback is installed, so
+// frames beyond max_fps are skipped here rather than drawn
+static gboolean ottsr_progress_tick(GtkWidget *widget, GdkFrameClock *clock, gpointer user_data) {
+    ottsr_app_t *app = (ottsr_app_t *)user_data;
+    gint64 frame_time = gdk_frame_clock_get_frame_time(clock);
+    int fps = CLAMP(app->config.max_fps, 1, 240);
+
+    if (frame_time - app->progress_last_frame < G_USEC_PER_SEC / fps) {
+        return G_SOURCE_CONTINUE;
+    }
+    app->progress_last_frame = frame_time;
+
+    ottsr_progress_draw(app, frame_time);
+    return G_SOURCE_CONTINUE;
+}
+
+static gboolean ottsr_progress_wanted(ottsr_app_t *app) {
+    return (app->session.state == OTTSR_STATE_STUDYING || app->session.state == OTTSR_STATE_BREAKING) &&
+           app->window_mapped && !app->window_iconified && !app->window_obscured &&
+           !app->in_background;
+}
+
+// Install or remove the tick callback to match session state and visibility
+static void ottsr_progress_sync(ottsr_app_t *app) {
+    if (!app->session_progress) return;
+
+    if (ottsr_progress_wanted(app)) {
+        if (app->progress_tick_id == 0) {
+            app->progress_last_frame = 0;
+            app->progress_tick_id = gtk_widget_add_tick_callback(app->session_progress,
+                                                                 ottsr_progress_tick, app, NULL);
+        }
+    } else if (app->progress_tick_id > 0) {
+        gtk_widget_remove_tick_callback(app->session_progress, app->progress_tick_id);
+        app->progress_tick_id = 0;
+    }
+}
+
+// The session timer was (re)armed
+void ottsr_progress_start(ottsr_app_t *app) {
+    ottsr_progress_sync(app);
+}
+
+void ottsr_progress_stop(ottsr_app_t *app) {
+    if (app->progress_tick_id > 0 && app->session_progress) {
+        gtk_widget_remove_tick_callback(app->session_progress, app->progress_tick_id);
+    }
+    app->progress_tick_id = 0;
+}
+
+static gboolean on_progress_map(GtkWidget *widget, GdkEvent *event, ottsr_app_t *app) {
+    app->window_mapped = TRUE;
+    ottsr_progress_sync(app);
+    return FALSE;
+}
+
+static gboolean on_progress_unmap(GtkWidget *widget, GdkEvent *event, ottsr_app_t *app) {
+    app->window_mapped = FALSE;
+    ottsr_progress_sync(app);
+    return FALSE;
+}
+
+static gboolean on_progress_window_state(GtkWidget *widget, GdkEventWindowState *event, ottsr_app_t *app) {
+    app->window_iconified = (event->new_window_state & GDK_WINDOW_STATE_ICONIFIED) != 0;
+    ottsr_progress_sync(app);
+    return FALSE;
+}
+
+// Only reported by X11 without a compositor; elsewhere the window stays "visible"
+static gboolean on_progress_visibility(GtkWidget *widget, GdkEventVisibility *event, ottsr_app_t *app) {
+    app->window_obscured = event->state == GDK_VISIBILITY_FULLY_OBSCURED;
+    ottsr_progress_sync(app);
+    return FALSE;
+}
+
+// Follow the main window's visibility
+void ottsr_progress_attach(ottsr_app_t *app) {
+    gtk_widget_add_events(app->main_window, GDK_STRUCTURE_MASK | GDK_VISIBILITY_NOTIFY_MASK);
+    g_signal_connect(app->main_window, "map-event", G_CALLBACK(on_progress_map), app);
+    g_signal_connect(app->main_window, "unmap-event", G_CALLBACK(on_progress_unmap), app);
+    g_signal_connect(app->main_window, "window-state-event", G_CALLBACK(on_progress_window_state), app);
+    g_signal_connect(app->main_window, "visibility-notify-event", G_CALLBACK(on_progress_visibility), app);
+}
@@ -0,0 +1,292 @@
+#include "ottsr.h"
+
+// Profile fields an admin may push; statistics are deliberately excluded
+static gboolean ottsr_profile_settings_equal(const ottsr_profile_t *a, const ottsr_profile_t *b) {
+    return strcmp(a->name, b->name) == 0 &&
+           a->study_minutes == b->study_minutes &&
+           a->break_minutes == b->break_minutes &&
+           a->long_break_minutes == b->long_break_minutes &&
+           a->sessions_until_long_break == b->sessions_until_long_break &&
+           a->sound_enabled == b->sound_enabled &&
+           a->notifications_enabled == b->notifications_enabled;
+}
+
+static int ottsr_find_profile(const ottsr_profile_t *profiles, int count, const char *name) {
+    for (int i = 0; i < count; i++) {
+        if (strcmp(profiles[i].name, name) == 0) return i;
+    }
+    return -1;
+}
+
+// Bring the profile combo in line with the new list, touching only rows that differ
+static void ottsr_sync_profile_combo(ottsr_app_t *app, char old_names[][OTTSR_MAX_NAME_LEN], int old_count) {
+    if (!app->profile_combo) return;
+
+    GtkComboBoxText *combo = GTK_COMBO_BOX_TEXT(app->profile_combo);
+    GtkTreeModel *model = gtk_combo_box_get_model(GTK_COMBO_BOX(combo));
+    int new_count = app->config.profile_count;
+
+    g_signal_handlers_block_by_func(combo, on_profile_changed, app);
+
+    for (int i = 0; i < MIN(old_count, new_count); i++) {
+        if (strcmp(old_names[i], app->config.profiles[i].name) == 0) continue;
+
+        GtkTreeIter iter;
+        if (gtk_tree_model_iter_nth_child(model, &iter, NULL, i)) {
+            gtk_list_store_set(GTK_LIST_STORE(model), &iter, 0, app->config.profiles[i].name, -1);
+        }
+    }
+    for (int i = old_count - 1; i >= new_count; i--) {
+        gtk_combo_box_text_remove(combo, i);
+    }
+    for (int i = old_count; i < new_count; i++) {
+        gtk_combo_box_text_append_text(combo, app->config.profiles[i].name);
+    }
+
+    if (gtk_combo_box_get_active(GTK_COMBO_BOX(combo)) != app->config.active_profile) {
+        gtk_combo_box_set_active(GTK_COMBO_BOX(combo), app->config.active_profile);
+    }
+
+    g_signal_handlers_unblock_by_func(combo, on_profile_changed, app);
+}
+
+// Same for the profile manager list, if it is open
+static void ottsr_sync_profile_list(ottsr_app_t *app, char old_names[][OTTSR_MAX_NAME_LEN], int old_count,
+                                    const gboolean *changed) {
+    if (!app->profiles_window || !app->profile_list) return;
+
+    GtkListBox *list = GTK_LIST_BOX(app->profile_list);
+    int new_count = app->config.profile_count;
+
+    for (int i = 0; i < MIN(old_count, new_count); i++) {
+        if (strcmp(old_names[i], app->config.profiles[i].name) == 0) continue;
+
+        GtkListBoxRow *row = gtk_list_box_get_row_at_index(list, i);
+        GtkWidget *child = row ? gtk_bin_get_child(GTK_BIN(row)) : NULL;
+        if (child && GTK_IS_LABEL(child)) {
+            gtk_label_set_text(GTK_LABEL(child), app->config.profiles[i].name);
+        }
+    }
+    for (int i = old_count - 1; i >= new_count; i--) {
+        GtkListBoxRow *row = gtk_list_box_get_row_at_index(list, i);
+        if (row) gtk_widget_destroy(GTK_WIDGET(row));
+    }
+    for (int i = old_count; i < new_count; i++) {
+        GtkWidget *row = gtk_list_box_row_new();
+        GtkWidget *label = gtk_label_new(app->config.profiles[i].name);
+        gtk_container_add(GTK_CONTAINER(row), label);
+        gtk_list_box_insert(list, row, -1);
+        gtk_widget_show_all(row);
+    }
+
+    // Refresh the editor only if the profile being edited was changed remotely
+    GtkListBoxRow *selected = gtk_list_box_get_selected_row(list);
+    if (selected) {
+        int index = gtk_list_box_row_get_index(selected);
+        if (index >= 0 && index < new_count && changed[index]) {
+            on_profile_list_changed(list, selected, app);
+        }
+    }
+}
+
+// Merge an externally edited config into the running one. Profiles are
+// matched by name: their settings follow the file, while statistics stay
+// with the in-memory values so a running session is never clobbered.
+void ottsr_config_apply(ottsr_app_t *app, const ottsr_config_t *incoming) {
+    ottsr_config_t *current = &app->config;
+    if (incoming->profile_count <= 0) return;
+
+    char active_name[OTTSR_MAX_NAME_LEN];
+    char running_name[OTTSR_MAX_NAME_LEN] = "";
+    g_strlcpy(active_name, current->profiles[current->active_profile].name, OTTSR_MAX_NAME_LEN);
+
+    gboolean running = app->session.state != OTTSR_STATE_IDLE;
+    if (running) {
+        g_strlcpy(running_name, current->profiles[app->session.profile_index].name, OTTSR_MAX_NAME_LEN);
+    }
+
+    ottsr_config_t *before = g_new(ottsr_config_t, 1);
+    *before = *current;
+    ottsr_profile_t *merged = g_new0(ottsr_profile_t, OTTSR_MAX_PROFILES);
+    int count = 0;
+
+    for (int i = 0; i < incoming->profile_count && count < OTTSR_MAX_PROFILES; i++) {
+        const ottsr_profile_t *remote = &incoming->profiles[i];
+        int local = ottsr_find_profile(current->profiles, current->profile_count, remote->name);
+
+        merged[count] = *remote;
+        if (local >= 0) {
+            merged[count].total_study_time = current->profiles[local].total_study_time;
+            merged[count].total_sessions = current->profiles[local].total_sessions;
+            merged[count].completed_sessions = current->profiles[local].completed_sessions;
+        }
+        count++;
+    }
+
+    // Never drop the profile a session is running under
+    if (running && ottsr_find_profile(merged, count, running_name) < 0) {
+        if (count == OTTSR_MAX_PROFILES) count--;
+        merged[count++] = current->profiles[app->session.profile_index];
+    }
+
+    // Work out which slots actually differ before overwriting anything
+    char old_names[OTTSR_MAX_PROFILES][OTTSR_MAX_NAME_LEN];
+    gboolean changed[OTTSR_MAX_PROFILES] = {FALSE};
+    gboolean any_changed = count != current->profile_count;
+    int old_count = current->profile_count;
+
+    for (int i = 0; i < old_count; i++) {
+        g_strlcpy(old_names[i], current->profiles[i].name, OTTSR_MAX_NAME_LEN);
+    }
+    for (int i = 0; i < count; i++) {
+        changed[i] = i >= old_count || !ottsr_profile_settings_equal(&current->profiles[i], &merged[i]);
+        any_changed |= changed[i];
+    }
+
+    if (any_changed) {
+        memcpy(current->profiles, merged, sizeof(ottsr_profile_t) * count);
+        current->profile_count = count;
+
+        int active = ottsr_find_profile(current->profiles, count, active_name);
+        current->active_profile = active >= 0 ? active : 0;
+        if (running) {
+            app->session.profile_index = ottsr_find_profile(current->profiles, count, running_name);
+        }
+
+        ottsr_sync_profile_combo(app, old_names, old_count);
+        ottsr_sync_profile_list(app, old_names, old_count, changed);
+
+        if (running) {
+            ottsr_phase_retime(app);
+            ottsr_http_update(app);
+        }
+    }
+
+    current->theme = incoming->theme;
+    current->sound_volume = incoming->sound_volume;
+    current->max_fps = incoming->max_fps;
+
+    // Open editors and the main window pick up what changed from here
+    ottsr_model_changed(app, before);
+
+    g_free(before);
+    g_free(merged);
+}
+
+// Swap in a different config wholesale, as when a kiosk changes user. The
+// session must be idle; widgets are kept and only differing rows rewritten.
+void ottsr_config_replace(ottsr_app_t *app, const ottsr_config_t *incoming) {
+    char old_names[OTTSR_MAX_PROFILES][OTTSR_MAX_NAME_LEN];
+    gboolean changed[OTTSR_MAX_PROFILES];
+    int old_count = app->config.profile_count;
+
+    for (int i = 0; i < old_count; i++) {
+        g_strlcpy(old_names[i], app->config.profiles[i].name, OTTSR_MAX_NAME_LEN);
+    }
+    for (int i = 0; i < incoming->profile_count; i++) {
+        changed[i] = i >= old_count || !ottsr_profile_settings_equal(&app->config.profiles[i],
+                                                                     &incoming->profiles[i]);
+    }
+
+    ottsr_config_t *before = g_new(ottsr_config_t, 1);
+    *before = app->config;
+
+    app->config = *incoming;
+    if (app->config.active_profile < 0 || app->config.active_profile >= app->config.profile_count) {
+        app->config.active_profile = 0;
+    }
+    app->session.profile_index = app->config.active_profile;
+
+    ottsr_sync_profile_combo(app, old_names, old_count);
+    ottsr_sync_profile_list(app, old_names, old_count, changed);
+    ottsr_model_changed(app, before);
+    g_free(before);
+}
+
+// Debounced: editors and deployment tools often write a file in several steps
+static gboolean ottsr_config_reload_cb(gpointer user_data) {
+    ottsr_app_t *app = (ottsr_app_t *)user_data;
+    app->config_reload_id = 0;
+
+    char *config_file = ottsr_get_config_file();
+    char *contents = NULL;
+    gsize length = 0;
+
+    if (!config_file || !g_file_get_contents(config_file, &contents, &length, NULL)) {
+        g_free(config_file);
+        return G_SOURCE_REMOVE;
+    }
+    g_free(config_file);
+
+    // Our own saves come back through the monitor too
+    guint64 hash = ottsr_hash_bytes(contents, length);
+    if (hash == app->saved_config_hash) {
+        g_free(contents);
+        return G_SOURCE_REMOVE;
+    }
+
+    ottsr_config_t *incoming = g_new(ottsr_config_t, 1);
+    *incoming = app->config;
+
+    if (ottsr_config_parse_json(incoming, contents, length)) {
+        ottsr_config_apply(app, incoming);
+        app->saved_config_hash = hash;
+        g_print("Configuration reloaded\n");
+    } else {
+        g_warning("Ignoring unreadable settings.json change");
+    }
+
+    g_free(incoming);
+    g_free(contents);
+    return G_SOURCE_REMOVE;
+}
+
+static void on_config_file_changed(GFileMonitor *monitor, GFile *file, GFile *other_file,
+                                   GFileMonitorEvent event, ottsr_app_t *app) {
+    switch (event) {
+        case G_FILE_MONITOR_EVENT_CHANGED:
+        case G_FILE_MONITOR_EVENT_CHANGES_DONE_HINT:
+        case G_FILE_MONITOR_EVENT_CREATED:
+        case G_FILE_MONITOR_EVENT_MOVED_IN:
+        case G_FILE_MONITOR_EVENT_RENAMED:
+            break;
+        default:
+            return;
+    }
+
+    if (app->config_reload_id > 0) {
+        g_source_remove(app->config_reload_id);
+    }
+    app->config_reload_id = g_timeout_add(OTTSR_RELOAD_DEBOUNCE_MS, ottsr_config_reload_cb, app);
+}
+
+void ottsr_config_monitor_start(ottsr_app_t *app) {
+    char *config_file = ottsr_get_config_file();
+    if (!config_file) return;
+
+    GFile *file = g_file_new_for_path(config_file);
+    GError *error = NULL;
+
+    app->config_monitor = g_file_monitor_file(file, G_FILE_MONITOR_WATCH_MOVES, NULL, &error);
+    if (app->config_monitor) {
+        g_signal_connect(app->config_monitor, "changed", G_CALLBACK(on_config_file_changed), app);
+    } else {
+        g_warning("Cannot watch %s: %s", config_file, error->message);
+        g_error_free(error);
+    }
+
+    g_object_unref(file);
+    g_free(config_file);
+}
+
+void ottsr_config_monitor_stop(ottsr_app_t *app) {
+    if (app->config_reload_id > 0) {
+        g_source_remove(app->config_reload_id);
+        app->config_reload_id = 0;
+    }
+    if (app->config_monitor) {
+        g_file_monitor_cancel(app->config_monitor);
+        g_object_unref(app->config_monitor);
+        app->config_monitor = NULL;
+    }
+}
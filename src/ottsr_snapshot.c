@@ -0,0 +1,95 @@
+#include "ottsr.h"
+
+// On-disk layout: this header followed by the raw ottsr_config_t
+typedef struct {
+    guint32 magic;
+    guint32 version;
+    guint32 config_size;
+    guint32 reserved;
+    gint64 source_mtime;
+    gint64 source_size;
+    gint64 stored_at;
+    guint64 source_hash;
+    guint64 payload_hash;
+} ottsr_snapshot_header_t;
+
+// One snapshot per source file, so several config files can share the cache
+static char *ottsr_snapshot_path(const char *source_path) {
+    char name[64];
+    snprintf(name, sizeof(name), "config-%016" G_GINT64_MODIFIER "x.snapshot",
+             ottsr_hash_bytes(source_path, strlen(source_path)));
+    return g_build_filename(g_get_user_cache_dir(), OTTSR_CACHE_DIR, name, NULL);
+}
+
+// Use the cached decoded config if it was built from this exact source file:
+// one with the same contents when source_hash is given, otherwise one with
+// the same mtime and size, which needs no read of the source at all. An mtime
+// no older than the snapshot could hide a later write within the same
+// second, so that only matches by hash. Returns FALSE (leaving config
+// untouched) when the cache is missing or stale.
+gboolean ottsr_snapshot_load(const char *source_path, const GStatBuf *source_stat,
+                             guint64 source_hash, ottsr_config_t *config) {
+    char *path = ottsr_snapshot_path(source_path);
+    GMappedFile *mapped = g_mapped_file_new(path, FALSE, NULL);
+    g_free(path);
+    if (!mapped) return FALSE;
+
+    gboolean valid = FALSE;
+    gsize length = g_mapped_file_get_length(mapped);
+    const char *data = g_mapped_file_get_contents(mapped);
+
+    if (length == sizeof(ottsr_snapshot_header_t) + sizeof(ottsr_config_t)) {
+        ottsr_snapshot_header_t header;
+        memcpy(&header, data, sizeof(header));
+        const char *payload = data + sizeof(header);
+
+        valid = header.magic == OTTSR_SNAPSHOT_MAGIC &&
+                header.version == OTTSR_SNAPSHOT_VERSION &&
+                header.config_size == sizeof(ottsr_config_t) &&
+                (source_hash != 0 ? header.source_hash == source_hash :
+                 header.source_mtime == (gint64)source_stat->st_mtime &&
+                 header.source_size == (gint64)source_stat->st_size &&
+                 header.source_mtime < header.stored_at) &&
+                header.payload_hash == ottsr_hash_bytes(payload, sizeof(ottsr_config_t));
+
+        if (valid) {
+            memcpy(config, payload, sizeof(ottsr_config_t));
+        }
+    }
+
+    g_mapped_file_unref(mapped);
+    return valid;
+}
+
+// Write the decoded config next to the keys it was derived from
+void ottsr_snapshot_store(const char *source_path, const GStatBuf *source_stat,
+                          guint64 source_hash, const ottsr_config_t *config) {
+    char *cache_dir = g_build_filename(g_get_user_cache_dir(), OTTSR_CACHE_DIR, NULL);
+    g_mkdir_with_parents(cache_dir, 0700);
+    g_free(cache_dir);
+
+    ottsr_snapshot_header_t header = {0};
+    header.magic = OTTSR_SNAPSHOT_MAGIC;
+    header.version = OTTSR_SNAPSHOT_VERSION;
+    header.config_size = sizeof(ottsr_config_t);
+    header.source_mtime = source_stat->st_mtime;
+    header.source_size = source_stat->st_size;
+    header.stored_at = g_get_real_time() / G_USEC_PER_SEC;
+    header.source_hash = source_hash;
+    header.payload_hash = ottsr_hash_bytes(config, sizeof(ottsr_config_t));
+
+    gsize length = sizeof(header) + sizeof(ottsr_config_t);
+    char *buffer = g_malloc(length);
+    memcpy(buffer, &header, sizeof(header));
+    memcpy(buffer + sizeof(header), config, sizeof(ottsr_config_t));
+
+    char *path = ottsr_snapshot_path(source_path);
+    GError *error = NULL;
+    if (!g_file_set_contents(path, buffer, length, &error)) {
+        g_warning("Failed to write config snapshot: %s", error->message);
+        g_error_free(error);
+    }
+
+    g_free(path);
+    g_free(buffer);
+}
@@ -0,0 +1,321 @@
+#include "ottsr.h"
+
+static const char *ottsr_stats_by_names[] = { "subject", "profile", "day" };
+
+// Inverse of ottsr_days_from_civil (days since 1970-01-01)
+void ottsr_civil_from_days(gint32 days, int *year, int *month, int *day) {
+    gint32 z = days + 719468;
+    gint32 era = (z >= 0 ? z : z - 146096) / 146097;
+    gint32 doe = z - era * 146097;
+    gint32 yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    gint32 doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    gint32 mp = (5 * doy + 2) / 153;
+
+    *day = doy - (153 * mp + 2) / 5 + 1;
+    *month = mp < 10 ? mp + 3 : mp - 9;
+    *year = yoe + era * 400 + (*month <= 2);
+}
+
+static gint64 ottsr_day_start(gint32 days) {
+    int year, month, day;
+    ottsr_civil_from_days(days, &year, &month, &day);
+
+    GDateTime *dt = g_date_time_new_local(year, month, day, 0, 0, 0);
+    gint64 timestamp = g_date_time_to_unix(dt);
+    g_date_time_unref(dt);
+    return timestamp;
+}
+
+static void ottsr_format_day(gint32 days, char *buffer, size_t buffer_size) {
+    int year, month, day;
+    ottsr_civil_from_days(days, &year, &month, &day);
+    snprintf(buffer, buffer_size, "%04d-%02d-%02d", year, month, day);
+}
+
+// YYYY-MM-DD, or today / week / month for the start of the current one
+static gboolean ottsr_parse_day(const char *text, gint32 *days) {
+    gint32 today = ottsr_local_day(g_get_real_time() / G_USEC_PER_SEC, NULL, NULL);
+
+    if (g_strcmp0(text, "today") == 0) {
+        *days = today;
+    } else if (g_strcmp0(text, "week") == 0) {
+        // 1970-01-01 was a Thursday
+        *days = today - ((today + 3) % 7 + 7) % 7;
+    } else if (g_strcmp0(text, "month") == 0) {
+        int year, month, day;
+        ottsr_civil_from_days(today, &year, &month, &day);
+        *days = today - (day - 1);
+    } else {
+        int year, month, day;
+        char extra;
+        if (sscanf(text, "%d-%d-%d%c", &year, &month, &day, &extra) != 3) return FALSE;
+
+        GDateTime *dt = g_date_time_new_local(year, month, day, 12, 0, 0);
+        if (!dt) return FALSE;
+        *days = ottsr_local_day(g_date_time_to_unix(dt), NULL, NULL);
+        g_date_time_unref(dt);
+    }
+    return TRUE;
+}
+
+gboolean ottsr_stats_parse_by(const char *name, ottsr_stats_by_t *by) {
+    for (int i = 0; i < (int)G_N_ELEMENTS(ottsr_stats_by_names); i++) {
+        if (g_strcmp0(name, ottsr_stats_by_names[i]) == 0) {
+            *by = (ottsr_stats_by_t)i;
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+static void ottsr_stats_row_free(gpointer data) {
+    ottsr_stats_row_t *row = data;
+    g_free(row->label);
+    g_free(row);
+}
+
+// Rows keyed by their label
+GHashTable *ottsr_stats_table_new(void) {
+    return g_hash_table_new_full(g_str_hash, g_str_equal, NULL, ottsr_stats_row_free);
+}
+
+void ottsr_stats_count(GHashTable *rows, const char *label, gint32 day, guint64 seconds, guint sessions) {
+    ottsr_stats_row_t *row = g_hash_table_lookup(rows, label);
+    if (!row) {
+        row = g_new0(ottsr_stats_row_t, 1);
+        row->label = g_strdup(label);
+        row->day = day;
+        g_hash_table_insert(rows, row->label, row);
+    }
+    row->seconds += seconds;
+    row->sessions += sessions;
+}
+
+const char *ottsr_stats_label(ottsr_stats_by_t by, const char *profile, const char *subject,
+                              gint32 day, char *buffer, size_t buffer_size) {
+    switch (by) {
+        case OTTSR_STATS_BY_PROFILE:
+            return profile;
+        case OTTSR_STATS_BY_DAY:
+            ottsr_format_day(day, buffer, buffer_size);
+            return buffer;
+        default:
+            return subject[0] ? subject : "(none)";
+    }
+}
+
+static gint ottsr_stats_row_cmp(gconstpointer a, gconstpointer b, gpointer user_data) {
+    const ottsr_stats_row_t *ra = *(const ottsr_stats_row_t **)a;
+    const ottsr_stats_row_t *rb = *(const ottsr_stats_row_t **)b;
+
+    if (GPOINTER_TO_INT(user_data) == OTTSR_STATS_BY_DAY) {
+        return (ra->day > rb->day) - (ra->day < rb->day);
+    }
+    if (ra->seconds != rb->seconds) return ra->seconds < rb->seconds ? 1 : -1;
+    return g_strcmp0(ra->label, rb->label);
+}
+
+static void ottsr_stats_print_table(GPtrArray *rows, ottsr_stats_by_t by) {
+    const char *heading = ottsr_stats_by_names[by];
+    glong width = MAX(strlen(heading), strlen("Total"));
+    guint64 total_seconds = 0;
+    guint total_sessions = 0;
+
+    for (guint i = 0; i < rows->len; i++) {
+        ottsr_stats_row_t *row = g_ptr_array_index(rows, i);
+        width = MAX(width, g_utf8_strlen(row->label, -1));
+        total_seconds += row->seconds;
+        total_sessions += row->sessions;
+    }
+
+    g_print("%-*s  %10s  %8s\n", (int)width, heading, "time", "sessions");
+    for (guint i = 0; i <= rows->len; i++) {
+        const char *label = "Total";
+        guint64 seconds = total_seconds;
+        guint sessions = total_sessions;
+
+        if (i < rows->len) {
+            ottsr_stats_row_t *row = g_ptr_array_index(rows, i);
+            label = row->label;
+            seconds = row->seconds;
+            sessions = row->sessions;
+        }
+
+        // Pad by characters, not bytes, so non-ASCII subjects line up
+        int padding = (int)(width - g_utf8_strlen(label, -1));
+        char time_str[32];
+        snprintf(time_str, sizeof(time_str), "%" G_GUINT64_FORMAT "h %02" G_GUINT64_FORMAT "m",
+                 seconds / 3600, (seconds % 3600) / 60);
+        g_print("%s%*s  %10s  %8u\n", label, padding, "", time_str, sessions);
+    }
+}
+
+static void ottsr_stats_print_json(GPtrArray *rows, ottsr_stats_by_t by, const char *since, const char *until) {
+    guint64 total_seconds = 0;
+    guint total_sessions = 0;
+
+    JsonBuilder *builder = json_builder_new();
+    json_builder_begin_object(builder);
+
+    json_builder_set_member_name(builder, "since");
+    if (since) json_builder_add_string_value(builder, since); else json_builder_add_null_value(builder);
+
+    json_builder_set_member_name(builder, "until");
+    if (until) json_builder_add_string_value(builder, until); else json_builder_add_null_value(builder);
+
+    json_builder_set_member_name(builder, "by");
+    json_builder_add_string_value(builder, ottsr_stats_by_names[by]);
+
+    json_builder_set_member_name(builder, "rows");
+    json_builder_begin_array(builder);
+    for (guint i = 0; i < rows->len; i++) {
+        ottsr_stats_row_t *row = g_ptr_array_index(rows, i);
+        total_seconds += row->seconds;
+        total_sessions += row->sessions;
+
+        json_builder_begin_object(builder);
+        json_builder_set_member_name(builder, ottsr_stats_by_names[by]);
+        json_builder_add_string_value(builder, row->label);
+        json_builder_set_member_name(builder, "seconds");
+        json_builder_add_int_value(builder, row->seconds);
+        json_builder_set_member_name(builder, "sessions");
+        json_builder_add_int_value(builder, row->sessions);
+        json_builder_end_object(builder);
+    }
+    json_builder_end_array(builder);
+
+    json_builder_set_member_name(builder, "total_seconds");
+    json_builder_add_int_value(builder, total_seconds);
+    json_builder_set_member_name(builder, "total_sessions");
+    json_builder_add_int_value(builder, total_sessions);
+    json_builder_end_object(builder);
+
+    JsonGenerator *generator = json_generator_new();
+    JsonNode *root = json_builder_get_root(builder);
+    json_generator_set_root(generator, root);
+
+    char *data = json_generator_to_data(generator, NULL);
+    g_print("%s\n", data);
+
+    g_free(data);
+    g_object_unref(builder);
+    g_object_unref(generator);
+    json_node_free(root);
+}
+
+// Add archived days in [first_day, last_day] and hot records in [from, to)
+void ottsr_stats_collect(GHashTable *table, ottsr_stats_by_t by, const ottsr_rollup_t *rollup, GArray *hot,
+                         gint32 first_day, gint32 last_day, gint64 from, gint64 to) {
+    char buffer[16];
+
+    // Archived history is already summed per day
+    for (guint i = 0; i < rollup->entries->len; i++) {
+        const ottsr_rollup_entry_t *entry = &g_array_index(rollup->entries, ottsr_rollup_entry_t, i);
+        if (entry->day < first_day || entry->day > last_day) continue;
+
+        const char *label = ottsr_stats_label(by, g_ptr_array_index(rollup->strings, entry->profile),
+                                              g_ptr_array_index(rollup->strings, entry->subject),
+                                              entry->day, buffer, sizeof(buffer));
+        ottsr_stats_count(table, label, entry->day, entry->seconds, entry->sessions);
+    }
+
+    // Recent sessions, read from history.dat without the archived ones
+    for (guint i = 0; i < hot->len; i++) {
+        const ottsr_history_record_t *record = &g_array_index(hot, ottsr_history_record_t, i);
+        if (record->started_at < from || record->started_at >= to) continue;
+
+        gint32 day = by == OTTSR_STATS_BY_DAY ? ottsr_local_day(record->started_at, NULL, NULL) : 0;
+        const char *label = ottsr_stats_label(by, record->profile, record->subject, day, buffer, sizeof(buffer));
+        ottsr_stats_count(table, label, day, record->study_seconds, 1);
+    }
+}
+
+// Sorted table or JSON document of the rows; since and until may be NULL
+void ottsr_stats_print(GHashTable *table, ottsr_stats_by_t by, gboolean json,
+                       const char *since, const char *until) {
+    GPtrArray *rows = g_ptr_array_new();
+    GHashTableIter iter;
+    gpointer value;
+    g_hash_table_iter_init(&iter, table);
+    while (g_hash_table_iter_next(&iter, NULL, &value)) {
+        g_ptr_array_add(rows, value);
+    }
+    g_ptr_array_sort_with_data(rows, ottsr_stats_row_cmp, GINT_TO_POINTER(by));
+
+    if (json) {
+        ottsr_stats_print_json(rows, by, since, until);
+    } else {
+        ottsr_stats_print_table(rows, by);
+    }
+    g_ptr_array_unref(rows);
+}
+
+// `ottsr stats`: totals from the history rollup plus the hot history.
+// Runs before GtkApplication exists, so no display, CSS or D-Bus is touched.
+int ottsr_stats_main(int argc, char *argv[]) {
+    gint64 start = g_get_monotonic_time();
+    char *since = NULL, *until = NULL, *by_name = NULL;
+    gboolean json = FALSE;
+
+    GOptionEntry entries[] = {
+        { "since", 's', 0, G_OPTION_ARG_STRING, &since, "First day (YYYY-MM-DD, today, week, month)", "DAY" },
+        { "until", 'u', 0, G_OPTION_ARG_STRING, &until, "Last day, inclusive", "DAY" },
+        { "by", 'b', 0, G_OPTION_ARG_STRING, &by_name, "Group by subject, profile or day", "KEY" },
+        { "json", 'j', 0, G_OPTION_ARG_NONE, &json, "Print JSON instead of a table", NULL },
+        { NULL }
+    };
+
+    GOptionContext *context = g_option_context_new("- summarize recorded study time");
+    g_option_context_add_main_entries(context, entries, NULL);
+
+    GError *error = NULL;
+    gboolean ok = g_option_context_parse(context, &argc, &argv, &error);
+    if (!ok) {
+        g_printerr("ottsr stats: %s\n", error->message);
+        g_error_free(error);
+    }
+    g_option_context_free(context);
+
+    ottsr_stats_by_t by = OTTSR_STATS_BY_SUBJECT;
+    if (ok && by_name && !(ok = ottsr_stats_parse_by(by_name, &by))) {
+        g_printerr("ottsr stats: --by must be subject, profile or day\n");
+    }
+
+    gint32 first_day = G_MININT32, last_day = G_MAXINT32;
+    if (ok && since && !(ok = ottsr_parse_day(since, &first_day))) {
+        g_printerr("ottsr stats: invalid --since '%s'\n", since);
+    }
+    if (ok && until && !(ok = ottsr_parse_day(until, &last_day))) {
+        g_printerr("ottsr stats: invalid --until '%s'\n", until);
+    }
+
+    if (!ok) {
+        g_free(since);
+        g_free(until);
+        g_free(by_name);
+        return 1;
+    }
+
+    gint64 from = since ? ottsr_day_start(first_day) : G_MININT64;
+    gint64 to = until ? ottsr_day_start(last_day + 1) : G_MAXINT64;
+    GHashTable *table = ottsr_stats_table_new();
+
+    ottsr_rollup_t *rollup = ottsr_rollup_load();
+    GArray *hot = ottsr_history_read(rollup->archived_records);
+    ottsr_stats_collect(table, by, rollup, hot, first_day, last_day, from, to);
+    g_array_unref(hot);
+    ottsr_rollup_free(rollup);
+
+    char since_day[16], until_day[16];
+    if (since) ottsr_format_day(first_day, since_day, sizeof(since_day));
+    if (until) ottsr_format_day(last_day, until_day, sizeof(until_day));
+    ottsr_stats_print(table, by, json, since ? since_day : NULL, until ? until_day : NULL);
+
+    g_debug("Stats answered in %.2f ms", (g_get_monotonic_time() - start) / 1000.0);
+
+    g_hash_table_destroy(table);
+    g_free(since);
+    g_free(until);
+    g_free(by_name);
+    return 0;
+}
@@ -0,0 +1,398 @@
+#include "ottsr.h"
+
+#define OTTSR_TRIE_NONE G_MAXUINT32
+
+static void ottsr_subject_free(gpointer data) {
+    ottsr_subject_t *subject = data;
+    g_free(subject->subject);
+    g_free(subject->key);
+    g_free(subject);
+}
+
+static ottsr_subject_t *ottsr_subject_new(const char *text, guint32 count, gint64 last_used) {
+    ottsr_subject_t *subject = g_new0(ottsr_subject_t, 1);
+    subject->subject = g_strdup(text);
+    subject->key = g_utf8_casefold(text, -1);
+    subject->count = count;
+    subject->last_used = last_used;
+    return subject;
+}
+
+void ottsr_subject_index_free(ottsr_subject_index_t *index) {
+    if (!index) return;
+    g_hash_table_destroy(index->by_subject);
+    g_ptr_array_unref(index->ranked);
+    g_array_unref(index->nodes);
+    g_free(index);
+}
+
+static char *ottsr_subjects_path(void) {
+    char *config_dir = ottsr_get_config_path();
+    if (!config_dir) return NULL;
+
+    char *path = g_build_filename(config_dir, OTTSR_SUBJECTS_FILE, NULL);
+    g_free(config_dir);
+    return path;
+}
+
+// Frequency decayed by age, so last week's subjects beat last year's
+static double ottsr_subject_score(const ottsr_subject_t *subject, gint64 now) {
+    double age_days = MAX(0, now - subject->last_used) / 86400.0;
+    return subject->count / (1.0 + age_days / OTTSR_SUBJECT_HALF_LIFE_DAYS);
+}
+
+static gint ottsr_subject_rank_cmp(gconstpointer a, gconstpointer b) {
+    const ottsr_subject_t *sa = *(ottsr_subject_t * const *)a;
+    const ottsr_subject_t *sb = *(ottsr_subject_t * const *)b;
+    if (sa->score > sb->score) return -1;
+    if (sa->score < sb->score) return 1;
+    return strcmp(sa->key, sb->key);
+}
+
+static guint32 ottsr_trie_child(GArray *nodes, guint32 parent, guint8 byte, gboolean create) {
+    ottsr_trie_node_t *node = &g_array_index(nodes, ottsr_trie_node_t, parent);
+
+    for (guint32 child = node->first_child; child != OTTSR_TRIE_NONE;
+         child = g_array_index(nodes, ottsr_trie_node_t, child).next_sibling) {
+        if (g_array_index(nodes, ottsr_trie_node_t, child).byte == byte) return child;
+    }
+    if (!create) return OTTSR_TRIE_NONE;
+
+    ottsr_trie_node_t fresh = {0};
+    fresh.first_child = OTTSR_TRIE_NONE;
+    fresh.next_sibling = node->first_child;
+    fresh.byte = byte;
+    g_array_append_val(nodes, fresh);
+
+    guint32 index = nodes->len - 1;
+    g_array_index(nodes, ottsr_trie_node_t, parent).first_child = index;
+    return index;
+}
+
+// Rank subjects, then insert them best-first into a byte trie. Because of
+// the insertion order each node's top list is exactly its best K completions,
+// so a lookup never has to look below the node it lands on.
+ottsr_subject_index_t *ottsr_subject_index_build(GPtrArray *subjects) {
+    ottsr_subject_index_t *index = g_new0(ottsr_subject_index_t, 1);
+    index->ranked = subjects;
+    index->by_subject = g_hash_table_new(g_str_hash, g_str_equal);
+    index->nodes = g_array_new(FALSE, FALSE, sizeof(ottsr_trie_node_t));
+
+    gint64 now = g_get_real_time() / G_USEC_PER_SEC;
+    for (guint i = 0; i < subjects->len; i++) {
+        ottsr_subject_t *subject = g_ptr_array_index(subjects, i);
+        subject->score = ottsr_subject_score(subject, now);
+    }
+    g_ptr_array_sort(subjects, ottsr_subject_rank_cmp);
+
+    ottsr_trie_node_t root = {0};
+    root.first_child = OTTSR_TRIE_NONE;
+    root.next_sibling = OTTSR_TRIE_NONE;
+    g_array_append_val(index->nodes, root);
+
+    for (guint i = 0; i < subjects->len; i++) {
+        ottsr_subject_t *subject = g_ptr_array_index(subjects, i);
+        g_hash_table_insert(index->by_subject, subject->subject, subject);
+
+        guint32 node = 0;
+        for (int depth = 0; ; depth++) {
+            ottsr_trie_node_t *n = &g_array_index(index->nodes, ottsr_trie_node_t, node);
+            if (n->top_count < OTTSR_SUBJECT_TOP_K) {
+                n->top[n->top_count++] = i;
+            }
+            if (depth >= OTTSR_SUBJECT_INDEX_DEPTH || subject->key[depth] == '\0') break;
+            node = ottsr_trie_child(index->nodes, node, (guint8)subject->key[depth], TRUE);
+        }
+    }
+
+    return index;
+}
+
+// Parse subjects.tsv: "count<TAB>last_used<TAB>subject" lines, summed per
+// subject. Usage is appended one line at a time, so compact it when it grows.
+static GPtrArray *ottsr_subjects_read(const char *path) {
+    GPtrArray *subjects = g_ptr_array_new_with_free_func(ottsr_subject_free);
+    GHashTable *seen = g_hash_table_new(g_str_hash, g_str_equal);
+    char *contents = NULL;
+    guint lines = 0;
+
+    if (path && g_file_get_contents(path, &contents, NULL, NULL)) {
+        char *saveptr = NULL;
+        for (char *line = strtok_r(contents, "\n", &saveptr); line;
+             line = strtok_r(NULL, "\n", &saveptr)) {
+            char *fields[3];
+            int n = 0;
+            for (char *p = line; n < 3; n++) {
+                fields[n] = p;
+                p = (n < 2) ? strchr(p, '\t') : NULL;
+                if (n < 2) {
+                    if (!p) break;
+                    *p++ = '\0';
+                }
+            }
+            if (n < 3 || !*fields[2]) continue;
+            lines++;
+
+            guint32 count = (guint32)g_ascii_strtoull(fields[0], NULL, 10);
+            gint64 last_used = g_ascii_strtoll(fields[1], NULL, 10);
+            ottsr_subject_t *subject = g_hash_table_lookup(seen, fields[2]);
+
+            if (subject) {
+                subject->count += count;
+                subject->last_used = MAX(subject->last_used, last_used);
+            } else {
+                subject = ottsr_subject_new(fields[2], count, last_used);
+                g_ptr_array_add(subjects, subject);
+                g_hash_table_insert(seen, subject->subject, subject);
+            }
+        }
+        g_free(contents);
+    }
+    g_hash_table_destroy(seen);
+
+    if (path && lines > subjects->len * 2 + 64) {
+        GString *out = g_string_new(NULL);
+        for (guint i = 0; i < subjects->len; i++) {
+            ottsr_subject_t *subject = g_ptr_array_index(subjects, i);
+            g_string_append_printf(out, "%u\t%" G_GINT64_FORMAT "\t%s\n",
+                                   subject->count, subject->last_used, subject->subject);
+        }
+        g_file_set_contents(path, out->str, out->len, NULL);
+        g_string_free(out, TRUE);
+    }
+
+    return subjects;
+}
+
+static void ottsr_subjects_load_thread(GTask *task, gpointer source, gpointer task_data,
+                                       GCancellable *cancellable) {
+    GPtrArray *subjects = task_data;
+
+    if (!subjects) {
+        char *path = ottsr_subjects_path();
+        subjects = ottsr_subjects_read(path);
+        g_free(path);
+    } else {
+        g_ptr_array_ref(subjects);
+    }
+
+    g_task_return_pointer(task, ottsr_subject_index_build(subjects),
+                          (GDestroyNotify)ottsr_subject_index_free);
+}
+
+static void ottsr_subjects_index_start(ottsr_app_t *app, GPtrArray *subjects);
+static void ottsr_subjects_count(ottsr_subject_index_t *index, const char *text);
+static void ottsr_subjects_append(const char *text);
+
+static void ottsr_subjects_load_done(GObject *source, GAsyncResult *result, gpointer user_data) {
+    ottsr_app_t *app = (ottsr_app_t *)user_data;
+    ottsr_subject_index_t *index = g_task_propagate_pointer(G_TASK(result), NULL);
+
+    // Cancelled because a kiosk switched user; a build for the new one is running
+    if (!index) return;
+    app->subjects_building = FALSE;
+
+    // Uses recorded before the first load have not been written out yet
+    gboolean initial = app->subjects == NULL;
+
+    ottsr_subject_index_free(app->subjects);
+    app->subjects = index;
+    app->subject_prefix[0] = '\0';
+    app->subject_cursor = 0;
+
+    // Usage recorded while this index was being built goes in now
+    gboolean stale = app->pending_subjects->len > 0;
+    for (guint i = 0; i < app->pending_subjects->len; i++) {
+        const char *text = g_ptr_array_index(app->pending_subjects, i);
+        if (initial) ottsr_subjects_append(text);
+        ottsr_subjects_count(index, text);
+    }
+    g_ptr_array_set_size(app->pending_subjects, 0);
+
+    g_debug("Subject index ready: %u subjects, %u nodes", index->ranked->len, index->nodes->len);
+    if (stale) ottsr_subjects_refresh(app);
+}
+
+static void ottsr_subjects_index_start(ottsr_app_t *app, GPtrArray *subjects) {
+    app->subjects_building = TRUE;
+
+    GTask *task = g_task_new(NULL, app->user_cancel, ottsr_subjects_load_done, app);
+    g_task_set_task_data(task, subjects, subjects ? (GDestroyNotify)g_ptr_array_unref : NULL);
+    g_task_run_in_thread(task, ottsr_subjects_load_thread);
+    g_object_unref(task);
+}
+
+// Load history and build the index in the background after startup
+void ottsr_subjects_load_async(ottsr_app_t *app) {
+    if (!app->pending_subjects) {
+        app->pending_subjects = g_ptr_array_new_with_free_func(g_free);
+    }
+    ottsr_subjects_index_start(app, NULL);
+}
+
+// Re-rank in the background from a copy of the current history
+void ottsr_subjects_refresh(ottsr_app_t *app) {
+    if (!app->subjects || app->subjects_building) return;
+
+    GPtrArray *copy = g_ptr_array_new_with_free_func(ottsr_subject_free);
+    for (guint i = 0; i < app->subjects->ranked->len; i++) {
+        ottsr_subject_t *subject = g_ptr_array_index(app->subjects->ranked, i);
+        g_ptr_array_add(copy, ottsr_subject_new(subject->subject, subject->count, subject->last_used));
+    }
+    ottsr_subjects_index_start(app, copy);
+}
+
+static gboolean ottsr_subjects_refresh_due(gpointer user_data) {
+    ottsr_app_t *app = (ottsr_app_t *)user_data;
+    app->subjects_refresh_id = 0;
+    ottsr_subjects_refresh(app);
+    return G_SOURCE_REMOVE;
+}
+
+// Drop the index, e.g. on quit or when a kiosk switches user
+void ottsr_subjects_clear(ottsr_app_t *app) {
+    if (app->subjects_refresh_id > 0) {
+        g_source_remove(app->subjects_refresh_id);
+        app->subjects_refresh_id = 0;
+    }
+    ottsr_subject_index_free(app->subjects);
+    app->subjects = NULL;
+    app->subjects_building = FALSE;
+    if (app->pending_subjects) g_ptr_array_set_size(app->pending_subjects, 0);
+}
+
+static void ottsr_subjects_count(ottsr_subject_index_t *index, const char *text) {
+    gint64 now = g_get_real_time() / G_USEC_PER_SEC;
+    ottsr_subject_t *subject = g_hash_table_lookup(index->by_subject, text);
+
+    if (subject) {
+        subject->count++;
+        subject->last_used = now;
+    } else {
+        // Not reachable from the trie until the refresh that recording schedules
+        subject = ottsr_subject_new(text, 1, now);
+        g_ptr_array_add(index->ranked, subject);
+        g_hash_table_insert(index->by_subject, subject->subject, subject);
+    }
+}
+
+static void ottsr_subjects_append(const char *text) {
+    char *path = ottsr_subjects_path();
+    FILE *file = path ? fopen(path, "a") : NULL;
+    if (file) {
+        fprintf(file, "1\t%" G_GINT64_FORMAT "\t%s\n", g_get_real_time() / G_USEC_PER_SEC, text);
+        fclose(file);
+    }
+    g_free(path);
+}
+
+// Count one use of a subject and append it to the history file
+void ottsr_subjects_record(ottsr_app_t *app, const char *text) {
+    if (!text || !*text || strchr(text, '\n') || strchr(text, '\t')) return;
+    if (!app->pending_subjects) return;
+
+    // Still loading: written out once the history file has been read
+    if (!app->subjects) {
+        g_ptr_array_add(app->pending_subjects, g_strdup(text));
+        return;
+    }
+
+    ottsr_subjects_append(text);
+    ottsr_subjects_count(app->subjects, text);
+
+    // A rebuild in flight works from an older copy; replay this on top of it
+    if (app->subjects_building) {
+        g_ptr_array_add(app->pending_subjects, g_strdup(text));
+    }
+
+    // Re-rank shortly, so a new subject becomes completable; uses recorded
+    // close together share one rebuild
+    if (app->subjects_refresh_id == 0) {
+        app->subjects_refresh_id = g_timeout_add_seconds(OTTSR_SUBJECTS_REFRESH_DELAY,
+                                                         ottsr_subjects_refresh_due, app);
+    }
+}
+
+// Top completions for a prefix. Typing one more character costs one step
+// down the trie from where the previous keystroke ended.
+guint ottsr_subjects_complete(ottsr_app_t *app, const char *text,
+                              const ottsr_subject_t **results, guint max_results) {
+    ottsr_subject_index_t *index = app->subjects;
+    if (!index || !text || !*text) return 0;
+
+    char *key = g_utf8_casefold(text, -1);
+    gsize key_len = strlen(key);
+    gsize indexed_len = MIN(key_len, OTTSR_SUBJECT_INDEX_DEPTH);
+    gsize prev_len = strlen(app->subject_prefix);
+
+    guint32 node = 0;
+    gsize depth = 0;
+    if (prev_len > 0 && prev_len <= indexed_len && strncmp(app->subject_prefix, key, prev_len) == 0) {
+        node = app->subject_cursor;
+        depth = prev_len;
+    }
+
+    for (; depth < indexed_len && node != OTTSR_TRIE_NONE; depth++) {
+        node = ottsr_trie_child(index->nodes, node, (guint8)key[depth], FALSE);
+    }
+
+    guint count = 0;
+    if (node != OTTSR_TRIE_NONE) {
+        g_strlcpy(app->subject_prefix, key, indexed_len + 1);
+        app->subject_cursor = node;
+
+        const ottsr_trie_node_t *n = &g_array_index(index->nodes, ottsr_trie_node_t, node);
+        for (guint i = 0; i < n->top_count && count < max_results; i++) {
+            const ottsr_subject_t *subject = g_ptr_array_index(index->ranked, n->top[i]);
+            // Past the indexed depth the trie can only narrow; check the rest here
+            if (key_len > indexed_len && strncmp(subject->key, key, key_len) != 0) continue;
+            results[count++] = subject;
+        }
+    } else {
+        app->subject_prefix[0] = '\0';
+    }
+
+    g_free(key);
+    return count;
+}
+
+static gboolean ottsr_subjects_match_all(GtkEntryCompletion *completion, const gchar *key,
+                                         GtkTreeIter *iter, gpointer user_data) {
+    return TRUE;
+}
+
+void ottsr_subjects_attach(ottsr_app_t *app, GtkWidget *entry) {
+    app->subject_store = gtk_list_store_new(1, G_TYPE_STRING);
+
+    GtkEntryCompletion *completion = gtk_entry_completion_new();
+    gtk_entry_completion_set_model(completion, GTK_TREE_MODEL(app->subject_store));
+    gtk_entry_completion_set_text_column(completion, 0);
+    gtk_entry_completion_set_match_func(completion, ottsr_subjects_match_all, NULL, NULL);
+    gtk_entry_completion_set_minimum_key_length(completion, 1);
+    gtk_entry_set_completion(GTK_ENTRY(entry), completion);
+    g_object_unref(completion);
+}
+
+// Keep the completion popup in step with the entry
+void ottsr_subjects_update_completion(ottsr_app_t *app, GtkEntry *entry) {
+    if (!app->subject_store) return;
+
+    const char *text = gtk_entry_get_text(entry);
+    const ottsr_subject_t *results[OTTSR_SUBJECT_TOP_K];
+    guint count = ottsr_subjects_complete(app, text, results, OTTSR_SUBJECT_TOP_K);
+
+    gtk_list_store_clear(app->subject_store);
+
+    // Nothing to offer once the entry already holds the only candidate
+    if (count == 1 && strcmp(results[0]->subject, text) == 0) return;
+
+    for (guint i = 0; i < count; i++) {
+        GtkTreeIter iter;
+        gtk_list_store_append(app->subject_store, &iter);
+        gtk_list_store_set(app->subject_store, &iter, 0, results[i]->subject, -1);
+    }
+
+    if (count > 0) {
+        gtk_entry_completion_complete(gtk_entry_get_completion(entry));
+    }
+}
@@ -0,0 +1,510 @@
+#include "ottsr.h"
+#include <math.h>
+
+// Pixels per day at each zoom step: several years at the bottom, one day at the top
+static const double ottsr_zoom_ppd[OTTSR_TIMELINE_ZOOM_STEPS] = {
+    0.125, 0.25, 0.5, 1, 2, 4, 8, 16, 32, 64, 128, 256
+};
+
+#define OTTSR_TILE_KEY(zoom, tile) (((gint64)(zoom) << 40) | (gint64)(tile))
+#define OTTSR_TILE_MASK ((G_GINT64_CONSTANT(1) << 40) - 1)
+
+// Days since 1970-01-01 for a civil date
+gint32 ottsr_days_from_civil(int year, int month, int day) {
+    year -= month <= 2;
+    int era = (year >= 0 ? year : year - 399) / 400;
+    int yoe = year - era * 400;
+    int doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+// Local calendar day of a timestamp, optionally with its month index
+// (year * 12 + month - 1) and the seconds since local midnight
+gint32 ottsr_local_day(gint64 timestamp, gint32 *month_index, int *seconds) {
+    GDateTime *dt = g_date_time_new_from_unix_local(timestamp);
+    int year, month, day;
+    g_date_time_get_ymd(dt, &year, &month, &day);
+
+    if (month_index) *month_index = year * 12 + month - 1;
+    if (seconds) {
+        *seconds = g_date_time_get_hour(dt) * 3600 + g_date_time_get_minute(dt) * 60 +
+                   g_date_time_get_second(dt);
+    }
+    g_date_time_unref(dt);
+    return ottsr_days_from_civil(year, month, day);
+}
+
+static gint32 ottsr_month_start(gint32 month_index) {
+    return ottsr_days_from_civil(month_index / 12, month_index % 12 + 1, 1);
+}
+
+static ottsr_lod_t ottsr_timeline_lod(int zoom) {
+    double ppd = ottsr_zoom_ppd[zoom];
+    if (ppd < 1) return OTTSR_LOD_MONTH;
+    if (ppd < 4) return OTTSR_LOD_WEEK;
+    if (ppd < 64) return OTTSR_LOD_DAY;
+    return OTTSR_LOD_SESSION;
+}
+
+static guint32 ottsr_timeline_bucket(const ottsr_timeline_t *timeline, ottsr_lod_t lod, gint64 index) {
+    GArray *buckets = timeline->levels[lod].buckets;
+    if (index < 0 || index >= buckets->len) return 0;
+    return g_array_index(buckets, guint32, index);
+}
+
+static gint ottsr_record_cmp(gconstpointer a, gconstpointer b) {
+    gint64 ta = ((const ottsr_history_record_t *)a)->started_at;
+    gint64 tb = ((const ottsr_history_record_t *)b)->started_at;
+    return (ta > tb) - (ta < tb);
+}
+
+// First record starting at or after the given time
+static guint ottsr_timeline_lower_bound(const ottsr_timeline_t *timeline, gint64 timestamp) {
+    guint lo = 0, hi = timeline->records->len;
+    while (lo < hi) {
+        guint mid = lo + (hi - lo) / 2;
+        if (g_array_index(timeline->records, ottsr_history_record_t, mid).started_at < timestamp) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+// Add seconds to the day, week and month containing a day. Returns a bit
+// per level whose maximum grew, since that rescales the whole level.
+static guint ottsr_timeline_accumulate(ottsr_timeline_t *timeline, gint32 day, gint32 month,
+                                       guint32 seconds) {
+    gint32 index[3] = { day, day / 7, month };
+    guint changed = 0;
+
+    for (int lod = OTTSR_LOD_DAY; lod <= OTTSR_LOD_MONTH; lod++) {
+        ottsr_timeline_level_t *level = &timeline->levels[lod];
+        if ((guint)index[lod] >= level->buckets->len) {
+            g_array_set_size(level->buckets, index[lod] + 1);
+        }
+
+        guint32 *value = &g_array_index(level->buckets, guint32, index[lod]);
+        *value += seconds;
+        if (*value > level->max) {
+            level->max = *value;
+            changed |= 1u << lod;
+        }
+    }
+    return changed;
+}
+
+// Rebuild all levels from the records
+static void ottsr_timeline_index(ottsr_timeline_t *timeline) {
+    g_array_sort(timeline->records, ottsr_record_cmp);
+
+    for (int lod = OTTSR_LOD_DAY; lod <= OTTSR_LOD_MONTH; lod++) {
+        g_array_set_size(timeline->levels[lod].buckets, 0);
+        timeline->levels[lod].max = 0;
+    }
+
+    gint64 now = g_get_real_time() / G_USEC_PER_SEC;
+    gint64 first = timeline->records->len > 0 ?
+        g_array_index(timeline->records, ottsr_history_record_t, 0).started_at : now;
+
+    // Columns are weeks, so start on a Monday (1970-01-01 was a Thursday)
+    gint32 first_day = ottsr_local_day(first, &timeline->first_month, NULL);
+    timeline->first_day = first_day - (first_day + 3) % 7;
+
+    for (guint i = 0; i < timeline->records->len; i++) {
+        const ottsr_history_record_t *record = &g_array_index(timeline->records, ottsr_history_record_t, i);
+        gint32 month;
+        gint32 day = ottsr_local_day(record->started_at, &month, NULL);
+        ottsr_timeline_accumulate(timeline, day - timeline->first_day,
+                                  month - timeline->first_month, record->study_seconds);
+    }
+
+    // Reach the present even after a quiet stretch
+    gint32 month;
+    gint32 today = ottsr_local_day(now, &month, NULL);
+    if (today >= timeline->first_day) {
+        ottsr_timeline_accumulate(timeline, today - timeline->first_day, month - timeline->first_month, 0);
+    }
+}
+
+// Takes ownership of records
+ottsr_timeline_t *ottsr_timeline_build(GArray *records) {
+    ottsr_timeline_t *timeline = g_new0(ottsr_timeline_t, 1);
+    timeline->records = records;
+    timeline->zoom = OTTSR_TIMELINE_DEFAULT_ZOOM;
+    timeline->tiles = g_hash_table_new_full(g_int64_hash, g_int64_equal, g_free,
+                                            (GDestroyNotify)cairo_surface_destroy);
+
+    for (int lod = OTTSR_LOD_DAY; lod <= OTTSR_LOD_MONTH; lod++) {
+        timeline->levels[lod].buckets = g_array_new(FALSE, TRUE, sizeof(guint32));
+    }
+
+    ottsr_timeline_index(timeline);
+    return timeline;
+}
+
+void ottsr_timeline_free(ottsr_timeline_t *timeline) {
+    if (!timeline) return;
+
+    g_hash_table_destroy(timeline->tiles);
+    for (int lod = OTTSR_LOD_DAY; lod <= OTTSR_LOD_MONTH; lod++) {
+        g_array_unref(timeline->levels[lod].buckets);
+    }
+    g_array_unref(timeline->records);
+    g_free(timeline);
+}
+
+typedef struct {
+    gint64 first_tile[OTTSR_TIMELINE_ZOOM_STEPS];
+    gint64 last_tile[OTTSR_TIMELINE_ZOOM_STEPS];
+    gboolean all[OTTSR_TIMELINE_ZOOM_STEPS];
+} ottsr_tile_ranges_t;
+
+static gboolean ottsr_tile_in_range(gpointer key, gpointer value, gpointer user_data) {
+    const ottsr_tile_ranges_t *ranges = user_data;
+    gint64 packed = *(gint64 *)key;
+    int zoom = (int)(packed >> 40);
+    gint64 tile = packed & OTTSR_TILE_MASK;
+
+    return ranges->all[zoom] ||
+           (tile >= ranges->first_tile[zoom] && tile <= ranges->last_tile[zoom]);
+}
+
+// Drop only the cached tiles, at every zoom, that show the bucket a new
+// session landed in. A new maximum recolours its whole level.
+static void ottsr_timeline_invalidate(ottsr_timeline_t *timeline, gint32 day, gint32 month, guint changed) {
+    ottsr_tile_ranges_t ranges;
+
+    for (int zoom = 0; zoom < OTTSR_TIMELINE_ZOOM_STEPS; zoom++) {
+        ottsr_lod_t lod = ottsr_timeline_lod(zoom);
+        ottsr_lod_t level = lod == OTTSR_LOD_SESSION ? OTTSR_LOD_DAY : lod;
+        double ppd = ottsr_zoom_ppd[zoom];
+        gint32 first, last;
+
+        if (lod == OTTSR_LOD_MONTH) {
+            first = ottsr_month_start(timeline->first_month + month) - timeline->first_day;
+            last = ottsr_month_start(timeline->first_month + month + 1) - timeline->first_day;
+        } else {
+            // Day cells share their week's column
+            first = day - day % 7;
+            last = first + 7;
+        }
+
+        ranges.first_tile[zoom] = (gint64)floor(first * ppd / OTTSR_TIMELINE_TILE_WIDTH);
+        ranges.last_tile[zoom] = (gint64)floor(last * ppd / OTTSR_TIMELINE_TILE_WIDTH);
+        ranges.all[zoom] = (changed & (1u << level)) != 0;
+    }
+
+    g_hash_table_foreach_remove(timeline->tiles, ottsr_tile_in_range, &ranges);
+}
+
+// Fold a newly recorded session into the levels
+void ottsr_timeline_add(ottsr_timeline_t *timeline, const ottsr_history_record_t *record) {
+    gint32 month;
+    gint32 day = ottsr_local_day(record->started_at, &month, NULL);
+
+    // Keep start order for the session view's binary search
+    guint position = ottsr_timeline_lower_bound(timeline, record->started_at + 1);
+    g_array_insert_val(timeline->records, position, *record);
+
+    if (day < timeline->first_day || month < timeline->first_month) {
+        // Earlier than anything indexed (clock change); the origin moves
+        ottsr_timeline_index(timeline);
+        g_hash_table_remove_all(timeline->tiles);
+    } else {
+        gint32 rel_day = day - timeline->first_day;
+        gint32 rel_month = month - timeline->first_month;
+        guint changed = ottsr_timeline_accumulate(timeline, rel_day, rel_month, record->study_seconds);
+        ottsr_timeline_invalidate(timeline, rel_day, rel_month, changed);
+    }
+
+    if (timeline->area) {
+        gtk_widget_queue_draw(timeline->area);
+    }
+}
+
+// Light grey for nothing, shading towards the accent purple (#764ba2)
+static void ottsr_timeline_heat(cairo_t *cr, guint32 value, guint32 max) {
+    if (value == 0 || max == 0) {
+        cairo_set_source_rgb(cr, 0.92, 0.93, 0.94);
+        return;
+    }
+    double t = 0.25 + 0.75 * (double)value / max;
+    cairo_set_source_rgb(cr, 0.92 - 0.46 * t, 0.93 - 0.64 * t, 0.94 - 0.30 * t);
+}
+
+static void ottsr_timeline_bar(cairo_t *cr, double x, double width, int height,
+                               guint32 value, guint32 max) {
+    double gap = width > 3 ? 1 : 0;
+    double bar = max > 0 ? (height - 4) * (double)value / max : 0;
+
+    ottsr_timeline_heat(cr, 0, 0);
+    cairo_rectangle(cr, x + gap, 0, MAX(1, width - 2 * gap), height);
+    cairo_fill(cr);
+
+    ottsr_timeline_heat(cr, value, max);
+    cairo_rectangle(cr, x + gap, height - bar, MAX(1, width - 2 * gap), bar);
+    cairo_fill(cr);
+}
+
+// Individual sessions placed by time of day inside their day cell
+static void ottsr_timeline_draw_sessions(ottsr_timeline_t *timeline, cairo_t *cr, gint32 first_day,
+                                         gint32 last_day, double column, double row) {
+    // A day of slack on each side covers any UTC offset
+    gint64 from = (gint64)(timeline->first_day + first_day - 1) * 86400;
+    guint i = ottsr_timeline_lower_bound(timeline, from);
+
+    for (; i < timeline->records->len; i++) {
+        const ottsr_history_record_t *record = &g_array_index(timeline->records, ottsr_history_record_t, i);
+        int seconds;
+        gint32 day = ottsr_local_day(record->started_at, NULL, &seconds) - timeline->first_day;
+
+        if (day >= last_day) break;
+        if (day < first_day) continue;
+
+        double x = (day / 7) * column + seconds / 86400.0 * column;
+        double width = MAX(1, record->study_seconds / 86400.0 * column);
+
+        if (record->completed) {
+            cairo_set_source_rgb(cr, 0.46, 0.29, 0.64);
+        } else {
+            cairo_set_source_rgb(cr, 0.70, 0.58, 0.82);
+        }
+        cairo_rectangle(cr, x, (day % 7) * row + 3, width, row - 6);
+        cairo_fill(cr);
+    }
+}
+
+static cairo_surface_t *ottsr_timeline_render_tile(ottsr_timeline_t *timeline, int zoom, gint64 tile) {
+    int height = timeline->tile_height;
+    double ppd = ottsr_zoom_ppd[zoom];
+    ottsr_lod_t lod = ottsr_timeline_lod(zoom);
+    double x0 = (double)tile * OTTSR_TIMELINE_TILE_WIDTH;
+    gint32 first_day = (gint32)floor(x0 / ppd);
+    gint32 last_day = (gint32)ceil((x0 + OTTSR_TIMELINE_TILE_WIDTH) / ppd);
+
+    cairo_surface_t *surface = cairo_image_surface_create(CAIRO_FORMAT_RGB24,
+                                                          OTTSR_TIMELINE_TILE_WIDTH, height);
+    cairo_t *cr = cairo_create(surface);
+    cairo_set_source_rgb(cr, 1, 1, 1);
+    cairo_paint(cr);
+    cairo_translate(cr, -x0, 0);
+
+    if (lod == OTTSR_LOD_MONTH) {
+        const ottsr_timeline_level_t *level = &timeline->levels[OTTSR_LOD_MONTH];
+        for (guint i = 0; i < level->buckets->len; i++) {
+            gint32 start = ottsr_month_start(timeline->first_month + i) - timeline->first_day;
+            gint32 end = ottsr_month_start(timeline->first_month + i + 1) - timeline->first_day;
+            if (end <= first_day || start >= last_day) continue;
+
+            ottsr_timeline_bar(cr, start * ppd, (end - start) * ppd, height,
+                               g_array_index(level->buckets, guint32, i), level->max);
+        }
+    } else if (lod == OTTSR_LOD_WEEK) {
+        const ottsr_timeline_level_t *level = &timeline->levels[OTTSR_LOD_WEEK];
+        for (gint32 week = first_day / 7; week <= last_day / 7; week++) {
+            ottsr_timeline_bar(cr, week * 7 * ppd, 7 * ppd, height,
+                               ottsr_timeline_bucket(timeline, OTTSR_LOD_WEEK, week), level->max);
+        }
+    } else {
+        // Calendar heatmap: a column per week, a row per weekday
+        const ottsr_timeline_level_t *level = &timeline->levels[OTTSR_LOD_DAY];
+        double column = 7 * ppd;
+        double row = height / 7.0;
+        gint32 first_week = first_day / 7;
+        gint32 last_week = last_day / 7;
+
+        for (gint32 week = first_week; week <= last_week; week++) {
+            for (int weekday = 0; weekday < 7; weekday++) {
+                guint32 value = ottsr_timeline_bucket(timeline, OTTSR_LOD_DAY, week * 7 + weekday);
+                ottsr_timeline_heat(cr, lod == OTTSR_LOD_SESSION ? 0 : value, level->max);
+                cairo_rectangle(cr, week * column + 1, weekday * row + 1, column - 2, row - 2);
+                cairo_fill(cr);
+            }
+        }
+
+        if (lod == OTTSR_LOD_SESSION) {
+            ottsr_timeline_draw_sessions(timeline, cr, first_week * 7, (last_week + 1) * 7, column, row);
+        }
+    }
+
+    cairo_destroy(cr);
+    return surface;
+}
+
+// Date at the left edge and the level being shown
+static void ottsr_timeline_draw_caption(ottsr_timeline_t *timeline, cairo_t *cr) {
+    static const char *lod_names[] = { "days", "weeks", "months", "sessions" };
+    gint64 day = timeline->first_day + (gint64)floor(MAX(0, timeline->origin));
+
+    GDateTime *dt = g_date_time_new_from_unix_utc(day * 86400);
+    char *date = g_date_time_format(dt, "%e %b %Y");
+    char *caption = g_strdup_printf("%s · %s", g_strstrip(date), lod_names[ottsr_timeline_lod(timeline->zoom)]);
+    g_date_time_unref(dt);
+
+    cairo_text_extents_t extents;
+    cairo_set_font_size(cr, 12);
+    cairo_text_extents(cr, caption, &extents);
+
+    cairo_set_source_rgba(cr, 1, 1, 1, 0.85);
+    cairo_rectangle(cr, 4, 4, extents.width + 12, 20);
+    cairo_fill(cr);
+    cairo_set_source_rgb(cr, 0.17, 0.24, 0.31);
+    cairo_move_to(cr, 10, 18);
+    cairo_show_text(cr, caption);
+
+    g_free(caption);
+    g_free(date);
+}
+
+static gboolean on_timeline_draw(GtkWidget *widget, cairo_t *cr, ottsr_timeline_t *timeline) {
+    int width = gtk_widget_get_allocated_width(widget);
+    int height = gtk_widget_get_allocated_height(widget);
+    double ppd = ottsr_zoom_ppd[timeline->zoom];
+    double span = timeline->levels[OTTSR_LOD_DAY].buckets->len;
+
+    if (height != timeline->tile_height) {
+        g_hash_table_remove_all(timeline->tiles);
+        timeline->tile_height = height;
+    }
+
+    // Open on the most recent weeks
+    if (!timeline->placed) {
+        timeline->origin = span - width / ppd;
+        timeline->placed = TRUE;
+    }
+    timeline->origin = CLAMP(timeline->origin, 0, MAX(0, span + 7 - width / ppd));
+
+    gint64 offset = (gint64)floor(timeline->origin * ppd);
+    gint64 first_tile = offset / OTTSR_TIMELINE_TILE_WIDTH;
+    gint64 last_tile = (offset + width) / OTTSR_TIMELINE_TILE_WIDTH;
+
+    for (gint64 tile = first_tile; tile <= last_tile; tile++) {
+        gint64 key = OTTSR_TILE_KEY(timeline->zoom, tile);
+        cairo_surface_t *surface = g_hash_table_lookup(timeline->tiles, &key);
+
+        if (!surface) {
+            if (g_hash_table_size(timeline->tiles) >= OTTSR_TIMELINE_MAX_TILES) {
+                g_hash_table_remove_all(timeline->tiles);
+            }
+            surface = ottsr_timeline_render_tile(timeline, timeline->zoom, tile);
+            gint64 *stored = g_new(gint64, 1);
+            *stored = key;
+            g_hash_table_insert(timeline->tiles, stored, surface);
+        }
+
+        cairo_set_source_surface(cr, surface, (double)(tile * OTTSR_TIMELINE_TILE_WIDTH - offset), 0);
+        cairo_paint(cr);
+    }
+
+    ottsr_timeline_draw_caption(timeline, cr);
+    return FALSE;
+}
+
+static void ottsr_timeline_pan(ottsr_timeline_t *timeline, GtkWidget *widget, double pixels) {
+    timeline->origin += pixels / ottsr_zoom_ppd[timeline->zoom];
+    gtk_widget_queue_draw(widget);
+}
+
+// Wheel zooms around the pointer; Shift+wheel or a horizontal wheel pans
+static gboolean on_timeline_scroll(GtkWidget *widget, GdkEventScroll *event, ottsr_timeline_t *timeline) {
+    int width = gtk_widget_get_allocated_width(widget);
+
+    switch (event->direction) {
+        case GDK_SCROLL_UP:
+        case GDK_SCROLL_DOWN: {
+            int step = event->direction == GDK_SCROLL_UP ? 1 : -1;
+            if (event->state & GDK_SHIFT_MASK) {
+                ottsr_timeline_pan(timeline, widget, -step * width / 4.0);
+                break;
+            }
+
+            int zoom = CLAMP(timeline->zoom + step, 0, OTTSR_TIMELINE_ZOOM_STEPS - 1);
+            double anchor = timeline->origin + event->x / ottsr_zoom_ppd[timeline->zoom];
+            timeline->zoom = zoom;
+            timeline->origin = anchor - event->x / ottsr_zoom_ppd[zoom];
+            gtk_widget_queue_draw(widget);
+            break;
+        }
+        case GDK_SCROLL_LEFT:
+            ottsr_timeline_pan(timeline, widget, -width / 4.0);
+            break;
+        case GDK_SCROLL_RIGHT:
+            ottsr_timeline_pan(timeline, widget, width / 4.0);
+            break;
+        default:
+            return FALSE;
+    }
+    return TRUE;
+}
+
+static gboolean on_timeline_button_press(GtkWidget *widget, GdkEventButton *event, ottsr_timeline_t *timeline) {
+    if (event->button != 1) return FALSE;
+
+    timeline->drag_x = event->x;
+    timeline->drag_origin = timeline->origin;
+    return TRUE;
+}
+
+static gboolean on_timeline_motion(GtkWidget *widget, GdkEventMotion *event, ottsr_timeline_t *timeline) {
+    if (!(event->state & GDK_BUTTON1_MASK)) return FALSE;
+
+    timeline->origin = timeline->drag_origin - (event->x - timeline->drag_x) / ottsr_zoom_ppd[timeline->zoom];
+    gtk_widget_queue_draw(widget);
+    return TRUE;
+}
+
+static void on_timeline_window_destroy(GtkWidget *widget, ottsr_app_t *app) {
+    app->timeline_window = NULL;
+
+    // The levels stay for the next open; the rendered tiles do not
+    if (app->timeline) {
+        app->timeline->area = NULL;
+        g_hash_table_remove_all(app->timeline->tiles);
+    }
+}
+
+void ottsr_create_timeline_window(ottsr_app_t *app) {
+    if (app->timeline_window) {
+        gtk_window_present(GTK_WINDOW(app->timeline_window));
+        return;
+    }
+
+    if (!app->timeline) {
+        gint64 start = g_get_monotonic_time();
+        app->timeline = ottsr_timeline_build(ottsr_history_read_all());
+        g_debug("Timeline indexed %u sessions in %.2f ms", app->timeline->records->len,
+                (g_get_monotonic_time() - start) / 1000.0);
+    }
+    ottsr_timeline_t *timeline = app->timeline;
+    timeline->placed = FALSE;
+
+    app->timeline_window = gtk_window_new(GTK_WINDOW_TOPLEVEL);
+    gtk_window_set_title(GTK_WINDOW(app->timeline_window), "Study Timeline");
+    gtk_window_set_default_size(GTK_WINDOW(app->timeline_window), 720, 300);
+    gtk_window_set_transient_for(GTK_WINDOW(app->timeline_window),
+                                GTK_WINDOW(app->main_window));
+    g_signal_connect(app->timeline_window, "destroy", G_CALLBACK(on_timeline_window_destroy), app);
+
+    GtkWidget *main_box = gtk_box_new(GTK_ORIENTATION_VERTICAL, 10);
+    gtk_container_set_border_width(GTK_CONTAINER(main_box), 20);
+    gtk_container_add(GTK_CONTAINER(app->timeline_window), main_box);
+
+    timeline->area = gtk_drawing_area_new();
+    gtk_widget_set_size_request(timeline->area, -1, 210);
+    gtk_widget_add_events(timeline->area, GDK_SCROLL_MASK | GDK_BUTTON_PRESS_MASK |
+                                          GDK_BUTTON1_MOTION_MASK);
+    g_signal_connect(timeline->area, "draw", G_CALLBACK(on_timeline_draw), timeline);
+    g_signal_connect(timeline->area, "scroll-event", G_CALLBACK(on_timeline_scroll), timeline);
+    g_signal_connect(timeline->area, "button-press-event", G_CALLBACK(on_timeline_button_press), timeline);
+    g_signal_connect(timeline->area, "motion-notify-event", G_CALLBACK(on_timeline_motion), timeline);
+    gtk_box_pack_start(GTK_BOX(main_box), timeline->area, TRUE, TRUE, 0);
+
+    GtkWidget *hint = gtk_label_new("Scroll to zoom, drag or Shift+scroll to move through time");
+    gtk_widget_set_halign(hint, GTK_ALIGN_START);
+    gtk_box_pack_start(GTK_BOX(main_box), hint, FALSE, FALSE, 0);
+
+    gtk_widget_show_all(app->timeline_window);
+}
@@ -0,0 +1,359 @@
+#include "ottsr.h"
+
+#ifdef G_OS_UNIX
+#include <sys/resource.h>
+#endif
+
+#define OTTSR_SNI_WATCHER "org.kde.StatusNotifierWatcher"
+#define OTTSR_SNI_WATCHER_PATH "/StatusNotifierWatcher"
+#define OTTSR_SNI_INTERFACE "org.kde.StatusNotifierItem"
+#define OTTSR_SNI_PATH "/StatusNotifierItem"
+
+static const char ottsr_sni_xml[] =
+    "<node>"
+    "  <interface name='org.kde.StatusNotifierItem'>"
+    "    <property name='Category' type='s' access='read'/>"
+    "    <property name='Id' type='s' access='read'/>"
+    "    <property name='Title' type='s' access='read'/>"
+    "    <property name='Status' type='s' access='read'/>"
+    "    <property name='IconName' type='s' access='read'/>"
+    "    <property name='ToolTip' type='(sa(iiay)ss)' access='read'/>"
+    "    <property name='ItemIsMenu' type='b' access='read'/>"
+    "    <method name='Activate'><arg name='x' type='i' direction='in'/><arg name='y' type='i' direction='in'/></method>"
+    "    <method name='SecondaryActivate'><arg name='x' type='i' direction='in'/><arg name='y' type='i' direction='in'/></method>"
+    "    <method name='ContextMenu'><arg name='x' type='i' direction='in'/><arg name='y' type='i' direction='in'/></method>"
+    "    <method name='Scroll'><arg name='delta' type='i' direction='in'/><arg name='orientation' type='s' direction='in'/></method>"
+    "    <signal name='NewTitle'/>"
+    "    <signal name='NewToolTip'/>"
+    "    <signal name='NewStatus'><arg name='status' type='s'/></signal>"
+    "  </interface>"
+    "</node>";
+
+// CPU time used by this process and its current resident set
+static void ottsr_resource_sample(gint64 *cpu_usec, glong *rss_kb) {
+    *cpu_usec = 0;
+    *rss_kb = 0;
+
+#ifdef G_OS_UNIX
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+        *cpu_usec = (gint64)(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * G_USEC_PER_SEC +
+                    usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+        *rss_kb = usage.ru_maxrss;
+    }
+
+    // Linux reports the current size here; ru_maxrss is only the peak
+    char *statm = NULL;
+    if (g_file_get_contents("/proc/self/statm", &statm, NULL, NULL)) {
+        long pages = 0, resident = 0;
+        if (sscanf(statm, "%ld %ld", &pages, &resident) == 2) {
+            *rss_kb = resident * (sysconf(_SC_PAGESIZE) / 1024);
+        }
+        g_free(statm);
+    }
+#endif
+}
+
+// Log what the mode we are leaving cost, then start measuring the next one.
+// Run with G_MESSAGES_DEBUG=all to compare a visible window with the tray.
+static void ottsr_resource_checkpoint(ottsr_app_t *app, const char *leaving) {
+    gint64 now = g_get_monotonic_time();
+    gint64 cpu;
+    glong rss;
+    ottsr_resource_sample(&cpu, &rss);
+
+    if (app->mode_started_at > 0 && now > app->mode_started_at) {
+        double wall = (now - app->mode_started_at) / (double)G_USEC_PER_SEC;
+        double used = (cpu - app->mode_started_cpu) / (double)G_USEC_PER_SEC;
+        g_debug("%s for %.0f s: %.3f s CPU (%.3f%%), RSS %ld KiB",
+                leaving, wall, used, 100.0 * used / wall, rss);
+    }
+
+    app->mode_started_at = now;
+    app->mode_started_cpu = cpu;
+}
+
+static void ottsr_tray_emit(ottsr_app_t *app, const char *signal, GVariant *parameters) {
+    if (!app->tray_connection || !app->tray_object_id) return;
+
+    g_dbus_connection_emit_signal(app->tray_connection, NULL, OTTSR_SNI_PATH, OTTSR_SNI_INTERFACE,
+                                  signal, parameters, NULL);
+}
+
+static gboolean ottsr_tray_tooltip_due(gpointer user_data);
+
+// The tray shows whole minutes left, rounded up, so it only needs waking
+// when that number changes; hosts fetch the text itself when they need it
+static void ottsr_tray_schedule(ottsr_app_t *app) {
+    if (app->tray_tooltip_id > 0) {
+        g_source_remove(app->tray_tooltip_id);
+        app->tray_tooltip_id = 0;
+    }
+    if (!app->tray_object_id) return;
+    if (app->session.state != OTTSR_STATE_STUDYING && app->session.state != OTTSR_STATE_BREAKING) return;
+
+    ottsr_session_sync(app);
+    int duration = ottsr_phase_duration(app);
+    int elapsed = app->session.state == OTTSR_STATE_STUDYING ?
+        app->session.elapsed_study_seconds : app->session.elapsed_break_seconds;
+    int shown = (duration - elapsed + 59) / 60;
+
+    // The last minute ends with the phase, which notifies anyway
+    if (shown <= 1) return;
+
+    gint64 change_at = app->phase_anchor + (gint64)(duration - 60 * (shown - 1)) * G_USEC_PER_SEC;
+    gint64 delay_ms = (change_at - g_get_monotonic_time()) / 1000 + 1;
+    app->tray_tooltip_id = g_timeout_add((guint)MAX(1, delay_ms), ottsr_tray_tooltip_due, app);
+}
+
+static gboolean ottsr_tray_tooltip_due(gpointer user_data) {
+    ottsr_app_t *app = (ottsr_app_t *)user_data;
+    app->tray_tooltip_id = 0;
+    ottsr_tray_emit(app, "NewTitle", NULL);
+    ottsr_tray_emit(app, "NewToolTip", NULL);
+    ottsr_tray_schedule(app);
+    return G_SOURCE_REMOVE;
+}
+
+void ottsr_tray_notify(ottsr_app_t *app) {
+    if (!app->tray_connection || !app->tray_object_id) return;
+
+    ottsr_tray_emit(app, "NewTitle", NULL);
+    ottsr_tray_emit(app, "NewToolTip", NULL);
+    ottsr_tray_emit(app, "NewStatus", g_variant_new("(s)",
+                    app->session.state == OTTSR_STATE_IDLE ? "Passive" : "Active"));
+    ottsr_tray_schedule(app);
+}
+
+// Hide the window and stop the display tick; the phase clock keeps running
+void ottsr_background_enter(ottsr_app_t *app) {
+    if (app->in_background || !app->tray_registered) return;
+
+    ottsr_resource_checkpoint(app, "Window visible");
+
+    if (app->session_timer_id > 0) {
+        g_source_remove(app->session_timer_id);
+        app->session_timer_id = 0;
+    }
+    ottsr_progress_stop(app);
+
+    gtk_window_get_position(GTK_WINDOW(app->main_window), &app->window_x, &app->window_y);
+    gtk_widget_hide(app->main_window);
+
+    app->in_background = TRUE;
+    ottsr_checkpoint_write(app);
+    ottsr_tray_notify(app);
+}
+
+void ottsr_background_leave(ottsr_app_t *app) {
+    if (!app->in_background) return;
+
+    ottsr_resource_checkpoint(app, "In background");
+
+    ottsr_session_sync(app);
+    app->in_background = FALSE;
+
+    if (app->session.state == OTTSR_STATE_STUDYING || app->session.state == OTTSR_STATE_BREAKING) {
+        app->session_timer_id = g_timeout_add_seconds(1, ottsr_timer_callback, app);
+        ottsr_progress_start(app);
+    }
+
+    gtk_window_move(GTK_WINDOW(app->main_window), app->window_x, app->window_y);
+    gtk_widget_show(app->main_window);
+    gtk_window_deiconify(GTK_WINDOW(app->main_window));
+    gtk_window_present(GTK_WINDOW(app->main_window));
+    ottsr_update_display(app);
+}
+
+static void ottsr_tray_text(ottsr_app_t *app, char *buffer, size_t buffer_size) {
+    ottsr_session_sync(app);
+
+    const char *phase;
+    int elapsed;
+    switch (app->session.state) {
+        case OTTSR_STATE_STUDYING:
+            phase = "Studying";
+            elapsed = app->session.elapsed_study_seconds;
+            break;
+        case OTTSR_STATE_BREAKING:
+            phase = app->session.is_long_break ? "Long break" : "Break";
+            elapsed = app->session.elapsed_break_seconds;
+            break;
+        case OTTSR_STATE_PAUSED:
+            g_strlcpy(buffer, "Paused", buffer_size);
+            return;
+        default:
+            g_strlcpy(buffer, "Ready to start studying", buffer_size);
+            return;
+    }
+
+    int minutes = (MAX(0, ottsr_phase_duration(app) - elapsed) + 59) / 60;
+    snprintf(buffer, buffer_size, "%s: %d min left", phase, minutes);
+}
+
+static GVariant *ottsr_tray_get_property(GDBusConnection *connection, const gchar *sender,
+                                         const gchar *object_path, const gchar *interface_name,
+                                         const gchar *property_name, GError **error, gpointer user_data) {
+    ottsr_app_t *app = (ottsr_app_t *)user_data;
+    char text[128];
+
+    if (g_strcmp0(property_name, "Category") == 0) return g_variant_new_string("ApplicationStatus");
+    if (g_strcmp0(property_name, "Id") == 0) return g_variant_new_string("ottsr");
+    if (g_strcmp0(property_name, "IconName") == 0) return g_variant_new_string("alarm-symbolic");
+    if (g_strcmp0(property_name, "ItemIsMenu") == 0) return g_variant_new_boolean(FALSE);
+    if (g_strcmp0(property_name, "Status") == 0) {
+        return g_variant_new_string(app->session.state == OTTSR_STATE_IDLE ? "Passive" : "Active");
+    }
+    if (g_strcmp0(property_name, "Title") == 0) {
+        ottsr_tray_text(app, text, sizeof(text));
+        return g_variant_new_string(text);
+    }
+    if (g_strcmp0(property_name, "ToolTip") == 0) {
+        ottsr_tray_text(app, text, sizeof(text));
+        return g_variant_new("(s@a(iiay)ss)", "alarm-symbolic",
+                             g_variant_new_array(G_VARIANT_TYPE("(iiay)"), NULL, 0),
+                             "Study Timer Pro", text);
+    }
+
+    // GDBus expects an error with a NULL value
+    g_set_error(error, G_DBUS_ERROR, G_DBUS_ERROR_UNKNOWN_PROPERTY, "No such property: %s", property_name);
+    return NULL;
+}
+
+static void ottsr_tray_method_call(GDBusConnection *connection, const gchar *sender,
+                                   const gchar *object_path, const gchar *interface_name,
+                                   const gchar *method_name, GVariant *parameters,
+                                   GDBusMethodInvocation *invocation, gpointer user_data) {
+    ottsr_app_t *app = (ottsr_app_t *)user_data;
+
+    // A click toggles between the window and the tray
+    if (g_strcmp0(method_name, "Activate") == 0) {
+        if (app->in_background) {
+            ottsr_background_leave(app);
+        } else {
+            ottsr_background_enter(app);
+        }
+    }
+    g_dbus_method_invocation_return_value(invocation, NULL);
+}
+
+static void ottsr_tray_registered_cb(GObject *source, GAsyncResult *result, gpointer user_data) {
+    ottsr_app_t *app = (ottsr_app_t *)user_data;
+    GError *error = NULL;
+    GVariant *reply = g_dbus_connection_call_finish(G_DBUS_CONNECTION(source), result, &error);
+
+    if (!reply) {
+        g_warning("Tray icon not registered: %s", error->message);
+        g_error_free(error);
+        return;
+    }
+    g_variant_unref(reply);
+    app->tray_registered = TRUE;
+}
+
+static void ottsr_tray_register(ottsr_app_t *app) {
+    if (!app->tray_connection || !app->tray_name) return;
+
+    g_dbus_connection_call(app->tray_connection, OTTSR_SNI_WATCHER, OTTSR_SNI_WATCHER_PATH,
+                           OTTSR_SNI_WATCHER, "RegisterStatusNotifierItem",
+                           g_variant_new("(s)", app->tray_name), NULL,
+                           G_DBUS_CALL_FLAGS_NONE, -1, NULL, ottsr_tray_registered_cb, app);
+}
+
+static void on_tray_bus_acquired(GDBusConnection *connection, const gchar *name, gpointer user_data) {
+    ottsr_app_t *app = (ottsr_app_t *)user_data;
+    static const GDBusInterfaceVTable vtable = {
+        .method_call = ottsr_tray_method_call,
+        .get_property = ottsr_tray_get_property,
+    };
+
+    GError *error = NULL;
+    GDBusNodeInfo *info = g_dbus_node_info_new_for_xml(ottsr_sni_xml, &error);
+    if (!info) {
+        g_warning("Bad tray interface: %s", error->message);
+        g_error_free(error);
+        return;
+    }
+
+    app->tray_connection = g_object_ref(connection);
+    app->tray_object_id = g_dbus_connection_register_object(connection, OTTSR_SNI_PATH,
+                                                            info->interfaces[0], &vtable,
+                                                            app, NULL, &error);
+    if (!app->tray_object_id) {
+        g_warning("Cannot export tray icon: %s", error->message);
+        g_error_free(error);
+    }
+    g_dbus_node_info_unref(info);
+    ottsr_tray_schedule(app);
+}
+
+static void on_tray_name_acquired(GDBusConnection *connection, const gchar *name, gpointer user_data) {
+    ottsr_tray_register((ottsr_app_t *)user_data);
+}
+
+// A panel (re)started: register with its watcher
+static void on_tray_watcher_appeared(GDBusConnection *connection, const gchar *name,
+                                     const gchar *owner, gpointer user_data) {
+    ottsr_tray_register((ottsr_app_t *)user_data);
+}
+
+// Without a panel the hidden window could never be brought back
+static void on_tray_watcher_vanished(GDBusConnection *connection, const gchar *name, gpointer user_data) {
+    ottsr_app_t *app = (ottsr_app_t *)user_data;
+    ottsr_background_leave(app);
+    app->tray_registered = FALSE;
+}
+
+void ottsr_tray_start(ottsr_app_t *app) {
+    app->mode_started_at = 0;
+    ottsr_resource_checkpoint(app, NULL);
+
+    app->tray_name = g_strdup_printf("org.kde.StatusNotifierItem-%d-1", (int)getpid());
+    app->tray_owner_id = g_bus_own_name(G_BUS_TYPE_SESSION, app->tray_name, G_BUS_NAME_OWNER_FLAGS_NONE,
+                                        on_tray_bus_acquired, on_tray_name_acquired, NULL, app, NULL);
+    app->tray_watch_id = g_bus_watch_name(G_BUS_TYPE_SESSION, OTTSR_SNI_WATCHER, G_BUS_NAME_WATCHER_FLAGS_NONE,
+                                          on_tray_watcher_appeared, on_tray_watcher_vanished, app, NULL);
+}
+
+void ottsr_tray_stop(ottsr_app_t *app) {
+    app->in_background = FALSE;
+    if (app->tray_tooltip_id > 0) {
+        g_source_remove(app->tray_tooltip_id);
+        app->tray_tooltip_id = 0;
+    }
+    if (app->tray_watch_id > 0) {
+        g_bus_unwatch_name(app->tray_watch_id);
+        app->tray_watch_id = 0;
+    }
+    if (app->tray_object_id > 0) {
+        g_dbus_connection_unregister_object(app->tray_connection, app->tray_object_id);
+        app->tray_object_id = 0;
+    }
+    if (app->tray_owner_id > 0) {
+        g_bus_unown_name(app->tray_owner_id);
+        app->tray_owner_id = 0;
+    }
+    g_clear_object(&app->tray_connection);
+    g_free(app->tray_name);
+    app->tray_name = NULL;
+    app->tray_registered = FALSE;
+}
+
+// Closing the window while a session runs keeps it going in the tray
+gboolean on_main_window_delete(GtkWidget *widget, GdkEvent *event, ottsr_app_t *app) {
+    if (app->config.minimize_to_tray && app->tray_registered &&
+        app->session.state != OTTSR_STATE_IDLE) {
+        ottsr_background_enter(app);
+        return TRUE;
+    }
+    return FALSE;
+}
+
+gboolean on_main_window_state(GtkWidget *widget, GdkEventWindowState *event, ottsr_app_t *app) {
+    if ((event->changed_mask & GDK_WINDOW_STATE_ICONIFIED) &&
+        (event->new_window_state & GDK_WINDOW_STATE_ICONIFIED) &&
+        app->config.minimize_to_tray) {
+        ottsr_background_enter(app);
+    }
+    return FALSE;
+}
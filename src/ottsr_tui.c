@@ -0,0 +1,447 @@
+#include "ottsr.h"
+
+#ifdef G_OS_UNIX
+#include <errno.h>
+#include <signal.h>
+#include <termios.h>
+#include <sys/ioctl.h>
+#include <glib-unix.h>
+
+// `ottsr --tui`: the timer in a terminal, for SSH sessions and machines
+// without a display. Sessions run through the same functions as the window
+// (ottsr_start_session, ottsr_timer_callback, the phase clock); only the
+// display differs. Frames are drawn into a cell grid and compared with the
+// previous one, and only the cells that changed are sent, with plain ANSI
+// escapes. A running timer costs a few dozen bytes a second.
+
+typedef enum {
+    OTTSR_CELL_PLAIN,
+    OTTSR_CELL_BOLD,
+    OTTSR_CELL_FILL
+} ottsr_cell_attr_t;
+
+// One character (UTF-8, assumed one column wide) and how it is shown
+typedef struct {
+    char text[4];
+    guint8 attr;
+} ottsr_cell_t;
+
+struct ottsr_tui {
+    int fd;
+    int rows;
+    int cols;
+    ottsr_cell_t *front;
+    ottsr_cell_t *back;
+    gboolean full;
+    GString *out;
+
+    struct termios saved;
+    gboolean raw;
+    GMainLoop *loop;
+    guint input_id;
+    guint resize_id;
+    guint interrupt_id;
+    guint terminate_id;
+
+    char message[128];
+    GPrintFunc saved_print;
+    GLogFunc saved_log;
+};
+
+static const char *ottsr_cell_attr_codes[] = { "\033[0m", "\033[0;1m", "\033[0;7m" };
+
+// g_print has no user data; there is only ever one terminal
+static ottsr_tui_t *ottsr_tui_active = NULL;
+
+static void ottsr_tui_write(ottsr_tui_t *tui, const char *data, gsize length) {
+    while (length > 0) {
+        ssize_t written = write(tui->fd, data, length);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return;
+        }
+        data += written;
+        length -= written;
+    }
+}
+
+static void ottsr_tui_write_text(ottsr_tui_t *tui, const char *text) {
+    ottsr_tui_write(tui, text, strlen(text));
+}
+
+static void ottsr_tui_resize(ottsr_tui_t *tui) {
+    struct winsize size = {0};
+    int rows = 24, cols = 80;
+    if (ioctl(tui->fd, TIOCGWINSZ, &size) == 0 && size.ws_row > 0 && size.ws_col > 0) {
+        rows = size.ws_row;
+        cols = size.ws_col;
+    }
+
+    if (rows != tui->rows || cols != tui->cols || !tui->front) {
+        g_free(tui->front);
+        g_free(tui->back);
+        tui->rows = rows;
+        tui->cols = cols;
+        tui->front = g_new0(ottsr_cell_t, (gsize)rows * cols);
+        tui->back = g_new0(ottsr_cell_t, (gsize)rows * cols);
+    }
+    tui->full = TRUE;
+}
+
+static void ottsr_tui_clear(ottsr_tui_t *tui) {
+    gsize cells = (gsize)tui->rows * tui->cols;
+    for (gsize i = 0; i < cells; i++) {
+        tui->back[i] = (ottsr_cell_t){ { ' ', 0, 0, 0 }, OTTSR_CELL_PLAIN };
+    }
+}
+
+// Text into the frame, clipped to the screen; control characters become '?'
+static void ottsr_tui_put(ottsr_tui_t *tui, int row, int col, const char *text, ottsr_cell_attr_t attr) {
+    if (row < 0 || row >= tui->rows) return;
+
+    for (const char *p = text; *p && col < tui->cols; col++) {
+        const char *next = g_utf8_next_char(p);
+        if (col >= 0) {
+            ottsr_cell_t *cell = &tui->back[row * tui->cols + col];
+            gsize length = MIN((gsize)(next - p), sizeof(cell->text));
+            memset(cell->text, 0, sizeof(cell->text));
+            if ((guchar)*p < 0x20 || *p == 0x7f || !g_utf8_validate(p, length, NULL)) {
+                cell->text[0] = '?';
+            } else {
+                memcpy(cell->text, p, length);
+            }
+            cell->attr = attr;
+        }
+        p = next;
+    }
+}
+
+static void ottsr_tui_put_center(ottsr_tui_t *tui, int row, int left, int width, const char *text,
+                                 ottsr_cell_attr_t attr) {
+    int length = (int)g_utf8_strlen(text, -1);
+    ottsr_tui_put(tui, row, left + MAX(0, (width - length) / 2), text, attr);
+}
+
+static void ottsr_tui_bar(ottsr_tui_t *tui, int row, int left, int width, const char *label, double progress) {
+    char percent[8];
+    snprintf(percent, sizeof(percent), "%3d%%", (int)(progress * 100.0));
+
+    int inner = width - 14;
+    if (inner < 4) return;
+    int filled = (int)(progress * inner + 0.5);
+
+    ottsr_tui_put(tui, row, left, label, OTTSR_CELL_PLAIN);
+    ottsr_tui_put(tui, row, left + 7, "[", OTTSR_CELL_PLAIN);
+    for (int i = 0; i < inner; i++) {
+        ottsr_tui_put(tui, row, left + 8 + i, i < filled ? " " : "-",
+                      i < filled ? OTTSR_CELL_FILL : OTTSR_CELL_PLAIN);
+    }
+    ottsr_tui_put(tui, row, left + 8 + inner, "]", OTTSR_CELL_PLAIN);
+    ottsr_tui_put(tui, row, left + 10 + inner, percent, OTTSR_CELL_PLAIN);
+}
+
+// Send the cells that differ from what the terminal shows, in one write
+static void ottsr_tui_flush(ottsr_tui_t *tui) {
+    GString *out = tui->out;
+    g_string_truncate(out, 0);
+    if (tui->full) g_string_append(out, "\033[0m\033[2J");
+
+    int attr = -1;
+    for (int row = 0; row < tui->rows; row++) {
+        int col = 0;
+        while (col < tui->cols) {
+            gsize index = (gsize)row * tui->cols + col;
+            if (!tui->full && memcmp(&tui->front[index], &tui->back[index], sizeof(ottsr_cell_t)) == 0) {
+                col++;
+                continue;
+            }
+
+            g_string_append_printf(out, "\033[%d;%dH", row + 1, col + 1);
+            while (col < tui->cols) {
+                index = (gsize)row * tui->cols + col;
+                const ottsr_cell_t *cell = &tui->back[index];
+                if (!tui->full && memcmp(&tui->front[index], cell, sizeof(ottsr_cell_t)) == 0) break;
+
+                if (cell->attr != attr) {
+                    attr = cell->attr;
+                    g_string_append(out, ottsr_cell_attr_codes[attr]);
+                }
+                g_string_append_len(out, cell->text, strnlen(cell->text, sizeof(cell->text)));
+                tui->front[index] = *cell;
+                col++;
+            }
+        }
+    }
+
+    if (out->len > 0) {
+        if (attr != OTTSR_CELL_PLAIN && attr != -1) g_string_append(out, ottsr_cell_attr_codes[OTTSR_CELL_PLAIN]);
+        ottsr_tui_write(tui, out->str, out->len);
+    }
+    tui->full = FALSE;
+}
+
+static void ottsr_tui_draw(ottsr_app_t *app) {
+    ottsr_tui_t *tui = app->tui;
+    ottsr_tui_clear(tui);
+
+    int width = MIN(tui->cols, 64);
+    int left = (tui->cols - width) / 2;
+    int top = MAX(0, (tui->rows - 14) / 2);
+    gboolean idle = app->session.state == OTTSR_STATE_IDLE;
+    const ottsr_profile_t *profile =
+        &app->config.profiles[idle ? app->config.active_profile : app->session.profile_index];
+
+    ottsr_tui_put(tui, top, left, "OTTSR", OTTSR_CELL_BOLD);
+    int name_length = (int)g_utf8_strlen(profile->name, -1);
+    ottsr_tui_put(tui, top, left + MAX(6, width - name_length), profile->name, OTTSR_CELL_PLAIN);
+
+    ottsr_tui_put_center(tui, top + 2, left, width, ottsr_time_text(ottsr_remaining_time(app)), OTTSR_CELL_BOLD);
+    ottsr_tui_put_center(tui, top + 3, left, width, ottsr_status_text(app), OTTSR_CELL_PLAIN);
+
+    double progress = ottsr_phase_progress(app, g_get_monotonic_time());
+    ottsr_tui_bar(tui, top + 5, left, width, "Study",
+                  app->session.state == OTTSR_STATE_STUDYING ? progress : 0.0);
+    ottsr_tui_bar(tui, top + 6, left, width, "Break",
+                  app->session.state == OTTSR_STATE_BREAKING ? progress : 0.0);
+
+    ottsr_tui_put(tui, top + 8, left, ottsr_stats_text(app), OTTSR_CELL_PLAIN);
+    const char *subject = idle ? app->config.last_subject : app->session.current_subject;
+    if (*subject) {
+        ottsr_tui_put(tui, top + 9, left, "Subject: ", OTTSR_CELL_PLAIN);
+        ottsr_tui_put(tui, top + 9, left + 9, subject, OTTSR_CELL_PLAIN);
+    }
+
+    ottsr_tui_put(tui, tui->rows - 2, 0, tui->message, OTTSR_CELL_PLAIN);
+    ottsr_tui_put(tui, tui->rows - 1, 0,
+                  idle ? "s start   n next profile   q quit" :
+                  app->session.state == OTTSR_STATE_PAUSED ? "p resume   x stop   q quit" :
+                  "p pause   x stop   q quit",
+                  OTTSR_CELL_BOLD);
+
+    ottsr_tui_flush(tui);
+}
+
+// Called from ottsr_update_display, so every session change redraws
+void ottsr_tui_update(ottsr_app_t *app) {
+    if (!app->tui) return;
+    ottsr_tui_draw(app);
+}
+
+// Messages would scroll the screen; show the latest on its own line instead
+static void ottsr_tui_print(const gchar *string) {
+    ottsr_tui_t *tui = ottsr_tui_active;
+    if (!tui) return;
+
+    if (strcmp(string, "\a") == 0) {
+        ottsr_tui_write(tui, string, 1);
+        return;
+    }
+    g_strlcpy(tui->message, string, sizeof(tui->message));
+    tui->message[strcspn(tui->message, "\r\n")] = '\0';
+}
+
+static void ottsr_tui_log(const gchar *domain, GLogLevelFlags level, const gchar *message, gpointer user_data) {
+    if (!(level & (G_LOG_LEVEL_ERROR | G_LOG_LEVEL_CRITICAL | G_LOG_LEVEL_WARNING | G_LOG_LEVEL_MESSAGE))) return;
+    ottsr_tui_t *tui = user_data;
+    snprintf(tui->message, sizeof(tui->message), "%s", message);
+    tui->message[strcspn(tui->message, "\r\n")] = '\0';
+}
+
+static void ottsr_tui_phase_due(const ottsr_clock_event_t *event, gpointer user_data) {
+    ottsr_phase_advance((ottsr_app_t *)user_data, event->deadline);
+}
+
+static void ottsr_tui_next_profile(ottsr_app_t *app) {
+    if (app->config.profile_count <= 1) return;
+    ottsr_model_set(app, OTTSR_PROP_ACTIVE_PROFILE, 0,
+                    (app->config.active_profile + 1) % app->config.profile_count);
+    ottsr_save_config(app);
+}
+
+static gboolean ottsr_tui_input(gint fd, GIOCondition condition, gpointer user_data) {
+    ottsr_app_t *app = user_data;
+    char keys[64];
+    ssize_t count = read(fd, keys, sizeof(keys));
+    if (count < 0 && errno == EINTR) return G_SOURCE_CONTINUE;
+    if (count <= 0) {
+        // Input closed; keep the timer running until a signal ends it
+        app->tui->input_id = 0;
+        return G_SOURCE_REMOVE;
+    }
+
+    for (ssize_t i = 0; i < count; i++) {
+        app->tui->message[0] = '\0';
+        switch (keys[i]) {
+            case 's':
+            case '\r':
+            case '\n':
+                ottsr_start_session(app);
+                break;
+            case 'p':
+            case ' ':
+                ottsr_pause_session(app);
+                break;
+            case 'x':
+                ottsr_stop_session(app);
+                break;
+            case 'n':
+                if (app->session.state == OTTSR_STATE_IDLE) ottsr_tui_next_profile(app);
+                break;
+            case 'q':
+            case 4:
+                g_main_loop_quit(app->tui->loop);
+                return G_SOURCE_CONTINUE;
+            case 12:
+                // Ctrl+L repaints everything
+                app->tui->full = TRUE;
+                break;
+        }
+    }
+    ottsr_update_display(app);
+    return G_SOURCE_CONTINUE;
+}
+
+static gboolean ottsr_tui_on_resize(gpointer user_data) {
+    ottsr_app_t *app = user_data;
+    ottsr_tui_resize(app->tui);
+    ottsr_update_display(app);
+    return G_SOURCE_CONTINUE;
+}
+
+static gboolean ottsr_tui_on_quit(gpointer user_data) {
+    ottsr_app_t *app = user_data;
+    g_main_loop_quit(app->tui->loop);
+    return G_SOURCE_CONTINUE;
+}
+
+static ottsr_tui_t *ottsr_tui_new(ottsr_app_t *app) {
+    ottsr_tui_t *tui = g_new0(ottsr_tui_t, 1);
+    tui->fd = STDOUT_FILENO;
+    tui->out = g_string_sized_new(4096);
+    tui->loop = g_main_loop_new(NULL, FALSE);
+    ottsr_tui_resize(tui);
+
+    // Keys arrive one at a time, unechoed; Ctrl+C still interrupts
+    if (isatty(STDIN_FILENO) && tcgetattr(STDIN_FILENO, &tui->saved) == 0) {
+        struct termios raw = tui->saved;
+        raw.c_lflag &= ~(ICANON | ECHO);
+        raw.c_cc[VMIN] = 1;
+        raw.c_cc[VTIME] = 0;
+        tui->raw = tcsetattr(STDIN_FILENO, TCSANOW, &raw) == 0;
+    }
+
+    // Alternate screen, cursor hidden
+    ottsr_tui_write_text(tui, "\033[?1049h\033[?25l");
+
+    tui->input_id = g_unix_fd_add(STDIN_FILENO, G_IO_IN | G_IO_HUP | G_IO_ERR, ottsr_tui_input, app);
+#ifdef SIGWINCH
+    tui->resize_id = g_unix_signal_add(SIGWINCH, ottsr_tui_on_resize, app);
+#endif
+    tui->interrupt_id = g_unix_signal_add(SIGINT, ottsr_tui_on_quit, app);
+    tui->terminate_id = g_unix_signal_add(SIGTERM, ottsr_tui_on_quit, app);
+
+    ottsr_tui_active = tui;
+    tui->saved_print = g_set_print_handler(ottsr_tui_print);
+    tui->saved_log = g_log_set_default_handler(ottsr_tui_log, tui);
+    return tui;
+}
+
+// Give the terminal back as it was
+static void ottsr_tui_free(ottsr_tui_t *tui) {
+    g_set_print_handler(tui->saved_print);
+    g_log_set_default_handler(tui->saved_log ? tui->saved_log : g_log_default_handler, NULL);
+    ottsr_tui_active = NULL;
+
+    if (tui->input_id > 0) g_source_remove(tui->input_id);
+    if (tui->resize_id > 0) g_source_remove(tui->resize_id);
+    g_source_remove(tui->interrupt_id);
+    g_source_remove(tui->terminate_id);
+
+    ottsr_tui_write_text(tui, "\033[0m\033[?25h\033[?1049l");
+    if (tui->raw) tcsetattr(STDIN_FILENO, TCSANOW, &tui->saved);
+
+    g_main_loop_unref(tui->loop);
+    g_string_free(tui->out, TRUE);
+    g_free(tui->front);
+    g_free(tui->back);
+    g_free(tui);
+}
+
+int ottsr_tui_main(int argc, char *argv[]) {
+    char *profile_name = NULL;
+    char *subject = NULL;
+    gboolean start = FALSE;
+
+    GOptionEntry entries[] = {
+        { "profile", 'p', 0, G_OPTION_ARG_STRING, &profile_name, "Profile to use", "NAME" },
+        { "subject", 's', 0, G_OPTION_ARG_STRING, &subject, "Subject of the sessions", "TEXT" },
+        { "start", 0, 0, G_OPTION_ARG_NONE, &start, "Start a session right away", NULL },
+        { NULL }
+    };
+
+    GOptionContext *context = g_option_context_new("- run the timer in the terminal");
+    g_option_context_add_main_entries(context, entries, NULL);
+    GError *error = NULL;
+    gboolean ok = g_option_context_parse(context, &argc, &argv, &error);
+    g_option_context_free(context);
+    if (!ok) {
+        g_printerr("ottsr --tui: %s\n", error->message);
+        g_error_free(error);
+        return 1;
+    }
+
+    ottsr_app_t *app = g_new0(ottsr_app_t, 1);
+    ottsr_init_app(app);
+
+    int status = 0;
+    if (profile_name) {
+        int index = -1;
+        for (int i = 0; i < app->config.profile_count; i++) {
+            if (g_ascii_strcasecmp(app->config.profiles[i].name, profile_name) == 0) index = i;
+        }
+        if (index < 0) {
+            g_printerr("ottsr --tui: no profile named %s\n", profile_name);
+            status = 1;
+        } else {
+            app->config.active_profile = index;
+        }
+    }
+    if (subject) g_strlcpy(app->config.last_subject, subject, OTTSR_MAX_NAME_LEN);
+
+    if (status == 0) {
+        app->clock = ottsr_clock_new(ottsr_tui_phase_due, app);
+        ottsr_hooks_start(app);
+        ottsr_checkpoint_open(app);
+        app->tui = ottsr_tui_new(app);
+
+        ottsr_checkpoint_recover(app);
+        ottsr_http_start(app);
+        ottsr_group_start(app);
+        if (start) ottsr_start_session(app);
+        ottsr_update_display(app);
+
+        g_main_loop_run(app->tui->loop);
+
+        ottsr_tui_free(app->tui);
+        app->tui = NULL;
+        ottsr_cleanup_app(app);
+    }
+
+    g_free(app);
+    g_free(profile_name);
+    g_free(subject);
+    return status;
+}
+
+#else
+
+// No termios or Unix signals: the terminal frontend is Unix only
+void ottsr_tui_update(ottsr_app_t *app) {
+}
+
+int ottsr_tui_main(int argc, char *argv[]) {
+    g_printerr("ottsr --tui: not supported on this platform\n");
+    return 1;
+}
+
+#endif // G_OS_UNIX
@@ -0,0 +1,137 @@
+#include "ottsr_harness.h"
+
+// `ottsr-archive-bench`: write years of synthetic session history, compact
+// everything past the retention period into the archive, and report the
+// bytes that went in and came out and the time it took. Everything is read
+// back afterwards and compared with what was written.
+
+static const char *ottsr_archive_bench_profiles[] = { "Pomodoro", "Deep Work", "Quick Review" };
+
+// Sessions every day for years, in time order, over a few dozen subjects
+static GArray *ottsr_archive_bench_history(int years, int per_day) {
+    GArray *records = g_array_new(FALSE, FALSE, sizeof(ottsr_history_record_t));
+    gint64 now = g_get_real_time() / G_USEC_PER_SEC;
+    gint64 first_day = now / 86400 - (gint64)years * 365;
+
+    for (gint64 day = first_day; day < now / 86400; day++) {
+        int sessions = g_random_int_range(0, 2 * per_day + 1);
+        gint64 at = day * 86400 + 8 * 3600;
+        for (int i = 0; i < sessions; i++) {
+            ottsr_history_record_t record = {0};
+            record.started_at = at + g_random_int_range(0, 1800);
+            record.study_seconds = g_random_int_range(10, 61) * 60;
+            record.completed = g_random_int_range(0, 5) != 0;
+            g_strlcpy(record.profile, ottsr_archive_bench_profiles[g_random_int_range(0, 3)], OTTSR_MAX_NAME_LEN);
+            g_snprintf(record.subject, OTTSR_MAX_NAME_LEN, "Course %d", g_random_int_range(1, 41));
+            g_array_append_val(records, record);
+            at = record.started_at + record.study_seconds + 300;
+        }
+    }
+    return records;
+}
+
+static gint64 ottsr_archive_bench_size(const char *config_dir, const char *name) {
+    char *path = g_build_filename(config_dir, name, NULL);
+    GStatBuf st;
+    gint64 size = g_stat(path, &st) == 0 ? (gint64)st.st_size : 0;
+    g_free(path);
+    return size;
+}
+
+static gboolean ottsr_archive_bench_same(GArray *written, GArray *read) {
+    if (written->len != read->len) return FALSE;
+    for (guint i = 0; i < written->len; i++) {
+        const ottsr_history_record_t *a = &g_array_index(written, ottsr_history_record_t, i);
+        const ottsr_history_record_t *b = &g_array_index(read, ottsr_history_record_t, i);
+        if (a->started_at != b->started_at || a->study_seconds != b->study_seconds ||
+            a->completed != b->completed || strcmp(a->profile, b->profile) != 0 ||
+            strcmp(a->subject, b->subject) != 0) {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+static int ottsr_archive_bench(const char *config_dir, int years, int per_day) {
+    GArray *records = ottsr_archive_bench_history(years, per_day);
+    for (guint i = 0; i < records->len; i++) {
+        if (!ottsr_history_append(&g_array_index(records, ottsr_history_record_t, i))) {
+            g_printerr("ottsr-archive-bench: cannot write history\n");
+            g_array_unref(records);
+            return 1;
+        }
+    }
+    gint64 bytes_in = ottsr_archive_bench_size(config_dir, OTTSR_HISTORY_FILE);
+
+    guint archived = 0;
+    gsize raw_bytes = 0, packed_bytes = 0;
+    gint64 start = g_get_monotonic_time();
+    gboolean ok = ottsr_archive_compact(&archived, &raw_bytes, &packed_bytes);
+    gint64 compacted = g_get_monotonic_time();
+
+    gint64 hot_out = ottsr_archive_bench_size(config_dir, OTTSR_HISTORY_FILE);
+    gint64 archive_out = ottsr_archive_bench_size(config_dir, OTTSR_ARCHIVE_FILE);
+    gint64 rollup_out = ottsr_archive_bench_size(config_dir, OTTSR_ROLLUP_FILE);
+
+    GArray *read = ottsr_history_read_all();
+    gint64 loaded = g_get_monotonic_time();
+    gboolean same = ottsr_archive_bench_same(records, read);
+
+    g_print("%u sessions over %d years, %" G_GINT64_FORMAT " bytes of history\n",
+            records->len, years, bytes_in);
+    g_print("Archived %u sessions in %.1f ms: %" G_GSIZE_FORMAT " bytes -> %" G_GSIZE_FORMAT " bytes (%.1fx)\n",
+            archived, (compacted - start) / 1000.0, raw_bytes, packed_bytes,
+            packed_bytes ? (double)raw_bytes / packed_bytes : 0.0);
+    g_print("On disk after: history %" G_GINT64_FORMAT ", archive %" G_GINT64_FORMAT
+            ", rollup %" G_GINT64_FORMAT " bytes (%" G_GINT64_FORMAT " in, %" G_GINT64_FORMAT " out)\n",
+            hot_out, archive_out, rollup_out, bytes_in, hot_out + archive_out + rollup_out);
+    g_print("Read back %u sessions in %.1f ms: %s\n", read->len, (loaded - compacted) / 1000.0,
+            ok && archived > 0 && same ? "PASS" : "FAIL");
+
+    g_array_unref(read);
+    g_array_unref(records);
+    return ok && archived > 0 && same ? 0 : 1;
+}
+
+int main(int argc, char *argv[]) {
+    int years = 4;
+    int per_day = 4;
+    int seed = 0;
+
+    GOptionEntry entries[] = {
+        { "years", 'y', 0, G_OPTION_ARG_INT, &years, "Years of history to generate", "N" },
+        { "per-day", 'd', 0, G_OPTION_ARG_INT, &per_day, "Average sessions per day", "N" },
+        { "seed", 's', 0, G_OPTION_ARG_INT, &seed, "Random seed for the history", "N" },
+        { NULL }
+    };
+
+    GOptionContext *context = g_option_context_new("- time compacting a long session history");
+    g_option_context_add_main_entries(context, entries, NULL);
+    GError *error = NULL;
+    gboolean ok = g_option_context_parse(context, &argc, &argv, &error);
+    g_option_context_free(context);
+    if (!ok) {
+        g_printerr("ottsr-archive-bench: %s\n", error->message);
+        g_error_free(error);
+        return 1;
+    }
+    if (seed != 0) g_random_set_seed((guint32)seed);
+
+    // History, archive and rollup go to a scratch home, not the user's
+    char *home = g_dir_make_tmp("ottsr-archive-XXXXXX", NULL);
+    if (!home) {
+        g_printerr("ottsr-archive-bench: cannot create a scratch home directory\n");
+        return 1;
+    }
+    g_setenv("HOME", home, TRUE);
+    g_unsetenv(OTTSR_KIOSK_ENV);
+
+    char *config_dir = ottsr_get_config_path();
+    g_mkdir_with_parents(config_dir, 0755);
+    int status = ottsr_archive_bench(config_dir, MAX(1, years), MAX(1, per_day));
+
+    g_free(config_dir);
+    ottsr_remove_tree(home);
+    g_free(home);
+    return status;
+}
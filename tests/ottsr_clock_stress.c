@@ -0,0 +1,86 @@
+#include "ottsr_harness.h"
+
+// `ottsr-clock-stress`: run a chain of short phases while the main loop is
+// stalled at random, and check that deadlines still fire on time
+typedef struct {
+    ottsr_clock_t *clock;
+    GMainLoop *loop;
+    gint64 start;
+    gint64 period;
+    int phases;
+    int done;
+    gint64 armed_at;
+    gint64 max_late;
+    gint64 total_late;
+    gint64 max_dispatch;
+} ottsr_clock_stress_t;
+
+// Chain the next phase off the deadline that fired, as the session does
+static void ottsr_clock_stress_due(const ottsr_clock_event_t *event, gpointer user_data) {
+    ottsr_clock_stress_t *stress = user_data;
+    gint64 now = g_get_monotonic_time();
+
+    gint64 late = ottsr_fire_late(event, stress->armed_at);
+    stress->max_late = MAX(stress->max_late, late);
+    stress->total_late += late;
+    stress->max_dispatch = MAX(stress->max_dispatch, now - event->deadline);
+
+    if (++stress->done == stress->phases) {
+        g_main_loop_quit(stress->loop);
+    } else {
+        stress->armed_at = now;
+        ottsr_clock_arm(stress->clock, event->deadline + stress->period);
+    }
+}
+
+int main(int argc, char *argv[]) {
+    int phases = 200;
+    int period_ms = 50;
+
+    GOptionEntry entries[] = {
+        { "phases", 'n', 0, G_OPTION_ARG_INT, &phases, "Number of phases", "N" },
+        { "period", 'p', 0, G_OPTION_ARG_INT, &period_ms, "Phase length in milliseconds", "MS" },
+        { NULL }
+    };
+
+    GOptionContext *context = g_option_context_new("- check phase timing under main-loop stalls");
+    g_option_context_add_main_entries(context, entries, NULL);
+    GError *error = NULL;
+    gboolean ok = g_option_context_parse(context, &argc, &argv, &error);
+    g_option_context_free(context);
+    if (!ok) {
+        g_printerr("ottsr-clock-stress: %s\n", error->message);
+        g_error_free(error);
+        return 1;
+    }
+
+    ottsr_clock_stress_t stress = {0};
+    stress.phases = MAX(1, phases);
+    stress.period = (gint64)MAX(1, period_ms) * 1000;
+    stress.loop = g_main_loop_new(NULL, FALSE);
+    stress.clock = ottsr_clock_new(ottsr_clock_stress_due, &stress);
+
+    ottsr_stall_t stall = {0};
+    ottsr_stall_start(&stall, period_ms / 3, stress.period / 2);
+    stress.start = g_get_monotonic_time();
+    stress.armed_at = stress.start;
+    ottsr_clock_arm(stress.clock, stress.start + stress.period);
+    g_main_loop_run(stress.loop);
+
+    ottsr_stall_stop(&stall);
+    ottsr_clock_free(stress.clock);
+    g_main_loop_unref(stress.loop);
+
+    // The thread must not fire late. The event source outranks the stalls,
+    // so the main loop may only see it late by the one stall in progress.
+    gint64 late_limit = 5000;
+    gint64 dispatch_limit = stress.period / 2 + late_limit;
+    gboolean passed = stress.max_late <= late_limit && stress.max_dispatch <= dispatch_limit;
+    g_print("%d phases of %d ms, stalls up to %.1f ms: fired avg %.1f us / max %" G_GINT64_FORMAT
+            " us after the deadline (limit %" G_GINT64_FORMAT " us), handled up to %.1f ms after"
+            " (limit %.1f ms): %s\n",
+            stress.done, period_ms, stall.longest / 1000.0,
+            (double)stress.total_late / stress.done, stress.max_late, late_limit,
+            stress.max_dispatch / 1000.0, dispatch_limit / 1000.0, passed ? "PASS" : "FAIL");
+    return passed ? 0 : 1;
+}
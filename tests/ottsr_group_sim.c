@@ -0,0 +1,235 @@
+#include "ottsr_harness.h"
+
+// `ottsr-group-sim`: a leader and followers on a simulated network with
+// delay, jitter and loss, each node on a clock skewed by up to an hour.
+// Checks that every follower takes on each phase from the one it joined in,
+// and arms every one of them within 100 ms of the leader.
+typedef struct ottsr_group_sim ottsr_group_sim_t;
+
+typedef struct {
+    ottsr_group_sim_t *sim;
+    ottsr_group_t *group;
+    int index;
+    gint64 skew;
+    int first_phase;
+    gint64 *errors;
+} ottsr_group_node_t;
+
+struct ottsr_group_sim {
+    GMainLoop *loop;
+    ottsr_group_node_t *nodes;
+    int count;
+    double loss;
+    int delay_ms;
+    int jitter_ms;
+    int phases;
+    int phase_ms;
+    int phase;
+    gint64 *anchors;
+    guint sent;
+    guint dropped;
+};
+
+typedef struct {
+    ottsr_group_node_t *node;
+    gsize length;
+    guint8 data[OTTSR_GROUP_MESSAGE_SIZE];
+} ottsr_group_packet_t;
+
+static gint64 ottsr_group_sim_clock(gpointer user_data) {
+    ottsr_group_node_t *node = user_data;
+    return g_get_monotonic_time() + node->skew;
+}
+
+static gboolean ottsr_group_sim_deliver(gpointer user_data) {
+    ottsr_group_packet_t *packet = user_data;
+    if (packet->node->group) ottsr_group_receive(packet->node->group, packet->data, packet->length);
+    return G_SOURCE_REMOVE;
+}
+
+static void ottsr_group_sim_send(const guint8 *data, gsize length, gpointer user_data) {
+    ottsr_group_node_t *from = user_data;
+    ottsr_group_sim_t *sim = from->sim;
+
+    for (int i = 0; i < sim->count; i++) {
+        ottsr_group_node_t *node = &sim->nodes[i];
+        if (node == from || !node->group) continue;
+
+        sim->sent++;
+        if (g_random_double() < sim->loss) {
+            sim->dropped++;
+            continue;
+        }
+
+        ottsr_group_packet_t *packet = g_new(ottsr_group_packet_t, 1);
+        packet->node = node;
+        packet->length = MIN(length, sizeof(packet->data));
+        memcpy(packet->data, data, packet->length);
+        int delay = MAX(0, sim->delay_ms + g_random_int_range(-sim->jitter_ms, sim->jitter_ms + 1));
+        g_timeout_add_full(G_PRIORITY_DEFAULT, delay, ottsr_group_sim_deliver, packet, g_free);
+    }
+}
+
+// Where a follower would arm, compared with where the leader did
+static void ottsr_group_sim_follow(const ottsr_group_phase_t *phase, gpointer user_data) {
+    ottsr_group_node_t *node = user_data;
+    ottsr_group_sim_t *sim = node->sim;
+    int index = phase->current_sessions;
+    if (index < 0 || index >= sim->phases) return;
+
+    gint64 error = ABS((phase->anchor - node->skew) - sim->anchors[index]);
+    node->errors[index] = MAX(node->errors[index], error);
+}
+
+static void ottsr_group_sim_publish(ottsr_group_sim_t *sim, gint64 anchor) {
+    ottsr_group_node_t *leader = &sim->nodes[0];
+    ottsr_group_phase_t phase = {0};
+    phase.state = sim->phase % 2 == 0 ? OTTSR_STATE_STUDYING : OTTSR_STATE_BREAKING;
+    phase.anchor = anchor;
+    phase.study_seconds = sim->phase_ms / 1000;
+    phase.break_seconds = sim->phase_ms / 1000;
+    phase.current_sessions = sim->phase;
+
+    sim->anchors[sim->phase] = anchor - leader->skew;
+    ottsr_group_publish(leader->group, &phase);
+}
+
+static gboolean ottsr_group_sim_quit(gpointer user_data) {
+    g_main_loop_quit(((ottsr_group_sim_t *)user_data)->loop);
+    return G_SOURCE_REMOVE;
+}
+
+// Leader phases are chained off the previous anchor, as the app's are
+static gboolean ottsr_group_sim_tick(gpointer user_data) {
+    ottsr_group_sim_t *sim = user_data;
+    gint64 anchor = sim->anchors[sim->phase] + sim->nodes[0].skew + (gint64)sim->phase_ms * 1000;
+
+    if (++sim->phase == sim->phases) {
+        g_timeout_add(OTTSR_GROUP_RETRY_MS, ottsr_group_sim_quit, sim);
+        return G_SOURCE_REMOVE;
+    }
+    ottsr_group_sim_publish(sim, anchor);
+    return G_SOURCE_CONTINUE;
+}
+
+// Followers join spread over the run, so some arrive mid-phase
+static gboolean ottsr_group_sim_join(gpointer user_data) {
+    ottsr_group_node_t *node = user_data;
+    node->first_phase = node->sim->phase;
+    node->group = ottsr_group_new("sim", FALSE, ottsr_group_sim_send, ottsr_group_sim_clock,
+                                  ottsr_group_sim_follow, node);
+    ottsr_group_join(node->group);
+    return G_SOURCE_REMOVE;
+}
+
+int main(int argc, char *argv[]) {
+    int followers = 5;
+    int phases = 10;
+    int phase_ms = 1000;
+    int delay_ms = 20;
+    int jitter_ms = 15;
+    double loss = 0.1;
+    int seed = 0;
+
+    GOptionEntry entries[] = {
+        { "followers", 'f', 0, G_OPTION_ARG_INT, &followers, "Number of followers", "N" },
+        { "phases", 'n', 0, G_OPTION_ARG_INT, &phases, "Number of phases the leader runs", "N" },
+        { "phase", 'p', 0, G_OPTION_ARG_INT, &phase_ms, "Phase length in milliseconds", "MS" },
+        { "delay", 'd', 0, G_OPTION_ARG_INT, &delay_ms, "Mean one-way delay in milliseconds", "MS" },
+        { "jitter", 'j', 0, G_OPTION_ARG_INT, &jitter_ms, "Delay jitter in milliseconds", "MS" },
+        { "loss", 'l', 0, G_OPTION_ARG_DOUBLE, &loss, "Fraction of packets dropped", "P" },
+        { "seed", 's', 0, G_OPTION_ARG_INT, &seed, "Random seed", "N" },
+        { NULL }
+    };
+
+    GOptionContext *context = g_option_context_new("- check study group sync under delay and loss");
+    g_option_context_add_main_entries(context, entries, NULL);
+    GError *error = NULL;
+    gboolean ok = g_option_context_parse(context, &argc, &argv, &error);
+    g_option_context_free(context);
+    if (!ok) {
+        g_printerr("ottsr-group-sim: %s\n", error->message);
+        g_error_free(error);
+        return 1;
+    }
+    if (seed != 0) g_random_set_seed((guint32)seed);
+
+    ottsr_group_sim_t sim = {0};
+    sim.count = MAX(1, followers) + 1;
+    sim.phases = MAX(1, phases);
+    sim.phase_ms = MAX(1000, phase_ms);
+    sim.delay_ms = MAX(0, delay_ms);
+    sim.jitter_ms = CLAMP(jitter_ms, 0, sim.delay_ms);
+    sim.loss = CLAMP(loss, 0.0, 0.9);
+    sim.loop = g_main_loop_new(NULL, FALSE);
+    sim.nodes = g_new0(ottsr_group_node_t, sim.count);
+    sim.anchors = g_new0(gint64, sim.phases);
+
+    for (int i = 0; i < sim.count; i++) {
+        ottsr_group_node_t *node = &sim.nodes[i];
+        node->sim = &sim;
+        node->index = i;
+        node->skew = (gint64)g_random_int_range(-3600, 3600) * G_USEC_PER_SEC + g_random_int_range(0, G_USEC_PER_SEC);
+        node->errors = g_new(gint64, sim.phases);
+        for (int p = 0; p < sim.phases; p++) node->errors[p] = -1;
+    }
+
+    // The first follower is there before the leader; the rest trickle in
+    sim.nodes[0].group = ottsr_group_new("sim", TRUE, ottsr_group_sim_send, ottsr_group_sim_clock,
+                                         ottsr_group_sim_follow, &sim.nodes[0]);
+    ottsr_group_sim_join(&sim.nodes[1]);
+    for (int i = 2; i < sim.count; i++) {
+        guint at = (guint)((gint64)sim.phase_ms * sim.phases * (i - 1) / sim.count);
+        g_timeout_add(at, ottsr_group_sim_join, &sim.nodes[i]);
+    }
+
+    ottsr_group_sim_publish(&sim, ottsr_group_sim_clock(&sim.nodes[0]));
+    g_timeout_add(sim.phase_ms, ottsr_group_sim_tick, &sim);
+    g_main_loop_run(sim.loop);
+
+    // A follower must pick up the phase it joined in (or the next, if the
+    // leader moved on during the handshake) and every phase after it, each
+    // within the bound
+    gboolean passed = TRUE;
+    gint64 worst = 0;
+    for (int i = 1; i < sim.count; i++) {
+        ottsr_group_node_t *node = &sim.nodes[i];
+        gint64 offset = 0, delay = 0;
+        gboolean synced = ottsr_group_get_offset(node->group, &offset, &delay);
+        gint64 true_offset = sim.nodes[0].skew - node->skew;
+        int from = MIN(node->first_phase + 1, sim.phases - 1);
+        if (node->errors[node->first_phase] >= 0) from = node->first_phase;
+        int expected = sim.phases - from;
+        int seen = 0, late = 0;
+        gint64 node_worst = 0;
+        for (int p = from; p < sim.phases; p++) {
+            if (node->errors[p] < 0) continue;
+            seen++;
+            if (node->errors[p] >= 100000) late++;
+            node_worst = MAX(node_worst, node->errors[p]);
+        }
+
+        g_print("follower %d: joined at phase %d, %s, offset error %.2f ms over %.1f ms, "
+                "%d/%d phases, %d over 100 ms, worst anchor error %.2f ms\n",
+                i, node->first_phase, synced ? "synced" : "NOT synced",
+                ABS(offset - true_offset) / 1000.0, delay / 1000.0,
+                seen, expected, late, node_worst / 1000.0);
+
+        if (!synced || seen != expected || late > 0) passed = FALSE;
+        worst = MAX(worst, node_worst);
+    }
+
+    g_print("%d followers, %d phases, %.0f%% loss, %d+-%d ms delay: %u packets (%u dropped), "
+            "worst anchor error %.2f ms: %s\n",
+            sim.count - 1, sim.phases, sim.loss * 100.0, sim.delay_ms, sim.jitter_ms,
+            sim.sent, sim.dropped, worst / 1000.0, passed ? "PASS" : "FAIL");
+
+    for (int i = 0; i < sim.count; i++) {
+        ottsr_group_free(sim.nodes[i].group);
+        g_free(sim.nodes[i].errors);
+    }
+    g_free(sim.anchors);
+    g_free(sim.nodes);
+    g_main_loop_unref(sim.loop);
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,116 @@
+#include "ottsr_harness.h"
+#ifdef G_OS_UNIX
+#include <signal.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#endif
+
+// Delete a file or a directory and everything in it; benchmarks use it to
+// drop their scratch homes
+void ottsr_remove_tree(const char *path) {
+    GDir *dir = g_dir_open(path, 0, NULL);
+    if (dir) {
+        const char *name;
+        while ((name = g_dir_read_name(dir))) {
+            char *child = g_build_filename(path, name, NULL);
+            ottsr_remove_tree(child);
+            g_free(child);
+        }
+        g_dir_close(dir);
+        g_rmdir(path);
+    } else {
+        g_unlink(path);
+    }
+}
+
+static gboolean ottsr_stall_run(gpointer user_data) {
+    ottsr_stall_t *stall = user_data;
+    gint64 length = g_random_int_range(0, (gint32)stall->max_us + 1);
+    stall->longest = MAX(stall->longest, length);
+    g_usleep(length);
+    return G_SOURCE_CONTINUE;
+}
+
+void ottsr_stall_start(ottsr_stall_t *stall, int interval_ms, gint64 max_us) {
+    stall->max_us = MAX(0, max_us);
+    stall->longest = 0;
+    stall->source_id = stall->max_us > 0 ? g_timeout_add(MAX(1, interval_ms), ottsr_stall_run, stall) : 0;
+}
+
+void ottsr_stall_stop(ottsr_stall_t *stall) {
+    if (stall->source_id > 0) {
+        g_source_remove(stall->source_id);
+        stall->source_id = 0;
+    }
+}
+
+// How late the timing thread fired; a deadline armed after it had passed
+// fires at once, so that one counts from the arm
+gint64 ottsr_fire_late(const ottsr_clock_event_t *event, gint64 armed_at) {
+    return event->fired_at - MAX(event->deadline, armed_at);
+}
+
+static gint ottsr_samples_compare(gconstpointer a, gconstpointer b) {
+    gint64 x = *(const gint64 *)a;
+    gint64 y = *(const gint64 *)b;
+    return x < y ? -1 : x > y;
+}
+
+void ottsr_samples_sort(GArray *samples) {
+    g_array_sort(samples, ottsr_samples_compare);
+}
+
+// Nearest-rank percentile of sorted gint64 samples
+gint64 ottsr_samples_percentile(GArray *samples, double p) {
+    if (samples->len == 0) return 0;
+    guint rank = (guint)(p * (samples->len - 1) + 0.5);
+    return g_array_index(samples, gint64, rank);
+}
+
+#ifdef G_OS_UNIX
+// Without a display, a private broadwayd stands in for one; windows then
+// paint into client-side image surfaces only
+GPid ottsr_broadway_start(void) {
+    int display = 50 + getpid() % 50;
+    char *name = g_strdup_printf(":%d", display);
+    char *argv[] = { "broadwayd", name, NULL };
+    GPid pid = 0;
+    GError *error = NULL;
+
+    if (!g_spawn_async(NULL, argv, NULL,
+                       G_SPAWN_SEARCH_PATH | G_SPAWN_DO_NOT_REAP_CHILD |
+                       G_SPAWN_STDOUT_TO_DEV_NULL | G_SPAWN_STDERR_TO_DEV_NULL,
+                       NULL, NULL, &pid, &error)) {
+        g_print("No display, and broadwayd could not start: %s\n", error->message);
+        g_error_free(error);
+        g_free(name);
+        return 0;
+    }
+
+    g_setenv("GDK_BACKEND", "broadway", TRUE);
+    g_setenv("BROADWAY_DISPLAY", name, TRUE);
+    g_free(name);
+    return pid;
+}
+
+void ottsr_broadway_stop(GPid pid) {
+    kill(pid, SIGTERM);
+    waitpid(pid, NULL, 0);
+    g_spawn_close_pid(pid);
+}
+
+// The display comes up while broadwayd starts listening
+gboolean ottsr_display_open(GPid broadway) {
+    gint64 deadline = g_get_monotonic_time() + 5 * G_USEC_PER_SEC;
+
+    if (broadway) g_usleep(G_USEC_PER_SEC / 5);
+    while (!gtk_init_check(NULL, NULL)) {
+        if (!broadway || g_get_monotonic_time() >= deadline ||
+            waitpid(broadway, NULL, WNOHANG) != 0) {
+            return FALSE;
+        }
+        g_usleep(G_USEC_PER_SEC / 10);
+    }
+    return TRUE;
+}
+#endif
@@ -0,0 +1,27 @@
+#ifndef OTTSR_HARNESS_H
+#define OTTSR_HARNESS_H
+
+#include "ottsr.h"
+
+// Blocks the main loop every so often for a random while, up to max_us,
+// like a slow relayout or a nested dialog would
+typedef struct {
+    gint64 max_us;
+    gint64 longest;
+    guint source_id;
+} ottsr_stall_t;
+
+// Helpers shared by the benchmark and check programs (ottsr_harness.c)
+void ottsr_remove_tree(const char *path);
+void ottsr_stall_start(ottsr_stall_t *stall, int interval_ms, gint64 max_us);
+void ottsr_stall_stop(ottsr_stall_t *stall);
+gint64 ottsr_fire_late(const ottsr_clock_event_t *event, gint64 armed_at);
+void ottsr_samples_sort(GArray *samples);
+gint64 ottsr_samples_percentile(GArray *samples, double p);
+#ifdef G_OS_UNIX
+GPid ottsr_broadway_start(void);
+void ottsr_broadway_stop(GPid pid);
+gboolean ottsr_display_open(GPid broadway);
+#endif
+
+#endif // OTTSR_HARNESS_H
@@ -0,0 +1,86 @@
+#include "ottsr_harness.h"
+
+// `ottsr-history-check`: cut history.dat off in the middle of a record, as
+// a crash during a write does, append after it and read everything back
+
+static ottsr_history_record_t ottsr_history_check_record(int i) {
+    ottsr_history_record_t record = {0};
+    record.started_at = 1700000000 + i * 3600;
+    record.study_seconds = 1500 + i;
+    record.completed = i % 2;
+    g_strlcpy(record.profile, "Pomodoro", OTTSR_MAX_NAME_LEN);
+    g_snprintf(record.subject, OTTSR_MAX_NAME_LEN, "Subject %d", i);
+    return record;
+}
+
+// Write the first bytes of one more record straight to the file
+static void ottsr_history_check_tear(const char *path, gsize bytes) {
+    ottsr_history_record_t record = ottsr_history_check_record(999);
+    FILE *file = fopen(path, "ab");
+    if (!file) return;
+    fwrite(&record, 1, bytes, file);
+    fclose(file);
+}
+
+// The records read back must be exactly the ones appended, in order
+static gboolean ottsr_history_check_expect(const char *label, const int *expected, guint count) {
+    GArray *records = ottsr_history_read(0);
+    gboolean ok = records->len == count;
+    for (guint i = 0; ok && i < count; i++) {
+        ottsr_history_record_t want = ottsr_history_check_record(expected[i]);
+        const ottsr_history_record_t *got = &g_array_index(records, ottsr_history_record_t, i);
+        ok = got->started_at == want.started_at && got->study_seconds == want.study_seconds &&
+             got->completed == want.completed && strcmp(got->profile, want.profile) == 0 &&
+             strcmp(got->subject, want.subject) == 0;
+    }
+
+    g_print("%s: %u records read back, %u expected: %s\n", label, records->len, count, ok ? "PASS" : "FAIL");
+    g_array_unref(records);
+    return ok;
+}
+
+int main(int argc, char *argv[]) {
+    (void)argc;
+    (void)argv;
+
+    // History goes to a scratch home, not the user's
+    char *home = g_dir_make_tmp("ottsr-history-XXXXXX", NULL);
+    if (!home) {
+        g_printerr("ottsr-history-check: cannot create a scratch home directory\n");
+        return 1;
+    }
+    g_setenv("HOME", home, TRUE);
+    g_unsetenv(OTTSR_KIOSK_ENV);
+
+    char *config_dir = ottsr_get_config_path();
+    g_mkdir_with_parents(config_dir, 0755);
+    char *path = g_build_filename(config_dir, OTTSR_HISTORY_FILE, NULL);
+    gboolean ok = TRUE;
+
+    // A torn record after whole ones
+    for (int i = 0; i < 3; i++) {
+        ottsr_history_record_t record = ottsr_history_check_record(i);
+        ok = ottsr_history_append(&record) && ok;
+    }
+    ottsr_history_check_tear(path, sizeof(ottsr_history_record_t) / 2);
+    for (int i = 3; i < 5; i++) {
+        ottsr_history_record_t record = ottsr_history_check_record(i);
+        ok = ottsr_history_append(&record) && ok;
+    }
+    const int torn_record[] = { 0, 1, 2, 3, 4 };
+    ok = ottsr_history_check_expect("Torn record", torn_record, G_N_ELEMENTS(torn_record)) && ok;
+
+    // A torn header in a file that never got a whole record
+    g_unlink(path);
+    ottsr_history_check_tear(path, 5);
+    ottsr_history_record_t record = ottsr_history_check_record(5);
+    ok = ottsr_history_append(&record) && ok;
+    const int torn_header[] = { 5 };
+    ok = ottsr_history_check_expect("Torn header", torn_header, G_N_ELEMENTS(torn_header)) && ok;
+
+    g_free(path);
+    g_free(config_dir);
+    ottsr_remove_tree(home);
+    g_free(home);
+    return ok ? 0 : 1;
+}
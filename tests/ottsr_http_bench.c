@@ -0,0 +1,192 @@
+#include "ottsr_harness.h"
+
+// `ottsr-http-bench`: hammer a loopback status server from several threads
+// while the status is republished underneath them
+typedef struct {
+    guint16 port;
+    gint *next;
+    int total;
+    int ok;
+    int failed;
+    gint64 total_latency;
+    gint64 max_latency;
+} ottsr_http_bench_worker_t;
+
+typedef struct {
+    guint16 port;
+    gint subscribed;
+    int events;
+} ottsr_http_bench_watcher_t;
+
+static GSocketConnection *ottsr_http_bench_connect(GSocketClient *client, guint16 port, const char *path) {
+    GSocketConnection *connection = g_socket_client_connect_to_host(client, "127.0.0.1", port, NULL, NULL);
+    if (!connection) return NULL;
+
+    char request[128];
+    int length = snprintf(request, sizeof(request), "GET %s HTTP/1.1\r\nHost: 127.0.0.1\r\n\r\n", path);
+    GOutputStream *out = g_io_stream_get_output_stream(G_IO_STREAM(connection));
+    if (!g_output_stream_write_all(out, request, length, NULL, NULL, NULL)) {
+        g_object_unref(connection);
+        return NULL;
+    }
+    return connection;
+}
+
+static gboolean ottsr_http_bench_get(GSocketClient *client, guint16 port) {
+    GSocketConnection *connection = ottsr_http_bench_connect(client, port, "/status");
+    if (!connection) return FALSE;
+
+    char reply[2048];
+    gsize length = 0;
+    GInputStream *in = g_io_stream_get_input_stream(G_IO_STREAM(connection));
+    for (;;) {
+        gssize count = g_input_stream_read(in, reply + length, sizeof(reply) - 1 - length, NULL, NULL);
+        if (count <= 0) break;
+        length += count;
+        if (length == sizeof(reply) - 1) break;
+    }
+    reply[length] = '\0';
+    g_object_unref(connection);
+
+    return g_str_has_prefix(reply, "HTTP/1.1 200 ") && strstr(reply, "\r\n\r\n{");
+}
+
+static gpointer ottsr_http_bench_thread(gpointer data) {
+    ottsr_http_bench_worker_t *worker = data;
+    GSocketClient *client = g_socket_client_new();
+
+    while (g_atomic_int_add(worker->next, 1) < worker->total) {
+        gint64 start = g_get_monotonic_time();
+        if (ottsr_http_bench_get(client, worker->port)) {
+            worker->ok++;
+        } else {
+            worker->failed++;
+        }
+        gint64 latency = g_get_monotonic_time() - start;
+        worker->total_latency += latency;
+        worker->max_latency = MAX(worker->max_latency, latency);
+    }
+
+    g_object_unref(client);
+    return NULL;
+}
+
+// Holds one event stream open for the whole run and counts what arrives
+static gpointer ottsr_http_bench_watch(gpointer data) {
+    ottsr_http_bench_watcher_t *watcher = data;
+    GSocketClient *client = g_socket_client_new();
+    GSocketConnection *connection = ottsr_http_bench_connect(client, watcher->port, "/events");
+
+    if (connection) {
+        GString *stream = g_string_new(NULL);
+        GInputStream *in = g_io_stream_get_input_stream(G_IO_STREAM(connection));
+        char buffer[4096];
+        gssize count;
+
+        while ((count = g_input_stream_read(in, buffer, sizeof(buffer), NULL, NULL)) > 0) {
+            g_string_append_len(stream, buffer, count);
+            if (strstr(stream->str, "event: status")) g_atomic_int_set(&watcher->subscribed, 1);
+        }
+
+        for (const char *p = stream->str; (p = strstr(p, "event: status")) != NULL; p++) {
+            watcher->events++;
+        }
+        g_string_free(stream, TRUE);
+        g_object_unref(connection);
+    }
+
+    // Unblocks the main thread if the stream never came up
+    g_atomic_int_set(&watcher->subscribed, 1);
+    g_object_unref(client);
+    return NULL;
+}
+
+int main(int argc, char *argv[]) {
+    int clients = 8;
+    int requests = 20000;
+    int updates = 200;
+
+    GOptionEntry entries[] = {
+        { "clients", 'c', 0, G_OPTION_ARG_INT, &clients, "Concurrent client threads", "N" },
+        { "requests", 'n', 0, G_OPTION_ARG_INT, &requests, "Total status requests", "N" },
+        { "updates", 'u', 0, G_OPTION_ARG_INT, &updates, "Status changes pushed during the run", "N" },
+        { NULL }
+    };
+
+    GOptionContext *context = g_option_context_new("- load-test the status server over loopback");
+    g_option_context_add_main_entries(context, entries, NULL);
+    GError *error = NULL;
+    gboolean ok = g_option_context_parse(context, &argc, &argv, &error);
+    g_option_context_free(context);
+    if (!ok) {
+        g_printerr("ottsr-http-bench: %s\n", error->message);
+        g_error_free(error);
+        return 1;
+    }
+
+    clients = MAX(1, clients);
+    requests = MAX(1, requests);
+    updates = MAX(0, updates);
+
+    ottsr_http_server_t *server = ottsr_http_server_new("127.0.0.1", 0);
+    if (!server) return 1;
+    guint16 port = ottsr_http_server_get_port(server);
+
+    ottsr_http_bench_watcher_t watcher = { port, 0, 0 };
+    GThread *watch_thread = g_thread_new("ottsr-http-watch", ottsr_http_bench_watch, &watcher);
+    while (!g_atomic_int_get(&watcher.subscribed)) g_usleep(1000);
+
+    gint next = 0;
+    ottsr_http_bench_worker_t *workers = g_new0(ottsr_http_bench_worker_t, clients);
+    GThread **threads = g_new0(GThread *, clients);
+    gint64 start = g_get_monotonic_time();
+
+    for (int i = 0; i < clients; i++) {
+        workers[i].port = port;
+        workers[i].next = &next;
+        workers[i].total = requests;
+        threads[i] = g_thread_new("ottsr-http-bench", ottsr_http_bench_thread, &workers[i]);
+    }
+
+    // Stand-in for the main loop: what publishing costs is all the UI pays
+    gint64 publish_time = 0;
+    for (int i = 0; i < updates; i++) {
+        char json[128];
+        int length = snprintf(json, sizeof(json),
+                              "{\"state\":\"studying\",\"sessions\":%d,\"updated_at\":%" G_GINT64_FORMAT "}",
+                              i, g_get_real_time() / G_USEC_PER_SEC);
+        gint64 before = g_get_monotonic_time();
+        ottsr_http_server_publish(server, json, length);
+        publish_time += g_get_monotonic_time() - before;
+        g_usleep(1000);
+    }
+
+    int served = 0, failed = 0;
+    gint64 total_latency = 0, max_latency = 0;
+    for (int i = 0; i < clients; i++) {
+        g_thread_join(threads[i]);
+        served += workers[i].ok;
+        failed += workers[i].failed;
+        total_latency += workers[i].total_latency;
+        max_latency = MAX(max_latency, workers[i].max_latency);
+    }
+    double seconds = (g_get_monotonic_time() - start) / (double)G_USEC_PER_SEC;
+
+    // Let the last events drain, then closing the server ends the stream
+    g_usleep(100000);
+    ottsr_http_server_free(server);
+    g_thread_join(watch_thread);
+
+    int expected = updates + 1;
+    gboolean passed = failed == 0 && watcher.events == expected;
+    g_print("%d requests from %d clients in %.2f s: %.0f req/s, latency avg %.0f us / max %.1f ms, "
+            "%d failed\n", served + failed, clients, seconds, (served + failed) / seconds,
+            (double)total_latency / (served + failed), max_latency / 1000.0, failed);
+    g_print("%d status updates published at %.1f us each, %d/%d events streamed: %s\n",
+            updates, updates > 0 ? (double)publish_time / updates : 0.0,
+            watcher.events, expected, passed ? "PASS" : "FAIL");
+
+    g_free(threads);
+    g_free(workers);
+    return passed ? 0 : 1;
+}
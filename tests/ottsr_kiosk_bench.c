@@ -0,0 +1,240 @@
+#include "ottsr_harness.h"
+
+// `ottsr-kiosk-bench`: the real main window in kiosk mode, handed from
+// student to student with a session running each time. Every switch ends
+// that session, so the outgoing user's history, notes and settings are
+// written while the next user comes in; the switch itself must not wait
+// for them. Afterwards each student's files are read back: every session
+// must be in its owner's history and nobody else's.
+
+typedef struct {
+    ottsr_app_t app;
+    int users;
+    int rounds;
+    int limit_ms;
+    char *root;
+    GArray *samples;
+    int *sessions;
+    gboolean mixed;
+    int status;
+} ottsr_kiosk_bench_t;
+
+static char *ottsr_kiosk_bench_user(int i) {
+    return g_strdup_printf("student-%02d", i);
+}
+
+// Every student has settings of their own, with a profile named after them
+static gboolean ottsr_kiosk_bench_seed(ottsr_kiosk_bench_t *bench) {
+    for (int i = 0; i < bench->users; i++) {
+        char *user = ottsr_kiosk_bench_user(i);
+        char *dir = g_build_filename(bench->root, user, NULL);
+        char *path = g_build_filename(dir, OTTSR_CONFIG_FILE, NULL);
+
+        ottsr_config_t config;
+        memset(&config, 0, sizeof(config));
+        ottsr_config_set_defaults(&config);
+        g_snprintf(config.profiles[0].name, OTTSR_MAX_NAME_LEN, "Course of %s", user);
+
+        gsize length = 0;
+        char *json = ottsr_config_to_json(&config, &length);
+        gboolean ok = g_mkdir_with_parents(dir, 0755) == 0 &&
+                      g_file_set_contents(path, json, length, NULL);
+        g_free(json);
+        g_free(path);
+        g_free(dir);
+        g_free(user);
+        if (!ok) return FALSE;
+    }
+    return TRUE;
+}
+
+// A session that has been studying for two minutes, with a note
+static void ottsr_kiosk_bench_study(ottsr_app_t *app, int switch_index) {
+    char *subject = g_strdup_printf("Subject %d", switch_index % 7);
+    gtk_entry_set_text(GTK_ENTRY(app->subject_entry), subject);
+    g_free(subject);
+
+    ottsr_start_session(app);
+    app->phase_anchor -= 120 * G_USEC_PER_SEC;
+    if (app->note_entry) gtk_entry_set_text(GTK_ENTRY(app->note_entry), "kiosk bench");
+}
+
+static void ottsr_kiosk_bench_activate(GtkApplication *gtk_app, gpointer user_data) {
+    ottsr_kiosk_bench_t *bench = (ottsr_kiosk_bench_t *)user_data;
+    ottsr_app_t *app = &bench->app;
+
+    ottsr_init_app(app);
+    app->app = gtk_app;
+    for (int i = 0; i < app->config.profile_count; i++) {
+        app->config.profiles[i].sound_enabled = FALSE;
+        app->config.profiles[i].notifications_enabled = FALSE;
+    }
+
+    ottsr_create_main_window(app);
+    if (!app->main_window || !app->kiosk) {
+        bench->status = 1;
+        return;
+    }
+    while (gtk_events_pending()) {
+        gtk_main_iteration();
+    }
+
+    // The window starts with the guest, who counts as one more user
+    int current = bench->users;
+    int switches = bench->rounds * bench->users;
+    for (int k = 0; k < switches; k++) {
+        int next = (k * 5 + 1) % bench->users;
+        if (next == current) next = (next + 1) % bench->users;
+        char *user = ottsr_kiosk_bench_user(next);
+
+        ottsr_kiosk_bench_study(app, k);
+        gint64 start = g_get_monotonic_time();
+        gboolean ok = ottsr_kiosk_switch(app, user);
+        gint64 elapsed = g_get_monotonic_time() - start;
+        g_array_append_val(bench->samples, elapsed);
+
+        char *expected = g_strdup_printf("Course of %s", user);
+        if (!ok || strcmp(app->config.profiles[0].name, expected) != 0) bench->mixed = TRUE;
+        g_free(expected);
+        g_free(user);
+
+        bench->sessions[current]++;
+        current = next;
+
+        // Loads for the new user finish between switches, as they would
+        // while a student sits down
+        while (gtk_events_pending()) {
+            gtk_main_iteration();
+        }
+    }
+
+    // With its last window gone the application returns from run
+    gtk_widget_destroy(app->main_window);
+    app->main_window = NULL;
+}
+
+// Sessions in one student's history, and whether each has its note
+static guint ottsr_kiosk_bench_count(const char *root, const char *user, gboolean *noted) {
+    char *history = g_build_filename(root, user, OTTSR_HISTORY_FILE, NULL);
+    char *notes_path = g_build_filename(root, user, OTTSR_NOTES_FILE, NULL);
+    GArray *records = ottsr_history_read_file(history, 0);
+    GHashTable *notes = ottsr_notes_read_file(notes_path);
+
+    *noted = TRUE;
+    for (guint i = 0; i < records->len; i++) {
+        gint64 started_at = g_array_index(records, ottsr_history_record_t, i).started_at;
+        *noted = *noted && g_hash_table_contains(notes, &started_at);
+    }
+    guint count = records->len;
+
+    g_hash_table_unref(notes);
+    g_array_unref(records);
+    g_free(notes_path);
+    g_free(history);
+    return count;
+}
+
+static int ottsr_kiosk_bench_report(ottsr_kiosk_bench_t *bench) {
+    gboolean kept = TRUE;
+    for (int i = 0; i <= bench->users; i++) {
+        char *user = i < bench->users ? ottsr_kiosk_bench_user(i) : g_strdup(OTTSR_KIOSK_GUEST);
+        gboolean noted = FALSE;
+        guint count = ottsr_kiosk_bench_count(bench->root, user, &noted);
+        if (count != (guint)bench->sessions[i] || !noted) {
+            g_print("  %s: %u sessions on disk, %d ended\n", user, count, bench->sessions[i]);
+            kept = FALSE;
+        }
+        g_free(user);
+    }
+
+    ottsr_samples_sort(bench->samples);
+    gint64 p50 = ottsr_samples_percentile(bench->samples, 0.50);
+    gint64 p95 = ottsr_samples_percentile(bench->samples, 0.95);
+    gint64 worst = ottsr_samples_percentile(bench->samples, 1.0);
+    gboolean fast = p95 < (gint64)bench->limit_ms * 1000;
+
+    g_print("%u switches between %d students, each ending a session\n", bench->samples->len, bench->users);
+    g_print("  switch p50 %.2f ms  p95 %.2f ms  max %.2f ms\n", p50 / 1000.0, p95 / 1000.0, worst / 1000.0);
+    g_print("Each student sees their own settings: %s\n", bench->mixed ? "FAIL" : "PASS");
+    g_print("Every session in its owner's history: %s\n", kept ? "PASS" : "FAIL");
+    g_print("p95 switch under %d ms: %s\n", bench->limit_ms, fast ? "PASS" : "FAIL");
+    return !bench->mixed && kept && fast ? 0 : 1;
+}
+
+int main(int argc, char *argv[]) {
+    ottsr_kiosk_bench_t bench = {0};
+    gboolean broadway = FALSE;
+    bench.users = 6;
+    bench.rounds = 10;
+    bench.limit_ms = 50;
+
+    GOptionEntry entries[] = {
+        { "users", 'u', 0, G_OPTION_ARG_INT, &bench.users, "Students sharing the kiosk", "N" },
+        { "rounds", 'r', 0, G_OPTION_ARG_INT, &bench.rounds, "Switches per student", "N" },
+        { "limit", 'l', 0, G_OPTION_ARG_INT, &bench.limit_ms, "Fail if the p95 switch takes this long", "MS" },
+        { "broadway", 'b', 0, G_OPTION_ARG_NONE, &broadway, "Run on a private broadwayd even with a display", NULL },
+        { NULL }
+    };
+
+    GOptionContext *context = g_option_context_new("- time kiosk user switches that end a session");
+    g_option_context_add_main_entries(context, entries, NULL);
+    GError *error = NULL;
+    gboolean ok = g_option_context_parse(context, &argc, &argv, &error);
+    g_option_context_free(context);
+    if (!ok) {
+        g_printerr("ottsr-kiosk-bench: %s\n", error->message);
+        g_error_free(error);
+        return 1;
+    }
+    bench.users = CLAMP(bench.users, 2, OTTSR_KIOSK_CACHE_SIZE * 2);
+    bench.rounds = MAX(1, bench.rounds);
+    bench.limit_ms = MAX(1, bench.limit_ms);
+
+    // Students go to a kiosk root in a scratch home
+    char *home = g_dir_make_tmp("ottsr-kiosk-XXXXXX", NULL);
+    if (!home) {
+        g_printerr("ottsr-kiosk-bench: cannot create a scratch home directory\n");
+        return 1;
+    }
+    bench.root = g_build_filename(home, "kiosk", NULL);
+    g_setenv("HOME", home, TRUE);
+    g_setenv(OTTSR_KIOSK_ENV, bench.root, TRUE);
+
+    if (!ottsr_kiosk_bench_seed(&bench)) {
+        g_printerr("ottsr-kiosk-bench: cannot write student settings\n");
+        bench.status = 1;
+    } else {
+        GPid broadwayd = 0;
+        if (broadway || (!g_getenv("GDK_BACKEND") && !g_getenv("DISPLAY") && !g_getenv("WAYLAND_DISPLAY"))) {
+            broadwayd = ottsr_broadway_start();
+        }
+
+        if (!ottsr_display_open(broadwayd)) {
+            // 77 is the usual "skipped" status for test runners
+            g_print("No display for the main window; install broadwayd or run under xvfb-run\n");
+            bench.status = 77;
+        } else {
+            bench.samples = g_array_new(FALSE, FALSE, sizeof(gint64));
+            bench.sessions = g_new0(int, bench.users + 1);
+
+            GtkApplication *gtk_app = gtk_application_new("com.github.g-flame.ottsr.KioskBench",
+                                                          G_APPLICATION_NON_UNIQUE);
+            g_signal_connect(gtk_app, "activate", G_CALLBACK(ottsr_kiosk_bench_activate), &bench);
+            g_application_run(G_APPLICATION(gtk_app), 0, NULL);
+
+            // Stopping the kiosk waits for the writer, so the files are complete
+            ottsr_cleanup_app(&bench.app);
+            g_object_unref(gtk_app);
+            if (bench.status == 0) bench.status = ottsr_kiosk_bench_report(&bench);
+
+            g_free(bench.sessions);
+            g_array_unref(bench.samples);
+        }
+        if (broadwayd) ottsr_broadway_stop(broadwayd);
+    }
+
+    ottsr_remove_tree(home);
+    g_free(bench.root);
+    g_free(home);
+    return bench.status;
+}
@@ -0,0 +1,117 @@
+#include "ottsr_harness.h"
+
+// `ottsr-plan-bench`: load a large synthetic timetable and plan a year of
+// study days against it, timing both
+
+static const char *ottsr_plan_bench_weekdays[] = { "MO", "TU", "WE", "TH", "FR" };
+
+// Weekly lectures over four years, as a university timetable export has
+// them, plus one-off appointments
+static GString *ottsr_plan_bench_calendar(gint32 today, int series, int singles) {
+    GString *ics = g_string_new("BEGIN:VCALENDAR\r\nVERSION:2.0\r\nPRODID:-//ottsr//bench//EN\r\n");
+
+    for (int i = 0; i < series; i++) {
+        int year, month, day;
+        ottsr_civil_from_days(today - 2 * 365 + g_random_int_range(0, 7), &year, &month, &day);
+        int hour = g_random_int_range(8, 19);
+        int minute = g_random_int_range(0, 4) * 15;
+        g_string_append_printf(ics,
+            "BEGIN:VEVENT\r\nUID:series-%d@ottsr\r\nSUMMARY:Lecture %d\r\n"
+            "DTSTART:%04d%02d%02dT%02d%02d00\r\nDURATION:PT%dM\r\n"
+            "RRULE:FREQ=WEEKLY;INTERVAL=%d;BYDAY=%s;COUNT=%d\r\n",
+            i, i, year, month, day, hour, minute, g_random_int_range(3, 13) * 15,
+            g_random_int_range(1, 3), ottsr_plan_bench_weekdays[g_random_int_range(0, 5)], 4 * 52);
+        if (i % 10 == 0) {
+            g_string_append_printf(ics, "EXDATE:%04d%02d%02dT%02d%02d00\r\n",
+                                   year + 1, month, MIN(day, 28), hour, minute);
+        }
+        g_string_append(ics, "END:VEVENT\r\n");
+    }
+
+    for (int i = 0; i < singles; i++) {
+        int year, month, day;
+        ottsr_civil_from_days(today + g_random_int_range(-365, 366), &year, &month, &day);
+        g_string_append_printf(ics,
+            "BEGIN:VEVENT\r\nUID:single-%d@ottsr\r\nSUMMARY:Appointment\r\n"
+            "DTSTART:%04d%02d%02dT%02d%02d00\r\nDURATION:PT%dM\r\nEND:VEVENT\r\n",
+            i, year, month, day, g_random_int_range(7, 21), g_random_int_range(0, 60),
+            g_random_int_range(2, 9) * 15);
+    }
+
+    g_string_append(ics, "END:VCALENDAR\r\n");
+    return ics;
+}
+
+static int ottsr_plan_bench(const ottsr_profile_t *profile, int from_minutes, int to_minutes, int min_study,
+                            int days) {
+    gint32 today = ottsr_local_day(g_get_real_time() / G_USEC_PER_SEC, NULL, NULL);
+    int series = 200;
+    int singles = 5000;
+
+    GString *ics = ottsr_plan_bench_calendar(today, series, singles);
+    ottsr_calendar_t *calendar = ottsr_calendar_new();
+    GTimeZone *local = g_time_zone_new_local();
+
+    gint64 start = g_get_monotonic_time();
+    ottsr_calendar_parse(calendar, ics->str, ics->len);
+    ottsr_calendar_index(calendar);
+    gint64 loaded = g_get_monotonic_time();
+
+    guint busy_blocks = 0, study_blocks = 0;
+    for (int i = 0; i < days; i++) {
+        gint64 from = ottsr_plan_to_unix(local, today + i, from_minutes * 60);
+        gint64 to = ottsr_plan_to_unix(local, today + i, to_minutes * 60);
+        GArray *busy = ottsr_calendar_busy(calendar, from, to);
+        GArray *plan = ottsr_plan_layout(profile, busy, from, to, min_study * 60);
+
+        busy_blocks += busy->len;
+        for (guint j = 0; j < plan->len; j++) {
+            study_blocks += g_array_index(plan, ottsr_plan_block_t, j).kind == OTTSR_PLAN_STUDY;
+        }
+        g_array_unref(plan);
+        g_array_unref(busy);
+    }
+    gint64 planned = g_get_monotonic_time();
+
+    g_print("%d weekly series (%d instances) and %d single events, %.1f KiB of iCalendar\n",
+            series, series * 4 * 52, singles, ics->len / 1024.0);
+    g_print("Parsed and indexed in %.2f ms\n", (loaded - start) / 1000.0);
+    g_print("Planned %d days in %.2f ms (%.1f us per day): %u busy blocks, %u study blocks\n",
+            days, (planned - loaded) / 1000.0, (planned - loaded) / (double)days, busy_blocks, study_blocks);
+
+    g_time_zone_unref(local);
+    ottsr_calendar_free(calendar);
+    g_string_free(ics, TRUE);
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    int days = 365;
+    int min_study = OTTSR_PLAN_MIN_STUDY;
+    int seed = 0;
+
+    GOptionEntry entries[] = {
+        { "days", 'n', 0, G_OPTION_ARG_INT, &days, "Number of days to plan", "N" },
+        { "min-study", 0, 0, G_OPTION_ARG_INT, &min_study, "Shortest study block worth keeping in minutes", "MIN" },
+        { "seed", 's', 0, G_OPTION_ARG_INT, &seed, "Random seed for the timetable", "N" },
+        { NULL }
+    };
+
+    GOptionContext *context = g_option_context_new("- time timetable loading and planning");
+    g_option_context_add_main_entries(context, entries, NULL);
+    GError *error = NULL;
+    gboolean ok = g_option_context_parse(context, &argc, &argv, &error);
+    g_option_context_free(context);
+    if (!ok) {
+        g_printerr("ottsr-plan-bench: %s\n", error->message);
+        g_error_free(error);
+        return 1;
+    }
+    if (seed != 0) g_random_set_seed((guint32)seed);
+
+    // The default profile, so the numbers do not depend on whoever runs it
+    ottsr_config_t config = {0};
+    ottsr_config_set_defaults(&config);
+    return ottsr_plan_bench(&config.profiles[0], OTTSR_PLAN_DAY_START, OTTSR_PLAN_DAY_END,
+                            MAX(1, min_study), MAX(1, days));
+}
@@ -0,0 +1,344 @@
+#include "ottsr_harness.h"
+
+// `ottsr-render-bench`: the real main window, moved into a
+// GtkOffscreenWindow and driven through a scripted session. Each state
+// change is timed over the frame GTK draws for it, split at the frame
+// clock's phases: styles and sizes are recomputed in "layout", and the
+// damaged region is drawn in "paint". Both are what a remote desktop
+// session pays for every frame before anything is sent.
+
+typedef enum {
+    OTTSR_RENDER_RESTYLE,
+    OTTSR_RENDER_START,
+    OTTSR_RENDER_TICK,
+    OTTSR_RENDER_PAUSE,
+    OTTSR_RENDER_RESUME,
+    OTTSR_RENDER_BREAK,
+    OTTSR_RENDER_STOP,
+    OTTSR_RENDER_STEPS
+} ottsr_render_step_t;
+
+static const char *ottsr_render_step_names[OTTSR_RENDER_STEPS] = {
+    "restyle", "start", "tick", "pause", "resume", "break", "stop"
+};
+
+// Light and dark are the GTK theme's two variants under our stylesheet;
+// plain drops OTTSR_CSS_STYLE to show what its gradients and shadows cost
+typedef struct {
+    const char *name;
+    gboolean dark;
+    gboolean stylesheet;
+} ottsr_render_theme_t;
+
+static const ottsr_render_theme_t ottsr_render_themes[] = {
+    { "light", FALSE, TRUE },
+    { "dark", TRUE, TRUE },
+    { "plain", FALSE, FALSE },
+};
+
+typedef struct {
+    ottsr_app_t app;
+    GtkWidget *window;
+    GdkFrameClock *clock;
+    const char *theme;
+    int ticks;
+    int rounds;
+    int frame_timeout_ms;
+    int status;
+
+    // The frame being timed
+    ottsr_render_step_t step;
+    gboolean recording;
+    gboolean timed_out;
+    gint64 frame_start;
+    gint64 layout_end;
+    gint64 paint_end;
+    GArray *layout[OTTSR_RENDER_STEPS];
+    GArray *paint[OTTSR_RENDER_STEPS];
+} ottsr_render_bench_t;
+
+// The phase handlers are connected "after", so they run once GTK's own
+// layout and paint handlers are done
+static void on_render_before_paint(GdkFrameClock *clock, ottsr_render_bench_t *bench) {
+    bench->frame_start = g_get_monotonic_time();
+    bench->layout_end = bench->frame_start;
+    bench->paint_end = bench->frame_start;
+}
+
+static void on_render_layout(GdkFrameClock *clock, ottsr_render_bench_t *bench) {
+    bench->layout_end = g_get_monotonic_time();
+    bench->paint_end = bench->layout_end;
+}
+
+static void on_render_paint(GdkFrameClock *clock, ottsr_render_bench_t *bench) {
+    bench->paint_end = g_get_monotonic_time();
+}
+
+static void on_render_after_paint(GdkFrameClock *clock, ottsr_render_bench_t *bench) {
+    if (!bench->recording) return;
+
+    gint64 layout = bench->layout_end - bench->frame_start;
+    gint64 paint = bench->paint_end - bench->layout_end;
+    g_array_append_val(bench->layout[bench->step], layout);
+    g_array_append_val(bench->paint[bench->step], paint);
+    bench->recording = FALSE;
+}
+
+static gboolean ottsr_render_timeout(gpointer user_data) {
+    ottsr_render_bench_t *bench = user_data;
+    bench->timed_out = TRUE;
+    return G_SOURCE_REMOVE;
+}
+
+// Apply one scripted state change and wait for the frame that shows it. A
+// frame that never comes fails the run; later steps are then skipped.
+static void ottsr_render_step(ottsr_render_bench_t *bench, ottsr_render_step_t step) {
+    ottsr_app_t *app = &bench->app;
+    if (bench->status != 0) return;
+
+    switch (step) {
+        case OTTSR_RENDER_START:
+            ottsr_start_session(app);
+            break;
+        case OTTSR_RENDER_TICK:
+            // A second passes without waiting for it
+            app->phase_anchor -= G_USEC_PER_SEC;
+            ottsr_timer_callback(app);
+            break;
+        case OTTSR_RENDER_PAUSE:
+        case OTTSR_RENDER_RESUME:
+            ottsr_pause_session(app);
+            break;
+        case OTTSR_RENDER_BREAK:
+            ottsr_phase_advance(app, g_get_monotonic_time());
+            break;
+        case OTTSR_RENDER_STOP:
+            ottsr_stop_session(app);
+            break;
+        default:
+            break;
+    }
+
+    // A frame is drawn even when nothing was damaged, and then costs nothing
+    bench->step = step;
+    bench->recording = TRUE;
+    bench->timed_out = FALSE;
+    guint timeout_id = g_timeout_add(bench->frame_timeout_ms, ottsr_render_timeout, bench);
+    gdk_frame_clock_request_phase(bench->clock, GDK_FRAME_CLOCK_PHASE_AFTER_PAINT);
+    while (bench->recording && !bench->timed_out) {
+        gtk_main_iteration();
+    }
+
+    if (bench->timed_out) {
+        bench->recording = FALSE;
+        bench->status = 1;
+        g_print("No frame for %s within %d ms: FAIL\n", ottsr_render_step_names[step], bench->frame_timeout_ms);
+    } else {
+        g_source_remove(timeout_id);
+    }
+}
+
+static void ottsr_render_theme_apply(ottsr_render_bench_t *bench, const ottsr_render_theme_t *theme) {
+    GdkScreen *screen = gdk_screen_get_default();
+    GtkStyleProvider *provider = GTK_STYLE_PROVIDER(bench->app.css_provider);
+
+    g_object_set(gtk_settings_get_default(), "gtk-application-prefer-dark-theme", theme->dark, NULL);
+    gtk_style_context_remove_provider_for_screen(screen, provider);
+    if (theme->stylesheet) {
+        gtk_style_context_add_provider_for_screen(screen, provider, GTK_STYLE_PROVIDER_PRIORITY_APPLICATION);
+    }
+}
+
+// Percentile of sorted samples, in milliseconds
+static double ottsr_render_percentile(GArray *samples, double p) {
+    return ottsr_samples_percentile(samples, p) / 1000.0;
+}
+
+static void ottsr_render_report_row(const char *what, GArray *layout, GArray *paint) {
+    ottsr_samples_sort(layout);
+    ottsr_samples_sort(paint);
+    g_print("  %-8s %5u  layout p50 %7.3f p99 %7.3f ms  paint p50 %7.3f p99 %7.3f max %7.3f ms\n",
+            what, layout->len,
+            ottsr_render_percentile(layout, 0.50), ottsr_render_percentile(layout, 0.99),
+            ottsr_render_percentile(paint, 0.50), ottsr_render_percentile(paint, 0.99),
+            ottsr_render_percentile(paint, 1.0));
+}
+
+static void ottsr_render_report(ottsr_render_bench_t *bench, const ottsr_render_theme_t *theme) {
+    GArray *layout = g_array_new(FALSE, FALSE, sizeof(gint64));
+    GArray *paint = g_array_new(FALSE, FALSE, sizeof(gint64));
+
+    g_print("Theme %s (%dx%d)\n", theme->name,
+            gtk_widget_get_allocated_width(bench->window),
+            gtk_widget_get_allocated_height(bench->window));
+    for (int step = 0; step < OTTSR_RENDER_STEPS; step++) {
+        g_array_append_vals(layout, bench->layout[step]->data, bench->layout[step]->len);
+        g_array_append_vals(paint, bench->paint[step]->data, bench->paint[step]->len);
+        ottsr_render_report_row(ottsr_render_step_names[step], bench->layout[step], bench->paint[step]);
+        g_array_set_size(bench->layout[step], 0);
+        g_array_set_size(bench->paint[step], 0);
+    }
+    ottsr_render_report_row("all", layout, paint);
+
+    g_array_unref(layout);
+    g_array_unref(paint);
+}
+
+static void ottsr_render_theme_run(ottsr_render_bench_t *bench, const ottsr_render_theme_t *theme) {
+    ottsr_render_theme_apply(bench, theme);
+    ottsr_render_step(bench, OTTSR_RENDER_RESTYLE);
+
+    for (int round = 0; round < bench->rounds; round++) {
+        ottsr_render_step(bench, OTTSR_RENDER_START);
+        for (int i = 0; i < bench->ticks; i++) ottsr_render_step(bench, OTTSR_RENDER_TICK);
+        ottsr_render_step(bench, OTTSR_RENDER_PAUSE);
+        ottsr_render_step(bench, OTTSR_RENDER_RESUME);
+        for (int i = 0; i < bench->ticks; i++) ottsr_render_step(bench, OTTSR_RENDER_TICK);
+        ottsr_render_step(bench, OTTSR_RENDER_BREAK);
+        for (int i = 0; i < bench->ticks; i++) ottsr_render_step(bench, OTTSR_RENDER_TICK);
+        ottsr_render_step(bench, OTTSR_RENDER_STOP);
+    }
+
+    if (bench->status == 0) ottsr_render_report(bench, theme);
+}
+
+// Build the window as ottsr_activate does, then move its contents offscreen
+static void ottsr_render_activate(GtkApplication *gtk_app, gpointer user_data) {
+    ottsr_render_bench_t *bench = (ottsr_render_bench_t *)user_data;
+    ottsr_app_t *app = &bench->app;
+
+    ottsr_init_app(app);
+    app->app = gtk_app;
+
+    // Notifications and beeps cost nothing to draw
+    for (int i = 0; i < app->config.profile_count; i++) {
+        app->config.profiles[i].sound_enabled = FALSE;
+        app->config.profiles[i].notifications_enabled = FALSE;
+    }
+
+    ottsr_create_main_window(app);
+    if (!app->main_window) {
+        bench->status = 1;
+        return;
+    }
+
+    GtkWidget *content = gtk_bin_get_child(GTK_BIN(app->main_window));
+    g_object_ref(content);
+    gtk_container_remove(GTK_CONTAINER(app->main_window), content);
+    bench->window = gtk_offscreen_window_new();
+    gtk_container_add(GTK_CONTAINER(bench->window), content);
+    g_object_unref(content);
+    gtk_widget_show_all(bench->window);
+    while (gtk_events_pending()) {
+        gtk_main_iteration();
+    }
+
+    bench->clock = gtk_widget_get_frame_clock(bench->window);
+    g_signal_connect_after(bench->clock, "before-paint", G_CALLBACK(on_render_before_paint), bench);
+    g_signal_connect_after(bench->clock, "layout", G_CALLBACK(on_render_layout), bench);
+    g_signal_connect_after(bench->clock, "paint", G_CALLBACK(on_render_paint), bench);
+    g_signal_connect_after(bench->clock, "after-paint", G_CALLBACK(on_render_after_paint), bench);
+
+    for (int step = 0; step < OTTSR_RENDER_STEPS; step++) {
+        bench->layout[step] = g_array_new(FALSE, FALSE, sizeof(gint64));
+        bench->paint[step] = g_array_new(FALSE, FALSE, sizeof(gint64));
+    }
+
+    g_print("%d rounds of start, %d ticks, pause, resume, %d ticks, break, %d ticks, stop\n",
+            bench->rounds, bench->ticks, bench->ticks, bench->ticks);
+    for (gsize i = 0; i < G_N_ELEMENTS(ottsr_render_themes); i++) {
+        if (!bench->theme || strcmp(bench->theme, ottsr_render_themes[i].name) == 0) {
+            ottsr_render_theme_run(bench, &ottsr_render_themes[i]);
+        }
+    }
+
+    for (int step = 0; step < OTTSR_RENDER_STEPS; step++) {
+        g_array_unref(bench->layout[step]);
+        g_array_unref(bench->paint[step]);
+    }
+    g_signal_handlers_disconnect_by_data(bench->clock, bench);
+
+    // With its last window gone the application returns from run
+    gtk_widget_destroy(bench->window);
+    bench->window = NULL;
+    gtk_widget_destroy(app->main_window);
+    app->main_window = NULL;
+}
+
+int main(int argc, char *argv[]) {
+    ottsr_render_bench_t bench = {0};
+    gboolean broadway = FALSE;
+    char *theme = NULL;
+    bench.ticks = 30;
+    bench.rounds = 3;
+    bench.frame_timeout_ms = 5000;
+
+    GOptionEntry entries[] = {
+        { "theme", 't', 0, G_OPTION_ARG_STRING, &theme, "Only this theme (light, dark, plain)", "NAME" },
+        { "ticks", 'n', 0, G_OPTION_ARG_INT, &bench.ticks, "Timer ticks per phase", "N" },
+        { "rounds", 'r', 0, G_OPTION_ARG_INT, &bench.rounds, "Sessions per theme", "N" },
+        { "frame-timeout", 0, 0, G_OPTION_ARG_INT, &bench.frame_timeout_ms,
+          "Fail if a frame is not drawn within this many milliseconds", "MS" },
+        { "broadway", 'b', 0, G_OPTION_ARG_NONE, &broadway, "Render on a private broadwayd even with a display", NULL },
+        { NULL }
+    };
+
+    GOptionContext *context = g_option_context_new("- time layout and paint of the main window per theme");
+    g_option_context_add_main_entries(context, entries, NULL);
+    GError *error = NULL;
+    gboolean ok = g_option_context_parse(context, &argc, &argv, &error);
+    g_option_context_free(context);
+    if (!ok) {
+        g_printerr("ottsr-render-bench: %s\n", error->message);
+        g_error_free(error);
+        return 1;
+    }
+
+    gboolean known = theme == NULL;
+    for (gsize i = 0; theme && i < G_N_ELEMENTS(ottsr_render_themes); i++) {
+        known |= strcmp(theme, ottsr_render_themes[i].name) == 0;
+    }
+    if (!known) {
+        g_printerr("ottsr-render-bench: unknown theme '%s'\n", theme);
+        g_free(theme);
+        return 1;
+    }
+    bench.theme = theme;
+    bench.ticks = MAX(1, bench.ticks);
+    bench.rounds = MAX(1, bench.rounds);
+    bench.frame_timeout_ms = MAX(1, bench.frame_timeout_ms);
+
+    // Sessions are recorded, so they go to a scratch home
+    char *home = g_dir_make_tmp("ottsr-render-bench-XXXXXX", NULL);
+    if (!home) {
+        g_printerr("ottsr-render-bench: cannot create a scratch home directory\n");
+        g_free(theme);
+        return 1;
+    }
+    g_setenv("HOME", home, TRUE);
+    g_unsetenv(OTTSR_KIOSK_ENV);
+
+    GPid broadwayd = 0;
+    if (broadway || (!g_getenv("GDK_BACKEND") && !g_getenv("DISPLAY") && !g_getenv("WAYLAND_DISPLAY"))) {
+        broadwayd = ottsr_broadway_start();
+    }
+
+    if (!ottsr_display_open(broadwayd)) {
+        // 77 is the usual "skipped" status for test runners
+        g_print("No display to render on; install broadwayd or run under xvfb-run\n");
+        bench.status = 77;
+    } else {
+        GtkApplication *gtk_app = gtk_application_new("com.github.g-flame.ottsr.RenderBench",
+                                                      G_APPLICATION_NON_UNIQUE);
+        g_signal_connect(gtk_app, "activate", G_CALLBACK(ottsr_render_activate), &bench);
+        g_application_run(G_APPLICATION(gtk_app), 0, NULL);
+        ottsr_cleanup_app(&bench.app);
+        g_object_unref(gtk_app);
+    }
+
+    if (broadwayd) ottsr_broadway_stop(broadwayd);
+    ottsr_remove_tree(home);
+    g_free(home);
+    g_free(theme);
+    return bench.status;
+}
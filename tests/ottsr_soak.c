@@ -0,0 +1,278 @@
+#include "ottsr_harness.h"
+
+// `ottsr-soak`: run a session through phase after phase for a long stretch
+// while other threads burn CPU and write to disk and the main loop is
+// stalled at random, as on a busy host. Every deadline goes through
+// ottsr_phase_advance, history, checkpoint and all, and for each one it
+// records how late the timing thread fired and how late after the
+// deadline ottsr_show_notification issued the notification.
+//
+// Profile lengths are whole minutes, so the soak keeps the clock itself and
+// arms it period after period; the session is otherwise the app's own.
+typedef struct {
+    ottsr_app_t *app;
+    ottsr_clock_t *clock;
+    GMainLoop *loop;
+    gint64 period;
+    gint64 end;
+    gint64 armed_at;
+    gint64 last_report;
+    gint quit;
+
+    // Deadline of the transition in progress, until its notification is seen
+    gint64 deadline;
+    gboolean awaiting;
+    guint missed;
+    GPrintFunc print;
+
+    GArray *fire_late;
+    GArray *notify_late;
+    gint written_mib;
+    FILE *csv;
+} ottsr_soak_t;
+
+static ottsr_soak_t *ottsr_soak;
+
+static gpointer ottsr_soak_burn(gpointer data) {
+    ottsr_soak_t *soak = data;
+    volatile guint64 sink = 0;
+
+    while (!g_atomic_int_get(&soak->quit)) {
+        for (int i = 0; i < 100000; i++) sink += (guint64)i * 2654435761u;
+    }
+    return NULL;
+}
+
+// Write and sync in 1 MiB chunks, starting over every 64 MiB
+static gpointer ottsr_soak_write(gpointer data) {
+    ottsr_soak_t *soak = data;
+    char *path = g_build_filename(g_get_tmp_dir(), "ottsr-soak-XXXXXX", NULL);
+    int fd = g_mkstemp(path);
+    if (fd < 0) {
+        g_warning("Failed to create %s for disk load", path);
+        g_free(path);
+        return NULL;
+    }
+
+    gsize chunk = 1 << 20;
+    char *buffer = g_malloc(chunk);
+    memset(buffer, 0x5a, chunk);
+    gsize offset = 0;
+
+    while (!g_atomic_int_get(&soak->quit)) {
+        if (offset >= 64 * chunk) {
+            if (ftruncate(fd, 0) != 0 || lseek(fd, 0, SEEK_SET) < 0) break;
+            offset = 0;
+        }
+        if (write(fd, buffer, chunk) != (ssize_t)chunk) break;
+        fsync(fd);
+        offset += chunk;
+        g_atomic_int_inc(&soak->written_mib);
+    }
+
+    close(fd);
+    g_unlink(path);
+    g_free(buffer);
+    g_free(path);
+    return NULL;
+}
+
+// Without a GApplication ottsr_show_notification prints the notification;
+// the first line printed during a transition is it
+static void ottsr_soak_print(const gchar *string) {
+    ottsr_soak_t *soak = ottsr_soak;
+
+    if (soak->awaiting) {
+        gint64 notify_late = g_get_monotonic_time() - soak->deadline;
+        g_array_append_val(soak->notify_late, notify_late);
+        soak->awaiting = FALSE;
+        return;
+    }
+    soak->print(string);
+}
+
+static void ottsr_soak_due(const ottsr_clock_event_t *event, gpointer user_data) {
+    ottsr_soak_t *soak = user_data;
+    gint64 fire_late = ottsr_fire_late(event, soak->armed_at);
+    g_array_append_val(soak->fire_late, fire_late);
+
+    soak->deadline = event->deadline;
+    soak->awaiting = TRUE;
+    ottsr_phase_advance(soak->app, event->deadline);
+
+    gint64 notify_late = -1;
+    if (soak->awaiting) {
+        soak->awaiting = FALSE;
+        soak->missed++;
+    } else {
+        notify_late = g_array_index(soak->notify_late, gint64, soak->notify_late->len - 1);
+    }
+
+    gint64 now = g_get_monotonic_time();
+    if (soak->csv) {
+        fprintf(soak->csv, "%u,%" G_GINT64_FORMAT ",%" G_GINT64_FORMAT "\n",
+                soak->fire_late->len, fire_late, notify_late);
+    }
+    if (now - soak->last_report >= 60 * G_USEC_PER_SEC) {
+        soak->last_report = now;
+        g_print("%u transitions, %.0f s left\n", soak->fire_late->len,
+                MAX(0, soak->end - now) / (double)G_USEC_PER_SEC);
+    }
+
+    if (event->deadline + soak->period > soak->end) {
+        g_main_loop_quit(soak->loop);
+    } else {
+        soak->armed_at = now;
+        ottsr_clock_arm(soak->clock, event->deadline + soak->period);
+    }
+}
+
+static void ottsr_soak_report(const char *what, GArray *samples) {
+    ottsr_samples_sort(samples);
+    g_print("%-12s p50 %8.2f ms  p99 %8.2f ms  max %8.2f ms\n", what,
+            ottsr_samples_percentile(samples, 0.50) / 1000.0,
+            ottsr_samples_percentile(samples, 0.99) / 1000.0,
+            ottsr_samples_percentile(samples, 1.0) / 1000.0);
+}
+
+// The stdout print handler GLib would use
+static void ottsr_soak_stdout(const gchar *string) {
+    fputs(string, stdout);
+    fflush(stdout);
+}
+
+int main(int argc, char *argv[]) {
+    int duration = 60;
+    int period_ms = 200;
+    int cpu_threads = (int)g_get_num_processors();
+    int io_threads = 1;
+    int stall_ms = 100;
+    int fire_limit_ms = 10;
+    int notify_limit_ms = 250;
+    int seed = 0;
+    char *csv_path = NULL;
+
+    GOptionEntry entries[] = {
+        { "duration", 't', 0, G_OPTION_ARG_INT, &duration, "Seconds to run", "S" },
+        { "period", 'p', 0, G_OPTION_ARG_INT, &period_ms, "Phase length in milliseconds", "MS" },
+        { "cpu", 'c', 0, G_OPTION_ARG_INT, &cpu_threads, "CPU burner threads (default: one per core)", "N" },
+        { "io", 'i', 0, G_OPTION_ARG_INT, &io_threads, "Disk writer threads", "N" },
+        { "stall", 's', 0, G_OPTION_ARG_INT, &stall_ms, "Longest main-loop stall in milliseconds", "MS" },
+        { "fire-limit", 0, 0, G_OPTION_ARG_INT, &fire_limit_ms, "Fail if any deadline fires later than this", "MS" },
+        { "notify-limit", 0, 0, G_OPTION_ARG_INT, &notify_limit_ms, "Fail if p99 handling is later than this", "MS" },
+        { "seed", 0, 0, G_OPTION_ARG_INT, &seed, "Random seed for the stalls", "N" },
+        { "csv", 0, 0, G_OPTION_ARG_FILENAME, &csv_path, "Write every transition to a CSV file", "FILE" },
+        { NULL }
+    };
+
+    GOptionContext *context = g_option_context_new("- check phase timing on a busy host");
+    g_option_context_add_main_entries(context, entries, NULL);
+    GError *error = NULL;
+    gboolean ok = g_option_context_parse(context, &argc, &argv, &error);
+    g_option_context_free(context);
+    if (!ok) {
+        g_printerr("ottsr-soak: %s\n", error->message);
+        g_error_free(error);
+        return 1;
+    }
+    if (seed != 0) g_random_set_seed((guint32)seed);
+
+    ottsr_soak_t soak = {0};
+    soak.period = (gint64)MAX(1, period_ms) * 1000;
+    soak.loop = g_main_loop_new(NULL, FALSE);
+    soak.fire_late = g_array_new(FALSE, FALSE, sizeof(gint64));
+    soak.notify_late = g_array_new(FALSE, FALSE, sizeof(gint64));
+
+    if (csv_path) {
+        soak.csv = fopen(csv_path, "w");
+        if (!soak.csv) {
+            g_printerr("ottsr-soak: cannot write %s\n", csv_path);
+            g_free(csv_path);
+            return 1;
+        }
+        fprintf(soak.csv, "transition,fire_late_us,notify_late_us\n");
+    }
+
+    // History and checkpoint go to a scratch home, not the user's
+    char *home = g_dir_make_tmp("ottsr-soak-XXXXXX", NULL);
+    if (!home) {
+        g_printerr("ottsr-soak: cannot create a scratch home directory\n");
+        g_free(csv_path);
+        return 1;
+    }
+    g_setenv("HOME", home, TRUE);
+    g_unsetenv(OTTSR_KIOSK_ENV);
+
+    // A study session that runs on into the next phase by itself, with
+    // notifications on and the beep off
+    ottsr_app_t *app = g_new0(ottsr_app_t, 1);
+    ottsr_config_set_defaults(&app->config);
+    app->config.autostart_sessions = TRUE;
+    app->config.profiles[0].notifications_enabled = TRUE;
+    app->config.profiles[0].sound_enabled = FALSE;
+    ottsr_checkpoint_open(app);
+    app->session.state = OTTSR_STATE_STUDYING;
+    app->session.session_start = time(NULL);
+    soak.app = app;
+
+    ottsr_soak = &soak;
+    GPrintFunc previous = g_set_print_handler(ottsr_soak_print);
+    soak.print = previous ? previous : ottsr_soak_stdout;
+
+    GPtrArray *threads = g_ptr_array_new();
+    for (int i = 0; i < cpu_threads; i++) {
+        g_ptr_array_add(threads, g_thread_new("ottsr-soak-cpu", ottsr_soak_burn, &soak));
+    }
+    for (int i = 0; i < io_threads; i++) {
+        g_ptr_array_add(threads, g_thread_new("ottsr-soak-io", ottsr_soak_write, &soak));
+    }
+
+    g_print("Soaking for %d s: %d ms phases, %d CPU and %d disk threads, stalls up to %d ms\n",
+            MAX(1, duration), period_ms, cpu_threads, io_threads, MAX(0, stall_ms));
+
+    soak.clock = ottsr_clock_new(ottsr_soak_due, &soak);
+    ottsr_stall_t stall = {0};
+    ottsr_stall_start(&stall, period_ms / 3, (gint64)MAX(0, stall_ms) * 1000);
+    gint64 start = g_get_monotonic_time();
+    soak.end = start + (gint64)MAX(1, duration) * G_USEC_PER_SEC;
+    soak.armed_at = start;
+    soak.last_report = start;
+    app->phase_anchor = start;
+    ottsr_clock_arm(soak.clock, start + soak.period);
+    g_main_loop_run(soak.loop);
+
+    ottsr_stall_stop(&stall);
+    ottsr_clock_free(soak.clock);
+    g_atomic_int_set(&soak.quit, 1);
+    for (guint i = 0; i < threads->len; i++) g_thread_join(g_ptr_array_index(threads, i));
+    g_ptr_array_unref(threads);
+    if (soak.csv) fclose(soak.csv);
+    g_set_print_handler(previous);
+
+    ottsr_checkpoint_close(app);
+    g_free(app);
+    ottsr_remove_tree(home);
+    g_free(home);
+
+    guint transitions = soak.fire_late->len;
+    ottsr_soak_report("fired", soak.fire_late);
+    ottsr_soak_report("notified", soak.notify_late);
+
+    gint64 fire_max = ottsr_samples_percentile(soak.fire_late, 1.0);
+    gint64 notify_p99 = ottsr_samples_percentile(soak.notify_late, 0.99);
+    gboolean passed = soak.missed == 0 && fire_max <= (gint64)fire_limit_ms * 1000 &&
+                      notify_p99 <= (gint64)notify_limit_ms * 1000;
+
+    g_print("%u transitions, %u without a notification, %.0f MiB written, stalls up to %.1f ms: %s\n",
+            transitions, soak.missed, (double)soak.written_mib, stall.longest / 1000.0,
+            passed ? "PASS" : "FAIL");
+    if (!passed) {
+        g_print("Limits: fired max %d ms, notified p99 %d ms\n", fire_limit_ms, notify_limit_ms);
+    }
+
+    g_array_unref(soak.fire_late);
+    g_array_unref(soak.notify_late);
+    g_main_loop_unref(soak.loop);
+    g_free(csv_path);
+    return passed ? 0 : 1;
+}
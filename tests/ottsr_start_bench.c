@@ -0,0 +1,161 @@
+#include "ottsr_harness.h"
+#include <utime.h>
+
+// `ottsr-start-bench`: time loading settings.json the three ways a start can
+// go. Cold has no snapshot and parses the JSON. Warm finds the snapshot and
+// an unchanged mtime and size, and never reads the file. Touched finds a new
+// mtime, hashes the contents and keeps the snapshot.
+
+typedef enum {
+    OTTSR_START_COLD,
+    OTTSR_START_WARM,
+    OTTSR_START_TOUCHED,
+    OTTSR_START_KINDS
+} ottsr_start_kind_t;
+
+static const char *ottsr_start_kind_names[OTTSR_START_KINDS] = { "cold", "warm", "touched" };
+
+// A settings file with every profile slot used, so parsing has work to do
+static gboolean ottsr_start_bench_write(const char *config_file, ottsr_config_t *written) {
+    memset(written, 0, sizeof(*written));
+    ottsr_config_set_defaults(written);
+    for (int i = written->profile_count; i < OTTSR_MAX_PROFILES; i++) {
+        written->profiles[i] = written->profiles[i % written->profile_count];
+        g_snprintf(written->profiles[i].name, OTTSR_MAX_NAME_LEN, "Course %d", i + 1);
+        written->profiles[i].total_sessions = i * 17;
+    }
+    written->profile_count = OTTSR_MAX_PROFILES;
+
+    gsize length = 0;
+    char *json = ottsr_config_to_json(written, &length);
+    gboolean ok = g_file_set_contents(config_file, json, length, NULL);
+    g_free(json);
+    return ok;
+}
+
+// Make the file look written a while ago, or touched now to a new time
+static void ottsr_start_bench_set_mtime(const char *config_file, gint64 seconds_ago) {
+    struct utimbuf times;
+    times.actime = times.modtime = (time_t)(g_get_real_time() / G_USEC_PER_SEC - seconds_ago);
+    g_utime(config_file, &times);
+}
+
+static gboolean ottsr_start_bench_same(const ottsr_config_t *a, const ottsr_config_t *b) {
+    if (a->profile_count != b->profile_count) return FALSE;
+    for (int i = 0; i < a->profile_count; i++) {
+        if (strcmp(a->profiles[i].name, b->profiles[i].name) != 0 ||
+            a->profiles[i].study_minutes != b->profiles[i].study_minutes ||
+            a->profiles[i].total_sessions != b->profiles[i].total_sessions) {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+static gint64 ottsr_start_bench_load(const char *config_file, const ottsr_config_t *written, gboolean *ok) {
+    ottsr_config_t config;
+    memset(&config, 0, sizeof(config));
+    ottsr_config_set_defaults(&config);
+
+    gint64 start = g_get_monotonic_time();
+    gboolean loaded = ottsr_config_load_file(config_file, &config);
+    gint64 elapsed = g_get_monotonic_time() - start;
+
+    *ok = *ok && loaded && ottsr_start_bench_same(&config, written);
+    return elapsed;
+}
+
+static int ottsr_start_bench(const char *config_file, const char *cache_dir, int rounds) {
+    ottsr_config_t written;
+    if (!ottsr_start_bench_write(config_file, &written)) {
+        g_printerr("ottsr-start-bench: cannot write settings\n");
+        return 1;
+    }
+
+    GArray *samples[OTTSR_START_KINDS];
+    for (int kind = 0; kind < OTTSR_START_KINDS; kind++) {
+        samples[kind] = g_array_new(FALSE, FALSE, sizeof(gint64));
+    }
+
+    gboolean ok = TRUE;
+    for (int round = 0; round < rounds; round++) {
+        ottsr_start_bench_set_mtime(config_file, 3600 + round);
+        ottsr_remove_tree(cache_dir);
+
+        gint64 cold = ottsr_start_bench_load(config_file, &written, &ok);
+        gint64 warm = ottsr_start_bench_load(config_file, &written, &ok);
+        ottsr_start_bench_set_mtime(config_file, 60 + round);
+        gint64 touched = ottsr_start_bench_load(config_file, &written, &ok);
+
+        g_array_append_val(samples[OTTSR_START_COLD], cold);
+        g_array_append_val(samples[OTTSR_START_WARM], warm);
+        g_array_append_val(samples[OTTSR_START_TOUCHED], touched);
+    }
+
+    g_print("settings.json with %d profiles, %d rounds\n", OTTSR_MAX_PROFILES, rounds);
+    for (int kind = 0; kind < OTTSR_START_KINDS; kind++) {
+        ottsr_samples_sort(samples[kind]);
+        g_print("  %-8s p50 %7.1f us  p95 %7.1f us\n", ottsr_start_kind_names[kind],
+                (double)ottsr_samples_percentile(samples[kind], 0.50),
+                (double)ottsr_samples_percentile(samples[kind], 0.95));
+    }
+
+    // The snapshot is only worth having if a warm start beats parsing
+    gint64 cold = ottsr_samples_percentile(samples[OTTSR_START_COLD], 0.50);
+    gint64 warm = ottsr_samples_percentile(samples[OTTSR_START_WARM], 0.50);
+    gboolean faster = warm < cold;
+    g_print("Loaded config matches what was written: %s\n", ok ? "yes" : "no");
+    g_print("Warm start faster than cold: %s\n", faster ? "PASS" : "FAIL");
+
+    for (int kind = 0; kind < OTTSR_START_KINDS; kind++) {
+        g_array_unref(samples[kind]);
+    }
+    return ok && faster ? 0 : 1;
+}
+
+int main(int argc, char *argv[]) {
+    int rounds = 50;
+
+    GOptionEntry entries[] = {
+        { "rounds", 'n', 0, G_OPTION_ARG_INT, &rounds, "Loads of each kind to time", "N" },
+        { NULL }
+    };
+
+    GOptionContext *context = g_option_context_new("- time cold and warm configuration loads");
+    g_option_context_add_main_entries(context, entries, NULL);
+    GError *error = NULL;
+    gboolean ok = g_option_context_parse(context, &argc, &argv, &error);
+    g_option_context_free(context);
+    if (!ok) {
+        g_printerr("ottsr-start-bench: %s\n", error->message);
+        g_error_free(error);
+        return 1;
+    }
+
+    // Settings and snapshots go to a scratch home, not the user's; the cache
+    // directory is read once, so it is set before anything asks for it
+    char *home = g_dir_make_tmp("ottsr-start-XXXXXX", NULL);
+    if (!home) {
+        g_printerr("ottsr-start-bench: cannot create a scratch home directory\n");
+        return 1;
+    }
+    char *cache_home = g_build_filename(home, ".cache", NULL);
+    g_setenv("HOME", home, TRUE);
+    g_setenv("XDG_CACHE_HOME", cache_home, TRUE);
+    g_unsetenv(OTTSR_KIOSK_ENV);
+
+    char *config_dir = ottsr_get_config_path();
+    g_mkdir_with_parents(config_dir, 0755);
+    char *config_file = ottsr_get_config_file();
+    char *cache_dir = g_build_filename(g_get_user_cache_dir(), OTTSR_CACHE_DIR, NULL);
+
+    int status = ottsr_start_bench(config_file, cache_dir, MAX(1, rounds));
+
+    g_free(cache_dir);
+    g_free(config_file);
+    g_free(config_dir);
+    ottsr_remove_tree(home);
+    g_free(cache_home);
+    g_free(home);
+    return status;
+}
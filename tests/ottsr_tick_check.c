@@ -0,0 +1,171 @@
+#include "ottsr_harness.h"
+
+// `ottsr-tick-check`: drive ottsr_timer_callback, and through it
+// ottsr_update_display, over whole phases against real widgets, and fail if
+// it touches the heap. Counting needs a build configured with
+// -DOTTSR_ALLOC_CHECK=ON on glibc, which replaces malloc, calloc and
+// realloc with wrappers that count calls while armed and hand the request
+// on to glibc. free is left alone: the memory is glibc's either way.
+//
+// GTK still copies a label's text when it really changes (the timer, once a
+// second); that copy is GTK's. The build links this program with --wrap for
+// the setters ottsr_update_display hands text to, and counting is paused
+// inside them, so only the refresh's own allocations count. How often they
+// are reached is reported alongside.
+#if defined(OTTSR_ALLOC_CHECK) && defined(__GLIBC__)
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t count, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+
+static gint ottsr_alloc_armed = 0;
+static gint ottsr_alloc_count = 0;
+
+static inline void ottsr_alloc_note(void) {
+    if (g_atomic_int_get(&ottsr_alloc_armed)) g_atomic_int_inc(&ottsr_alloc_count);
+}
+
+void *malloc(size_t size) {
+    ottsr_alloc_note();
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size) {
+    ottsr_alloc_note();
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *ptr, size_t size) {
+    ottsr_alloc_note();
+    return __libc_realloc(ptr, size);
+}
+
+static gint ottsr_alloc_handed = 0;
+
+#define OTTSR_ALLOC_HANDED(call) G_STMT_START { \
+    gint armed = g_atomic_int_get(&ottsr_alloc_armed); \
+    g_atomic_int_set(&ottsr_alloc_armed, 0); \
+    call; \
+    g_atomic_int_set(&ottsr_alloc_armed, armed); \
+    if (armed) g_atomic_int_inc(&ottsr_alloc_handed); \
+} G_STMT_END
+
+void __real_gtk_label_set_text(GtkLabel *label, const char *text);
+void __real_gtk_progress_bar_set_text(GtkProgressBar *bar, const char *text);
+void __real_gtk_progress_bar_set_fraction(GtkProgressBar *bar, gdouble fraction);
+
+void __wrap_gtk_label_set_text(GtkLabel *label, const char *text) {
+    OTTSR_ALLOC_HANDED(__real_gtk_label_set_text(label, text));
+}
+
+void __wrap_gtk_progress_bar_set_text(GtkProgressBar *bar, const char *text) {
+    OTTSR_ALLOC_HANDED(__real_gtk_progress_bar_set_text(bar, text));
+}
+
+void __wrap_gtk_progress_bar_set_fraction(GtkProgressBar *bar, gdouble fraction) {
+    OTTSR_ALLOC_HANDED(__real_gtk_progress_bar_set_fraction(bar, fraction));
+}
+
+#define OTTSR_ALLOC_COUNTING TRUE
+#else
+static gint ottsr_alloc_armed = 0;
+static gint ottsr_alloc_count = 0;
+static gint ottsr_alloc_handed = 0;
+
+#define OTTSR_ALLOC_COUNTING FALSE
+#endif
+
+// One refresh, as the once-a-second timeout runs it, with elapsed seconds
+// of the phase gone by
+static void ottsr_tick_check_tick(ottsr_app_t *app, int elapsed) {
+    app->phase_anchor = g_get_monotonic_time() - (gint64)elapsed * G_USEC_PER_SEC;
+    ottsr_timer_callback(app);
+}
+
+int main(int argc, char *argv[]) {
+    int phases = 4;
+
+    GOptionEntry entries[] = {
+        { "phases", 'n', 0, G_OPTION_ARG_INT, &phases, "Study and break phases to run", "N" },
+        { NULL }
+    };
+
+    GOptionContext *context = g_option_context_new("- check that the display refresh does not allocate");
+    g_option_context_add_main_entries(context, entries, NULL);
+    GError *error = NULL;
+    gboolean ok = g_option_context_parse(context, &argc, &argv, &error);
+    g_option_context_free(context);
+    if (!ok) {
+        g_printerr("ottsr-tick-check: %s\n", error->message);
+        g_error_free(error);
+        return 1;
+    }
+
+    if (!gtk_init_check(NULL, NULL)) {
+        // 77 is the usual "skipped" status for test runners
+        g_print("No display for the widgets; run under xvfb-run\n");
+        return 77;
+    }
+
+    // The longest phases the spinners allow, so every table entry is used
+    ottsr_app_t *app = g_new0(ottsr_app_t, 1);
+    ottsr_config_set_defaults(&app->config);
+    ottsr_profile_t *profile = &app->config.profiles[0];
+    profile->study_minutes = OTTSR_TIME_TABLE_SECONDS / 60;
+    profile->break_minutes = 15;
+    profile->long_break_minutes = 30;
+
+    // The widgets ottsr_update_display writes to, without the rest of the window
+    app->timer_label = g_object_ref_sink(gtk_label_new(""));
+    app->status_label = g_object_ref_sink(gtk_label_new(""));
+    app->stats_label = g_object_ref_sink(gtk_label_new(""));
+    app->session_progress = g_object_ref_sink(gtk_progress_bar_new());
+    app->break_progress = g_object_ref_sink(gtk_progress_bar_new());
+
+    // Build the time table and the first stats line before counting
+    ottsr_update_display(app);
+
+    int ticks = 0;
+    gint64 start = g_get_monotonic_time();
+    g_atomic_int_set(&ottsr_alloc_armed, 1);
+
+    for (int phase = 0; phase < MAX(1, phases); phase++) {
+        gboolean study = phase % 2 == 0;
+        app->session.state = study ? OTTSR_STATE_STUDYING : OTTSR_STATE_BREAKING;
+        app->session.is_long_break = !study && phase % 4 == 3;
+        int duration = ottsr_phase_duration(app);
+
+        for (int elapsed = 0; elapsed <= duration; elapsed++) {
+            ottsr_tick_check_tick(app, elapsed);
+            if (study) profile->total_study_time++;
+            ticks++;
+        }
+
+        if (study) {
+            profile->completed_sessions++;
+            app->session.current_sessions++;
+        }
+    }
+
+    g_atomic_int_set(&ottsr_alloc_armed, 0);
+    gint64 elapsed = g_get_monotonic_time() - start;
+    int allocations = g_atomic_int_get(&ottsr_alloc_count);
+    int handed = g_atomic_int_get(&ottsr_alloc_handed);
+    g_object_unref(app->timer_label);
+    g_object_unref(app->status_label);
+    g_object_unref(app->stats_label);
+    g_object_unref(app->session_progress);
+    g_object_unref(app->break_progress);
+    g_free(app);
+
+    g_print("%d ticks over %d phases in %.2f ms (%.0f ns/tick)\n",
+            ticks, MAX(1, phases), elapsed / 1000.0, elapsed * 1000.0 / ticks);
+
+    // 77 is the usual "skipped" status for test runners
+    if (!OTTSR_ALLOC_COUNTING) {
+        g_print("Allocations not counted: configure with -DOTTSR_ALLOC_CHECK=ON on glibc\n");
+        return 77;
+    }
+    g_print("%d widget updates handed to GTK, %d heap allocations of our own: %s\n",
+            handed, allocations, allocations == 0 ? "PASS" : "FAIL");
+    return allocations == 0 ? 0 : 1;
+}
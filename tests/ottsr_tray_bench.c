@@ -0,0 +1,238 @@
+#include "ottsr_harness.h"
+#include <sys/resource.h>
+
+// `ottsr-tray-bench`: the real main window in a study session, first
+// visible and then hidden to the tray for the same time, with CPU time and
+// resident memory measured over each stretch. A private session bus with a
+// stand-in StatusNotifierWatcher takes the place of the panel, so the tray
+// icon registers as it would on a desktop.
+
+static const char ottsr_tray_bench_watcher_xml[] =
+    "<node>"
+    "  <interface name='org.kde.StatusNotifierWatcher'>"
+    "    <method name='RegisterStatusNotifierItem'><arg name='service' type='s' direction='in'/></method>"
+    "  </interface>"
+    "</node>";
+
+typedef struct {
+    gint64 cpu_usec;
+    long rss_kib;
+} ottsr_tray_bench_sample_t;
+
+typedef struct {
+    ottsr_app_t app;
+    int seconds;
+    guint watcher_id;
+    guint watcher_object_id;
+    GDBusConnection *watcher_connection;
+    ottsr_tray_bench_sample_t window;
+    ottsr_tray_bench_sample_t tray;
+    int status;
+} ottsr_tray_bench_t;
+
+static void ottsr_tray_bench_watcher_call(GDBusConnection *connection, const gchar *sender,
+                                          const gchar *object_path, const gchar *interface_name,
+                                          const gchar *method_name, GVariant *parameters,
+                                          GDBusMethodInvocation *invocation, gpointer user_data) {
+    g_dbus_method_invocation_return_value(invocation, NULL);
+}
+
+static void on_tray_bench_watcher_bus(GDBusConnection *connection, const gchar *name, gpointer user_data) {
+    ottsr_tray_bench_t *bench = (ottsr_tray_bench_t *)user_data;
+    static const GDBusInterfaceVTable vtable = {
+        .method_call = ottsr_tray_bench_watcher_call,
+    };
+
+    GDBusNodeInfo *info = g_dbus_node_info_new_for_xml(ottsr_tray_bench_watcher_xml, NULL);
+    bench->watcher_connection = g_object_ref(connection);
+    bench->watcher_object_id = g_dbus_connection_register_object(connection, "/StatusNotifierWatcher",
+                                                                 info->interfaces[0], &vtable,
+                                                                 bench, NULL, NULL);
+    g_dbus_node_info_unref(info);
+}
+
+// CPU time so far and the resident set now; ru_maxrss would only give the
+// peak, which the visible stretch sets for both
+static void ottsr_tray_bench_sample(ottsr_tray_bench_sample_t *sample) {
+    struct rusage usage = {0};
+    getrusage(RUSAGE_SELF, &usage);
+    sample->cpu_usec = (gint64)(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * G_USEC_PER_SEC +
+                       usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+    sample->rss_kib = usage.ru_maxrss;
+
+    char *statm = NULL;
+    if (g_file_get_contents("/proc/self/statm", &statm, NULL, NULL)) {
+        long pages = 0, resident = 0;
+        if (sscanf(statm, "%ld %ld", &pages, &resident) == 2) {
+            sample->rss_kib = resident * (sysconf(_SC_PAGESIZE) / 1024);
+        }
+        g_free(statm);
+    }
+}
+
+static gboolean ottsr_tray_bench_quit(gpointer user_data) {
+    g_main_loop_quit((GMainLoop *)user_data);
+    return G_SOURCE_REMOVE;
+}
+
+// Let the app run undisturbed and return what it cost
+static ottsr_tray_bench_sample_t ottsr_tray_bench_stretch(int seconds) {
+    ottsr_tray_bench_sample_t before, after, used;
+    GMainLoop *loop = g_main_loop_new(NULL, FALSE);
+
+    ottsr_tray_bench_sample(&before);
+    g_timeout_add_seconds(seconds, ottsr_tray_bench_quit, loop);
+    g_main_loop_run(loop);
+    ottsr_tray_bench_sample(&after);
+    g_main_loop_unref(loop);
+
+    used.cpu_usec = after.cpu_usec - before.cpu_usec;
+    used.rss_kib = after.rss_kib;
+    return used;
+}
+
+// The watcher answers on the same bus; give the registration a moment
+static gboolean ottsr_tray_bench_registered(ottsr_app_t *app) {
+    gint64 deadline = g_get_monotonic_time() + 5 * G_USEC_PER_SEC;
+    while (!app->tray_registered && g_get_monotonic_time() < deadline) {
+        g_main_context_iteration(NULL, FALSE);
+        g_usleep(G_USEC_PER_SEC / 100);
+    }
+    return app->tray_registered;
+}
+
+// Build and show the window as ottsr_activate does, then run both stretches
+static void ottsr_tray_bench_activate(GtkApplication *gtk_app, gpointer user_data) {
+    ottsr_tray_bench_t *bench = (ottsr_tray_bench_t *)user_data;
+    ottsr_app_t *app = &bench->app;
+
+    ottsr_init_app(app);
+    app->app = gtk_app;
+    for (int i = 0; i < app->config.profile_count; i++) {
+        app->config.profiles[i].sound_enabled = FALSE;
+        app->config.profiles[i].notifications_enabled = FALSE;
+    }
+
+    ottsr_checkpoint_open(app);
+    ottsr_create_main_window(app);
+    if (!app->main_window) {
+        bench->status = 1;
+        return;
+    }
+    gtk_widget_show_all(app->main_window);
+    ottsr_tray_start(app);
+
+    if (!ottsr_tray_bench_registered(app)) {
+        g_print("The tray icon did not register with the watcher\n");
+        bench->status = 1;
+    } else {
+        ottsr_start_session(app);
+        bench->window = ottsr_tray_bench_stretch(bench->seconds);
+        ottsr_background_enter(app);
+        bench->tray = ottsr_tray_bench_stretch(bench->seconds);
+        ottsr_background_leave(app);
+        ottsr_stop_session(app);
+    }
+
+    // With its last window gone the application returns from run
+    gtk_widget_destroy(app->main_window);
+    app->main_window = NULL;
+}
+
+static void ottsr_tray_bench_print(const char *what, const ottsr_tray_bench_sample_t *sample, int seconds) {
+    g_print("%-8s %8.1f MiB RSS  %8.3f s CPU  %6.2f%% of one core\n", what,
+            sample->rss_kib / 1024.0, sample->cpu_usec / (double)G_USEC_PER_SEC,
+            100.0 * sample->cpu_usec / ((gint64)seconds * G_USEC_PER_SEC));
+}
+
+int main(int argc, char *argv[]) {
+    ottsr_tray_bench_t bench = {0};
+    gboolean broadway = FALSE;
+    bench.seconds = 30;
+
+    GOptionEntry entries[] = {
+        { "seconds", 't', 0, G_OPTION_ARG_INT, &bench.seconds, "Seconds to run visible and in the tray", "S" },
+        { "broadway", 'b', 0, G_OPTION_ARG_NONE, &broadway, "Run on a private broadwayd even with a display", NULL },
+        { NULL }
+    };
+
+    GOptionContext *context = g_option_context_new("- compare a visible window with the tray icon");
+    g_option_context_add_main_entries(context, entries, NULL);
+    GError *error = NULL;
+    gboolean ok = g_option_context_parse(context, &argc, &argv, &error);
+    g_option_context_free(context);
+    if (!ok) {
+        g_printerr("ottsr-tray-bench: %s\n", error->message);
+        g_error_free(error);
+        return 1;
+    }
+    bench.seconds = MAX(2, bench.seconds);
+
+    // 77 is the usual "skipped" status for test runners
+    char *daemon = g_find_program_in_path("dbus-daemon");
+    if (!daemon) {
+        g_print("No dbus-daemon for a private session bus\n");
+        return 77;
+    }
+    g_free(daemon);
+
+    // The session is recorded, so it goes to a scratch home
+    char *home = g_dir_make_tmp("ottsr-tray-bench-XXXXXX", NULL);
+    if (!home) {
+        g_printerr("ottsr-tray-bench: cannot create a scratch home directory\n");
+        return 1;
+    }
+    g_setenv("HOME", home, TRUE);
+    g_unsetenv(OTTSR_KIOSK_ENV);
+
+    GTestDBus *bus = g_test_dbus_new(G_TEST_DBUS_NONE);
+    g_test_dbus_up(bus);
+    bench.watcher_id = g_bus_own_name(G_BUS_TYPE_SESSION, "org.kde.StatusNotifierWatcher",
+                                      G_BUS_NAME_OWNER_FLAGS_NONE, on_tray_bench_watcher_bus,
+                                      NULL, NULL, &bench, NULL);
+
+    GPid broadwayd = 0;
+    if (broadway || (!g_getenv("GDK_BACKEND") && !g_getenv("DISPLAY") && !g_getenv("WAYLAND_DISPLAY"))) {
+        broadwayd = ottsr_broadway_start();
+    }
+
+    if (!ottsr_display_open(broadwayd)) {
+        g_print("No display for the main window; install broadwayd or run under xvfb-run\n");
+        bench.status = 77;
+    } else {
+        GtkApplication *gtk_app = gtk_application_new("com.github.g-flame.ottsr.TrayBench",
+                                                      G_APPLICATION_NON_UNIQUE);
+        g_signal_connect(gtk_app, "activate", G_CALLBACK(ottsr_tray_bench_activate), &bench);
+        g_application_run(G_APPLICATION(gtk_app), 0, NULL);
+        ottsr_cleanup_app(&bench.app);
+        g_object_unref(gtk_app);
+    }
+
+    if (bench.status == 0) {
+        g_print("A study session for %d s in each mode\n", bench.seconds);
+        ottsr_tray_bench_print("window", &bench.window, bench.seconds);
+        ottsr_tray_bench_print("tray", &bench.tray, bench.seconds);
+
+        // Hidden, nothing is drawn: the tray must cost less than the window
+        gboolean cheaper = bench.tray.cpu_usec < bench.window.cpu_usec;
+        g_print("Tray uses %.0f%% of the window's CPU time: %s\n",
+                100.0 * bench.tray.cpu_usec / MAX(bench.window.cpu_usec, 1), cheaper ? "PASS" : "FAIL");
+        bench.status = cheaper ? 0 : 1;
+    }
+
+    if (bench.watcher_object_id) {
+        g_dbus_connection_unregister_object(bench.watcher_connection, bench.watcher_object_id);
+    }
+    g_clear_object(&bench.watcher_connection);
+    g_bus_unown_name(bench.watcher_id);
+    if (broadwayd) ottsr_broadway_stop(broadwayd);
+
+    // Other references to the bus connection may outlive this; stop the
+    // daemon without waiting for them
+    g_test_dbus_stop(bus);
+    g_object_unref(bus);
+
+    ottsr_remove_tree(home);
+    g_free(home);
+    return bench.status;
+}
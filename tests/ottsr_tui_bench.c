@@ -0,0 +1,148 @@
+#include "ottsr_harness.h"
+#include <signal.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+// `ottsr-tui-bench`: run the ottsr terminal frontend and then its window,
+// each in a running session for the same time, and compare what they cost. Both
+// share a scratch home directory: the terminal run leaves its session
+// checkpointed and the window resumes it, so neither sits idle.
+
+typedef struct {
+    gboolean ran;
+    double cpu_seconds;
+    double wall_seconds;
+    long max_rss_kib;
+} ottsr_tui_bench_result_t;
+
+static ottsr_tui_bench_result_t ottsr_tui_bench_run(const char *exe, gboolean tui, char **env, int seconds) {
+    ottsr_tui_bench_result_t result = {0};
+    char *argv_tui[] = { (char *)exe, "--tui", "--start", NULL };
+    char *argv_gtk[] = { (char *)exe, NULL };
+    GPid pid;
+    gint input = -1;
+    GError *error = NULL;
+
+    // Output goes nowhere, but is still drawn; input stays open and quiet
+    if (!g_spawn_async_with_pipes(NULL, tui ? argv_tui : argv_gtk, env,
+                                  G_SPAWN_DO_NOT_REAP_CHILD | G_SPAWN_STDOUT_TO_DEV_NULL |
+                                  G_SPAWN_STDERR_TO_DEV_NULL,
+                                  NULL, NULL, &pid, &input, NULL, NULL, &error)) {
+        g_printerr("ottsr-tui-bench: cannot start %s: %s\n", exe, error->message);
+        g_error_free(error);
+        return result;
+    }
+
+    gint64 start = g_get_monotonic_time();
+    gint64 end = start + (gint64)seconds * G_USEC_PER_SEC;
+    int wait_status = 0;
+    struct rusage usage = {0};
+    pid_t done = 0;
+
+    while (g_get_monotonic_time() < end) {
+        g_usleep(100 * 1000);
+        done = wait4(pid, &wait_status, WNOHANG, &usage);
+        if (done != 0) break;
+    }
+    if (done == 0) {
+        kill(pid, SIGTERM);
+        done = wait4(pid, &wait_status, 0, &usage);
+    }
+    close(input);
+    g_spawn_close_pid(pid);
+
+    result.wall_seconds = (g_get_monotonic_time() - start) / (double)G_USEC_PER_SEC;
+    // Exiting on its own before the time was up means it could not run
+    result.ran = done == pid && g_get_monotonic_time() >= end;
+    result.cpu_seconds = usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6 +
+                         usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
+#ifdef __APPLE__
+    result.max_rss_kib = usage.ru_maxrss / 1024;
+#else
+    result.max_rss_kib = usage.ru_maxrss;
+#endif
+    return result;
+}
+
+static void ottsr_tui_bench_print(const char *what, const ottsr_tui_bench_result_t *result) {
+    g_print("%-10s %8.1f MiB peak RSS  %8.3f s CPU  %6.2f%% of one core\n", what,
+            result->max_rss_kib / 1024.0, result->cpu_seconds,
+            100.0 * result->cpu_seconds / MAX(result->wall_seconds, 0.001));
+}
+
+int main(int argc, char *argv[]) {
+    int seconds = 30;
+    char *exe = NULL;
+
+    GOptionEntry entries[] = {
+        { "seconds", 't', 0, G_OPTION_ARG_INT, &seconds, "Seconds to run each frontend", "S" },
+        { "exe", 'e', 0, G_OPTION_ARG_FILENAME, &exe, "The ottsr executable (default: next to this one)", "PATH" },
+        { NULL }
+    };
+
+    GOptionContext *context = g_option_context_new("- compare the terminal and window frontends");
+    g_option_context_add_main_entries(context, entries, NULL);
+    GError *error = NULL;
+    gboolean ok = g_option_context_parse(context, &argc, &argv, &error);
+    g_option_context_free(context);
+    if (!ok) {
+        g_printerr("ottsr-tui-bench: %s\n", error->message);
+        g_error_free(error);
+        return 1;
+    }
+    seconds = MAX(2, seconds);
+
+    if (!exe) {
+        char *self = g_file_read_link("/proc/self/exe", NULL);
+        if (self) {
+            char *dir = g_path_get_dirname(self);
+            exe = g_build_filename(dir, "ottsr", NULL);
+            g_free(dir);
+            g_free(self);
+        }
+    }
+    if (!exe || !g_file_test(exe, G_FILE_TEST_IS_EXECUTABLE)) {
+        g_printerr("ottsr-tui-bench: cannot find the ottsr executable; pass --exe\n");
+        g_free(exe);
+        return 1;
+    }
+
+    char *home = g_dir_make_tmp("ottsr-tui-bench-XXXXXX", NULL);
+    if (!home) {
+        g_printerr("ottsr-tui-bench: cannot create a scratch home directory\n");
+        g_free(exe);
+        return 1;
+    }
+    char **env = g_environ_setenv(g_get_environ(), "HOME", home, TRUE);
+    env = g_environ_unsetenv(env, OTTSR_KIOSK_ENV);
+
+    g_print("Running each frontend for %d s in a study session\n", seconds);
+    ottsr_tui_bench_result_t tui = ottsr_tui_bench_run(exe, TRUE, env, seconds);
+    ottsr_tui_bench_result_t gtk = ottsr_tui_bench_run(exe, FALSE, env, seconds);
+
+    int status = 0;
+    if (!tui.ran) {
+        g_print("The terminal frontend exited early\n");
+        status = 1;
+    } else {
+        ottsr_tui_bench_print("terminal", &tui);
+    }
+    if (!gtk.ran) {
+        // 77 is the usual "skipped" status for test runners
+        g_print("The window exited early (no display, or another instance running?)\n");
+        if (status == 0) status = 77;
+    } else {
+        ottsr_tui_bench_print("window", &gtk);
+    }
+    if (tui.ran && gtk.ran) {
+        g_print("The terminal frontend uses %.0f%% of the window's memory and %.0f%% of its CPU time\n",
+                100.0 * tui.max_rss_kib / MAX(gtk.max_rss_kib, 1),
+                100.0 * tui.cpu_seconds / MAX(gtk.cpu_seconds, 0.001));
+    }
+
+    ottsr_remove_tree(home);
+    g_strfreev(env);
+    g_free(home);
+    g_free(exe);
+    return status;
+}